@@ -26,6 +26,9 @@
 #include "messages.h"
 #include "children.h"
 #include "dnscache.h"
+#include "regexp-prefilter.h"
+#include "pipe-profiler.h"
+#include "path-tracer.h"
 #include "alarms.h"
 #include "stats/stats-registry.h"
 #include "metrics/metrics.h"
@@ -222,7 +225,8 @@ app_startup(void)
   crypto_init();
   hostname_global_init();
   dns_caching_global_init();
-  dns_caching_thread_init();
+  host_resolve_global_init();
+  regexp_prefilter_global_init();
   afinter_global_init();
   child_manager_init();
   alarm_init();
@@ -284,14 +288,16 @@ app_shutdown(void)
   log_msg_global_deinit();
 
   afinter_global_deinit();
+  pipe_profiler_global_deinit();
+  path_tracer_global_deinit();
   metrics_global_deinit();
+  host_resolve_global_deinit();
   stats_destroy();
   child_manager_deinit();
   g_list_foreach(application_hooks, (GFunc) g_free, NULL);
   g_list_free(application_hooks);
   g_list_free_full(application_thread_init_hooks, g_free);
   g_list_free_full(application_thread_deinit_hooks, g_free);
-  dns_caching_thread_deinit();
   dns_caching_global_deinit();
   hostname_global_deinit();
   crypto_deinit();
@@ -345,7 +351,6 @@ void
 app_thread_start(void)
 {
   scratch_buffers_allocator_init();
-  dns_caching_thread_init();
   main_loop_call_thread_init();
   run_application_thread_init_hooks();
 }
@@ -355,7 +360,6 @@ app_thread_stop(void)
 {
   run_application_thread_deinit_hooks();
   main_loop_call_thread_deinit();
-  dns_caching_thread_deinit();
   scratch_buffers_allocator_deinit();
   timeutils_cache_deinit();
 }
@@ -267,6 +267,10 @@ main_location_print (FILE *yyo, YYLTYPE const * const yylocp)
 %token KW_SYSLOG_STATS                10405
 %token KW_HEALTHCHECK_FREQ            10406
 %token KW_WORKER_PARTITION_KEY        10407
+%token KW_WORKER_PARTITION_REBALANCE  10408
+%token KW_LATENCY_SAMPLING            10409
+%token KW_PROMETHEUS_PORT             10412
+%token KW_PROMETHEUS_ADDRESS          10413
 
 %token KW_CHAIN_HOSTNAMES             10090
 %token KW_NORMALIZE_HOSTNAMES         10091
@@ -289,6 +293,7 @@ main_location_print (FILE *yyo, YYLTYPE const * const yylocp)
 %token KW_DNS_CACHE_EXPIRE            10130
 %token KW_DNS_CACHE_EXPIRE_FAILED     10131
 %token KW_DNS_CACHE_HOSTS             10132
+%token KW_DNS_RESOLVER_THREADS        10133
 
 %token KW_PERSIST_ONLY                10140
 %token KW_USE_RCPTID                  10141
@@ -442,6 +447,7 @@ main_location_print (FILE *yyo, YYLTYPE const * const yylocp)
 
 /* metrics template */
 %token KW_LABELS                      10530
+%token KW_MAX_SERIES                  10531
 
 
 /* END_DECLS */
@@ -1163,6 +1169,14 @@ stats_group_option
 	| KW_LIFETIME '(' positive_integer ')'      { last_stats_options->lifetime = $3; }
 	| KW_MAX_DYNAMIC '(' nonnegative_integer ')'   { last_stats_options->max_dynamic = $3; }
 	| KW_SYSLOG_STATS '(' yesnoauto ')'     { last_stats_options->syslog_stats = $3; }
+	| KW_LATENCY_SAMPLING '(' nonnegative_integer ')' { last_stats_options->latency_sampling = $3; }
+	| KW_PROMETHEUS_PORT '(' nonnegative_integer ')' { last_stats_options->prometheus_port = $3; }
+	| KW_PROMETHEUS_ADDRESS '(' string ')'
+	  {
+	    g_free(last_stats_options->prometheus_address);
+	    last_stats_options->prometheus_address = g_strdup($3);
+	    free($3);
+	  }
 	| KW_HEALTHCHECK_FREQ '(' nonnegative_integer ')' { last_healthcheck_options->freq = $3; }
 	;
 
@@ -1172,6 +1186,8 @@ dns_cache_option
 	| KW_DNS_CACHE_EXPIRE_FAILED '(' positive_integer ')'
 	                                        { last_dns_cache_options->expire_failed = $3; }
 	| KW_DNS_CACHE_HOSTS '(' string ')'     { last_dns_cache_options->hosts = g_strdup($3); free($3); }
+	| KW_DNS_RESOLVER_THREADS '(' nonnegative_integer ')'
+	                                        { last_dns_cache_options->resolver_threads = $3; }
         ;
 
 
@@ -1413,6 +1429,7 @@ threaded_dest_driver_batch_option
 threaded_dest_driver_workers_option
         : KW_WORKERS '(' positive_integer ')'  { log_threaded_dest_driver_set_num_workers(last_driver, $3); }
         | KW_WORKER_PARTITION_KEY '(' template_content ')' { log_threaded_dest_driver_set_worker_partition_key_ref(last_driver, $3); }
+        | KW_WORKER_PARTITION_REBALANCE '(' yesno ')' { log_threaded_dest_driver_set_worker_partition_rebalance(last_driver, $3); }
         ;
 
 /* implies dest_driver_option */
@@ -1688,6 +1705,7 @@ dyn_metrics_template_opt
         : KW_KEY '(' string ')' { dyn_metrics_template_set_key(last_dyn_metrics_template, $3); g_free($3); }
         | KW_LABELS '(' dyn_metrics_template_labels_opts ')'
         | KW_LEVEL '(' nonnegative_integer ')' { dyn_metrics_template_set_level(last_dyn_metrics_template, $3); }
+        | KW_MAX_SERIES '(' nonnegative_integer ')' { dyn_metrics_template_set_max_series(last_dyn_metrics_template, $3); }
 
 dyn_metrics_template_labels_opts
         : dyn_metrics_template_labels_opt dyn_metrics_template_labels_opts
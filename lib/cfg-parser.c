@@ -104,6 +104,9 @@ static CfgLexerKeyword main_keywords[] =
   { "lifetime",           KW_LIFETIME },
   { "max_dynamics",       KW_MAX_DYNAMIC },
   { "syslog_stats",       KW_SYSLOG_STATS },
+  { "latency_sampling",   KW_LATENCY_SAMPLING },
+  { "prometheus_port",    KW_PROMETHEUS_PORT },
+  { "prometheus_address", KW_PROMETHEUS_ADDRESS },
   { "healthcheck_freq",   KW_HEALTHCHECK_FREQ},
   { "min_iw_size_per_reader", KW_MIN_IW_SIZE_PER_READER },
   { "flush_lines",        KW_FLUSH_LINES },
@@ -176,6 +179,7 @@ static CfgLexerKeyword main_keywords[] =
   { "dns_cache_size",     KW_DNS_CACHE_SIZE },
   { "dns_cache_expire",   KW_DNS_CACHE_EXPIRE },
   { "dns_cache_expire_failed", KW_DNS_CACHE_EXPIRE_FAILED },
+  { "dns_resolver_threads", KW_DNS_RESOLVER_THREADS },
   {
     "pass_unix_credentials",   KW_PASS_UNIX_CREDENTIALS, KWS_OBSOLETE,
     "The use of pass-unix-credentials() has been deprecated in " VERSION_3_35 " in favour of "
@@ -187,6 +191,7 @@ static CfgLexerKeyword main_keywords[] =
   { "retries",            KW_RETRIES },
   { "workers",            KW_WORKERS },
   { "worker_partition_key", KW_WORKER_PARTITION_KEY },
+  { "worker_partition_rebalance", KW_WORKER_PARTITION_REBALANCE },
   { "batch_lines",        KW_BATCH_LINES },
   { "batch_timeout",      KW_BATCH_TIMEOUT },
 
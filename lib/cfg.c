@@ -294,6 +294,7 @@ cfg_init(GlobalConfig *cfg)
   stats_reinit(&cfg->stats_options);
 
   dns_caching_update_options(&cfg->dns_cache_options);
+  host_resolve_set_resolver_threads(cfg->dns_cache_options.resolver_threads);
   hostname_reinit(cfg->custom_domain);
   host_resolve_options_init_globals(&cfg->host_resolve_options);
   log_template_options_init(&cfg->template_options, cfg);
@@ -698,6 +699,7 @@ cfg_free(GlobalConfig *self)
   g_free(self->recv_time_zone);
   g_free(self->bad_hostname_re);
   dns_cache_options_destroy(&self->dns_cache_options);
+  stats_options_destroy(&self->stats_options);
   g_free(self->custom_domain);
   plugin_context_deinit_instance(&self->plugin_context);
   cfg_tree_free_instance(&self->tree);
@@ -25,7 +25,8 @@
 #include "dnscache.h"
 #include "messages.h"
 #include "timeutils/cache.h"
-#include "tls-support.h"
+#include "stats/stats-registry.h"
+#include "apphook.h"
 
 #include <sys/types.h>
 #include <netinet/in.h>
@@ -150,7 +151,9 @@ dns_cache_store(DNSCache *self, gboolean persistent, gint family, void *addr, co
   DNSCacheEntry *entry;
   guint hash_size;
 
-  iv_validate_now();
+  /* the asynchronous resolver stores its results from threads without an ivykis loop */
+  if (iv_inited())
+    iv_validate_now();
 
   entry = g_new(DNSCacheEntry, 1);
 
@@ -296,16 +299,12 @@ dns_cache_check_hosts(DNSCache *self, glong t)
  * Returns TRUE if the cache was able to serve the request (e.g. had a
  * matching entry at all).
  */
-gboolean
-dns_cache_lookup(DNSCache *self, gint family, void *addr, const gchar **hostname, gsize *hostname_len,
-                 gboolean *positive)
+static gboolean
+dns_cache_lookup_entry(DNSCache *self, time_t now, gint family, void *addr, const gchar **hostname,
+                       gsize *hostname_len, gboolean *positive)
 {
   DNSCacheKey key;
   DNSCacheEntry *entry;
-  time_t now;
-
-  now = get_cached_realtime_sec();
-  dns_cache_check_hosts(self, now);
 
   dns_cache_fill_key(&key, family, addr);
   entry = g_hash_table_lookup(self->cache, &key);
@@ -330,6 +329,16 @@ dns_cache_lookup(DNSCache *self, gint family, void *addr, const gchar **hostname
   return FALSE;
 }
 
+gboolean
+dns_cache_lookup(DNSCache *self, gint family, void *addr, const gchar **hostname, gsize *hostname_len,
+                 gboolean *positive)
+{
+  time_t now = get_cached_realtime_sec();
+
+  dns_cache_check_hosts(self, now);
+  return dns_cache_lookup_entry(self, now, family, addr, hostname, hostname_len, positive);
+}
+
 DNSCache *
 dns_cache_new(const DNSCacheOptions *options)
 {
@@ -360,6 +369,7 @@ dns_cache_options_defaults(DNSCacheOptions *options)
   options->expire = 3600;
   options->expire_failed = 60;
   options->hosts = NULL;
+  options->resolver_threads = 0;
 }
 
 void
@@ -374,65 +384,156 @@ dns_cache_options_destroy(DNSCacheOptions *options)
  * not be aware of underlying data structures and locking, they can simply
  * call these functions to lookup/query the DNS cache.
  *
- * I would prefer these to be moved into a higher level implementation
- * detail.
+ * The cache is shared by all threads, so a name resolved by one of them
+ * (or by the asynchronous resolver) is reused by the others.  To keep lock
+ * contention low, addresses are hashed into a fixed number of shards, each
+ * of them a separate DNSCache instance with its own lock and its share of
+ * dns-cache-size().  The hosts file is loaded only once, into a separate
+ * DNSCache that is consulted before the shards.
  **************************************************************************/
 
-TLS_BLOCK_START
-{
-  DNSCache *dns_cache;
-}
-TLS_BLOCK_END;
+#define DNS_CACHE_SHARDS 16
 
-#define dns_cache __tls_deref(dns_cache)
+typedef struct _DNSCacheShard
+{
+  GMutex lock;
+  DNSCache *cache;
+  DNSCacheOptions options;
+} DNSCacheShard;
+
+/* entries of the hosts file, reloaded (at most once a second) under the
+ * writer lock, looked up under the reader lock */
+typedef struct _DNSCacheHosts
+{
+  GRWLock lock;
+  DNSCache *cache;
+  DNSCacheOptions options;
+  /* the last time the file was checked, and whether it has entries at all,
+   * so that lookups skip the lock when it is not used */
+  gint checked_at;
+  gint loaded;
+} DNSCacheHosts;
 
 /* DNS cache related options are global, independent of the configuration
  * (e.g.  GlobalConfig instance), and they are stored in the
- * "effective_dns_cache_options" variable below.
- *
- * The reasons for using the global variable are as explained below.
- *
- * Some notes:
- *   1) DNS cache contents are better retained between configuration reloads
- *   2) There are multiple DNSCache instances as they are per-thread data structs.
- *
- * The usual pattern would be:
- *    DNSCache->options -> DNSCacheOptions
- *
- * And options would be a reference and would point inside a DNSCacheOptions
- * instance contained within the GlobalConfig.
- *
- * The problem with this approach is that we don't want to recreate DNSCache
- * instances when reloading the configuration (as we want to keep their
- * config), and this would mean that we'd have to update the "options"
- * pointers in each of the existing instances.  And those instances are
- * per-thread variables, making it a bit more difficult to track them.
- *
- * For this reason, it was a lot simpler to use a global variable to hold
- * configuration options, one that can be updated as the configuration is
- * reloaded.  Then DNSCache instances transparently take the options changes
- * into account as they continue to resolve names.
- *
- * I could come up with even better solutions to this problem (like using a
- * layer above GlobalConfig, a state that encapsulates per-execution state
- * of syslog-ng), however, right now that would be an overkill and I want to
- * get the DNSCache refactors into the master tree.
+ * "effective_dns_cache_options" variable below, so that the cache contents
+ * are retained between configuration reloads.  Every shard has its own
+ * copy, updated under the lock of the shard.
  */
-
 static DNSCacheOptions effective_dns_cache_options;
-G_LOCK_DEFINE_STATIC(unused_dns_caches);
-static GList *unused_dns_caches;
+static DNSCacheShard dns_cache_shards[DNS_CACHE_SHARDS];
+static DNSCacheHosts dns_cache_hosts;
+
+static StatsCounterItem *dns_cache_hits;
+static StatsCounterItem *dns_cache_misses;
+
+static DNSCacheShard *
+_lookup_shard(gint family, void *addr)
+{
+  DNSCacheKey key;
+
+  dns_cache_fill_key(&key, family, addr);
+  return &dns_cache_shards[dns_cache_key_hash(&key) % DNS_CACHE_SHARDS];
+}
+
+static void
+_shard_update_options(DNSCacheShard *shard, const DNSCacheOptions *options)
+{
+  shard->options.cache_size = MAX(options->cache_size / DNS_CACHE_SHARDS, 1);
+  shard->options.expire = options->expire;
+  shard->options.expire_failed = options->expire_failed;
+}
+
+static void
+_hosts_update_options(DNSCacheHosts *hosts, const DNSCacheOptions *options)
+{
+  g_free(hosts->options.hosts);
+  hosts->options.hosts = g_strdup(options->hosts);
+
+  /* force a reload on the next lookup, the file name might have changed */
+  hosts->cache->hosts_mtime = -1;
+  hosts->cache->hosts_checktime = 0;
+  g_atomic_int_set(&hosts->checked_at, 0);
+}
+
+static void
+_hosts_check(DNSCacheHosts *hosts, time_t now)
+{
+  if (G_LIKELY(g_atomic_int_get(&hosts->checked_at) == (gint) now))
+    return;
+
+  g_rw_lock_writer_lock(&hosts->lock);
+  dns_cache_check_hosts(hosts->cache, now);
+  g_atomic_int_set(&hosts->loaded, hosts->cache->persistent_count > 0);
+  g_atomic_int_set(&hosts->checked_at, (gint) now);
+  g_rw_lock_writer_unlock(&hosts->lock);
+}
+
+static gboolean
+_hosts_lookup(DNSCacheHosts *hosts, gint family, void *addr, gchar *hostname, gsize hostname_size,
+              gsize *hostname_len, gboolean *positive)
+{
+  time_t now = get_cached_realtime_sec();
+  const gchar *cached_hostname;
+  gsize cached_hostname_len;
+  gboolean found;
+
+  _hosts_check(hosts, now);
+  if (!g_atomic_int_get(&hosts->loaded))
+    return FALSE;
+
+  g_rw_lock_reader_lock(&hosts->lock);
+  found = dns_cache_lookup_entry(hosts->cache, now, family, addr, &cached_hostname, &cached_hostname_len, positive);
+  if (found)
+    {
+      g_strlcpy(hostname, cached_hostname, hostname_size);
+      *hostname_len = MIN(cached_hostname_len, hostname_size - 1);
+    }
+  g_rw_lock_reader_unlock(&hosts->lock);
+
+  return found;
+}
 
+/*
+ * The hostname is copied to @hostname, as the entry may be evicted by
+ * another thread as soon as the lock of the shard is released.
+ */
 gboolean
-dns_caching_lookup(gint family, void *addr, const gchar **hostname, gsize *hostname_len, gboolean *positive)
+dns_caching_lookup(gint family, void *addr, gchar *hostname, gsize hostname_size, gsize *hostname_len,
+                   gboolean *positive)
 {
-  return dns_cache_lookup(dns_cache, family, addr, hostname, hostname_len, positive);
+  DNSCacheShard *shard = _lookup_shard(family, addr);
+  const gchar *cached_hostname;
+  gsize cached_hostname_len;
+  gboolean found;
+
+  if (_hosts_lookup(&dns_cache_hosts, family, addr, hostname, hostname_size, hostname_len, positive))
+    {
+      stats_counter_inc(dns_cache_hits);
+      return TRUE;
+    }
+
+  g_mutex_lock(&shard->lock);
+  found = dns_cache_lookup(shard->cache, family, addr, &cached_hostname, &cached_hostname_len, positive);
+  if (found)
+    {
+      g_strlcpy(hostname, cached_hostname, hostname_size);
+      *hostname_len = MIN(cached_hostname_len, hostname_size - 1);
+    }
+  g_mutex_unlock(&shard->lock);
+
+  stats_counter_inc(found ? dns_cache_hits : dns_cache_misses);
+  return found;
 }
 
 void
 dns_caching_store(gint family, void *addr, const gchar *hostname, gboolean positive)
 {
-  dns_cache_store_dynamic(dns_cache, family, addr, hostname, positive);
+  DNSCacheShard *shard = _lookup_shard(family, addr);
+
+  g_mutex_lock(&shard->lock);
+  dns_cache_store_dynamic(shard->cache, family, addr, hostname, positive);
+  g_mutex_unlock(&shard->lock);
 }
 
 void
@@ -447,49 +548,90 @@ dns_caching_update_options(const DNSCacheOptions *new_options)
   options->expire = new_options->expire;
   options->expire_failed = new_options->expire_failed;
   options->hosts = g_strdup(new_options->hosts);
-}
-
-void
-dns_caching_thread_init(void)
-{
-  g_assert(dns_cache == NULL);
+  options->resolver_threads = new_options->resolver_threads;
 
-  G_LOCK(unused_dns_caches);
-  if (unused_dns_caches)
+  for (gint i = 0; i < DNS_CACHE_SHARDS; i++)
     {
-      dns_cache = unused_dns_caches->data;
-      unused_dns_caches = g_list_delete_link(unused_dns_caches, unused_dns_caches);
+      DNSCacheShard *shard = &dns_cache_shards[i];
+
+      g_mutex_lock(&shard->lock);
+      _shard_update_options(shard, options);
+      g_mutex_unlock(&shard->lock);
     }
-  G_UNLOCK(unused_dns_caches);
 
-  if (!dns_cache)
-    dns_cache = dns_cache_new(&effective_dns_cache_options);
+  g_rw_lock_writer_lock(&dns_cache_hosts.lock);
+  _hosts_update_options(&dns_cache_hosts, options);
+  g_rw_lock_writer_unlock(&dns_cache_hosts.lock);
 }
 
-void
-dns_caching_thread_deinit(void)
+static void
+_register_stats(void)
 {
-  g_assert(dns_cache != NULL);
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, "dns_cache_hits_total", NULL, 0);
+  stats_register_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &dns_cache_hits);
+  stats_cluster_single_key_set(&sc_key, "dns_cache_misses_total", NULL, 0);
+  stats_register_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &dns_cache_misses);
+  stats_unlock();
+}
 
-  G_LOCK(unused_dns_caches);
-  unused_dns_caches = g_list_prepend(unused_dns_caches, dns_cache);
-  G_UNLOCK(unused_dns_caches);
-  dns_cache = NULL;
+static void
+_unregister_stats(void)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, "dns_cache_hits_total", NULL, 0);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &dns_cache_hits);
+  stats_cluster_single_key_set(&sc_key, "dns_cache_misses_total", NULL, 0);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &dns_cache_misses);
+  stats_unlock();
 }
 
 void
 dns_caching_global_init(void)
 {
   dns_cache_options_defaults(&effective_dns_cache_options);
+
+  for (gint i = 0; i < DNS_CACHE_SHARDS; i++)
+    {
+      DNSCacheShard *shard = &dns_cache_shards[i];
+
+      g_mutex_init(&shard->lock);
+      dns_cache_options_defaults(&shard->options);
+      _shard_update_options(shard, &effective_dns_cache_options);
+      shard->cache = dns_cache_new(&shard->options);
+    }
+
+  g_rw_lock_init(&dns_cache_hosts.lock);
+  dns_cache_options_defaults(&dns_cache_hosts.options);
+  dns_cache_hosts.cache = dns_cache_new(&dns_cache_hosts.options);
+  dns_cache_hosts.checked_at = 0;
+  dns_cache_hosts.loaded = FALSE;
+
+  register_application_hook(AH_RUNNING, (ApplicationHookFunc) _register_stats, NULL, AHM_RUN_ONCE);
+  register_application_hook(AH_SHUTDOWN, (ApplicationHookFunc) _unregister_stats, NULL, AHM_RUN_ONCE);
 }
 
 void
 dns_caching_global_deinit(void)
 {
-  G_LOCK(unused_dns_caches);
-  g_list_foreach(unused_dns_caches, (GFunc) dns_cache_free, NULL);
-  g_list_free(unused_dns_caches);
-  unused_dns_caches = NULL;
-  G_UNLOCK(unused_dns_caches);
+  for (gint i = 0; i < DNS_CACHE_SHARDS; i++)
+    {
+      DNSCacheShard *shard = &dns_cache_shards[i];
+
+      dns_cache_free(shard->cache);
+      shard->cache = NULL;
+      dns_cache_options_destroy(&shard->options);
+      g_mutex_clear(&shard->lock);
+    }
+
+  dns_cache_free(dns_cache_hosts.cache);
+  dns_cache_hosts.cache = NULL;
+  dns_cache_options_destroy(&dns_cache_hosts.options);
+  g_rw_lock_clear(&dns_cache_hosts.lock);
+
   dns_cache_options_destroy(&effective_dns_cache_options);
 }
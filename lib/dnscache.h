@@ -34,6 +34,8 @@ typedef struct
   gint expire;
   gint expire_failed;
   gchar *hosts;
+  /* number of threads resolving cache misses in the background, 0 to resolve them synchronously */
+  gint resolver_threads;
 } DNSCacheOptions;
 
 typedef struct _DNSCache DNSCache;
@@ -48,12 +50,11 @@ void dns_cache_free(DNSCache *self);
 void dns_cache_options_defaults(DNSCacheOptions *options);
 void dns_cache_options_destroy(DNSCacheOptions *options);
 
-gboolean dns_caching_lookup(gint family, void *addr, const gchar **hostname, gsize *hostname_len, gboolean *positive);
+gboolean dns_caching_lookup(gint family, void *addr, gchar *hostname, gsize hostname_size, gsize *hostname_len,
+                            gboolean *positive);
 void dns_caching_store(gint family, void *addr, const gchar *hostname, gboolean positive);
 void dns_caching_update_options(const DNSCacheOptions *dns_cache_options);
 
-void dns_caching_thread_init(void);
-void dns_caching_thread_deinit(void);
 void dns_caching_global_init(void);
 void dns_caching_global_deinit(void);
 
@@ -22,6 +22,7 @@
  *
  */
 #include "filter-op.h"
+#include "filter-re.h"
 
 typedef struct _FilterOp
 {
@@ -96,6 +97,10 @@ fop_or_eval(FilterExprNode *s, LogMessage **msgs, gint num_msg, LogTemplateEvalO
 FilterExprNode *
 fop_or_new(FilterExprNode *e1, FilterExprNode *e2)
 {
+  FilterExprNode *merged = filter_re_merge_or(e1, e2);
+  if (merged)
+    return merged;
+
   FilterOp *self = g_new0(FilterOp, 1);
 
   fop_init_instance(self);
@@ -247,3 +247,214 @@ filter_match_new(void)
   self->super.super.free_fn = filter_match_free;
   return &self->super.super;
 }
+
+/*
+ * A chain of regexp filters or-ed together, e.g. message("a") or
+ * message("b") or ..., against the same value and with the same flags.
+ *
+ * The patterns are combined into a single alternation and evaluated with
+ * one PCRE match instead of one match per filter.  If the combined pattern
+ * fails to compile, the members are evaluated one by one, just like the
+ * original OR chain would do.
+ */
+typedef struct _FilterRESet
+{
+  FilterExprNode super;
+  NVHandle value_handle;
+  gint matcher_flags;
+  GPtrArray *members;
+  LogMatcher *matcher;
+} FilterRESet;
+
+static gboolean
+filter_re_set_eval(FilterExprNode *s, LogMessage **msgs, gint num_msg, LogTemplateEvalOptions *options)
+{
+  FilterRESet *self = (FilterRESet *) s;
+  LogMessage *msg = msgs[num_msg - 1];
+
+  if (self->matcher)
+    {
+      msg_trace("match() evaluation started against a name-value pair using a set of patterns",
+                evt_tag_msg_value_name("name", self->value_handle),
+                evt_tag_msg_value("value", msg, self->value_handle),
+                evt_tag_int("patterns", self->members->len),
+                evt_tag_msg_reference(msg));
+      return log_matcher_match_value(self->matcher, msg, self->value_handle) ^ s->comp;
+    }
+
+  for (guint i = 0; i < self->members->len; i++)
+    {
+      FilterExprNode *member = g_ptr_array_index(self->members, i);
+
+      if (filter_expr_eval_with_context(member, msgs, num_msg, options))
+        return !s->comp;
+    }
+  return s->comp;
+}
+
+static GString *
+_format_combined_pattern(FilterRESet *self)
+{
+  GString *pattern = g_string_new("");
+
+  for (guint i = 0; i < self->members->len; i++)
+    {
+      FilterRE *member = (FilterRE *) g_ptr_array_index(self->members, i);
+
+      if (i > 0)
+        g_string_append_c(pattern, '|');
+      g_string_append_printf(pattern, "(?:%s)", member->matcher->pattern);
+    }
+  return pattern;
+}
+
+static gboolean
+filter_re_set_init(FilterExprNode *s, GlobalConfig *cfg)
+{
+  FilterRESet *self = (FilterRESet *) s;
+  LogMatcherOptions matcher_options;
+  GError *error = NULL;
+
+  for (guint i = 0; i < self->members->len; i++)
+    {
+      if (!filter_expr_init(g_ptr_array_index(self->members, i), cfg))
+        return FALSE;
+    }
+
+  log_matcher_unref(self->matcher);
+  self->matcher = NULL;
+
+  log_matcher_options_defaults(&matcher_options);
+  matcher_options.flags = self->matcher_flags;
+  log_matcher_options_init(&matcher_options);
+
+  GString *pattern = _format_combined_pattern(self);
+  self->matcher = log_matcher_new(&matcher_options);
+  if (!log_matcher_compile(self->matcher, pattern->str, &error))
+    {
+      msg_debug("Failed to combine regexp filters into a single pattern, evaluating them one by one",
+                evt_tag_str("error", error->message));
+      g_clear_error(&error);
+      log_matcher_unref(self->matcher);
+      self->matcher = NULL;
+    }
+
+  g_string_free(pattern, TRUE);
+  log_matcher_options_destroy(&matcher_options);
+  return TRUE;
+}
+
+static void
+filter_re_set_free(FilterExprNode *s)
+{
+  FilterRESet *self = (FilterRESet *) s;
+
+  log_matcher_unref(self->matcher);
+  g_ptr_array_free(self->members, TRUE);
+}
+
+static FilterExprNode *
+filter_re_set_new(FilterRE *first)
+{
+  FilterRESet *self = g_new0(FilterRESet, 1);
+
+  filter_expr_node_init_instance(&self->super);
+  self->super.init = filter_re_set_init;
+  self->super.eval = filter_re_set_eval;
+  self->super.free_fn = filter_re_set_free;
+  self->super.type = "regexp-set";
+  self->value_handle = first->value_handle;
+  self->matcher_flags = first->matcher_options.flags;
+  self->members = g_ptr_array_new_with_free_func((GDestroyNotify) filter_expr_unref);
+  return &self->super;
+}
+
+static gboolean
+_filter_re_is_mergeable(FilterExprNode *s)
+{
+  FilterRE *self = (FilterRE *) s;
+
+  if (s->comp || s->eval != filter_re_eval)
+    return FALSE;
+
+  if (s->free_fn == filter_match_free)
+    {
+      FilterMatch *match = (FilterMatch *) s;
+
+      if (match->template || !match->super.value_handle)
+        return FALSE;
+    }
+  else if (s->free_fn != filter_re_free)
+    {
+      return FALSE;
+    }
+
+  if (!self->matcher || strcmp(self->matcher_options.type, "pcre") != 0)
+    return FALSE;
+
+  if (self->matcher_options.flags & LMF_STORE_MATCHES)
+    return FALSE;
+
+  return log_matcher_pcre_pattern_is_self_contained(self->matcher->pattern);
+}
+
+static void
+_filter_re_set_add(FilterRESet *self, FilterExprNode *member)
+{
+  if (member->free_fn != filter_re_set_free)
+    {
+      g_ptr_array_add(self->members, member);
+      return;
+    }
+
+  FilterRESet *other = (FilterRESet *) member;
+
+  for (guint i = 0; i < other->members->len; i++)
+    g_ptr_array_add(self->members, g_ptr_array_index(other->members, i));
+  g_ptr_array_set_free_func(other->members, NULL);
+  filter_expr_unref(member);
+}
+
+static FilterRE *
+_filter_re_set_first_member(FilterExprNode *s)
+{
+  if (s->free_fn == filter_re_set_free)
+    return s->comp ? NULL : g_ptr_array_index(((FilterRESet *) s)->members, 0);
+
+  if (!_filter_re_is_mergeable(s))
+    return NULL;
+  return (FilterRE *) s;
+}
+
+/*
+ * Merges e1 or e2 into a FilterRESet if both are mergeable regexp filters
+ * (or sets of them).  Takes over the references of e1 and e2 on success,
+ * returns NULL and leaves them alone otherwise.
+ */
+FilterExprNode *
+filter_re_merge_or(FilterExprNode *e1, FilterExprNode *e2)
+{
+  FilterRE *first = _filter_re_set_first_member(e1);
+  FilterRE *second = _filter_re_set_first_member(e2);
+
+  if (!first || !second)
+    return NULL;
+
+  if (first->value_handle != second->value_handle ||
+      first->matcher_options.flags != second->matcher_options.flags)
+    return NULL;
+
+  FilterRESet *self;
+  if (e1->free_fn == filter_re_set_free)
+    {
+      self = (FilterRESet *) e1;
+    }
+  else
+    {
+      self = (FilterRESet *) filter_re_set_new(first);
+      g_ptr_array_add(self->members, e1);
+    }
+
+  _filter_re_set_add(self, e2);
+  return &self->super;
+}
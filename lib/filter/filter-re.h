@@ -39,4 +39,6 @@ void filter_match_set_value_handle(FilterExprNode *s, NVHandle value_handle);
 void filter_match_set_template_ref(FilterExprNode *s, LogTemplate *template);
 FilterExprNode *filter_match_new(void);
 
+FilterExprNode *filter_re_merge_or(FilterExprNode *e1, FilterExprNode *e2);
+
 #endif
@@ -382,3 +382,68 @@ Test(filter, test_match_with_template_non_trivial)
   filter_match_set_template_ref(filter, compile_template("$PID $PROGRAM"));
   testcase("<15>Oct 15 16:17:01 host openvpn[2499]: PTHREAD support initialized", filter, TRUE);
 }
+
+Test(filter, test_or_of_regexps_is_merged_into_a_set)
+{
+  const gchar *msg = "<15>Oct 15 16:17:01 host openvpn[2499]: PTHREAD support initialized";
+  FilterExprNode *filter;
+
+  filter = fop_or_new(fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "^foo", 0),
+                                 create_pcre_regexp_filter(LM_V_MESSAGE, "bar$", 0)),
+                      create_pcre_regexp_filter(LM_V_MESSAGE, "support", 0));
+  cr_assert_str_eq(filter->type, "regexp-set");
+  testcase(msg, filter, TRUE);
+
+  filter = fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "^foo", 0),
+                      fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "bar", 0),
+                                 create_pcre_regexp_filter(LM_V_MESSAGE, "^support", 0)));
+  cr_assert_str_eq(filter->type, "regexp-set");
+  testcase(msg, filter, FALSE);
+
+  filter = fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "(?i)^pthread", 0),
+                      create_pcre_regexp_filter(LM_V_MESSAGE, "^SUPPORT", 0));
+  cr_assert_str_eq(filter->type, "regexp-set");
+  testcase(msg, filter, TRUE);
+}
+
+Test(filter, test_or_of_incompatible_regexps_is_not_merged)
+{
+  const gchar *msg = "<15>Oct 15 16:17:01 host openvpn[2499]: PTHREAD support initialized";
+  FilterExprNode *filter;
+
+  filter = fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "^foo", 0),
+                      create_pcre_regexp_filter(LM_V_PROGRAM, "^openvpn", 0));
+  cr_assert_str_eq(filter->type, "OR");
+  testcase(msg, filter, TRUE);
+
+  filter = fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "^foo", 0),
+                      create_pcre_regexp_filter(LM_V_MESSAGE, "^pthread", LMF_ICASE));
+  cr_assert_str_eq(filter->type, "OR");
+  testcase(msg, filter, TRUE);
+
+  filter = fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "(o)\\1", 0),
+                      create_pcre_regexp_filter(LM_V_MESSAGE, "(P)THREAD", 0));
+  cr_assert_str_eq(filter->type, "OR");
+  testcase(msg, filter, TRUE);
+
+  filter = fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "(x)?(?(1)y|PTHREAD)", 0),
+                      create_pcre_regexp_filter(LM_V_MESSAGE, "^foo", 0));
+  cr_assert_str_eq(filter->type, "OR");
+  testcase(msg, filter, TRUE);
+
+  filter = fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "^foo", 0),
+                      create_pcre_regexp_filter(LM_V_MESSAGE, "(P)THREAD (?1)?support", 0));
+  cr_assert_str_eq(filter->type, "OR");
+  testcase(msg, filter, TRUE);
+
+  filter = fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "^foo", 0),
+                      create_pcre_regexp_filter(LM_V_MESSAGE, "(s)upport ini\\g{-1}", 0));
+  cr_assert_str_eq(filter->type, "OR");
+  testcase(msg, filter, FALSE);
+
+  FilterExprNode *negated = create_pcre_regexp_filter(LM_V_MESSAGE, "^foo", 0);
+  negated->comp = TRUE;
+  filter = fop_or_new(negated, create_pcre_regexp_filter(LM_V_MESSAGE, "^bar", 0));
+  cr_assert_str_eq(filter->type, "OR");
+  testcase(msg, filter, TRUE);
+}
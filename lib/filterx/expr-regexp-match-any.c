@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "expr-regexp-match-any.h"
+#include "filterx/expr-regexp-common.h"
+#include "filterx/expr-literal.h"
+#include "filterx/expr-literal-generator.h"
+#include "filterx/object-string.h"
+#include "filterx/object-primitive.h"
+#include "filterx/object-null.h"
+#include "filterx/object-extractor.h"
+#include "logmatcher.h"
+#include "compat/pcre.h"
+
+#define FILTERX_FUNC_REGEXP_MATCH_ANY_USAGE "Usage: regexp_match_any(string, [pattern, ...])"
+
+typedef struct FilterXFuncRegexpMatchAny_
+{
+  FilterXFunction super;
+  FilterXExpr *string_expr;
+  FilterXExpr *patterns_expr;
+  GPtrArray *patterns;
+  /*
+   * When set, patterns holds a single alternation of all the patterns,
+   * each alternative tagged with its index as a (*MARK), so one scan
+   * finds the match and tells which pattern produced it.
+   */
+  gboolean combined;
+} FilterXFuncRegexpMatchAny;
+
+static gboolean
+_match_pattern(pcre2_code_8 *pattern, const gchar *str, gsize str_len, pcre2_match_data *match_data,
+               gboolean *matched)
+{
+  gint rc = pcre2_match(pattern, (PCRE2_SPTR) str, (PCRE2_SIZE) str_len, 0, 0, match_data, NULL);
+
+  /* rc == 0 only means that the ovector was too small to hold the groups, we only need the match itself */
+  *matched = rc >= 0;
+  if (rc < 0 && rc != PCRE2_ERROR_NOMATCH)
+    {
+      msg_error("FilterX: Error while matching regexp", evt_tag_int("error_code", rc));
+      return FALSE;
+    }
+  return TRUE;
+}
+
+static gboolean
+_find_combined_match(FilterXFuncRegexpMatchAny *self, const gchar *str, gsize str_len,
+                     pcre2_match_data *match_data, gint *index)
+{
+  gboolean matched;
+  if (!_match_pattern(g_ptr_array_index(self->patterns, 0), str, str_len, match_data, &matched))
+    return FALSE;
+
+  if (matched)
+    *index = (gint) g_ascii_strtoll((const gchar *) pcre2_get_mark(match_data), NULL, 10);
+  return TRUE;
+}
+
+/*
+ * Same result as the combined alternation: the pattern matching at the
+ * leftmost position wins, the first one in the list on a tie.
+ */
+static gboolean
+_find_leftmost_match(FilterXFuncRegexpMatchAny *self, const gchar *str, gsize str_len,
+                     pcre2_match_data *match_data, gint *index)
+{
+  PCRE2_SIZE leftmost = 0;
+
+  for (guint i = 0; i < self->patterns->len; i++)
+    {
+      gboolean matched;
+      if (!_match_pattern(g_ptr_array_index(self->patterns, i), str, str_len, match_data, &matched))
+        return FALSE;
+
+      if (!matched)
+        continue;
+
+      PCRE2_SIZE start = match_start_offset(pcre2_get_ovector_pointer(match_data));
+      if (*index < 0 || start < leftmost)
+        {
+          *index = i;
+          leftmost = start;
+        }
+    }
+  return TRUE;
+}
+
+static FilterXObject *
+_match_any_eval(FilterXExpr *s)
+{
+  FilterXFuncRegexpMatchAny *self = (FilterXFuncRegexpMatchAny *) s;
+
+  FilterXObject *result = NULL;
+  FilterXObject *string_obj = filterx_expr_eval(self->string_expr);
+  if (!string_obj)
+    return NULL;
+
+  const gchar *str;
+  gsize str_len;
+  if (!filterx_object_extract_string_ref(string_obj, &str, &str_len))
+    {
+      msg_error("FilterX: Regexp matching left hand side must be string type",
+                evt_tag_str("type", string_obj->type->name));
+      goto exit;
+    }
+
+  pcre2_match_data *match_data = pcre2_match_data_create(1, NULL);
+  gint index = -1;
+  gboolean success = self->combined
+                     ? _find_combined_match(self, str, str_len, match_data, &index)
+                     : _find_leftmost_match(self, str, str_len, match_data, &index);
+  pcre2_match_data_free(match_data);
+
+  if (success)
+    result = index >= 0 ? filterx_integer_new(index) : filterx_null_new();
+
+exit:
+  filterx_object_unref(string_obj);
+  return result;
+}
+
+static gboolean
+_collect_pattern(gsize index, FilterXExpr *value, gpointer user_data)
+{
+  GPtrArray *pattern_strings = (GPtrArray *) user_data;
+
+  if (!filterx_expr_is_literal(value))
+    return FALSE;
+
+  gsize pattern_len;
+  FilterXObject *pattern_obj = filterx_expr_eval(value);
+  const gchar *pattern = pattern_obj ? filterx_string_get_value_ref(pattern_obj, &pattern_len) : NULL;
+  if (pattern)
+    g_ptr_array_add(pattern_strings, g_strndup(pattern, pattern_len));
+
+  filterx_object_unref(pattern_obj);
+  return pattern != NULL;
+}
+
+static GPtrArray *
+_collect_patterns(FilterXFuncRegexpMatchAny *self)
+{
+  if (!filterx_expr_is_literal_list_generator(self->patterns_expr))
+    return NULL;
+
+  GPtrArray *pattern_strings = g_ptr_array_new_with_free_func(g_free);
+  if (!filterx_literal_list_generator_foreach(self->patterns_expr, _collect_pattern, pattern_strings) ||
+      pattern_strings->len == 0)
+    {
+      g_ptr_array_free(pattern_strings, TRUE);
+      return NULL;
+    }
+
+  return pattern_strings;
+}
+
+static gboolean
+_can_combine_patterns(GPtrArray *pattern_strings)
+{
+  if (pattern_strings->len < 2)
+    return FALSE;
+
+  for (guint i = 0; i < pattern_strings->len; i++)
+    {
+      if (!log_matcher_pcre_pattern_is_self_contained(g_ptr_array_index(pattern_strings, i)))
+        return FALSE;
+    }
+  return TRUE;
+}
+
+static gboolean
+_compile_pattern(FilterXFuncRegexpMatchAny *self, const gchar *pattern)
+{
+  pcre2_code_8 *compiled = filterx_regexp_compile_pattern_defaults(pattern);
+  if (!compiled)
+    return FALSE;
+
+  g_ptr_array_add(self->patterns, compiled);
+  return TRUE;
+}
+
+static gboolean
+_compile_combined_pattern(FilterXFuncRegexpMatchAny *self, GPtrArray *pattern_strings)
+{
+  GString *combined = g_string_new(NULL);
+
+  for (guint i = 0; i < pattern_strings->len; i++)
+    {
+      if (i > 0)
+        g_string_append_c(combined, '|');
+      g_string_append_printf(combined, "(?:%s)(*:%u)", (const gchar *) g_ptr_array_index(pattern_strings, i), i);
+    }
+
+  gboolean success = _compile_pattern(self, combined->str);
+  g_string_free(combined, TRUE);
+  return success;
+}
+
+static gboolean
+_init_patterns(FilterXFuncRegexpMatchAny *self, GlobalConfig *cfg)
+{
+  if (!filterx_expr_init(self->patterns_expr, cfg))
+    return FALSE;
+
+  GPtrArray *pattern_strings = _collect_patterns(self);
+  if (!pattern_strings)
+    {
+      msg_error("regexp_match_any(): patterns argument must be a non-empty list of literal strings. "
+                FILTERX_FUNC_REGEXP_MATCH_ANY_USAGE);
+      goto error;
+    }
+
+  self->combined = _can_combine_patterns(pattern_strings);
+  gboolean success = TRUE;
+  if (self->combined)
+    {
+      success = _compile_combined_pattern(self, pattern_strings);
+    }
+  else
+    {
+      for (guint i = 0; i < pattern_strings->len && success; i++)
+        success = _compile_pattern(self, g_ptr_array_index(pattern_strings, i));
+    }
+  g_ptr_array_free(pattern_strings, TRUE);
+
+  if (!success)
+    {
+      msg_error("regexp_match_any(): failed to compile pattern. " FILTERX_FUNC_REGEXP_MATCH_ANY_USAGE);
+      g_ptr_array_set_size(self->patterns, 0);
+      goto error;
+    }
+
+  return TRUE;
+
+error:
+  filterx_expr_deinit(self->patterns_expr, cfg);
+  return FALSE;
+}
+
+static FilterXExpr *
+_match_any_optimize(FilterXExpr *s)
+{
+  FilterXFuncRegexpMatchAny *self = (FilterXFuncRegexpMatchAny *) s;
+
+  self->string_expr = filterx_expr_optimize(self->string_expr);
+  self->patterns_expr = filterx_expr_optimize(self->patterns_expr);
+  return filterx_function_optimize_method(&self->super);
+}
+
+static gboolean
+_match_any_init(FilterXExpr *s, GlobalConfig *cfg)
+{
+  FilterXFuncRegexpMatchAny *self = (FilterXFuncRegexpMatchAny *) s;
+
+  if (!filterx_expr_init(self->string_expr, cfg))
+    return FALSE;
+
+  if (!_init_patterns(self, cfg))
+    {
+      filterx_expr_deinit(self->string_expr, cfg);
+      return FALSE;
+    }
+
+  return filterx_function_init_method(&self->super, cfg);
+}
+
+static void
+_match_any_deinit(FilterXExpr *s, GlobalConfig *cfg)
+{
+  FilterXFuncRegexpMatchAny *self = (FilterXFuncRegexpMatchAny *) s;
+
+  filterx_expr_deinit(self->string_expr, cfg);
+  filterx_expr_deinit(self->patterns_expr, cfg);
+  g_ptr_array_set_size(self->patterns, 0);
+  filterx_function_deinit_method(&self->super, cfg);
+}
+
+static void
+_match_any_free(FilterXExpr *s)
+{
+  FilterXFuncRegexpMatchAny *self = (FilterXFuncRegexpMatchAny *) s;
+
+  filterx_expr_unref(self->string_expr);
+  filterx_expr_unref(self->patterns_expr);
+  g_ptr_array_free(self->patterns, TRUE);
+  filterx_function_free_method(&self->super);
+}
+
+static gboolean
+_extract_match_any_args(FilterXFuncRegexpMatchAny *self, FilterXFunctionArgs *args, GError **error)
+{
+  if (filterx_function_args_len(args) != 2)
+    {
+      g_set_error(error, FILTERX_FUNCTION_ERROR, FILTERX_FUNCTION_ERROR_CTOR_FAIL,
+                  "invalid number of arguments. " FILTERX_FUNC_REGEXP_MATCH_ANY_USAGE);
+      return FALSE;
+    }
+
+  self->string_expr = filterx_function_args_get_expr(args, 0);
+  self->patterns_expr = filterx_function_args_get_expr(args, 1);
+  return TRUE;
+}
+
+/*
+ * Matches string against a list of patterns and returns the index of the
+ * pattern that matched, or null if none did.  As 0 is a valid index, test
+ * the result against null instead of its truthiness.
+ */
+FilterXExpr *
+filterx_function_regexp_match_any_new(FilterXFunctionArgs *args, GError **error)
+{
+  FilterXFuncRegexpMatchAny *self = g_new0(FilterXFuncRegexpMatchAny, 1);
+
+  filterx_function_init_instance(&self->super, "regexp_match_any");
+  self->super.super.eval = _match_any_eval;
+  self->super.super.optimize = _match_any_optimize;
+  self->super.super.init = _match_any_init;
+  self->super.super.deinit = _match_any_deinit;
+  self->super.super.free_fn = _match_any_free;
+  self->patterns = g_ptr_array_new_with_free_func((GDestroyNotify) pcre2_code_free);
+
+  if (!_extract_match_any_args(self, args, error) ||
+      !filterx_function_args_check(args, error))
+    goto error;
+
+  filterx_function_args_free(args);
+  return &self->super.super;
+
+error:
+  filterx_function_args_free(args);
+  filterx_expr_unref(&self->super.super);
+  return NULL;
+}
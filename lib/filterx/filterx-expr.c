@@ -76,6 +76,28 @@ filterx_expr_format_location_tag(FilterXExpr *self)
     return evt_tag_str("expr", "n/a");
 }
 
+/* only called while the pipe profiler is running, see filterx_expr_eval() */
+FilterXObject *
+filterx_expr_eval_profiled(FilterXExpr *self)
+{
+  if (!pipe_profiler_is_sampling())
+    return self->eval(self);
+
+  gchar frame_name[PIPE_PROFILER_FRAME_NAME_MAX];
+
+  if (self->lloc)
+    g_snprintf(frame_name, sizeof(frame_name), "filterx::%s@%s:%d:%d",
+               self->type, self->lloc->name, self->lloc->first_line, self->lloc->first_column);
+  else
+    g_snprintf(frame_name, sizeof(frame_name), "filterx::%s", self->type);
+
+  pipe_profiler_enter(frame_name);
+  FilterXObject *result = self->eval(self);
+  pipe_profiler_leave();
+
+  return result;
+}
+
 FilterXExpr *
 filterx_expr_optimize(FilterXExpr *self)
 {
@@ -28,6 +28,7 @@
 #include "filterx-object.h"
 #include "cfg-lexer.h"
 #include "stats/stats-counter.h"
+#include "pipe-profiler.h"
 
 struct _FilterXExpr
 {
@@ -90,11 +91,16 @@ struct _FilterXExpr
  * filterx_expr_eval_typed() which will unmarshall any values before
  * returning them.
  */
+FilterXObject *filterx_expr_eval_profiled(FilterXExpr *self);
+
 static inline FilterXObject *
 filterx_expr_eval(FilterXExpr *self)
 {
   stats_counter_inc(self->eval_count);
 
+  if (G_UNLIKELY(pipe_profiler_running))
+    return filterx_expr_eval_profiled(self);
+
   return self->eval(self);
 }
 
@@ -46,6 +46,7 @@
 #include "filterx/func-flatten.h"
 #include "filterx/func-sdata.h"
 #include "filterx/func-repr.h"
+#include "filterx/expr-regexp-match-any.h"
 #include "filterx/expr-regexp-search.h"
 #include "filterx/expr-regexp-subst.h"
 #include "filterx/expr-regexp.h"
@@ -153,6 +154,7 @@ _ctors_init(void)
   g_assert(filterx_builtin_function_ctor_register("unset_empties", filterx_function_unset_empties_new));
   g_assert(filterx_builtin_function_ctor_register("set_fields", filterx_function_set_fields_new));
   g_assert(filterx_builtin_function_ctor_register("regexp_subst", filterx_function_regexp_subst_new));
+  g_assert(filterx_builtin_function_ctor_register("regexp_match_any", filterx_function_regexp_match_any_new));
   g_assert(filterx_builtin_function_ctor_register("unset", filterx_function_unset_new));
   g_assert(filterx_builtin_function_ctor_register("flatten", filterx_function_flatten_new));
   g_assert(filterx_builtin_function_ctor_register("is_sdata_from_enterprise",
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/filterx-lib.h"
+
+#include "filterx/expr-regexp-match-any.h"
+#include "filterx/expr-literal.h"
+#include "filterx/expr-literal-generator.h"
+#include "filterx/object-string.h"
+#include "filterx/object-primitive.h"
+#include "filterx/object-null.h"
+#include "apphook.h"
+#include "scratch-buffers.h"
+
+static FilterXExpr *
+_patterns_new(const gchar *patterns[])
+{
+  FilterXExpr *list = filterx_literal_list_generator_new();
+  GList *elements = NULL;
+
+  for (gint i = 0; patterns[i]; i++)
+    {
+      FilterXExpr *pattern = filterx_literal_new(filterx_string_new(patterns[i], -1));
+      elements = g_list_append(elements, filterx_literal_generator_elem_new(NULL, pattern, FALSE));
+    }
+  filterx_literal_generator_set_elements(list, elements);
+  return list;
+}
+
+static FilterXExpr *
+_match_any_new(const gchar *lhs, FilterXExpr *patterns)
+{
+  GList *args = NULL;
+  args = g_list_append(args, filterx_function_arg_new(NULL, filterx_non_literal_new(filterx_string_new(lhs, -1))));
+  args = g_list_append(args, filterx_function_arg_new(NULL, patterns));
+
+  GError *error = NULL;
+  FilterXExpr *expr = filterx_function_regexp_match_any_new(filterx_function_args_new(args, NULL), &error);
+  cr_assert_null(error);
+  return filterx_expr_optimize(expr);
+}
+
+static void
+_assert_match_any(const gchar *lhs, const gchar *patterns[], gint64 expected_index)
+{
+  FilterXExpr *expr = _match_any_new(lhs, _patterns_new(patterns));
+  cr_assert(filterx_expr_init(expr, configuration));
+
+  FilterXObject *result = filterx_expr_eval(expr);
+  cr_assert(result);
+
+  gint64 index;
+  cr_assert(filterx_integer_unwrap(result, &index), "regexp_match_any() returned no index for %s", lhs);
+  cr_assert_eq(index, expected_index, "unexpected pattern index for %s: %" G_GINT64_FORMAT, lhs, index);
+
+  filterx_object_unref(result);
+  filterx_expr_deinit(expr, configuration);
+  filterx_expr_unref(expr);
+}
+
+static void
+_assert_no_match(const gchar *lhs, const gchar *patterns[])
+{
+  FilterXExpr *expr = _match_any_new(lhs, _patterns_new(patterns));
+  cr_assert(filterx_expr_init(expr, configuration));
+
+  FilterXObject *result = filterx_expr_eval(expr);
+  cr_assert(result);
+  cr_assert(filterx_object_is_type(result, &FILTERX_TYPE_NAME(null)));
+
+  filterx_object_unref(result);
+  filterx_expr_deinit(expr, configuration);
+  filterx_expr_unref(expr);
+}
+
+static void
+_assert_init_error(FilterXExpr *patterns)
+{
+  FilterXExpr *expr = _match_any_new("foobar", patterns);
+  cr_assert_not(filterx_expr_init(expr, configuration));
+  filterx_expr_unref(expr);
+}
+
+Test(filterx_expr_regexp_match_any, returns_the_index_of_the_matching_pattern)
+{
+  const gchar *patterns[] = {"CRON\\[", "sshd\\[", "kernel:", NULL};
+
+  _assert_match_any("CRON[42]: job started", patterns, 0);
+  _assert_match_any("sshd[1234]: Accepted publickey", patterns, 1);
+  _assert_match_any("kernel: oom", patterns, 2);
+}
+
+Test(filterx_expr_regexp_match_any, returns_null_if_no_pattern_matches)
+{
+  const gchar *patterns[] = {"foo", "bar", NULL};
+
+  _assert_no_match("baz", patterns);
+}
+
+Test(filterx_expr_regexp_match_any, capture_groups_in_the_patterns_do_not_shift_the_index)
+{
+  const gchar *patterns[] = {"(a)(b)", "(?<name>c)", "(d)", NULL};
+
+  _assert_match_any("xxd", patterns, 2);
+  _assert_match_any("xcx", patterns, 1);
+}
+
+Test(filterx_expr_regexp_match_any, leftmost_match_wins_first_pattern_on_tie)
+{
+  const gchar *patterns[] = {"bar", "foo", "foo.*", NULL};
+
+  _assert_match_any("foo bar", patterns, 1);
+  _assert_match_any("barfoo", patterns, 0);
+}
+
+Test(filterx_expr_regexp_match_any, patterns_that_cannot_be_combined_give_the_same_result)
+{
+  const gchar *patterns[] = {"(x)\\1", "(ab)\\1", NULL};
+
+  _assert_match_any("ababxx", patterns, 1);
+  _assert_match_any("xxabab", patterns, 0);
+  _assert_no_match("abxab", patterns);
+
+  const gchar *single[] = {"(?x) foo # comment", NULL};
+  _assert_match_any("foo", single, 0);
+}
+
+Test(filterx_expr_regexp_match_any, invalid_patterns_argument)
+{
+  const gchar *empty[] = {NULL};
+  const gchar *invalid[] = {"foo", "(", NULL};
+
+  _assert_init_error(filterx_literal_new(filterx_string_new("foo", -1)));
+  _assert_init_error(_patterns_new(empty));
+  _assert_init_error(_patterns_new(invalid));
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  init_libtest_filterx();
+}
+
+static void
+teardown(void)
+{
+  scratch_buffers_explicit_gc();
+  deinit_libtest_filterx();
+  app_shutdown();
+}
+
+TestSuite(filterx_expr_regexp_match_any, .init = setup, .fini = teardown);
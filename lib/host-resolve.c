@@ -28,6 +28,7 @@
 #include "tls-support.h"
 #include "compat/socket.h"
 #include "apphook.h"
+#include "stats/stats-registry.h"
 
 #include <iv.h>
 
@@ -340,6 +341,92 @@ sockaddr_to_dnscache_key(GSockAddr *saddr)
     }
 }
 
+static const gchar *
+resolve_address(GSockAddr *saddr, gchar *buf, gsize buf_len)
+{
+#ifdef SYSLOG_NG_HAVE_GETNAMEINFO
+  return resolve_address_using_getnameinfo(saddr, buf, buf_len);
+#else
+  return resolve_address_using_gethostbyaddr(saddr, buf, buf_len);
+#endif
+}
+
+/****************************************************************************
+ * Asynchronous resolver
+ *
+ * With dns-resolver-threads() set, cache misses are resolved by a pool of
+ * background threads instead of the thread processing the message.  Until
+ * the result lands in the (shared) DNS cache, messages from that address
+ * carry the address itself, so a slow DNS server never stalls ingestion.
+ ****************************************************************************/
+
+#define MAX_PENDING_RESOLUTIONS 4096
+
+static GThreadPool *resolver_pool;
+static gint resolver_threads;
+G_LOCK_DEFINE_STATIC(resolver_lock);
+/* address string -> GSockAddr, the address is owned by this table */
+static GHashTable *pending_resolutions;
+static StatsCounterItem *pending_resolutions_counter;
+
+static void
+_resolve_in_background(gpointer data, gpointer user_data)
+{
+  GSockAddr *saddr = (GSockAddr *) data;
+  gchar buf[256];
+  gchar key[64];
+  const gchar *hname;
+  gboolean positive;
+
+  hname = resolve_address(saddr, buf, sizeof(buf));
+  positive = (hname != NULL);
+  if (!hname)
+    hname = g_sockaddr_format(saddr, buf, sizeof(buf), GSA_ADDRESS_ONLY);
+
+  dns_caching_store(saddr->sa.sa_family, sockaddr_to_dnscache_key(saddr), hname, positive);
+
+  g_sockaddr_format(saddr, key, sizeof(key), GSA_ADDRESS_ONLY);
+  G_LOCK(resolver_lock);
+  g_hash_table_remove(pending_resolutions, key);
+  stats_counter_dec(pending_resolutions_counter);
+  G_UNLOCK(resolver_lock);
+}
+
+static gboolean
+_is_async_resolution_enabled(const HostResolveOptions *host_resolve_options)
+{
+  /* the result is only ever seen through the cache */
+  return host_resolve_options->use_dns_cache && g_atomic_int_get(&resolver_threads) > 0;
+}
+
+static void
+_resolve_async(GSockAddr *saddr)
+{
+  gchar key[64];
+
+  g_sockaddr_format(saddr, key, sizeof(key), GSA_ADDRESS_ONLY);
+
+  G_LOCK(resolver_lock);
+  if (!g_hash_table_contains(pending_resolutions, key) &&
+      g_hash_table_size(pending_resolutions) < MAX_PENDING_RESOLUTIONS)
+    {
+      GSockAddr *pending_saddr = g_sockaddr_ref(saddr);
+
+      g_hash_table_insert(pending_resolutions, g_strdup(key), pending_saddr);
+      stats_counter_inc(pending_resolutions_counter);
+      g_thread_pool_push(resolver_pool, pending_saddr, NULL);
+    }
+  G_UNLOCK(resolver_lock);
+}
+
+void
+host_resolve_set_resolver_threads(gint threads)
+{
+  if (threads > 0)
+    g_thread_pool_set_max_threads(resolver_pool, threads, NULL);
+  g_atomic_int_set(&resolver_threads, threads);
+}
+
 static const gchar *
 resolve_sockaddr_to_inet_or_inet6_hostname(gsize *result_len, GSockAddr *saddr,
                                            const HostResolveOptions *host_resolve_options)
@@ -356,17 +443,21 @@ resolve_sockaddr_to_inet_or_inet6_hostname(gsize *result_len, GSockAddr *saddr,
 
   if (host_resolve_options->use_dns_cache)
     {
-      if (dns_caching_lookup(saddr->sa.sa_family, dnscache_key, (const gchar **) &hname, &hname_len, &positive))
-        return hostname_apply_options_fqdn(hname_len, result_len, hname, positive, host_resolve_options);
+      if (dns_caching_lookup(saddr->sa.sa_family, dnscache_key, hostname_buffer, sizeof(hostname_buffer),
+                             &hname_len, &positive))
+        return hostname_apply_options_fqdn(hname_len, result_len, hostname_buffer, positive, host_resolve_options);
     }
 
-  if (!hname && host_resolve_options->use_dns && host_resolve_options->use_dns != 2)
+  if (host_resolve_options->use_dns && host_resolve_options->use_dns != 2)
     {
-#ifdef SYSLOG_NG_HAVE_GETNAMEINFO
-      hname = resolve_address_using_getnameinfo(saddr, hostname_buffer, sizeof(hostname_buffer));
-#else
-      hname = resolve_address_using_gethostbyaddr(saddr, hostname_buffer, sizeof(hostname_buffer));
-#endif
+      if (_is_async_resolution_enabled(host_resolve_options))
+        {
+          _resolve_async(saddr);
+          hname = g_sockaddr_format(saddr, hostname_buffer, sizeof(hostname_buffer), GSA_ADDRESS_ONLY);
+          return hostname_apply_options_fqdn(-1, result_len, hname, FALSE, host_resolve_options);
+        }
+
+      hname = resolve_address(saddr, hostname_buffer, sizeof(hostname_buffer));
       positive = (hname != NULL);
     }
 
@@ -479,8 +570,47 @@ _reinit_resolver(gint type, gpointer user_data)
   res_init();
 }
 
+static void
+_register_stats(gint type, gpointer user_data)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, "dns_resolutions_pending", NULL, 0);
+  stats_register_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &pending_resolutions_counter);
+  stats_unlock();
+}
+
+static void
+_unregister_stats(gint type, gpointer user_data)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, "dns_resolutions_pending", NULL, 0);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &pending_resolutions_counter);
+  stats_unlock();
+}
+
 void
 host_resolve_global_init(void)
 {
+  pending_resolutions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_sockaddr_unref);
+  resolver_pool = g_thread_pool_new(_resolve_in_background, NULL, 1, FALSE, NULL);
+  resolver_threads = 0;
+
   register_application_hook(AH_CONFIG_STOPPED, _reinit_resolver, NULL, AHM_RUN_REPEAT);
+  register_application_hook(AH_RUNNING, _register_stats, NULL, AHM_RUN_ONCE);
+  register_application_hook(AH_SHUTDOWN, _unregister_stats, NULL, AHM_RUN_ONCE);
+}
+
+void
+host_resolve_global_deinit(void)
+{
+  /* queued requests are dropped, their addresses are freed with the pending table */
+  g_thread_pool_free(resolver_pool, TRUE, TRUE);
+  resolver_pool = NULL;
+
+  g_hash_table_destroy(pending_resolutions);
+  pending_resolutions = NULL;
 }
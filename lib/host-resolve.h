@@ -46,4 +46,9 @@ void host_resolve_options_init_globals(HostResolveOptions *options);
 void host_resolve_options_init(HostResolveOptions *options, HostResolveOptions *global_options);
 void host_resolve_options_destroy(HostResolveOptions *options);
 
+void host_resolve_set_resolver_threads(gint threads);
+
+void host_resolve_global_init(void);
+void host_resolve_global_deinit(void);
+
 #endif
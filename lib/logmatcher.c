@@ -29,6 +29,7 @@
 #include "scratch-buffers.h"
 #include "compat/string.h"
 #include "compat/pcre.h"
+#include "regexp-prefilter.h"
 
 static void
 log_matcher_store_pattern(LogMatcher *self, const gchar *pattern)
@@ -282,6 +283,7 @@ typedef struct _LogMatcherPcreRe
 {
   LogMatcher super;
   pcre2_code *pattern;
+  RegexpPrefilter prefilter;
   gint match_options;
   gchar *nv_prefix;
   gint nv_prefix_len;
@@ -375,6 +377,7 @@ log_matcher_pcre_re_compile(LogMatcher *s, const gchar *re, GError **error)
   if (!_jit_pcre2_regexp(self, re, error))
     return FALSE;
 
+  regexp_prefilter_init(&self->prefilter, self->pattern, re, self->super.flags & LMF_ICASE);
   return TRUE;
 }
 
@@ -509,6 +512,9 @@ log_matcher_pcre_re_match(LogMatcher *s, LogMessage *msg, gint value_handle, con
   if (value_len == -1)
     value_len = strlen(value);
 
+  if (!regexp_prefilter_may_match(&self->prefilter, value, value_len))
+    return FALSE;
+
   result.match_data = pcre2_match_data_create_from_pattern(self->pattern, NULL);
   result.source_value = value;
   result.source_value_len = value_len;
@@ -565,6 +571,12 @@ log_matcher_pcre_re_replace(LogMatcher *s, LogMessage *msg, gint value_handle, c
   gint options;
   gboolean last_match_was_empty;
 
+  if (value_len == -1)
+    value_len = strlen(value);
+
+  if (!regexp_prefilter_may_match(&self->prefilter, value, value_len))
+    return NULL;
+
   result.match_data = pcre2_match_data_create_from_pattern(self->pattern, NULL);
   PCRE2_SIZE *matches = pcre2_get_ovector_pointer(result.match_data);
 
@@ -574,9 +586,6 @@ log_matcher_pcre_re_replace(LogMatcher *s, LogMessage *msg, gint value_handle, c
 
   matches[0] = matches[1] = 0;
 
-  if (value_len == -1)
-    value_len = strlen(value);
-
   result.source_value = value;
   result.source_value_len = value_len;
   result.source_handle = value_handle;
@@ -692,6 +701,7 @@ log_matcher_pcre_re_free(LogMatcher *s)
 {
   LogMatcherPcreRe *self = (LogMatcherPcreRe *) s;
   pcre2_code_free(self->pattern);
+  regexp_prefilter_destroy(&self->prefilter);
   log_matcher_free_method(s);
 }
 
@@ -711,6 +721,44 @@ log_matcher_pcre_re_new(const LogMatcherOptions *options)
   return &self->super;
 }
 
+/*
+ * Constructs that do not survive being wrapped in (?:...)| with other
+ * patterns: numbered and named back references, subroutine calls and
+ * conditionals (the group numbers shift), start-of-pattern verbs like
+ * (*UTF), \Q without a closing \E and extended mode comments, which would
+ * swallow the rest of the combined pattern.
+ */
+gboolean
+log_matcher_pcre_pattern_is_self_contained(const gchar *pattern)
+{
+  for (const gchar *p = pattern; *p; p++)
+    {
+      if (p[0] == '\\')
+        {
+          if (g_ascii_isdigit(p[1]) || strchr("gkQ", p[1]))
+            return FALSE;
+          if (p[1])
+            p++;
+        }
+      else if (p[0] == '(' && p[1] == '*')
+        {
+          return FALSE;
+        }
+      else if (p[0] == '(' && p[1] == '?')
+        {
+          if (strchr("P&R+-0123456789(", p[2]))
+            return FALSE;
+
+          for (const gchar *opt = &p[2]; g_ascii_isalpha(*opt) || *opt == '^'; opt++)
+            {
+              if (*opt == 'x')
+                return FALSE;
+            }
+        }
+    }
+  return TRUE;
+}
+
 void
 log_matcher_pcre_set_nv_prefix(LogMatcher *s, const gchar *prefix)
 {
@@ -169,6 +169,7 @@ _deserialize_message_version_2x(LogMessageSerializationState *state)
   if (!serialize_read_uint32(sa, &msg->flags))
     return FALSE;
   msg->flags |= LF_STATE_MASK;
+  msg->flags &= ~LF_STATE_PATH_TRACED;
   if (!serialize_read_uint16(sa, &msg->pri))
     return FALSE;
   if (!g_sockaddr_deserialize(sa, &msg->saddr))
@@ -454,6 +455,7 @@ _deserialize_message_version_1x(LogMessageSerializationState *state)
         return FALSE;
     }
   msg->flags |= LF_STATE_MASK;
+  msg->flags &= ~LF_STATE_PATH_TRACED;
   if (!serialize_read_uint16(sa, &msg->pri))
     return FALSE;
 
@@ -42,6 +42,7 @@
 #include "apphook.h"
 #include "scratch-buffers.h"
 #include "str-format.h"
+#include "path-tracer.h"
 
 #include <glib/gprintf.h>
 #include <sys/types.h>
@@ -1578,6 +1579,10 @@ log_msg_new_mark(void)
 static void
 log_msg_free(LogMessage *self)
 {
+  /* clones are freed before their original, which owns the trace */
+  if (G_UNLIKELY(path_tracer_is_traced(self)) && !self->original)
+    path_tracer_finish(self);
+
   if (log_msg_chk_flag(self, LF_STATE_OWN_PAYLOAD) && self->payload)
     nv_table_unref(self->payload);
   if (log_msg_chk_flag(self, LF_STATE_OWN_TAGS) && self->tags && self->num_tags > 0)
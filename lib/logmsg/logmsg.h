@@ -175,6 +175,8 @@ enum
   /* part of the state that is kept across clones */
   LF_STATE_CLONED_MASK = 0xFE00,
   LF_STATE_TRACING     = 0x0200,
+  /* sampled by the path tracer, see path-tracer.h */
+  LF_STATE_PATH_TRACED = 0x0400,
 
   LF_CHAINED_HOSTNAME  = 0x00010000,
 
@@ -311,6 +311,27 @@ Test(logmsg_serialize, existing_and_given_ts_processed)
   g_string_free(stream, TRUE);
 }
 
+Test(logmsg_serialize, path_traced_flag_is_not_restored)
+{
+  LogMessage *msg = _create_message_to_be_serialized(RAW_MSG, strlen(RAW_MSG));
+  GString *stream = g_string_sized_new(512);
+  SerializeArchive *sa = serialize_string_archive_new(stream);
+
+  msg->flags |= LF_STATE_PATH_TRACED;
+  log_msg_serialize(msg, sa, 0);
+
+  log_msg_unref(msg);
+  msg = log_msg_new_empty();
+
+  cr_assert(log_msg_deserialize(msg, sa), ERROR_MSG);
+  cr_assert_eq(msg->flags & LF_STATE_PATH_TRACED, 0,
+               "messages read back from a disk-buffer must not be reported as path traced");
+
+  log_msg_unref(msg);
+  serialize_archive_free(sa);
+  g_string_free(stream, TRUE);
+}
+
 #include "messages/syslog-ng-pe-6.0-msg.h"
 #include "messages/syslog-ng-3.17.1-msg.h"
 #include "messages/syslog-ng-3.18.1-msg.h"
@@ -344,6 +365,7 @@ Test(logmsg_serialize, test_deserialization_of_pe_message)
 {
   LogMessage *msg = _deserialize_message_from_string(serialized_pe_msg, sizeof(serialized_pe_msg));
   _check_deserialized_message_original_fields(msg);
+  cr_assert_eq(msg->flags & LF_STATE_PATH_TRACED, 0);
   log_msg_unref(msg);
 }
 
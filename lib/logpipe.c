@@ -25,6 +25,8 @@
 #include "logpipe.h"
 #include "cfg-tree.h"
 #include "cfg-walker.h"
+#include "pipe-profiler.h"
+#include "path-tracer.h"
 #include "perf/perf.h"
 
 gboolean (*pipe_single_step_hook)(LogPipe *pipe, LogMessage *msg, const LogPathOptions *path_options);
@@ -85,6 +87,34 @@ _is_fastpath(LogPipe *self)
   return TRUE;
 }
 
+static void
+_log_pipe_queue_profiled(LogPipe *self, LogMessage *msg, const LogPathOptions *path_options)
+{
+  if (!pipe_profiler_should_sample())
+    {
+      if (_is_fastpath(self))
+        self->queue(self, msg, path_options);
+      else
+        log_pipe_queue_slow_path(self, msg, path_options);
+      pipe_profiler_end_skip();
+      return;
+    }
+
+  gchar location[PIPE_PROFILER_FRAME_NAME_MAX];
+  gchar frame_name[PIPE_PROFILER_FRAME_NAME_MAX];
+
+  g_snprintf(frame_name, sizeof(frame_name), "%s@%s",
+             self->plugin_name ? : "pipe",
+             log_expr_node_format_location(self->expr_node, location, sizeof(location)));
+
+  pipe_profiler_enter(frame_name);
+  if (_is_fastpath(self))
+    self->queue(self, msg, path_options);
+  else
+    log_pipe_queue_slow_path(self, msg, path_options);
+  pipe_profiler_leave();
+}
+
 void
 log_pipe_queue(LogPipe *self, LogMessage *msg, const LogPathOptions *path_options)
 {
@@ -99,6 +129,15 @@ log_pipe_queue(LogPipe *self, LogMessage *msg, const LogPathOptions *path_option
         }
     }
 
+  if (G_UNLIKELY((self->flags & PIF_CONFIG_RELATED) != 0 && path_tracer_is_traced(msg)))
+    path_tracer_record_pipe(self, msg);
+
+  if (G_UNLIKELY((self->flags & PIF_CONFIG_RELATED) != 0 && pipe_profiler_running))
+    {
+      _log_pipe_queue_profiled(self, msg, path_options);
+      return;
+    }
+
   /* on the fastpath we can use tail call optimization, so we won't have a
    * series of log_pipe_queue() calls on the stack, it improves perf traces
    * if nothing else, but I believe it also helps locality by using a lot
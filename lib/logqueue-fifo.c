@@ -195,7 +195,7 @@ log_queue_fifo_drop_messages_from_input_queue(LogQueueFifo *self, InputQueue *in
 
       iv_list_del(&node->list);
       input_queue->len--;
-      log_queue_dropped_messages_inc(&self->super);
+      log_queue_message_dropped(&self->super, node->msg);
       log_msg_free_queue_node(node);
 
       LogMessage *msg = node->msg;
@@ -370,7 +370,7 @@ log_queue_fifo_push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *pat
 
   if (_message_has_to_be_dropped(self, path_options))
     {
-      log_queue_dropped_messages_inc(&self->super);
+      log_queue_message_dropped(&self->super, msg);
       g_mutex_unlock(&self->super.lock);
 
       log_msg_drop(msg, path_options, AT_PROCESSED);
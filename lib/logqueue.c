@@ -42,11 +42,20 @@ log_queue_memory_usage_sub(LogQueue *self, gsize value)
   stats_counter_sub(self->metrics.owned.memory_usage, value);
 }
 
+static inline void
+_update_queued_messages_peak(LogQueue *self)
+{
+  if (self->metrics.owned.queued_messages_peak)
+    stats_counter_set_max(self->metrics.owned.queued_messages_peak,
+                          stats_counter_get(self->metrics.owned.queued_messages));
+}
+
 void
 log_queue_queued_messages_add(LogQueue *self, gsize value)
 {
   stats_counter_add(self->metrics.shared.queued_messages, value);
   stats_counter_add(self->metrics.owned.queued_messages, value);
+  _update_queued_messages_peak(self);
 }
 
 void
@@ -61,6 +70,7 @@ log_queue_queued_messages_inc(LogQueue *self)
 {
   stats_counter_inc(self->metrics.shared.queued_messages);
   stats_counter_inc(self->metrics.owned.queued_messages);
+  _update_queued_messages_peak(self);
 }
 
 void
@@ -79,6 +89,7 @@ log_queue_queued_messages_reset(LogQueue *self)
   stats_counter_set(self->metrics.owned.queued_messages, log_queue_get_length(self));
   stats_counter_add(self->metrics.shared.queued_messages,
                     stats_counter_get(self->metrics.owned.queued_messages));
+  _update_queued_messages_peak(self);
 }
 
 void
@@ -87,6 +98,25 @@ log_queue_dropped_messages_inc(LogQueue *self)
   stats_counter_inc(self->metrics.shared.dropped_messages);
 }
 
+/* called for each message the queue drops by itself (e.g. when it is
+ * full), possibly with self->lock held */
+void
+log_queue_message_dropped(LogQueue *self, LogMessage *msg)
+{
+  log_queue_dropped_messages_inc(self);
+
+  if (self->drop_notify)
+    self->drop_notify(msg, self->drop_notify_data);
+}
+
+/* not synchronized with pushes, only call it while the queue is not fed */
+void
+log_queue_set_drop_notify(LogQueue *self, LogQueueDropNotifyFunc drop_notify, gpointer user_data)
+{
+  self->drop_notify = drop_notify;
+  self->drop_notify_data = user_data;
+}
+
 /*
  * When this is called, it is assumed that the output thread is currently
  * not running (since this is the function that wakes it up), thus we can
@@ -276,6 +306,10 @@ _register_owned_counters(LogQueue *self, gint stats_level, StatsClusterKeyBuilde
 
     stats_cluster_key_builder_set_name(builder, "memory_usage_bytes");
     self->metrics.owned.memory_usage_sc_key = stats_cluster_key_builder_build_single(builder);
+
+    /* the highest number of queued events since the queue was created */
+    stats_cluster_key_builder_set_name(builder, "events_peak");
+    self->metrics.owned.events_peak_sc_key = stats_cluster_key_builder_build_single(builder);
   }
   stats_cluster_key_builder_pop(builder);
 
@@ -285,8 +319,12 @@ _register_owned_counters(LogQueue *self, gint stats_level, StatsClusterKeyBuilde
                            &self->metrics.owned.queued_messages);
     stats_register_counter(stats_level, self->metrics.owned.memory_usage_sc_key, SC_TYPE_SINGLE_VALUE,
                            &self->metrics.owned.memory_usage);
+    stats_register_counter(stats_level, self->metrics.owned.events_peak_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.owned.queued_messages_peak);
   }
   stats_unlock();
+
+  _update_queued_messages_peak(self);
 }
 
 static void
@@ -347,6 +385,14 @@ _unregister_owned_counters(LogQueue *self)
 
         stats_cluster_key_free(self->metrics.owned.memory_usage_sc_key);
       }
+
+    if (self->metrics.owned.events_peak_sc_key)
+      {
+        stats_unregister_counter(self->metrics.owned.events_peak_sc_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.owned.queued_messages_peak);
+
+        stats_cluster_key_free(self->metrics.owned.events_peak_sc_key);
+      }
   }
   stats_unlock();
 }
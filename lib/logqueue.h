@@ -26,10 +26,12 @@
 #define LOGQUEUE_H_INCLUDED
 
 #include "logmsg/logmsg.h"
+#include "path-tracer.h"
 #include "stats/stats-registry.h"
 #include "stats/stats-cluster-key-builder.h"
 
 typedef void (*LogQueuePushNotifyFunc)(gpointer user_data);
+typedef void (*LogQueueDropNotifyFunc)(LogMessage *msg, gpointer user_data);
 
 typedef struct _LogQueue LogQueue;
 
@@ -51,9 +53,11 @@ typedef struct _LogQueueMetrics
   {
     StatsClusterKey *events_sc_key;
     StatsClusterKey *memory_usage_sc_key;
+    StatsClusterKey *events_peak_sc_key;
 
     StatsCounterItem *memory_usage;
     StatsCounterItem *queued_messages;
+    StatsCounterItem *queued_messages_peak;
   } owned;
 } LogQueueMetrics;
 
@@ -74,6 +78,8 @@ struct _LogQueue
   LogQueuePushNotifyFunc parallel_push_notify;
   gpointer parallel_push_data;
   GDestroyNotify parallel_push_data_destroy;
+  LogQueueDropNotifyFunc drop_notify;
+  gpointer drop_notify_data;
 
   /* queue management */
   gboolean (*keep_on_reload)(LogQueue *self);
@@ -115,6 +121,9 @@ log_queue_is_empty_racy(LogQueue *self)
 static inline void
 log_queue_push_tail(LogQueue *self, LogMessage *msg, const LogPathOptions *path_options)
 {
+  if (G_UNLIKELY(path_tracer_is_traced(msg)))
+    path_tracer_record_hop(msg, "queue-push", self->persist_name);
+
   self->push_tail(self, msg, path_options);
 }
 
@@ -131,6 +140,9 @@ log_queue_pop_head(LogQueue *self, LogPathOptions *path_options)
   if (msg && self->throttle_buckets > 0)
     self->throttle_buckets--;
 
+  if (msg && G_UNLIKELY(path_tracer_is_traced(msg)))
+    path_tracer_record_hop(msg, "queue-pop", self->persist_name);
+
   return msg;
 }
 
@@ -211,6 +223,8 @@ void log_queue_queued_messages_dec(LogQueue *self);
 void log_queue_queued_messages_reset(LogQueue *self);
 
 void log_queue_dropped_messages_inc(LogQueue *self);
+void log_queue_message_dropped(LogQueue *self, LogMessage *msg);
+void log_queue_set_drop_notify(LogQueue *self, LogQueueDropNotifyFunc drop_notify, gpointer user_data);
 
 void log_queue_push_notify(LogQueue *self);
 void log_queue_reset_parallel_push(LogQueue *self);
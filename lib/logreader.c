@@ -474,18 +474,20 @@ set:
   log_msg_set_daddr(msg, aux->local_addr ? : self->local_addr);
 }
 
-static gboolean
-log_reader_handle_line(LogReader *self, const guchar *line, gint length, LogTransportAuxData *aux)
+static LogMessage *
+_log_reader_construct_message(LogReader *self, const guchar *line, gint length)
 {
-  LogMessage *m;
+  LogMessage *m = msg_format_construct_message(&self->options->parse_options, line, length);
 
-  m = msg_format_construct_message(&self->options->parse_options, line, length);
   msg_debug("Incoming log entry",
             evt_tag_mem("input", line, length),
             evt_tag_msg_reference(m));
+  return m;
+}
 
-  msg_format_parse_into(&self->options->parse_options, m, line, length);
-
+static gboolean
+_log_reader_post_message(LogReader *self, LogMessage *m, gint length, LogTransportAuxData *aux)
+{
   _log_reader_insert_msg_length_stats(self, length);
 
   log_msg_set_recvd_rawmsg_size(m, length);
@@ -512,6 +514,134 @@ log_reader_handle_line(LogReader *self, const guchar *line, gint length, LogTran
   return log_source_free_to_send(&self->super);
 }
 
+static gboolean
+log_reader_handle_line(LogReader *self, const guchar *line, gint length, LogTransportAuxData *aux)
+{
+  LogMessage *m = _log_reader_construct_message(self, line, length);
+
+  msg_format_parse_into(&self->options->parse_options, m, line, length);
+  return _log_reader_post_message(self, m, length, aux);
+}
+
+/*
+ * Batched parsing: the records of a fetch run are copied aside as they are
+ * fetched (the buffer of LogProtoServer is only valid until the next
+ * fetch), then their messages are allocated, parsed and posted in three
+ * tight loops, which keeps the parser hot in the instruction cache.
+ *
+ * Only enabled for sources without position tracking, as bookmarks are
+ * requested from the AckTracker one message at a time.
+ */
+#define LOG_READER_MAX_BATCH_SIZE 64
+
+struct _LogReaderBatchRecord
+{
+  LogMessage *msg;
+  gsize offset;
+  gsize length;
+  LogTransportAuxData aux;
+};
+
+static void
+_batch_init(LogReader *self)
+{
+  if (!(self->options->flags & LR_BATCHED_PARSING) || self->batch.records)
+    return;
+
+  if (log_proto_server_is_position_tracked(self->proto))
+    {
+      msg_warning("WARNING: flags(batched-parsing) is not supported for sources tracking their position, ignoring",
+                  log_pipe_location_tag(&self->super.super));
+      return;
+    }
+
+  self->batch.size = MIN(self->options->fetch_limit, LOG_READER_MAX_BATCH_SIZE);
+  self->batch.len = 0;
+  self->batch.lines = g_string_sized_new(4096);
+  self->batch.records = g_new0(LogReaderBatchRecord, self->batch.size);
+}
+
+static void
+_batch_free(LogReader *self)
+{
+  if (!self->batch.records)
+    return;
+
+  g_assert(self->batch.len == 0);
+  g_string_free(self->batch.lines, TRUE);
+  self->batch.lines = NULL;
+  g_free(self->batch.records);
+  self->batch.records = NULL;
+}
+
+static inline gboolean
+_batch_enabled(LogReader *self)
+{
+  return self->batch.records != NULL;
+}
+
+static void
+_batch_add(LogReader *self, const guchar *line, gsize length, LogTransportAuxData *aux)
+{
+  LogReaderBatchRecord *record = &self->batch.records[self->batch.len++];
+
+  record->offset = self->batch.lines->len;
+  record->length = length;
+  g_string_append_len(self->batch.lines, (const gchar *) line, length);
+
+  log_transport_aux_data_init(&record->aux);
+  if (aux)
+    log_transport_aux_data_copy(&record->aux, aux);
+}
+
+/* posting the batch must not overrun the flow-control window */
+static gboolean
+_batch_is_full(LogReader *self)
+{
+  gboolean suspended;
+  gsize free_window = window_size_counter_get(&self->super.window_size, &suspended);
+
+  return self->batch.len >= self->batch.size || self->batch.len >= free_window;
+}
+
+static gboolean
+_batch_flush(LogReader *self, LogTransportAuxData *aux)
+{
+  gboolean free_to_send = log_source_free_to_send(&self->super);
+  gint i;
+
+  if (self->batch.len == 0)
+    return free_to_send;
+
+  const guchar *lines = (const guchar *) self->batch.lines->str;
+
+  for (i = 0; i < self->batch.len; i++)
+    {
+      LogReaderBatchRecord *record = &self->batch.records[i];
+      record->msg = _log_reader_construct_message(self, lines + record->offset, record->length);
+    }
+
+  for (i = 0; i < self->batch.len; i++)
+    {
+      LogReaderBatchRecord *record = &self->batch.records[i];
+      msg_format_parse_into(&self->options->parse_options, record->msg, lines + record->offset, record->length);
+    }
+
+  for (i = 0; i < self->batch.len; i++)
+    {
+      LogReaderBatchRecord *record = &self->batch.records[i];
+
+      free_to_send = _log_reader_post_message(self, record->msg, record->length, aux ? &record->aux : NULL);
+      record->msg = NULL;
+      log_transport_aux_data_destroy(&record->aux);
+    }
+
+  stats_aggregator_add_data_point(self->average_batch_size, self->batch.len);
+  self->batch.len = 0;
+  g_string_truncate(self->batch.lines, 0);
+  return free_to_send;
+}
+
 /* returns: notify_code (NC_XXXX) or 0 for success */
 static gint
 log_reader_fetch_log(LogReader *self)
@@ -554,9 +684,11 @@ log_reader_fetch_log(LogReader *self)
       switch (status)
         {
         case LPS_EOF:
+          _batch_flush(self, aux);
           log_transport_aux_data_destroy(aux);
           return NC_CLOSE;
         case LPS_ERROR:
+          _batch_flush(self, aux);
           log_transport_aux_data_destroy(aux);
           return NC_READ_ERROR;
         case LPS_SUCCESS:
@@ -577,6 +709,14 @@ log_reader_fetch_log(LogReader *self)
         {
           msg_count++;
 
+          if (_batch_enabled(self))
+            {
+              _batch_add(self, msg, msg_len, aux);
+              if (_batch_is_full(self) && !_batch_flush(self, aux))
+                break;
+              continue;
+            }
+
           if (!log_reader_handle_line(self, msg, msg_len, aux))
             {
               /* window is full, don't generate further messages */
@@ -584,6 +724,7 @@ log_reader_fetch_log(LogReader *self)
             }
         }
     }
+  _batch_flush(self, aux);
   log_transport_aux_data_destroy(aux);
 
   return 0;
@@ -652,6 +793,14 @@ _register_aggregated_stats(LogReader *self)
 
   stats_register_aggregator_cps(level, &sc_key, &sc_key_eps_input, SC_TYPE_SINGLE_VALUE, &self->CPS);
 
+  if (_batch_enabled(self))
+    {
+      stats_cluster_single_key_legacy_set_with_name(&sc_key, self->super.options->stats_source | SCS_SOURCE,
+                                                    self->super.stats_id,
+                                                    instance_name, "batch_size_avg");
+      stats_register_aggregator_average(level, &sc_key, &self->average_batch_size);
+    }
+
   stats_aggregator_unlock();
 }
 
@@ -663,6 +812,7 @@ _unregister_aggregated_stats(LogReader *self)
   stats_unregister_aggregator(&self->max_message_size);
   stats_unregister_aggregator(&self->average_messages_size);
   stats_unregister_aggregator(&self->CPS);
+  stats_unregister_aggregator(&self->average_batch_size);
 
   stats_aggregator_unlock();
 }
@@ -692,6 +842,8 @@ log_reader_init(LogPipe *s)
       return FALSE;
     }
 
+  _batch_init(self);
+
   iv_event_register(&self->schedule_wakeup);
 
   log_reader_start_watches(self);
@@ -715,6 +867,7 @@ log_reader_deinit(LogPipe *s)
   log_reader_stop_watches(self);
 
   _unregister_aggregated_stats(self);
+  _batch_free(self);
   if (!log_source_deinit(s))
     return FALSE;
 
@@ -896,6 +1049,7 @@ CfgFlagHandler log_reader_flag_handlers[] =
   { "threaded",                   CFH_SET, offsetof(LogReaderOptions, flags),               LR_THREADED },
   { "ignore-aux-data",            CFH_SET, offsetof(LogReaderOptions, flags),               LR_IGNORE_AUX_DATA },
   { "exit-on-eof",                CFH_SET, offsetof(LogReaderOptions, flags),               LR_EXIT_ON_EOF },
+  { "batched-parsing",            CFH_SET, offsetof(LogReaderOptions, flags),               LR_BATCHED_PARSING },
   { NULL },
 };
 
@@ -40,6 +40,7 @@
 #define LR_IGNORE_AUX_DATA 0x0008
 #define LR_THREADED        0x0040
 #define LR_EXIT_ON_EOF     0x0080
+#define LR_BATCHED_PARSING 0x0100
 
 /* options */
 
@@ -58,6 +59,8 @@ typedef struct _LogReaderOptions
 
 typedef struct _LogReader LogReader;
 
+typedef struct _LogReaderBatchRecord LogReaderBatchRecord;
+
 struct _LogReader
 {
   LogSource super;
@@ -71,6 +74,16 @@ struct _LogReader
   StatsAggregator *max_message_size;
   StatsAggregator *average_messages_size;
   StatsAggregator *CPS;
+  StatsAggregator *average_batch_size;
+
+  /* records fetched but not yet parsed and posted, see flags(batched-parsing) */
+  struct
+  {
+    gint size;
+    gint len;
+    GString *lines;
+    LogReaderBatchRecord *records;
+  } batch;
 
   /* NOTE: these used to be LogReaderWatch members, which were merged into
    * LogReader with the multi-thread refactorization */
@@ -34,6 +34,7 @@
 #include "timeutils/misc.h"
 #include "compat/time.h"
 #include "scratch-buffers.h"
+#include "path-tracer.h"
 
 #include <string.h>
 #include <unistd.h>
@@ -49,6 +50,34 @@ log_source_wakeup(LogSource *self)
   msg_diagnostics("Source has been resumed", log_pipe_location_tag(&self->super));
 }
 
+static inline gsize
+_suspend_clock_msec(void)
+{
+  /* wraps around on 32 bit platforms, only differences are used */
+  gsize now = (gsize) (g_get_monotonic_time() / 1000);
+
+  return now ? now : 1;
+}
+
+static void
+_flow_control_suspended(LogSource *self)
+{
+  if (!self->metrics.flow_control_suspended_time)
+    return;
+
+  if (atomic_gssize_compare_and_exchange(&self->suspended_since, 0, _suspend_clock_msec()))
+    stats_counter_inc(self->metrics.flow_control_suspensions);
+}
+
+static void
+_flow_control_resumed(LogSource *self)
+{
+  gsize suspended_since = atomic_gssize_set_and_get(&self->suspended_since, 0);
+
+  if (suspended_since)
+    stats_counter_add(self->metrics.flow_control_suspended_time, _suspend_clock_msec() - suspended_since);
+}
+
 static inline guint32
 _take_reclaimed_window(LogSource *self, guint32 window_size_increment)
 {
@@ -88,7 +117,11 @@ _flow_control_window_size_adjust(LogSource *self, guint32 window_size_increment,
   if (need_to_resume_counter)
     window_size_counter_resume(&self->window_size);
   if (old_window_size == 0 || need_to_resume_counter)
-    log_source_wakeup(self);
+    {
+      if (!window_size_counter_suspended(&self->window_size))
+        _flow_control_resumed(self);
+      log_source_wakeup(self);
+    }
 }
 
 static void
@@ -195,6 +228,7 @@ log_source_flow_control_suspend(LogSource *self)
             evt_tag_str("function", __FUNCTION__));
 
   window_size_counter_suspend(&self->window_size);
+  _flow_control_suspended(self);
 }
 
 void
@@ -260,7 +294,11 @@ _inc_balanced(LogSource *self, gsize inc)
   gsize old_window_size = window_size_counter_add(&self->window_size, offered_dynamic, NULL);
   stats_counter_add(self->metrics.stat_window_size, offered_dynamic);
   if (old_window_size == 0 && offered_dynamic != 0)
-    log_source_wakeup(self);
+    {
+      if (!window_size_counter_suspended(&self->window_size))
+        _flow_control_resumed(self);
+      log_source_wakeup(self);
+    }
 }
 
 static void
@@ -360,9 +398,14 @@ log_source_dynamic_window_realloc(LogSource *self)
   /* it is safe to assume that the window size is not decremented while this function runs,
    * only incrementation is possible by destination threads */
 
+  gsize old_full_window_size = self->full_window_size;
+
   if (!_reclaim_window_instead_of_rebalance(self))
     _dynamic_window_rebalance(self);
 
+  if (self->full_window_size != old_full_window_size)
+    stats_counter_inc(self->metrics.window_reallocations);
+
   dynamic_window_stat_reset(&self->dynamic_window.stat);
 }
 
@@ -473,6 +516,33 @@ _unregister_raw_bytes_stats(LogSource *self)
   stats_byte_counter_deinit(&self->metrics.recvd_bytes, self->metrics.recvd_bytes_key);
 }
 
+static void
+_register_flow_control_stats(LogSource *self, gint stats_level)
+{
+  stats_register_counter(stats_level, self->metrics.flow_control_suspensions_key, SC_TYPE_SINGLE_VALUE,
+                         &self->metrics.flow_control_suspensions);
+  stats_register_counter(stats_level, self->metrics.flow_control_suspended_time_key, SC_TYPE_SINGLE_VALUE,
+                         &self->metrics.flow_control_suspended_time);
+
+  if (dynamic_window_is_enabled(&self->dynamic_window))
+    stats_register_counter(stats_level, self->metrics.window_reallocations_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.window_reallocations);
+}
+
+static void
+_unregister_flow_control_stats(LogSource *self)
+{
+  _flow_control_resumed(self);
+
+  stats_unregister_counter(self->metrics.flow_control_suspensions_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.flow_control_suspensions);
+  stats_unregister_counter(self->metrics.flow_control_suspended_time_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.flow_control_suspended_time);
+
+  stats_unregister_counter(self->metrics.window_reallocations_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.window_reallocations);
+}
+
 static void
 _register_counters(LogSource *self)
 {
@@ -492,6 +562,7 @@ _register_counters(LogSource *self)
   stats_register_counter(level, &sc_key, SC_TYPE_STAMP, &self->metrics.last_message_seen);
 
   _register_window_stats(self);
+  _register_flow_control_stats(self, level);
 
   stats_unlock();
 
@@ -534,6 +605,8 @@ _unregister_counters(LogSource *self)
                                        instance_name);
   stats_unregister_counter(&sc_key, SC_TYPE_STAMP, &self->metrics.last_message_seen);
 
+  _unregister_flow_control_stats(self);
+
   stats_unlock();
 }
 
@@ -570,6 +643,12 @@ log_source_post(LogSource *self, LogMessage *msg)
       msg_debug("Source has been suspended",
                 log_pipe_location_tag(&self->super),
                 evt_tag_str("function", __FUNCTION__));
+
+      _flow_control_suspended(self);
+
+      /* a destination may have freed up the window before we started the clock */
+      if (!window_size_counter_suspended(&self->window_size))
+        _flow_control_resumed(self);
     }
 
   /*
@@ -660,6 +739,9 @@ log_source_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options
 
   msg_stats_update_counters(self->stats_id, msg);
 
+  if (G_UNLIKELY(path_tracer_running))
+    path_tracer_sample(s, msg);
+
   /* message setup finished, send it out */
 
   guint64 rcptid = msg->rcptid;
@@ -741,6 +823,28 @@ _set_metric_options(LogSource *self, const gchar *stats_id, StatsClusterKeyBuild
     self->metrics.recvd_bytes_key = stats_cluster_key_builder_build_single(self->metrics.stats_kb);
   }
   stats_cluster_key_builder_pop(self->metrics.stats_kb);
+
+  stats_cluster_key_builder_push(self->metrics.stats_kb);
+  {
+    stats_cluster_key_builder_add_label(self->metrics.stats_kb, stats_cluster_label("id", self->stats_id));
+
+    stats_cluster_key_builder_set_name(self->metrics.stats_kb, "input_flow_control_suspensions_total");
+    if (self->metrics.flow_control_suspensions_key)
+      stats_cluster_key_free(self->metrics.flow_control_suspensions_key);
+    self->metrics.flow_control_suspensions_key = stats_cluster_key_builder_build_single(self->metrics.stats_kb);
+
+    stats_cluster_key_builder_set_name(self->metrics.stats_kb, "input_window_reallocations_total");
+    if (self->metrics.window_reallocations_key)
+      stats_cluster_key_free(self->metrics.window_reallocations_key);
+    self->metrics.window_reallocations_key = stats_cluster_key_builder_build_single(self->metrics.stats_kb);
+
+    stats_cluster_key_builder_set_name(self->metrics.stats_kb, "input_flow_control_suspended_seconds_total");
+    stats_cluster_key_builder_set_unit(self->metrics.stats_kb, SCU_MILLISECONDS);
+    if (self->metrics.flow_control_suspended_time_key)
+      stats_cluster_key_free(self->metrics.flow_control_suspended_time_key);
+    self->metrics.flow_control_suspended_time_key = stats_cluster_key_builder_build_single(self->metrics.stats_kb);
+  }
+  stats_cluster_key_builder_pop(self->metrics.stats_kb);
 }
 
 void
@@ -814,6 +918,15 @@ log_source_free(LogPipe *s)
   if (self->metrics.recvd_bytes_key)
     stats_cluster_key_free(self->metrics.recvd_bytes_key);
 
+  if (self->metrics.flow_control_suspensions_key)
+    stats_cluster_key_free(self->metrics.flow_control_suspensions_key);
+
+  if (self->metrics.flow_control_suspended_time_key)
+    stats_cluster_key_free(self->metrics.flow_control_suspended_time_key);
+
+  if (self->metrics.window_reallocations_key)
+    stats_cluster_key_free(self->metrics.window_reallocations_key);
+
   log_pipe_detach_expr_node(&self->super);
   log_pipe_free_method(s);
 
@@ -77,6 +77,8 @@ struct _LogSource
   gsize full_window_size;
   atomic_gssize window_size_to_be_reclaimed;
   atomic_gssize pending_reclaimed;
+  /* monotonic time in msec when flow-control suspended the source, 0 if it is not suspended */
+  atomic_gssize suspended_since;
 
   struct
   {
@@ -92,6 +94,15 @@ struct _LogSource
     StatsClusterKey *recvd_bytes_key;
     StatsByteCounter recvd_bytes;
 
+    StatsClusterKey *flow_control_suspensions_key;
+    StatsCounterItem *flow_control_suspensions;
+
+    StatsClusterKey *flow_control_suspended_time_key;
+    StatsCounterItem *flow_control_suspended_time;
+
+    StatsClusterKey *window_reallocations_key;
+    StatsCounterItem *window_reallocations;
+
     StatsCluster *stat_window_size_cluster;
     StatsCluster *stat_full_window_cluster;
   } metrics;
@@ -26,16 +26,53 @@
 #include "stats/stats-cluster-single.h"
 #include "stats/aggregator/stats-aggregator-registry.h"
 #include "logthrdestdrv.h"
+#include "logqueue-fifo.h"
 #include "seqnum.h"
 #include "scratch-buffers.h"
 #include "template/eval.h"
 #include "mainloop-threaded-worker.h"
+#include "compat/time.h"
 
 #include <string.h>
 
 #define MAX_RETRIES_ON_ERROR_DEFAULT 3
 #define MAX_RETRIES_BEFORE_SUSPEND_DEFAULT 3
 
+/* worker-partition-rebalance(yes): partitions are hashed into a fixed
+ * number of slots, each packing the number of in-flight messages of the
+ * slot and the index of the worker they were dispatched to (+1, zero
+ * meaning "never dispatched") into a single atomic value */
+#define PARTITION_SLOTS 4096
+#define PARTITION_SLOT_WORKER_BITS 10
+#define PARTITION_SLOT_WORKER_MASK ((1 << PARTITION_SLOT_WORKER_BITS) - 1)
+#define PARTITION_SLOT_MAX_WORKERS PARTITION_SLOT_WORKER_MASK
+
+static inline gssize
+_partition_slot_pending(gssize slot_value)
+{
+  return slot_value >> PARTITION_SLOT_WORKER_BITS;
+}
+
+static inline gint
+_partition_slot_worker_index(gssize slot_value)
+{
+  return (gint) (slot_value & PARTITION_SLOT_WORKER_MASK) - 1;
+}
+
+static inline gssize
+_partition_slot_value(gssize pending, gint worker_index)
+{
+  return (pending << PARTITION_SLOT_WORKER_BITS) | (worker_index + 1);
+}
+
+static inline gint
+_partition_slot_index(LogThreadedDestDriver *self, LogMessage *msg)
+{
+  LogTemplateEvalOptions options = DEFAULT_TEMPLATE_EVAL_OPTIONS;
+
+  return log_template_hash(self->worker_partition_key, msg, &options) & (PARTITION_SLOTS - 1);
+}
+
 const gchar *
 log_threaded_result_to_str(LogThreadedResult self)
 {
@@ -54,6 +91,71 @@ log_threaded_result_to_str(LogThreadedResult self)
   return as_str[self];
 }
 
+static const gchar *
+_worker_state_to_str(LogThreadedDestWorkerState state)
+{
+  g_assert(state < LTWS_MAX);
+
+  static const gchar *as_str[] = { "connected",
+                                   "suspended",
+                                   "flushing",
+                                 };
+
+  return as_str[state];
+}
+
+/* NOTE: runs in the worker thread */
+static void
+_account_state_time(LogThreadedDestWorker *self, LogThreadedDestWorkerState state, const struct timespec *now)
+{
+  struct timespec *since = &self->metrics.state_since[state];
+  gint64 elapsed_nsec = (gint64) (now->tv_sec - since->tv_sec) * 1000000000 + (now->tv_nsec - since->tv_nsec)
+                        + self->metrics.state_time_residual_nsec[state];
+
+  stats_counter_add(self->metrics.state_time[state], elapsed_nsec / 1000000);
+  self->metrics.state_time_residual_nsec[state] = elapsed_nsec % 1000000;
+  *since = *now;
+}
+
+void
+log_threaded_dest_worker_enter_state(LogThreadedDestWorker *self, LogThreadedDestWorkerState state)
+{
+  if (!self->metrics.state_time[state] || self->metrics.in_state[state])
+    return;
+
+  clock_gettime(CLOCK_MONOTONIC, &self->metrics.state_since[state]);
+  self->metrics.in_state[state] = TRUE;
+}
+
+void
+log_threaded_dest_worker_leave_state(LogThreadedDestWorker *self, LogThreadedDestWorkerState state)
+{
+  if (!self->metrics.in_state[state])
+    return;
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  _account_state_time(self, state, &now);
+  self->metrics.in_state[state] = FALSE;
+}
+
+/* accounts the time of the ongoing states, so that long lasting ones show up in the counters */
+static void
+_update_state_time(LogThreadedDestWorker *self)
+{
+  struct timespec now = { 0 };
+
+  for (gint state = 0; state < LTWS_MAX; state++)
+    {
+      if (!self->metrics.in_state[state])
+        continue;
+
+      if (now.tv_sec == 0 && now.tv_nsec == 0)
+        clock_gettime(CLOCK_MONOTONIC, &now);
+      _account_state_time(self, state, &now);
+    }
+}
+
 
 void
 log_threaded_dest_driver_set_batch_lines(LogDriver *s, gint batch_lines)
@@ -98,12 +200,143 @@ log_threaded_dest_driver_process_flag(LogDriver *s, const gchar *flag)
 
 /* LogThreadedDestWorker */
 
+/* only called for slots that have in-flight messages, so the worker index is kept */
+static inline void
+_acquire_partition_slot(LogThreadedDestDriver *self, gint slot_index)
+{
+  atomic_gssize_add(&self->dispatch.partition_slots[slot_index], (gssize) 1 << PARTITION_SLOT_WORKER_BITS);
+}
+
+static inline void
+_release_partition_slot(LogThreadedDestDriver *self, gint slot_index)
+{
+  atomic_gssize_sub(&self->dispatch.partition_slots[slot_index], (gssize) 1 << PARTITION_SLOT_WORKER_BITS);
+}
+
+/* The queued table maps each message in the queue to the slot it was
+ * dispatched with (low bits) and to the number of its copies in the queue
+ * (high bits), as the same message can be dispatched more than once.  The
+ * slot is never recomputed, as the partition key can be formatted
+ * differently by the time the message is popped (e.g. it depends on the
+ * current time). */
+static void
+_record_queued_partitioned_message(LogThreadedDestWorker *self, LogMessage *msg, gint slot_index)
+{
+  g_mutex_lock(&self->partitioning.lock);
+
+  gsize value = GPOINTER_TO_SIZE(g_hash_table_lookup(self->partitioning.queued, msg));
+  if (!value)
+    {
+      value = slot_index;
+    }
+  else if ((gint) (value & (PARTITION_SLOTS - 1)) != slot_index)
+    {
+      /* account the copy in the slot of the queued one, which keeps that
+       * slot on this worker */
+      _release_partition_slot(self->owner, slot_index);
+      _acquire_partition_slot(self->owner, value & (PARTITION_SLOTS - 1));
+    }
+  g_hash_table_insert(self->partitioning.queued, msg, GSIZE_TO_POINTER(value + PARTITION_SLOTS));
+
+  g_mutex_unlock(&self->partitioning.lock);
+}
+
+/* returns -1 for messages that were not dispatched to this worker */
+static gint
+_take_queued_partitioned_message(LogThreadedDestWorker *self, LogMessage *msg)
+{
+  gint slot_index = -1;
+
+  g_mutex_lock(&self->partitioning.lock);
+
+  gsize value = GPOINTER_TO_SIZE(g_hash_table_lookup(self->partitioning.queued, msg));
+  if (value)
+    {
+      slot_index = value & (PARTITION_SLOTS - 1);
+      value -= PARTITION_SLOTS;
+
+      if (value < PARTITION_SLOTS)
+        g_hash_table_remove(self->partitioning.queued, msg);
+      else
+        g_hash_table_insert(self->partitioning.queued, msg, GSIZE_TO_POINTER(value));
+    }
+
+  g_mutex_unlock(&self->partitioning.lock);
+  return slot_index;
+}
+
+static void
+_complete_partitioned_message(LogThreadedDestWorker *self, gint slot_index)
+{
+  _release_partition_slot(self->owner, slot_index);
+  atomic_gssize_dec(&self->partitioning.pending);
+  stats_counter_dec(self->metrics.pending_events);
+}
+
+/* messages dropped by the queue itself (e.g. when it is full) are never
+ * popped, runs in the thread pushing to the queue */
+static void
+_on_partitioned_message_dropped(LogMessage *msg, gpointer user_data)
+{
+  LogThreadedDestWorker *self = (LogThreadedDestWorker *) user_data;
+  gint slot_index = _take_queued_partitioned_message(self, msg);
+
+  if (slot_index >= 0)
+    _complete_partitioned_message(self, slot_index);
+}
+
+static void
+_track_popped_partitioned_message(LogThreadedDestWorker *self, LogMessage *msg)
+{
+  if (!self->owner->worker_partition_rebalance)
+    return;
+
+  /* a rewound message is popped again, its slot is already recorded */
+  if (self->partitioning.popped < self->partitioning.slots->len)
+    {
+      self->partitioning.popped++;
+      return;
+    }
+
+  gint slot_index = _take_queued_partitioned_message(self, msg);
+  g_array_append_val(self->partitioning.slots, slot_index);
+  self->partitioning.popped++;
+}
+
+static void
+_complete_partitioned_messages(LogThreadedDestWorker *self, gint batch_size)
+{
+  if (!self->owner->worker_partition_rebalance)
+    return;
+
+  guint completed = MIN((guint) batch_size, self->partitioning.popped);
+  for (guint i = 0; i < completed; i++)
+    {
+      gint slot_index = g_array_index(self->partitioning.slots, gint, i);
+      if (slot_index >= 0)
+        _complete_partitioned_message(self, slot_index);
+    }
+
+  g_array_remove_range(self->partitioning.slots, 0, completed);
+  self->partitioning.popped -= completed;
+}
+
+static inline void
+_rewind_partitioned_messages(LogThreadedDestWorker *self, gint batch_size)
+{
+  if (!self->owner->worker_partition_rebalance)
+    return;
+
+  self->partitioning.popped -= MIN((guint) batch_size, self->partitioning.popped);
+}
+
 /* this should be used in combination with LTR_EXPLICIT_ACK_MGMT to actually confirm message delivery. */
 void
 log_threaded_dest_worker_ack_messages(LogThreadedDestWorker *self, gint batch_size)
 {
   log_queue_ack_backlog(self->queue, batch_size);
   stats_counter_add(self->owner->metrics.written_messages, batch_size);
+  _complete_partitioned_messages(self, batch_size);
   self->retries_on_error_counter = 0;
   self->batch_size -= batch_size;
 }
@@ -113,6 +346,7 @@ log_threaded_dest_worker_drop_messages(LogThreadedDestWorker *self, gint batch_s
 {
   log_queue_ack_backlog(self->queue, batch_size);
   stats_counter_add(self->owner->metrics.dropped_messages, batch_size);
+  _complete_partitioned_messages(self, batch_size);
   self->retries_on_error_counter = 0;
   self->batch_size -= batch_size;
 }
@@ -121,10 +355,21 @@ void
 log_threaded_dest_worker_rewind_messages(LogThreadedDestWorker *self, gint batch_size)
 {
   log_queue_rewind_backlog(self->queue, batch_size);
+  _rewind_partitioned_messages(self, batch_size);
   self->rewound_batch_size = self->batch_size;
   self->batch_size -= batch_size;
 }
 
+LogMessage *
+log_threaded_dest_worker_pop_message(LogThreadedDestWorker *self, LogPathOptions *path_options)
+{
+  LogMessage *msg = log_queue_pop_head(self->queue, path_options);
+
+  if (msg)
+    _track_popped_partitioned_message(self, msg);
+  return msg;
+}
+
 static gchar *
 _format_queue_persist_name(LogThreadedDestWorker *self)
 {
@@ -216,6 +461,7 @@ static void
 _suspend(LogThreadedDestWorker *self)
 {
   self->suspended = TRUE;
+  log_threaded_dest_worker_enter_state(self, LTWS_SUSPENDED);
 }
 
 /* NOTE: runs in the worker thread */
@@ -477,7 +723,7 @@ _perform_inserts(LogThreadedDestWorker *self)
             }
         }
 
-      LogMessage *msg = log_queue_pop_head(self->queue, &path_options);
+      LogMessage *msg = log_threaded_dest_worker_pop_message(self, &path_options);
       if (!msg)
         {
           scratch_buffers_reclaim_marked(mark);
@@ -582,6 +828,8 @@ _perform_work(gpointer data)
   gint timeout_msec = 0;
 
   self->suspended = FALSE;
+  log_threaded_dest_worker_leave_state(self, LTWS_SUSPENDED);
+  _update_state_time(self);
   main_loop_worker_run_gc();
   _stop_watches(self);
 
@@ -735,6 +983,7 @@ _perform_final_flush(LogThreadedDestWorker *self)
   result = log_threaded_dest_worker_flush(self, mode);
   _process_result(self, result);
   log_queue_rewind_backlog_all(self->queue);
+  _rewind_partitioned_messages(self, self->partitioning.popped);
 }
 
 static gboolean
@@ -780,6 +1029,7 @@ _worker_thread(MainLoopThreadedWorker *s)
   _perform_final_flush(self);
 
   _disconnect(self);
+  log_threaded_dest_worker_leave_state(self, LTWS_SUSPENDED);
 
   msg_debug("Dedicated worker thread finished",
             evt_tag_int("worker_index", self->worker_index),
@@ -841,6 +1091,46 @@ _init_worker_sck_builder(LogThreadedDestWorker *self, StatsClusterKeyBuilder *bu
   stats_cluster_key_builder_add_label(builder, stats_cluster_label("worker", worker_index_str));
 }
 
+static gboolean
+_init_partition_tracking(LogThreadedDestWorker *self)
+{
+  /* the dispatched messages are looked up by their address when popped,
+   * which does not survive serialization */
+  if (!log_queue_has_type(self->queue, log_queue_fifo_get_type()))
+    {
+      msg_error("worker-partition-rebalance() can only be used with memory queues, disable disk-buffer()",
+                log_expr_node_location_tag(self->owner->super.super.super.expr_node));
+      return FALSE;
+    }
+
+  /* messages kept from the previous configuration (including the backlog)
+   * were not dispatched to this worker, they are popped again and
+   * completing them does not release any partition slot */
+  log_queue_rewind_backlog_all(self->queue);
+  g_mutex_init(&self->partitioning.lock);
+  self->partitioning.queued = g_hash_table_new(NULL, NULL);
+  self->partitioning.slots = g_array_new(FALSE, FALSE, sizeof(gint));
+  self->partitioning.popped = 0;
+  atomic_gssize_set(&self->partitioning.pending, 0);
+  log_queue_set_drop_notify(self->queue, _on_partitioned_message_dropped, self);
+  return TRUE;
+}
+
+static void
+_deinit_partition_tracking(LogThreadedDestWorker *self)
+{
+  if (!self->partitioning.queued)
+    return;
+
+  /* the queue may outlive this worker */
+  log_queue_set_drop_notify(self->queue, NULL, NULL);
+  g_hash_table_destroy(self->partitioning.queued);
+  self->partitioning.queued = NULL;
+  g_mutex_clear(&self->partitioning.lock);
+  g_array_free(self->partitioning.slots, TRUE);
+  self->partitioning.slots = NULL;
+}
+
 static gboolean
 _acquire_worker_queue(LogThreadedDestWorker *self, gint stats_level, StatsClusterKeyBuilder *driver_sck_builder)
 {
@@ -857,6 +1147,9 @@ _acquire_worker_queue(LogThreadedDestWorker *self, gint stats_level, StatsCluste
   if (!self->queue)
     return FALSE;
 
+  if (self->owner->worker_partition_rebalance)
+    return _init_partition_tracking(self);
+
   return TRUE;
 }
 
@@ -877,6 +1170,32 @@ _register_worker_stats(LogThreadedDestWorker *self)
   }
   stats_cluster_key_builder_pop(kb);
 
+  stats_cluster_key_builder_push(kb);
+  {
+    _init_worker_sck_builder(self, kb);
+    stats_cluster_key_builder_set_name(kb, "output_event_latency_seconds");
+
+    stats_lock();
+    {
+      stats_cluster_key_builder_push(kb);
+      stats_cluster_key_builder_add_label(kb, stats_cluster_label("stage", "received_to_queued"));
+      stats_histogram_register(&self->metrics.received_to_queued_latency, level, kb);
+      stats_cluster_key_builder_pop(kb);
+
+      stats_cluster_key_builder_push(kb);
+      stats_cluster_key_builder_add_label(kb, stats_cluster_label("stage", "received_to_sent"));
+      stats_histogram_register(&self->metrics.received_to_sent_latency, level, kb);
+      stats_cluster_key_builder_pop(kb);
+
+      stats_cluster_key_builder_push(kb);
+      stats_cluster_key_builder_add_label(kb, stats_cluster_label("stage", "sent_to_acked"));
+      stats_histogram_register(&self->metrics.sent_to_acked_latency, level, kb);
+      stats_cluster_key_builder_pop(kb);
+    }
+    stats_unlock();
+  }
+  stats_cluster_key_builder_pop(kb);
+
   stats_cluster_key_builder_push(kb);
   {
     _init_worker_sck_builder(self, kb);
@@ -901,11 +1220,41 @@ _register_worker_stats(LogThreadedDestWorker *self)
       self->metrics.message_delay_sample_age_key = stats_cluster_key_builder_build_single(kb);
       stats_register_counter(level, self->metrics.message_delay_sample_age_key, SC_TYPE_SINGLE_VALUE,
                              &self->metrics.message_delay_sample_age);
+
+      if (self->owner->worker_partition_rebalance)
+        {
+          stats_cluster_key_builder_set_name(kb, "output_worker_pending_events");
+          stats_cluster_key_builder_set_unit(kb, SCU_NONE);
+          stats_cluster_key_builder_set_frame_of_reference(kb, SCFOR_NONE);
+          self->metrics.pending_events_key = stats_cluster_key_builder_build_single(kb);
+          stats_register_counter(level, self->metrics.pending_events_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.pending_events);
+        }
     }
     stats_unlock();
   }
   stats_cluster_key_builder_pop(kb);
 
+  stats_cluster_key_builder_push(kb);
+  {
+    _init_worker_sck_builder(self, kb);
+    stats_cluster_key_builder_set_name(kb, "output_worker_state_seconds_total");
+    stats_cluster_key_builder_set_unit(kb, SCU_MILLISECONDS);
+
+    stats_lock();
+    for (gint state = 0; state < LTWS_MAX; state++)
+      {
+        stats_cluster_key_builder_push(kb);
+        stats_cluster_key_builder_add_label(kb, stats_cluster_label("state", _worker_state_to_str(state)));
+        self->metrics.state_time_keys[state] = stats_cluster_key_builder_build_single(kb);
+        stats_register_counter(level, self->metrics.state_time_keys[state], SC_TYPE_SINGLE_VALUE,
+                               &self->metrics.state_time[state]);
+        stats_cluster_key_builder_pop(kb);
+      }
+    stats_unlock();
+  }
+  stats_cluster_key_builder_pop(kb);
+
   UnixTime now;
   unix_time_set_now(&now);
   stats_counter_set_time(self->metrics.message_delay_sample_age, now.ut_sec);
@@ -949,6 +1298,30 @@ _unregister_worker_stats(LogThreadedDestWorker *self)
         stats_cluster_key_free(self->metrics.message_delay_sample_age_key);
         self->metrics.message_delay_sample_age_key = NULL;
       }
+
+    if (self->metrics.pending_events_key)
+      {
+        stats_unregister_counter(self->metrics.pending_events_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.pending_events);
+        stats_cluster_key_free(self->metrics.pending_events_key);
+        self->metrics.pending_events_key = NULL;
+      }
+
+    stats_histogram_unregister(&self->metrics.received_to_queued_latency);
+    stats_histogram_unregister(&self->metrics.received_to_sent_latency);
+    stats_histogram_unregister(&self->metrics.sent_to_acked_latency);
+
+    for (gint state = 0; state < LTWS_MAX; state++)
+      {
+        if (!self->metrics.state_time_keys[state])
+          continue;
+
+        stats_unregister_counter(self->metrics.state_time_keys[state], SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.state_time[state]);
+        stats_cluster_key_free(self->metrics.state_time_keys[state]);
+        self->metrics.state_time_keys[state] = NULL;
+        self->metrics.in_state[state] = FALSE;
+      }
   }
   stats_unlock();
 
@@ -977,6 +1350,7 @@ void
 log_threaded_dest_worker_free_method(LogThreadedDestWorker *self)
 {
   _unregister_worker_stats(self);
+  _deinit_partition_tracking(self);
 
   main_loop_threaded_worker_clear(&self->thread);
 }
@@ -997,6 +1371,8 @@ log_threaded_dest_worker_init_instance(LogThreadedDestWorker *self, LogThreadedD
   self->time_reopen = -1;
 
   self->partitioning.last_key = NULL;
+  self->partitioning.queued = NULL;
+  self->partitioning.slots = NULL;
 
   _init_watches(self);
 
@@ -1039,6 +1415,14 @@ log_threaded_dest_driver_set_flush_on_worker_key_change(LogDriver *s, gboolean f
   self->flush_on_key_change = f;
 }
 
+void
+log_threaded_dest_driver_set_worker_partition_rebalance(LogDriver *s, gboolean rebalance)
+{
+  LogThreadedDestDriver *self = (LogThreadedDestDriver *) s;
+
+  self->worker_partition_rebalance = rebalance;
+}
+
 /* compatibility bridge between LogThreadedDestWorker */
 
 static gboolean
@@ -1135,6 +1519,101 @@ log_threaded_dest_driver_set_max_retries_on_error(LogDriver *s, gint max_retries
   self->retries_on_error_max = max_retries;
 }
 
+/*
+ * Partition rebalancing
+ *
+ * With worker-partition-rebalance(yes) the partition key is not mapped to a
+ * fixed worker.  Instead, each partition (identified by the hash of the
+ * partition key) sticks to the worker it was last dispatched to as long as
+ * that worker still has messages of the partition in flight, which keeps
+ * per-partition ordering intact.  Once the worker has completed all of them,
+ * the partition is free to move and is handed to the least loaded worker,
+ * so idle workers pick up the partitions of busy ones.
+ *
+ * Partitions are hashed into PARTITION_SLOTS slots, partitions sharing a
+ * slot move together.  The slot is updated with compare-and-exchange, so
+ * source threads dispatch without a global lock.  The slot chosen at
+ * dispatch time is recorded for each queued message, the worker releases
+ * it once the message is acked or dropped, or when the queue drops the
+ * message by itself (e.g. on overflow).
+ *
+ * Queued messages are never moved between workers: a partition only moves
+ * once it has no messages in flight, so hot partitions sharing a worker
+ * stay there as long as they are continuously fed.
+ */
+static inline gssize
+_worker_pending_messages(LogThreadedDestWorker *dw)
+{
+  return atomic_gssize_get(&dw->partitioning.pending);
+}
+
+static gint
+_find_least_loaded_worker(LogThreadedDestDriver *self, gint preferred_worker_index)
+{
+  gint best_index = preferred_worker_index >= 0 ? preferred_worker_index : 0;
+  gssize best_pending = _worker_pending_messages(self->workers[best_index]);
+
+  for (gint i = 0; i < self->num_workers && best_pending > 0; i++)
+    {
+      gssize pending = _worker_pending_messages(self->workers[i]);
+      if (pending < best_pending)
+        {
+          best_index = i;
+          best_pending = pending;
+        }
+    }
+  return best_index;
+}
+
+static LogThreadedDestWorker *
+_dispatch_partition(LogThreadedDestDriver *self, LogMessage *msg)
+{
+  gint slot_index = _partition_slot_index(self, msg);
+  atomic_gssize *slot = &self->dispatch.partition_slots[slot_index];
+  gssize old_value, new_value;
+  gint last_worker_index, worker_index;
+
+  do
+    {
+      old_value = atomic_gssize_get(slot);
+      gssize pending = _partition_slot_pending(old_value);
+
+      last_worker_index = _partition_slot_worker_index(old_value);
+      if (last_worker_index < 0 || pending == 0)
+        worker_index = _find_least_loaded_worker(self, last_worker_index);
+      else
+        worker_index = last_worker_index;
+
+      new_value = _partition_slot_value(pending + 1, worker_index);
+    }
+  while (!atomic_gssize_compare_and_exchange(slot, old_value, new_value));
+
+  if (last_worker_index >= 0 && last_worker_index != worker_index)
+    stats_counter_inc(self->metrics.partition_migrations);
+
+  LogThreadedDestWorker *dw = self->workers[worker_index];
+  _record_queued_partitioned_message(dw, msg, slot_index);
+  atomic_gssize_inc(&dw->partitioning.pending);
+  stats_counter_inc(dw->metrics.pending_events);
+  return dw;
+}
+
+static void
+_init_partition_dispatch(LogThreadedDestDriver *self)
+{
+  if (!self->worker_partition_rebalance)
+    return;
+
+  self->dispatch.partition_slots = g_new0(atomic_gssize, PARTITION_SLOTS);
+}
+
+static void
+_deinit_partition_dispatch(LogThreadedDestDriver *self)
+{
+  g_free(self->dispatch.partition_slots);
+  self->dispatch.partition_slots = NULL;
+}
+
 LogThreadedDestWorker *
 _lookup_worker(LogThreadedDestDriver *self, LogMessage *msg)
 {
@@ -1158,15 +1637,23 @@ log_threaded_dest_driver_queue(LogPipe *s, LogMessage *msg,
                                const LogPathOptions *path_options)
 {
   LogThreadedDestDriver *self = (LogThreadedDestDriver *)s;
-  LogThreadedDestWorker *dw = _lookup_worker(self, msg);
   LogPathOptions local_path_options;
 
   if (!path_options->flow_control_requested)
     path_options = log_msg_break_ack(msg, path_options, &local_path_options);
 
   log_msg_add_ack(msg, path_options);
+
+  LogThreadedDestWorker *dw;
+  if (self->worker_partition_rebalance)
+    dw = _dispatch_partition(self, msg);
+  else
+    dw = _lookup_worker(self, msg);
+
   log_queue_push_tail(dw->queue, log_msg_ref(msg), path_options);
 
+  stats_histogram_sample_elapsed(&dw->metrics.received_to_queued_latency, &msg->timestamps[LM_TS_RECVD]);
+
   stats_counter_inc(self->metrics.processed_messages);
 
   log_dest_driver_queue_method(s, msg, path_options);
@@ -1268,6 +1755,18 @@ _register_driver_stats(LogThreadedDestDriver *self, StatsClusterKeyBuilder *driv
   }
   stats_cluster_key_builder_pop(driver_sck_builder);
 
+  if (self->worker_partition_rebalance)
+    {
+      stats_cluster_key_builder_push(driver_sck_builder);
+      {
+        stats_cluster_key_builder_set_name(driver_sck_builder, "output_worker_partition_migrations_total");
+        stats_cluster_key_builder_set_legacy_alias(driver_sck_builder, -1, "", "");
+        stats_cluster_key_builder_set_legacy_alias_name(driver_sck_builder, "");
+        self->metrics.partition_migrations_sc_key = stats_cluster_key_builder_build_single(driver_sck_builder);
+      }
+      stats_cluster_key_builder_pop(driver_sck_builder);
+    }
+
   stats_cluster_key_builder_push(driver_sck_builder);
   {
     stats_cluster_key_builder_set_legacy_alias(driver_sck_builder, self->stats_source | SCS_DESTINATION,
@@ -1286,6 +1785,10 @@ _register_driver_stats(LogThreadedDestDriver *self, StatsClusterKeyBuilder *driv
                            &self->metrics.processed_messages);
     stats_register_counter(level, self->metrics.output_event_retries_sc_key, SC_TYPE_SINGLE_VALUE,
                            &self->metrics.output_event_retries);
+
+    if (self->metrics.partition_migrations_sc_key)
+      stats_register_counter(level, self->metrics.partition_migrations_sc_key, SC_TYPE_SINGLE_VALUE,
+                             &self->metrics.partition_migrations);
   }
   stats_unlock();
 }
@@ -1330,6 +1833,15 @@ _unregister_driver_stats(LogThreadedDestDriver *self)
         stats_cluster_key_free(self->metrics.output_event_retries_sc_key);
         self->metrics.output_event_retries_sc_key = NULL;
       }
+
+    if (self->metrics.partition_migrations_sc_key)
+      {
+        stats_unregister_counter(self->metrics.partition_migrations_sc_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.partition_migrations);
+
+        stats_cluster_key_free(self->metrics.partition_migrations_sc_key);
+        self->metrics.partition_migrations_sc_key = NULL;
+      }
   }
   stats_unlock();
 }
@@ -1404,6 +1916,24 @@ log_threaded_dest_driver_init_method(LogPipe *s)
       return FALSE;
     }
 
+  if (self->worker_partition_rebalance && !self->worker_partition_key)
+    {
+      msg_error("worker-partition-rebalance() requires worker-partition-key() to be set",
+                log_expr_node_location_tag(self->super.super.super.expr_node));
+      return FALSE;
+    }
+
+  if (self->worker_partition_rebalance && self->num_workers > PARTITION_SLOT_MAX_WORKERS)
+    {
+      msg_error("worker-partition-rebalance() supports a limited number of workers",
+                evt_tag_int("workers", self->num_workers),
+                evt_tag_int("max_workers", PARTITION_SLOT_MAX_WORKERS),
+                log_expr_node_location_tag(self->super.super.super.expr_node));
+      return FALSE;
+    }
+
+  _init_partition_dispatch(self);
+
   StatsClusterKeyBuilder *driver_sck_builder = stats_cluster_key_builder_new();
   _init_driver_sck_builder(self, driver_sck_builder);
 
@@ -1477,6 +2007,7 @@ log_threaded_dest_driver_deinit_method(LogPipe *s)
   _unregister_driver_stats(self);
 
   _destroy_workers(self);
+  _deinit_partition_dispatch(self);
 
   return log_dest_driver_deinit_method(s);
 }
@@ -31,11 +31,13 @@
 #include "stats/aggregator/stats-aggregator.h"
 #include "stats/stats-compat.h"
 #include "stats/stats-cluster-key-builder.h"
+#include "stats/stats-histogram.h"
 #include "logqueue.h"
 #include "seqnum.h"
 #include "mainloop-threaded-worker.h"
 #include "timeutils/misc.h"
 #include "template/templates.h"
+#include "atomic-gssize.h"
 
 #include <iv.h>
 #include <iv_event.h>
@@ -71,6 +73,15 @@ enum
   /* NOTE: everything >= 0x1000 is driver specific */
 };
 
+/* states whose duration is measured, flushing overlaps with connected */
+typedef enum
+{
+  LTWS_CONNECTED,
+  LTWS_SUSPENDED,
+  LTWS_FLUSHING,
+  LTWS_MAX
+} LogThreadedDestWorkerState;
+
 typedef struct _LogThreadedDestDriver LogThreadedDestDriver;
 typedef struct _LogThreadedDestWorker LogThreadedDestWorker;
 
@@ -102,6 +113,19 @@ struct _LogThreadedDestWorker
   struct
   {
     GString *last_key;
+
+    /* worker-partition-rebalance(yes): the partition slot chosen at
+     * dispatch time for each message sitting in the queue (protected by
+     * lock), the slot of each message popped from the queue but not yet
+     * acked/dropped (-1 for messages that were not dispatched to this
+     * worker, e.g. restored from a persisted queue), number of those
+     * entries currently popped (the rest were rewound), and the number of
+     * messages dispatched to this worker and not completed yet */
+    GMutex lock;
+    GHashTable *queued;
+    GArray *slots;
+    guint popped;
+    atomic_gssize pending;
   } partitioning;
 
   struct
@@ -110,12 +134,25 @@ struct _LogThreadedDestWorker
     StatsClusterKey *output_unreachable_key;
     StatsClusterKey *message_delay_sample_key;
     StatsClusterKey *message_delay_sample_age_key;
+    StatsClusterKey *pending_events_key;
 
     StatsByteCounter written_bytes;
     StatsCounterItem *output_unreachable;
+    StatsCounterItem *pending_events;
     StatsCounterItem *message_delay_sample;
     StatsCounterItem *message_delay_sample_age;
 
+    StatsHistogram received_to_queued_latency;
+    StatsHistogram received_to_sent_latency;
+    StatsHistogram sent_to_acked_latency;
+
+    StatsClusterKey *state_time_keys[LTWS_MAX];
+    StatsCounterItem *state_time[LTWS_MAX];
+    gboolean in_state[LTWS_MAX];
+    struct timespec state_since[LTWS_MAX];
+    /* the sub-millisecond part of the time not yet added to state_time */
+    gint64 state_time_residual_nsec[LTWS_MAX];
+
     gint64 last_delay_update;
   } metrics;
 
@@ -130,6 +167,9 @@ struct _LogThreadedDestWorker
 
 const gchar *log_threaded_result_to_str(LogThreadedResult self);
 
+void log_threaded_dest_worker_enter_state(LogThreadedDestWorker *self, LogThreadedDestWorkerState state);
+void log_threaded_dest_worker_leave_state(LogThreadedDestWorker *self, LogThreadedDestWorkerState state);
+
 struct _LogThreadedDestDriver
 {
   LogDestDriver super;
@@ -139,11 +179,13 @@ struct _LogThreadedDestDriver
     StatsClusterKey *output_events_sc_key;
     StatsClusterKey *processed_sc_key;
     StatsClusterKey *output_event_retries_sc_key;
+    StatsClusterKey *partition_migrations_sc_key;
 
     StatsCounterItem *dropped_messages;
     StatsCounterItem *processed_messages;
     StatsCounterItem *written_messages;
     StatsCounterItem *output_event_retries;
+    StatsCounterItem *partition_migrations;
 
     StatsAggregator *max_message_size;
     StatsAggregator *average_messages_size;
@@ -183,6 +225,12 @@ struct _LogThreadedDestDriver
 
   gboolean flush_on_key_change;
   LogTemplate *worker_partition_key;
+  gboolean worker_partition_rebalance;
+
+  struct
+  {
+    atomic_gssize *partition_slots;
+  } dispatch;
   gint stats_source;
 
   /* this counter is not thread safe if there are multiple worker threads,
@@ -221,6 +269,8 @@ log_threaded_dest_worker_connect(LogThreadedDestWorker *self)
 
 
   stats_counter_set(self->metrics.output_unreachable, !self->connected);
+  if (self->connected)
+    log_threaded_dest_worker_enter_state(self, LTWS_CONNECTED);
   return self->connected;
 }
 
@@ -231,6 +281,7 @@ log_threaded_dest_worker_disconnect(LogThreadedDestWorker *self)
     self->disconnect(self);
   self->connected = FALSE;
   stats_counter_set(self->metrics.output_unreachable, !self->connected);
+  log_threaded_dest_worker_leave_state(self, LTWS_CONNECTED);
 }
 
 static inline LogThreadedResult
@@ -249,6 +300,9 @@ log_threaded_dest_worker_insert(LogThreadedDestWorker *self, LogMessage *msg)
 
   LogThreadedResult result = self->insert(self, msg);
 
+  if (result == LTR_QUEUED || result == LTR_SUCCESS || result == LTR_EXPLICIT_ACK_MGMT)
+    stats_histogram_sample_elapsed(&self->metrics.received_to_sent_latency, &msg->timestamps[LM_TS_RECVD]);
+
   if (self->metrics.message_delay_sample
       && (result == LTR_QUEUED || result == LTR_SUCCESS || result == LTR_EXPLICIT_ACK_MGMT))
     {
@@ -273,8 +327,24 @@ log_threaded_dest_worker_flush(LogThreadedDestWorker *self, LogThreadedFlushMode
 {
   LogThreadedResult result = LTR_SUCCESS;
 
+  /* only synchronously acknowledged batches are measured, with
+   * LTR_EXPLICIT_ACK_MGMT the ack arrives later */
+  UnixTime flush_start;
+  gboolean sampled = self->batch_size > 0 && stats_histogram_is_enabled(&self->metrics.sent_to_acked_latency)
+                     && stats_histogram_should_sample(&self->metrics.sent_to_acked_latency);
+  if (sampled)
+    unix_time_set_now(&flush_start);
+
   if (self->flush)
-    result = self->flush(self, mode);
+    {
+      log_threaded_dest_worker_enter_state(self, LTWS_FLUSHING);
+      result = self->flush(self, mode);
+      log_threaded_dest_worker_leave_state(self, LTWS_FLUSHING);
+    }
+
+  if (sampled && result == LTR_SUCCESS)
+    stats_histogram_observe_elapsed(&self->metrics.sent_to_acked_latency, &flush_start);
+
   iv_validate_now();
   self->last_flush_time = iv_now;
   return result;
@@ -290,6 +360,7 @@ log_threaded_dest_driver_flush(LogThreadedDestDriver *self)
 void log_threaded_dest_worker_ack_messages(LogThreadedDestWorker *self, gint batch_size);
 void log_threaded_dest_worker_drop_messages(LogThreadedDestWorker *self, gint batch_size);
 void log_threaded_dest_worker_rewind_messages(LogThreadedDestWorker *self, gint batch_size);
+LogMessage *log_threaded_dest_worker_pop_message(LogThreadedDestWorker *self, LogPathOptions *path_options);
 void log_threaded_dest_worker_wakeup_when_suspended(LogThreadedDestWorker *self);
 gboolean log_threaded_dest_worker_init_method(LogThreadedDestWorker *self);
 void log_threaded_dest_worker_deinit_method(LogThreadedDestWorker *self);
@@ -318,6 +389,7 @@ void log_threaded_dest_driver_set_max_retries_on_error(LogDriver *s, gint max_re
 void log_threaded_dest_driver_set_num_workers(LogDriver *s, gint num_workers);
 void log_threaded_dest_driver_set_worker_partition_key_ref(LogDriver *s, LogTemplate *key);
 void log_threaded_dest_driver_set_flush_on_worker_key_change(LogDriver *s, gboolean f);
+void log_threaded_dest_driver_set_worker_partition_rebalance(LogDriver *s, gboolean rebalance);
 void log_threaded_dest_driver_set_batch_lines(LogDriver *s, gint batch_lines);
 void log_threaded_dest_driver_set_batch_timeout(LogDriver *s, gint batch_timeout);
 void log_threaded_dest_driver_set_time_reopen(LogDriver *s, time_t time_reopen);
@@ -831,3 +831,261 @@ teardown(void)
 }
 
 TestSuite(logthrdestdrv, .init = setup, .fini = teardown);
+
+static LogThreadedResult
+_insert_partitioned_message_success(LogThreadedDestWorker *s, LogMessage *msg)
+{
+  return LTR_SUCCESS;
+}
+
+static LogThreadedDestWorker *
+_construct_partitioned_worker(LogThreadedDestDriver *s, gint worker_index)
+{
+  LogThreadedDestWorker *worker = g_new0(LogThreadedDestWorker, 1);
+
+  log_threaded_dest_worker_init_instance(worker, s, worker_index);
+  worker->insert = _insert_partitioned_message_success;
+  return worker;
+}
+
+static TestThreadedDestDriver *
+_create_rebalanced_dd(gint num_workers)
+{
+  GlobalConfig *cfg = main_loop_get_current_config(main_loop);
+  TestThreadedDestDriver *self = test_threaded_dd_new(cfg);
+
+  LogTemplate *partition_key = log_template_new(cfg, NULL);
+  cr_assert(log_template_compile(partition_key, "$HOST", NULL));
+
+  self->super.worker.construct = _construct_partitioned_worker;
+  log_threaded_dest_driver_set_num_workers(&self->super.super.super, num_workers);
+  log_threaded_dest_driver_set_worker_partition_key_ref(&self->super.super.super, partition_key);
+  log_threaded_dest_driver_set_worker_partition_rebalance(&self->super.super.super, TRUE);
+  return self;
+}
+
+static void
+_queue_message_with_host(TestThreadedDestDriver *self, const gchar *host)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT_NOACK;
+  LogMessage *msg = create_sample_message();
+
+  log_msg_set_value(msg, LM_V_HOST, host, -1);
+  log_pipe_queue(&self->super.super.super.super, msg, &path_options);
+}
+
+static gint
+_worker_queue_length(TestThreadedDestDriver *self, gint worker_index)
+{
+  return log_queue_get_length(self->super.workers[worker_index]->queue);
+}
+
+/* worker threads are not started, so nothing is consumed from the queues
+ * and the dispatch decisions are deterministic */
+Test(logthrdestdrv_partitioning, partitions_stick_to_their_worker_while_in_flight)
+{
+  TestThreadedDestDriver *rdd = _create_rebalanced_dd(2);
+  cr_assert(log_pipe_init(&rdd->super.super.super.super));
+
+  _queue_message_with_host(rdd, "hot");
+  _queue_message_with_host(rdd, "hot");
+  _queue_message_with_host(rdd, "hot");
+  _queue_message_with_host(rdd, "cold");
+  _queue_message_with_host(rdd, "hot");
+
+  cr_assert_eq(_worker_queue_length(rdd, 0), 4, "in-flight partition should not move between workers");
+  cr_assert_eq(_worker_queue_length(rdd, 1), 1, "new partition should go to the least loaded worker");
+
+  log_pipe_deinit(&rdd->super.super.super.super);
+  log_pipe_unref(&rdd->super.super.super.super);
+}
+
+static void
+_pop_message(TestThreadedDestDriver *self, gint worker_index, const gchar *expected_host)
+{
+  LogThreadedDestWorker *worker = self->super.workers[worker_index];
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  LogMessage *msg = log_threaded_dest_worker_pop_message(worker, &path_options);
+  cr_assert_not_null(msg);
+  cr_assert_str_eq(log_msg_get_value(msg, LM_V_HOST, NULL), expected_host);
+  log_msg_unref(msg);
+  worker->batch_size++;
+}
+
+static void
+_ack_messages(TestThreadedDestDriver *self, gint worker_index, gint num_messages)
+{
+  log_threaded_dest_worker_ack_messages(self->super.workers[worker_index], num_messages);
+}
+
+Test(logthrdestdrv_partitioning, drained_partitions_move_to_the_least_loaded_worker)
+{
+  TestThreadedDestDriver *rdd = _create_rebalanced_dd(2);
+  cr_assert(log_pipe_init(&rdd->super.super.super.super));
+
+  _queue_message_with_host(rdd, "first");
+  _queue_message_with_host(rdd, "second");
+
+  /* "first" is popped but not yet acked on worker#0, while worker#1 becomes idle */
+  _pop_message(rdd, 0, "first");
+  _pop_message(rdd, 1, "second");
+  _ack_messages(rdd, 1, 1);
+
+  _queue_message_with_host(rdd, "first");
+  cr_assert_eq(_worker_queue_length(rdd, 0), 1, "in-flight partition should not move to the idle worker");
+  cr_assert_eq(_worker_queue_length(rdd, 1), 0);
+  cr_assert_eq(stats_counter_get(rdd->super.metrics.partition_migrations), 0);
+
+  /* a rewound message stays in flight */
+  log_threaded_dest_worker_rewind_messages(rdd->super.workers[0], 1);
+  _pop_message(rdd, 0, "first");
+  _pop_message(rdd, 0, "first");
+  _ack_messages(rdd, 0, 2);
+
+  /* "first" is drained, make worker#0 the busier one and dispatch "first" again */
+  _queue_message_with_host(rdd, "third");
+  cr_assert_eq(_worker_queue_length(rdd, 0), 1);
+
+  _queue_message_with_host(rdd, "first");
+  _queue_message_with_host(rdd, "first");
+  cr_assert_eq(_worker_queue_length(rdd, 0), 1);
+  cr_assert_eq(_worker_queue_length(rdd, 1), 2, "drained partition should move to the least loaded worker");
+  cr_assert_eq(stats_counter_get(rdd->super.metrics.partition_migrations), 1);
+
+  _pop_message(rdd, 1, "first");
+  _pop_message(rdd, 1, "first");
+
+  log_pipe_deinit(&rdd->super.super.super.super);
+  log_pipe_unref(&rdd->super.super.super.super);
+}
+
+Test(logthrdestdrv_partitioning, restored_backlog_does_not_release_partitions)
+{
+  TestThreadedDestDriver *rdd = _create_rebalanced_dd(2);
+  cr_assert(log_pipe_init(&rdd->super.super.super.super));
+
+  /* pretend that worker#0 kept a message from the previous configuration */
+  LogThreadedDestWorker *worker = rdd->super.workers[0];
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT_NOACK;
+  LogMessage *restored = create_sample_message();
+  log_msg_set_value(restored, LM_V_HOST, "restored", -1);
+  log_queue_push_tail(worker->queue, restored, &path_options);
+
+  _queue_message_with_host(rdd, "first");
+  _queue_message_with_host(rdd, "second");
+  cr_assert_eq(_worker_queue_length(rdd, 0), 2);
+  cr_assert_eq(_worker_queue_length(rdd, 1), 1);
+
+  /* completing the restored message must not drain "first" */
+  _pop_message(rdd, 0, "restored");
+  _ack_messages(rdd, 0, 1);
+  _pop_message(rdd, 1, "second");
+  _ack_messages(rdd, 1, 1);
+
+  _queue_message_with_host(rdd, "first");
+  cr_assert_eq(_worker_queue_length(rdd, 0), 2, "partition should stay on its worker while in flight");
+  cr_assert_eq(_worker_queue_length(rdd, 1), 0);
+  cr_assert_eq(stats_counter_get(rdd->super.metrics.partition_migrations), 0);
+
+  log_pipe_deinit(&rdd->super.super.super.super);
+  log_pipe_unref(&rdd->super.super.super.super);
+}
+
+static void
+_set_partition_key(TestThreadedDestDriver *self, const gchar *key)
+{
+  LogTemplate *partition_key = log_template_new(main_loop_get_current_config(main_loop), NULL);
+  cr_assert(log_template_compile(partition_key, key, NULL));
+  log_threaded_dest_driver_set_worker_partition_key_ref(&self->super.super.super, partition_key);
+}
+
+static void
+_assert_partition_moves_when_drained(TestThreadedDestDriver *rdd, const gchar *host)
+{
+  /* make worker#0 the busier one, the partition should leave it */
+  _queue_message_with_host(rdd, "third");
+  _queue_message_with_host(rdd, "third");
+
+  _queue_message_with_host(rdd, host);
+  cr_assert_eq(_worker_queue_length(rdd, 1), 1, "drained partition should move to the least loaded worker");
+  cr_assert_eq(stats_counter_get(rdd->super.metrics.partition_migrations), 1);
+}
+
+Test(logthrdestdrv_partitioning, completion_releases_the_slot_chosen_at_dispatch)
+{
+  TestThreadedDestDriver *rdd = _create_rebalanced_dd(2);
+  cr_assert(log_pipe_init(&rdd->super.super.super.super));
+
+  _queue_message_with_host(rdd, "first");
+  _queue_message_with_host(rdd, "second");
+
+  /* the key is formatted differently by the time the message is completed */
+  _set_partition_key(rdd, "$PROGRAM");
+  _pop_message(rdd, 0, "first");
+  _ack_messages(rdd, 0, 1);
+  _pop_message(rdd, 1, "second");
+  _set_partition_key(rdd, "$HOST");
+
+  cr_assert_eq(atomic_gssize_get(&rdd->super.workers[0]->partitioning.pending), 0);
+  _assert_partition_moves_when_drained(rdd, "first");
+
+  log_pipe_deinit(&rdd->super.super.super.super);
+  log_pipe_unref(&rdd->super.super.super.super);
+}
+
+Test(logthrdestdrv_partitioning, messages_dropped_by_the_queue_release_their_slot)
+{
+  TestThreadedDestDriver *rdd = _create_rebalanced_dd(2);
+  rdd->super.super.log_fifo_size = 2;
+  cr_assert(log_pipe_init(&rdd->super.super.super.super));
+
+  _queue_message_with_host(rdd, "first");
+  _queue_message_with_host(rdd, "first");
+  _queue_message_with_host(rdd, "first");
+  _queue_message_with_host(rdd, "second");
+  cr_assert_eq(_worker_queue_length(rdd, 0), 2, "the queue should have dropped the third message");
+
+  _pop_message(rdd, 0, "first");
+  _pop_message(rdd, 0, "first");
+  _ack_messages(rdd, 0, 2);
+  _pop_message(rdd, 1, "second");
+
+  cr_assert_eq(atomic_gssize_get(&rdd->super.workers[0]->partitioning.pending), 0);
+  _assert_partition_moves_when_drained(rdd, "first");
+
+  log_pipe_deinit(&rdd->super.super.super.super);
+  log_pipe_unref(&rdd->super.super.super.super);
+}
+
+Test(logthrdestdrv_partitioning, rebalance_requires_a_partition_key)
+{
+  TestThreadedDestDriver *rdd = test_threaded_dd_new(main_loop_get_current_config(main_loop));
+  log_threaded_dest_driver_set_worker_partition_rebalance(&rdd->super.super.super, TRUE);
+
+  start_grabbing_messages();
+  cr_assert_not(log_pipe_init(&rdd->super.super.super.super));
+  assert_grabbed_log_contains("worker-partition-rebalance() requires worker-partition-key()");
+  stop_grabbing_messages();
+
+  log_pipe_unref(&rdd->super.super.super.super);
+}
+
+static void
+setup_partitioning(void)
+{
+  app_startup();
+
+  main_loop = main_loop_get_instance();
+  main_loop_init(main_loop, &main_loop_options);
+  cfg_set_current_version(main_loop_get_current_config(main_loop));
+}
+
+static void
+teardown_partitioning(void)
+{
+  main_loop_deinit(main_loop);
+  app_shutdown();
+}
+
+TestSuite(logthrdestdrv_partitioning, .init = setup_partitioning, .fini = teardown_partitioning);
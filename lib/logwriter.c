@@ -29,6 +29,7 @@
 #include "stats/stats-cluster-single.h"
 #include "stats/aggregator/stats-aggregator.h"
 #include "stats/stats-compat.h"
+#include "stats/stats-histogram.h"
 #include "hostname.h"
 #include "host-resolve.h"
 #include "seqnum.h"
@@ -91,6 +92,8 @@ struct _LogWriter
     StatsCounterItem *message_delay;
     StatsClusterKey *message_delay_sample_age_key;
     StatsCounterItem *message_delay_sample_age;
+    StatsHistogram received_to_queued_latency;
+    StatsHistogram received_to_sent_latency;
 
     struct
     {
@@ -885,6 +888,7 @@ log_writer_queue(LogPipe *s, LogMessage *lm, const LogPathOptions *path_options)
     }
 
   stats_counter_inc(self->metrics.processed_messages);
+  stats_histogram_sample_elapsed(&self->metrics.received_to_queued_latency, &lm->timestamps[LM_TS_RECVD]);
   log_queue_push_tail(self->queue, lm, path_options);
 }
 
@@ -1193,6 +1197,7 @@ log_writer_update_message_stats(LogWriter *self, const LogMessage *msg, gsize ms
 {
   stats_aggregator_add_data_point(self->metrics.max_message_size, msg_len);
   stats_aggregator_add_data_point(self->metrics.average_messages_size, msg_len);
+  stats_histogram_sample_elapsed(&self->metrics.received_to_sent_latency, &msg->timestamps[LM_TS_RECVD]);
 
   if (self->metrics.message_delay)
     {
@@ -1503,6 +1508,29 @@ _unregister_raw_bytes_stats(LogWriter *self)
   stats_byte_counter_deinit(&self->metrics.written_bytes, self->metrics.written_bytes_key);
 }
 
+static void
+_register_latency_histograms(LogWriter *self, gint level)
+{
+  StatsClusterKeyBuilder *kb = self->metrics.stats_kb;
+
+  stats_cluster_key_builder_push(kb);
+  {
+    stats_cluster_key_builder_add_label(kb, stats_cluster_label("id", self->stats_id));
+    stats_cluster_key_builder_set_name(kb, "output_event_latency_seconds");
+
+    stats_cluster_key_builder_push(kb);
+    stats_cluster_key_builder_add_label(kb, stats_cluster_label("stage", "received_to_queued"));
+    stats_histogram_register(&self->metrics.received_to_queued_latency, level, kb);
+    stats_cluster_key_builder_pop(kb);
+
+    stats_cluster_key_builder_push(kb);
+    stats_cluster_key_builder_add_label(kb, stats_cluster_label("stage", "received_to_sent"));
+    stats_histogram_register(&self->metrics.received_to_sent_latency, level, kb);
+    stats_cluster_key_builder_pop(kb);
+  }
+  stats_cluster_key_builder_pop(kb);
+}
+
 static void
 _register_counters(LogWriter *self)
 {
@@ -1546,6 +1574,8 @@ _register_counters(LogWriter *self)
   unix_time_set_now(&now);
   stats_counter_set_time(self->metrics.message_delay_sample_age, now.ut_sec);
 
+  _register_latency_histograms(self, level);
+
   stats_unlock();
   _register_aggregated_stats(self, self->metrics.output_events_key, level, SC_TYPE_WRITTEN);
 
@@ -1610,6 +1640,9 @@ _unregister_counters(LogWriter *self)
     stats_unregister_counter(self->metrics.message_delay_key, SC_TYPE_SINGLE_VALUE, &self->metrics.message_delay);
     stats_unregister_counter(self->metrics.message_delay_sample_age_key, SC_TYPE_SINGLE_VALUE,
                              &self->metrics.message_delay_sample_age);
+
+    stats_histogram_unregister(&self->metrics.received_to_queued_latency);
+    stats_histogram_unregister(&self->metrics.received_to_sent_latency);
   }
   stats_unlock();
   _unregister_aggregated_stats(self);
@@ -33,6 +33,8 @@
 #include "logpipe.h"
 #include "console.h"
 #include "debugger/debugger-main.h"
+#include "pipe-profiler.h"
+#include "path-tracer.h"
 
 #include <string.h>
 
@@ -561,6 +563,109 @@ export_config_graph(ControlConnection *cc, GString *command, gpointer user_data,
   control_connection_send_reply(cc, result);
 }
 
+static void
+control_connection_profile(ControlConnection *cc, GString *command, gpointer user_data, gboolean *cancelled)
+{
+  gchar **cmds = g_strsplit(command->str, " ", 3);
+  GString *result = g_string_sized_new(128);
+
+  if (!cmds[1])
+    {
+      g_string_assign(result, "FAIL Invalid arguments received");
+      goto exit;
+    }
+
+  if (g_str_equal(cmds[1], "START"))
+    {
+      gint sampling = cmds[2] ? atoi(cmds[2]) : PIPE_PROFILER_DEFAULT_SAMPLING;
+
+      if (sampling <= 0)
+        {
+          g_string_assign(result, "FAIL Invalid sampling rate, expecting a positive integer");
+          goto exit;
+        }
+      pipe_profiler_start(sampling);
+      msg_info("Pipeline profiler started",
+               evt_tag_int("sampling", sampling));
+      g_string_printf(result, "OK Profiler started, sampling 1 out of %d messages", sampling);
+    }
+  else if (g_str_equal(cmds[1], "STOP"))
+    {
+      pipe_profiler_stop();
+      msg_info("Pipeline profiler stopped");
+      g_string_assign(result, "OK Profiler stopped");
+    }
+  else if (g_str_equal(cmds[1], "RESET"))
+    {
+      pipe_profiler_reset();
+      g_string_assign(result, "OK Profiler results cleared");
+    }
+  else if (g_str_equal(cmds[1], "REPORT"))
+    {
+      pipe_profiler_format_report(result);
+    }
+  else if (g_str_equal(cmds[1], "COLLAPSED"))
+    {
+      pipe_profiler_format_collapsed_stacks(result);
+      if (result->len == 0)
+        g_string_assign(result, "No profiler samples available\n");
+    }
+  else
+    {
+      g_string_assign(result, "FAIL Invalid arguments received");
+    }
+
+exit:
+  g_strfreev(cmds);
+  control_connection_send_reply(cc, result);
+}
+
+static void
+control_connection_path_trace(ControlConnection *cc, GString *command, gpointer user_data, gboolean *cancelled)
+{
+  gchar **cmds = g_strsplit(command->str, " ", 3);
+  GString *result = g_string_sized_new(128);
+
+  if (!cmds[1])
+    {
+      g_string_assign(result, "FAIL Invalid arguments received");
+      goto exit;
+    }
+
+  if (g_str_equal(cmds[1], "START"))
+    {
+      gint sampling = cmds[2] ? atoi(cmds[2]) : PATH_TRACER_DEFAULT_SAMPLING;
+
+      if (sampling <= 0)
+        {
+          g_string_assign(result, "FAIL Invalid sampling rate, expecting a positive integer");
+          goto exit;
+        }
+      path_tracer_start(sampling);
+      msg_info("Message path tracing started",
+               evt_tag_int("sampling", sampling));
+      g_string_printf(result, "OK Path tracing started, tracing 1 out of %d messages", sampling);
+    }
+  else if (g_str_equal(cmds[1], "STOP"))
+    {
+      path_tracer_stop();
+      msg_info("Message path tracing stopped");
+      g_string_assign(result, "OK Path tracing stopped");
+    }
+  else if (g_str_equal(cmds[1], "DUMP"))
+    {
+      path_tracer_format_json(result);
+    }
+  else
+    {
+      g_string_assign(result, "FAIL Invalid arguments received");
+    }
+
+exit:
+  g_strfreev(cmds);
+  control_connection_send_reply(cc, result);
+}
+
 ControlCommand default_commands[] =
 {
   { "ATTACH", control_connection_attach, .threaded = TRUE },
@@ -573,6 +678,8 @@ ControlCommand default_commands[] =
   { "PWD", process_credentials },
   { "LISTFILES", control_connection_list_files },
   { "EXPORT_CONFIG_GRAPH", export_config_graph },
+  { "PROFILE", control_connection_profile },
+  { "PATH_TRACE", control_connection_path_trace },
   { NULL, NULL },
 };
 
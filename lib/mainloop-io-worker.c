@@ -26,6 +26,10 @@
 #include "mainloop-call.h"
 #include "logqueue.h"
 #include "apphook.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-key-builder.h"
+#include "tls-support.h"
+#include "compat/time.h"
 
 /************************************************************************************
  * I/O worker threads
@@ -33,6 +37,129 @@
 
 static struct iv_work_pool main_loop_io_workers;
 
+typedef enum
+{
+  IOW_TIME_BUSY,
+  IOW_TIME_IDLE,
+  IOW_TIME_JOB_WAIT,
+  IOW_TIME_BATCH_CALLBACKS,
+  IOW_TIME_MAX
+} MainLoopIOWorkerTime;
+
+static const gchar *io_worker_time_metric_names[IOW_TIME_MAX] =
+{
+  "io_worker_busy_seconds_total",
+  "io_worker_idle_seconds_total",
+  "io_worker_job_wait_seconds_total",
+  "io_worker_batch_callback_seconds_total",
+};
+
+TLS_BLOCK_START
+{
+  /* metrics of the I/O worker running on this thread, labeled with its thread index */
+  struct
+  {
+    StatsClusterKey *jobs_key;
+    StatsCounterItem *jobs;
+
+    StatsClusterKey *time_keys[IOW_TIME_MAX];
+    StatsCounterItem *time[IOW_TIME_MAX];
+    /* the counters are in milliseconds, the remainder is carried over */
+    gint64 time_residual_nsec[IOW_TIME_MAX];
+
+    gint64 idle_since_nsec;
+  } io_worker_metrics;
+}
+TLS_BLOCK_END;
+
+#define io_worker_metrics __tls_deref(io_worker_metrics)
+
+static inline gint64
+_now_nsec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (gint64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void
+_account_time(MainLoopIOWorkerTime type, gint64 elapsed_nsec)
+{
+  if (!io_worker_metrics.time[type] || elapsed_nsec < 0)
+    return;
+
+  elapsed_nsec += io_worker_metrics.time_residual_nsec[type];
+  stats_counter_add(io_worker_metrics.time[type], elapsed_nsec / 1000000);
+  io_worker_metrics.time_residual_nsec[type] = elapsed_nsec % 1000000;
+}
+
+/* NOTE: runs in the worker thread */
+static void
+_register_metrics(void)
+{
+  gint thread_index = main_loop_worker_get_thread_index();
+
+  /* no thread ID could be allocated */
+  if (thread_index < 0)
+    return;
+
+  gchar thread_label[16];
+  g_snprintf(thread_label, sizeof(thread_label), "%d", thread_index);
+
+  StatsClusterKeyBuilder *kb = stats_cluster_key_builder_new();
+  stats_cluster_key_builder_add_label(kb, stats_cluster_label("thread", thread_label));
+
+  /* the worker threads outlive configuration changes, thus these are on stats-level 0 */
+  stats_lock();
+  {
+    stats_cluster_key_builder_set_name(kb, "io_worker_jobs_total");
+    io_worker_metrics.jobs_key = stats_cluster_key_builder_build_single(kb);
+    stats_register_counter(STATS_LEVEL0, io_worker_metrics.jobs_key, SC_TYPE_SINGLE_VALUE, &io_worker_metrics.jobs);
+
+    stats_cluster_key_builder_set_unit(kb, SCU_MILLISECONDS);
+    for (gint type = 0; type < IOW_TIME_MAX; type++)
+      {
+        stats_cluster_key_builder_set_name(kb, io_worker_time_metric_names[type]);
+        io_worker_metrics.time_keys[type] = stats_cluster_key_builder_build_single(kb);
+        stats_register_counter(STATS_LEVEL0, io_worker_metrics.time_keys[type], SC_TYPE_SINGLE_VALUE,
+                               &io_worker_metrics.time[type]);
+        io_worker_metrics.time_residual_nsec[type] = 0;
+      }
+  }
+  stats_unlock();
+
+  stats_cluster_key_builder_free(kb);
+
+  io_worker_metrics.idle_since_nsec = _now_nsec();
+}
+
+/* NOTE: runs in the worker thread */
+static void
+_unregister_metrics(void)
+{
+  if (!io_worker_metrics.jobs_key)
+    return;
+
+  _account_time(IOW_TIME_IDLE, _now_nsec() - io_worker_metrics.idle_since_nsec);
+
+  stats_lock();
+  {
+    stats_unregister_counter(io_worker_metrics.jobs_key, SC_TYPE_SINGLE_VALUE, &io_worker_metrics.jobs);
+    for (gint type = 0; type < IOW_TIME_MAX; type++)
+      stats_unregister_counter(io_worker_metrics.time_keys[type], SC_TYPE_SINGLE_VALUE, &io_worker_metrics.time[type]);
+  }
+  stats_unlock();
+
+  stats_cluster_key_free(io_worker_metrics.jobs_key);
+  io_worker_metrics.jobs_key = NULL;
+  for (gint type = 0; type < IOW_TIME_MAX; type++)
+    {
+      stats_cluster_key_free(io_worker_metrics.time_keys[type]);
+      io_worker_metrics.time_keys[type] = NULL;
+    }
+}
+
 static void
 _release(MainLoopIOWorkerJob *self)
 {
@@ -60,6 +187,7 @@ main_loop_io_worker_job_submit(MainLoopIOWorkerJob *self, gpointer arg)
   main_loop_worker_job_start();
   self->working = TRUE;
   self->arg = arg;
+  self->submitted_at_nsec = _now_nsec();
   iv_work_pool_submit_work(&main_loop_io_workers, &self->work_item);
   return TRUE;
 }
@@ -75,6 +203,7 @@ main_loop_io_worker_job_submit_continuation(MainLoopIOWorkerJob *self, gpointer
   main_loop_worker_job_start();
   self->working = TRUE;
   self->arg = arg;
+  self->submitted_at_nsec = _now_nsec();
 
   iv_work_pool_submit_continuation(&main_loop_io_workers, &self->work_item);
 }
@@ -85,8 +214,22 @@ main_loop_io_worker_job_submit_continuation(MainLoopIOWorkerJob *self, gpointer
 static void
 _work(MainLoopIOWorkerJob *self)
 {
+  gint64 started_at = _now_nsec();
+
+  _account_time(IOW_TIME_IDLE, started_at - io_worker_metrics.idle_since_nsec);
+  _account_time(IOW_TIME_JOB_WAIT, started_at - self->submitted_at_nsec);
+  stats_counter_inc(io_worker_metrics.jobs);
+
   self->work(self->user_data, self->arg);
+
+  gint64 work_finished_at = _now_nsec();
   main_loop_worker_invoke_batch_callbacks();
+  gint64 finished_at = _now_nsec();
+
+  _account_time(IOW_TIME_BATCH_CALLBACKS, finished_at - work_finished_at);
+  _account_time(IOW_TIME_BUSY, finished_at - started_at);
+  io_worker_metrics.idle_since_nsec = finished_at;
+
   main_loop_worker_run_gc();
 }
 
@@ -124,11 +267,13 @@ static void
 main_loop_io_worker_thread_start(void *cookie)
 {
   main_loop_worker_thread_start(MLW_ASYNC_WORKER);
+  _register_metrics();
 }
 
 static void
 main_loop_io_worker_thread_stop(void *cookie)
 {
+  _unregister_metrics();
   main_loop_worker_thread_stop();
 }
 
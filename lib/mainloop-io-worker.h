@@ -37,6 +37,8 @@ typedef struct _MainLoopIOWorkerJob
   gpointer user_data;
   gpointer arg;
   gboolean working;
+  /* CLOCK_MONOTONIC, to measure the time the job spent waiting for a worker */
+  gint64 submitted_at_nsec;
   struct iv_work_item work_item;
 } MainLoopIOWorkerJob;
 
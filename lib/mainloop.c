@@ -151,6 +151,9 @@ struct _MainLoop
 
   struct iv_timer exit_timer;
 
+  /* fires periodically, its lateness is the latency of the main loop */
+  struct iv_timer latency_probe;
+
   /* Currently running configuration, should not be used outside the mainloop
    * logic. If anything needs access to the GlobalConfig instance at runtime,
    * it needs to save that during initialization.  If anything needs the
@@ -174,6 +177,11 @@ struct _MainLoop
     StatsCounterItem *last_reload;
     StatsCounterItem *last_successful_reload;
     StatsCounterItem *last_cfgfile_mtime;
+    StatsCounterItem *latency;
+    StatsCounterItem *latency_max;
+    StatsCounterItem *latency_probes;
+    /* latency is counted in milliseconds, the remainder is carried over */
+    gint64 latency_residual_nsec;
   } metrics;
 };
 
@@ -592,6 +600,54 @@ main_loop_exit(MainLoop *self)
   return;
 }
 
+#define MAIN_LOOP_LATENCY_PROBE_INTERVAL_MSEC 1000
+
+/*
+ * ivykis has no per-iteration hook, so the latency of the main loop is
+ * sampled with a timer instead: the time elapsed between its expiry and
+ * the invocation of its handler is the time the main thread spent on
+ * other callbacks (reloads, control commands, internal messages, ...).
+ */
+static void
+_main_loop_latency_probe_elapsed(gpointer user_data)
+{
+  MainLoop *self = (MainLoop *) user_data;
+
+  iv_validate_now();
+  glong lag_nsec = timespec_diff_nsec(&iv_now, &self->latency_probe.expires);
+  if (lag_nsec < 0)
+    lag_nsec = 0;
+
+  gint64 latency_nsec = lag_nsec + self->metrics.latency_residual_nsec;
+  stats_counter_add(self->metrics.latency, latency_nsec / 1000000);
+  self->metrics.latency_residual_nsec = latency_nsec % 1000000;
+  stats_counter_set_max(self->metrics.latency_max, lag_nsec / 1000000);
+  stats_counter_inc(self->metrics.latency_probes);
+
+  self->latency_probe.expires = iv_now;
+  timespec_add_msec(&self->latency_probe.expires, MAIN_LOOP_LATENCY_PROBE_INTERVAL_MSEC);
+  iv_timer_register(&self->latency_probe);
+}
+
+static void
+main_loop_start_latency_probe(MainLoop *self)
+{
+  IV_TIMER_INIT(&self->latency_probe);
+  iv_validate_now();
+  self->latency_probe.expires = iv_now;
+  self->latency_probe.handler = _main_loop_latency_probe_elapsed;
+  self->latency_probe.cookie = self;
+  timespec_add_msec(&self->latency_probe.expires, MAIN_LOOP_LATENCY_PROBE_INTERVAL_MSEC);
+  iv_timer_register(&self->latency_probe);
+}
+
+static void
+main_loop_stop_latency_probe(MainLoop *self)
+{
+  if (iv_timer_registered(&self->latency_probe))
+    iv_timer_unregister(&self->latency_probe);
+}
+
 static void
 _register_metrics(MainLoop *self)
 {
@@ -608,6 +664,17 @@ _register_metrics(MainLoop *self)
 
   stats_cluster_single_key_set(&k, "last_config_file_modification_timestamp_seconds", NULL, 0);
   stats_register_counter(0, &k, SC_TYPE_SINGLE_VALUE, &self->metrics.last_cfgfile_mtime);
+
+  stats_cluster_single_key_set(&k, "main_loop_latency_seconds_total", NULL, 0);
+  stats_cluster_single_key_add_unit(&k, SCU_MILLISECONDS);
+  stats_register_counter(0, &k, SC_TYPE_SINGLE_VALUE, &self->metrics.latency);
+
+  stats_cluster_single_key_set(&k, "main_loop_latency_max_seconds", NULL, 0);
+  stats_cluster_single_key_add_unit(&k, SCU_MILLISECONDS);
+  stats_register_counter(0, &k, SC_TYPE_SINGLE_VALUE, &self->metrics.latency_max);
+
+  stats_cluster_single_key_set(&k, "main_loop_latency_probes_total", NULL, 0);
+  stats_register_counter(0, &k, SC_TYPE_SINGLE_VALUE, &self->metrics.latency_probes);
   stats_unlock();
 }
 
@@ -624,6 +691,17 @@ _unregister_metrics(MainLoop *self)
 
   stats_cluster_single_key_set(&k, "last_config_file_modification_timestamp_seconds", NULL, 0);
   stats_unregister_counter(&k, SC_TYPE_SINGLE_VALUE, &self->metrics.last_cfgfile_mtime);
+
+  stats_cluster_single_key_set(&k, "main_loop_latency_seconds_total", NULL, 0);
+  stats_cluster_single_key_add_unit(&k, SCU_MILLISECONDS);
+  stats_unregister_counter(&k, SC_TYPE_SINGLE_VALUE, &self->metrics.latency);
+
+  stats_cluster_single_key_set(&k, "main_loop_latency_max_seconds", NULL, 0);
+  stats_cluster_single_key_add_unit(&k, SCU_MILLISECONDS);
+  stats_unregister_counter(&k, SC_TYPE_SINGLE_VALUE, &self->metrics.latency_max);
+
+  stats_cluster_single_key_set(&k, "main_loop_latency_probes_total", NULL, 0);
+  stats_unregister_counter(&k, SC_TYPE_SINGLE_VALUE, &self->metrics.latency_probes);
   stats_unlock();
 }
 
@@ -656,6 +734,7 @@ main_loop_init(MainLoop *self, MainLoopOptions *options)
     self->current_configuration->use_plugin_discovery = FALSE;
 
   _register_metrics(self);
+  main_loop_start_latency_probe(self);
 }
 
 static inline void
@@ -734,6 +813,7 @@ main_loop_deinit(MainLoop *self)
   control_deinit(self->control_server);
 
   iv_event_unregister(&self->exit_requested);
+  main_loop_stop_latency_probe(self);
   main_loop_call_deinit();
   main_loop_io_worker_deinit();
   main_loop_worker_deinit();
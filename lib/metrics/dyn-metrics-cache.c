@@ -29,13 +29,20 @@
 #include "apphook.h"
 #include "tls-support.h"
 
+/* the overflowed label sets are only a hint, the table is emptied when it grows this large */
+#define MAX_OVERFLOWED_LABELS 1024
+
 TLS_BLOCK_START
 {
   DynMetricsStore *metrics_cache;
+  GHashTable *metrics_cache_generations;
+  GHashTable *metrics_cache_overflowed;
 }
 TLS_BLOCK_END;
 
 #define metrics_cache __tls_deref(metrics_cache)
+#define metrics_cache_generations __tls_deref(metrics_cache_generations)
+#define metrics_cache_overflowed __tls_deref(metrics_cache_overflowed)
 
 static DynMetricsStore *global_metrics_cache;
 static GMutex global_metrics_cache_lock;
@@ -56,12 +63,31 @@ _purge_global_cache(gint type, gpointer c)
   g_mutex_unlock(&global_metrics_cache_lock);
 }
 
+static guint
+_overflowed_labels_hash(gconstpointer k)
+{
+  const DynMetricsOverflowedLabels *overflowed = (const DynMetricsOverflowedLabels *) k;
+
+  return (guint) (overflowed->fingerprint ^ (overflowed->fingerprint >> 32)) ^ overflowed->metric_id;
+}
+
+static gboolean
+_overflowed_labels_equal(gconstpointer a, gconstpointer b)
+{
+  const DynMetricsOverflowedLabels *lhs = (const DynMetricsOverflowedLabels *) a;
+  const DynMetricsOverflowedLabels *rhs = (const DynMetricsOverflowedLabels *) b;
+
+  return lhs->metric_id == rhs->metric_id && lhs->fingerprint == rhs->fingerprint;
+}
+
 static void
 _init_tls_cache(gpointer user_data)
 {
   g_assert(!metrics_cache);
 
   metrics_cache = dyn_metrics_store_new();
+  metrics_cache_generations = g_hash_table_new(g_direct_hash, g_direct_equal);
+  metrics_cache_overflowed = g_hash_table_new_full(_overflowed_labels_hash, _overflowed_labels_equal, g_free, NULL);
 }
 
 static void
@@ -69,6 +95,8 @@ _deinit_tls_cache(gpointer user_data)
 {
   _sync_with_global_cache(metrics_cache);
   dyn_metrics_store_free(metrics_cache);
+  g_hash_table_destroy(metrics_cache_generations);
+  g_hash_table_destroy(metrics_cache_overflowed);
 }
 
 DynMetricsStore *
@@ -77,6 +105,61 @@ dyn_metrics_cache(void)
   return metrics_cache;
 }
 
+/*
+ * Records the generation of the counters of a metric that the calling
+ * thread has seen, returns TRUE if it differs from the previous one, in
+ * which case the cached counters of the metric have to be dropped.
+ */
+gboolean
+dyn_metrics_cache_update_generation(guint metric_id, gint generation)
+{
+  gpointer key = GUINT_TO_POINTER(metric_id);
+
+  if (GPOINTER_TO_INT(g_hash_table_lookup(metrics_cache_generations, key)) == generation)
+    return FALSE;
+
+  g_hash_table_insert(metrics_cache_generations, key, GINT_TO_POINTER(generation));
+  return TRUE;
+}
+
+/* returns NULL if the label set is not known to be overflowed by the calling thread */
+DynMetricsOverflowedLabels *
+dyn_metrics_cache_lookup_overflowed(guint metric_id, guint64 fingerprint)
+{
+  DynMetricsOverflowedLabels lookup_key = { .metric_id = metric_id, .fingerprint = fingerprint };
+
+  return g_hash_table_lookup(metrics_cache_overflowed, &lookup_key);
+}
+
+DynMetricsOverflowedLabels *
+dyn_metrics_cache_add_overflowed(guint metric_id, guint64 fingerprint)
+{
+  if (g_hash_table_size(metrics_cache_overflowed) >= MAX_OVERFLOWED_LABELS)
+    g_hash_table_remove_all(metrics_cache_overflowed);
+
+  DynMetricsOverflowedLabels *overflowed = g_new0(DynMetricsOverflowedLabels, 1);
+  overflowed->metric_id = metric_id;
+  overflowed->fingerprint = fingerprint;
+  g_hash_table_replace(metrics_cache_overflowed, overflowed, overflowed);
+
+  return overflowed;
+}
+
+void
+dyn_metrics_cache_remove_overflowed(DynMetricsOverflowedLabels *overflowed)
+{
+  g_hash_table_remove(metrics_cache_overflowed, overflowed);
+}
+
+/* the counters of exited threads are kept alive by the global cache */
+void
+dyn_metrics_cache_remove_global_counter(StatsClusterKey *key)
+{
+  g_mutex_lock(&global_metrics_cache_lock);
+  dyn_metrics_store_remove_counter(global_metrics_cache, key);
+  g_mutex_unlock(&global_metrics_cache_lock);
+}
+
 void
 dyn_metrics_cache_global_init(void)
 {
@@ -30,7 +30,26 @@
 #include "stats/stats-registry.h"
 #include "dyn-metrics-store.h"
 
+/*
+ * A label set that the limiter of a metric counted in its overflow series,
+ * remembered by the thread so that its next occurrences can skip the
+ * limiter.  See dyn_metrics_limiter_admit().
+ */
+typedef struct _DynMetricsOverflowedLabels
+{
+  guint metric_id;
+  guint64 fingerprint;
+  gint generation;
+  guint64 headroom;
+  guint64 pending_weight;
+} DynMetricsOverflowedLabels;
+
 DynMetricsStore *dyn_metrics_cache(void);
+gboolean dyn_metrics_cache_update_generation(guint metric_id, gint generation);
+DynMetricsOverflowedLabels *dyn_metrics_cache_lookup_overflowed(guint metric_id, guint64 fingerprint);
+DynMetricsOverflowedLabels *dyn_metrics_cache_add_overflowed(guint metric_id, guint64 fingerprint);
+void dyn_metrics_cache_remove_overflowed(DynMetricsOverflowedLabels *overflowed);
+void dyn_metrics_cache_remove_global_counter(StatsClusterKey *key);
 
 void dyn_metrics_cache_global_init(void);
 void dyn_metrics_cache_global_deinit(void);
@@ -0,0 +1,605 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "dyn-metrics-limiter.h"
+#include "dyn-metrics-cache.h"
+#include "stats/stats-cluster-single.h"
+#include "stats/stats-cluster-key-builder.h"
+
+#include <string.h>
+
+/* the sketch monitors this many label sets for each exact series */
+#define SKETCH_SIZE_PER_SERIES 2
+#define SKETCH_MIN_SIZE 16
+
+/* demoted series are removed from the registry at most this often (in overflowing label sets) */
+#define DEMOTED_SERIES_CLEANUP_INTERVAL 1024
+
+/* identifies the limiter in the per-thread caches, never reused unlike the address */
+static gint next_limiter_id = 1;
+
+/*
+ * Space-Saving sketch: a fixed number of monitored label sets, each with
+ * a count and the maximal overestimation of that count.  When a new label
+ * set arrives and the sketch is full, it replaces the least frequent one,
+ * inheriting its count as error.  The entries are kept in a min-heap.
+ */
+typedef struct _SketchEntry
+{
+  guint64 fingerprint;
+  guint64 count;
+  guint64 error;
+  guint heap_index;
+} SketchEntry;
+
+typedef struct _Sketch
+{
+  guint capacity;
+  guint len;
+  SketchEntry *entries;
+  /* indexes of entries, ordered by count */
+  guint *heap;
+  guint *free_slots;
+  guint free_len;
+  GHashTable *index;
+} Sketch;
+
+typedef struct _ExactSeries
+{
+  guint64 fingerprint;
+  StatsCluster *cluster;
+  StatsCounterItem *counter;
+  /* counter value at the promotion, and the frequency estimated before it */
+  gsize base;
+  guint64 credit;
+  gsize memory;
+} ExactSeries;
+
+struct _DynMetricsLimiter
+{
+  GMutex lock;
+  guint id;
+  gchar *name;
+  gsize max_series;
+  gint level;
+
+  GHashTable *exact;
+  Sketch sketch;
+  /* lower bound of the frequency of the least frequent exact series */
+  guint64 min_exact_frequency;
+
+  GList *demoted;
+  guint overflows_since_cleanup;
+  /* incremented on each demotion, threads drop the cached series of the metric when it changes */
+  gint generation;
+
+  StatsCluster *overflow_cluster;
+  StatsCounterItem *overflow_counter;
+
+  struct
+  {
+    StatsClusterKey *memory_key;
+    StatsClusterKey *series_key;
+    StatsCounterItem *memory;
+    StatsCounterItem *series;
+  } metrics;
+};
+
+static void
+_sketch_swap(Sketch *self, guint a, guint b)
+{
+  guint slot = self->heap[a];
+  self->heap[a] = self->heap[b];
+  self->heap[b] = slot;
+
+  self->entries[self->heap[a]].heap_index = a;
+  self->entries[self->heap[b]].heap_index = b;
+}
+
+static guint64
+_sketch_count_at(Sketch *self, guint heap_index)
+{
+  return self->entries[self->heap[heap_index]].count;
+}
+
+static void
+_sketch_sift_up(Sketch *self, guint i)
+{
+  while (i > 0)
+    {
+      guint parent = (i - 1) / 2;
+      if (_sketch_count_at(self, parent) <= _sketch_count_at(self, i))
+        break;
+      _sketch_swap(self, parent, i);
+      i = parent;
+    }
+}
+
+static void
+_sketch_sift_down(Sketch *self, guint i)
+{
+  while (TRUE)
+    {
+      guint smallest = i;
+      guint left = 2 * i + 1;
+      guint right = left + 1;
+
+      if (left < self->len && _sketch_count_at(self, left) < _sketch_count_at(self, smallest))
+        smallest = left;
+      if (right < self->len && _sketch_count_at(self, right) < _sketch_count_at(self, smallest))
+        smallest = right;
+
+      if (smallest == i)
+        break;
+      _sketch_swap(self, smallest, i);
+      i = smallest;
+    }
+}
+
+/* returns the guaranteed count of the label set */
+static guint64
+_sketch_add(Sketch *self, guint64 fingerprint, guint64 weight)
+{
+  SketchEntry *entry = g_hash_table_lookup(self->index, &fingerprint);
+
+  if (entry)
+    {
+      entry->count += weight;
+      _sketch_sift_down(self, entry->heap_index);
+    }
+  else if (self->len < self->capacity)
+    {
+      guint slot = self->free_slots[--self->free_len];
+      entry = &self->entries[slot];
+      entry->fingerprint = fingerprint;
+      entry->count = weight;
+      entry->error = 0;
+      entry->heap_index = self->len;
+      self->heap[self->len++] = slot;
+
+      g_hash_table_insert(self->index, &entry->fingerprint, entry);
+      _sketch_sift_up(self, entry->heap_index);
+    }
+  else
+    {
+      entry = &self->entries[self->heap[0]];
+      g_hash_table_remove(self->index, &entry->fingerprint);
+
+      entry->fingerprint = fingerprint;
+      entry->error = entry->count;
+      entry->count += weight;
+
+      g_hash_table_insert(self->index, &entry->fingerprint, entry);
+      _sketch_sift_down(self, 0);
+    }
+
+  return entry->count - entry->error;
+}
+
+static void
+_sketch_remove(Sketch *self, guint64 fingerprint)
+{
+  SketchEntry *entry = g_hash_table_lookup(self->index, &fingerprint);
+
+  if (!entry)
+    return;
+
+  g_hash_table_remove(self->index, &entry->fingerprint);
+
+  guint i = entry->heap_index;
+  guint slot = self->heap[i];
+
+  self->len--;
+  if (i != self->len)
+    {
+      self->heap[i] = self->heap[self->len];
+      self->entries[self->heap[i]].heap_index = i;
+      _sketch_sift_down(self, i);
+      _sketch_sift_up(self, i);
+    }
+  self->free_slots[self->free_len++] = slot;
+}
+
+static gsize
+_sketch_memory_usage(Sketch *self)
+{
+  /* an entry, its heap and free slot indexes and a hash table node (hash, key, value) */
+  return self->capacity * (sizeof(SketchEntry) + 3 * sizeof(guint) + 2 * sizeof(gpointer));
+}
+
+static void
+_sketch_init(Sketch *self, guint capacity)
+{
+  self->capacity = capacity;
+  self->len = 0;
+  self->entries = g_new0(SketchEntry, capacity);
+  self->heap = g_new0(guint, capacity);
+  self->free_slots = g_new0(guint, capacity);
+  for (guint i = 0; i < capacity; i++)
+    self->free_slots[i] = capacity - 1 - i;
+  self->free_len = capacity;
+  self->index = g_hash_table_new(g_int64_hash, g_int64_equal);
+}
+
+static void
+_sketch_destroy(Sketch *self)
+{
+  g_hash_table_destroy(self->index);
+  g_free(self->free_slots);
+  g_free(self->heap);
+  g_free(self->entries);
+}
+
+/* FNV-1a over the labels, the name is the same for every series of the limiter */
+static guint64
+_fingerprint(const StatsClusterKey *key)
+{
+  guint64 hash = 14695981039346656037ULL;
+
+  for (gsize i = 0; i < key->labels_len; i++)
+    {
+      const gchar *strings[] = { key->labels[i].name, key->labels[i].value ? : "" };
+
+      for (gsize s = 0; s < G_N_ELEMENTS(strings); s++)
+        {
+          /* including the terminating NUL, so that label boundaries matter */
+          for (const guchar *p = (const guchar *) strings[s]; ; p++)
+            {
+              hash = (hash ^ *p) * 1099511628211ULL;
+              if (!*p)
+                break;
+            }
+        }
+    }
+
+  return hash;
+}
+
+static gsize
+_estimate_series_memory(const StatsClusterKey *key)
+{
+  gsize size = sizeof(ExactSeries) + sizeof(StatsCluster) + sizeof(StatsCounterItem) + strlen(key->name) + 1;
+
+  for (gsize i = 0; i < key->labels_len; i++)
+    {
+      size += sizeof(StatsClusterLabel) + strlen(key->labels[i].name) + 1;
+      size += (key->labels[i].value ? strlen(key->labels[i].value) : 0) + 1;
+    }
+
+  return size;
+}
+
+static guint64
+_exact_series_frequency(ExactSeries *series)
+{
+  /* negative increments can take the counter below its value at the promotion */
+  gssize delta = (gssize) (stats_counter_get(series->counter) - series->base);
+
+  if (delta < 0 && (guint64) -delta > series->credit)
+    return 0;
+  return series->credit + delta;
+}
+
+static ExactSeries *
+_find_least_frequent_exact_series(DynMetricsLimiter *self)
+{
+  ExactSeries *least_frequent = NULL;
+  guint64 min_frequency = G_MAXUINT64;
+
+  GHashTableIter iter;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->exact);
+  while (g_hash_table_iter_next(&iter, NULL, &value))
+    {
+      ExactSeries *series = (ExactSeries *) value;
+      guint64 frequency = _exact_series_frequency(series);
+
+      if (frequency < min_frequency)
+        {
+          min_frequency = frequency;
+          least_frequent = series;
+        }
+    }
+
+  self->min_exact_frequency = least_frequent ? min_frequency : 0;
+  return least_frequent;
+}
+
+static gboolean
+_promote(DynMetricsLimiter *self, guint64 fingerprint, const StatsClusterKey *key, guint64 credit)
+{
+  StatsCounterItem *counter;
+  StatsCluster *cluster = stats_register_dynamic_counter_lockfree(self->level, key, SC_TYPE_SINGLE_VALUE, &counter);
+
+  /* max-dynamic-stats() reached */
+  if (!cluster)
+    return FALSE;
+
+  ExactSeries *series = g_new0(ExactSeries, 1);
+  series->fingerprint = fingerprint;
+  series->cluster = cluster;
+  series->counter = counter;
+  series->base = stats_counter_get(counter);
+  series->credit = credit;
+  series->memory = _estimate_series_memory(key);
+  g_hash_table_insert(self->exact, &series->fingerprint, series);
+
+  self->min_exact_frequency = MIN(self->min_exact_frequency, credit);
+
+  stats_counter_inc(self->metrics.series);
+  stats_counter_add(self->metrics.memory, series->memory);
+  return TRUE;
+}
+
+static void
+_free_exact_series(ExactSeries *series)
+{
+  stats_unregister_dynamic_counter_lockfree(series->cluster, SC_TYPE_SINGLE_VALUE, &series->counter);
+  g_free(series);
+}
+
+/* removes the demoted series from the registry, once no thread uses them */
+static void
+_remove_demoted_series(DynMetricsLimiter *self)
+{
+  self->overflows_since_cleanup = 0;
+
+  if (!self->demoted)
+    return;
+
+  stats_lock();
+  GList *l = self->demoted;
+  while (l)
+    {
+      GList *next = l->next;
+      StatsClusterKey *key = (StatsClusterKey *) l->data;
+
+      if (!stats_get_cluster(key) || stats_remove_cluster(key))
+        {
+          stats_cluster_key_free(key);
+          self->demoted = g_list_delete_link(self->demoted, l);
+        }
+      l = next;
+    }
+  stats_unlock();
+}
+
+static void
+_demote(DynMetricsLimiter *self, ExactSeries *series)
+{
+  StatsClusterKey *key = stats_cluster_key_clone(g_new0(StatsClusterKey, 1), &series->cluster->key);
+  self->demoted = g_list_prepend(self->demoted, key);
+
+  stats_counter_dec(self->metrics.series);
+  stats_counter_sub(self->metrics.memory, series->memory);
+
+  g_hash_table_remove(self->exact, &series->fingerprint);
+
+  /* threads still holding the demoted series in their caches drop it, see dyn_metrics_limiter_sync_cache() */
+  g_atomic_int_inc(&self->generation);
+  dyn_metrics_cache_remove_global_counter(key);
+  _remove_demoted_series(self);
+}
+
+/*
+ * pending_weight was already counted in the overflow series, but not yet
+ * seen by the sketch.  On rejection, headroom is set to the weight the
+ * label set can gain before it might take the place of an exact series:
+ * until then, the outcome is the same as long as no series is demoted.
+ */
+static gboolean
+_admit_locked(DynMetricsLimiter *self, guint64 fingerprint, const StatsClusterKey *key, guint64 pending_weight,
+              guint64 weight, guint64 *headroom)
+{
+  *headroom = 0;
+
+  if (g_hash_table_lookup(self->exact, &fingerprint))
+    return TRUE;
+
+  if (g_hash_table_size(self->exact) < self->max_series)
+    return _promote(self, fingerprint, key, 0);
+
+  if (++self->overflows_since_cleanup >= DEMOTED_SERIES_CLEANUP_INTERVAL)
+    _remove_demoted_series(self);
+
+  guint64 guaranteed_frequency = _sketch_add(&self->sketch, fingerprint, pending_weight + weight);
+  if (guaranteed_frequency <= self->min_exact_frequency)
+    {
+      *headroom = self->min_exact_frequency - guaranteed_frequency;
+      return FALSE;
+    }
+
+  ExactSeries *least_frequent = _find_least_frequent_exact_series(self);
+  if (!least_frequent || guaranteed_frequency <= self->min_exact_frequency)
+    {
+      *headroom = self->min_exact_frequency - MIN(guaranteed_frequency, self->min_exact_frequency);
+      return FALSE;
+    }
+
+  _demote(self, least_frequent);
+  _sketch_remove(&self->sketch, fingerprint);
+
+  /* the current weight is going to be counted by the new series */
+  return _promote(self, fingerprint, key, guaranteed_frequency - weight);
+}
+
+/*
+ * Returns TRUE if the label set of key is counted in its own series,
+ * FALSE if it should be counted in the overflow series.  weight is the
+ * value the series is going to be incremented with.
+ */
+gboolean
+dyn_metrics_limiter_admit(DynMetricsLimiter *self, const StatsClusterKey *key, gssize weight)
+{
+  guint64 fingerprint = _fingerprint(key);
+  guint64 increment = MAX(weight, 0);
+  guint64 pending_weight = 0;
+
+  /* label sets overflowed by this thread skip the lock until they might be promoted or a series is demoted */
+  DynMetricsOverflowedLabels *overflowed = dyn_metrics_cache_lookup_overflowed(self->id, fingerprint);
+  if (overflowed)
+    {
+      if (overflowed->generation == g_atomic_int_get(&self->generation) &&
+          overflowed->pending_weight + increment <= overflowed->headroom)
+        {
+          overflowed->pending_weight += increment;
+          return FALSE;
+        }
+
+      pending_weight = overflowed->pending_weight;
+      dyn_metrics_cache_remove_overflowed(overflowed);
+    }
+
+  guint64 headroom;
+  g_mutex_lock(&self->lock);
+  gboolean admitted = _admit_locked(self, fingerprint, key, pending_weight, increment, &headroom);
+  gint generation = self->generation;
+  g_mutex_unlock(&self->lock);
+
+  if (!admitted)
+    {
+      overflowed = dyn_metrics_cache_add_overflowed(self->id, fingerprint);
+      overflowed->generation = generation;
+      overflowed->headroom = headroom;
+    }
+
+  return admitted;
+}
+
+/*
+ * Drops the cached series of the metric from the cache of the calling
+ * thread if a series has been demoted since the last call, so that the
+ * demoted series is not updated anymore.  Costs a single atomic read as
+ * long as nothing is demoted.
+ */
+void
+dyn_metrics_limiter_sync_cache(DynMetricsLimiter *self, DynMetricsStore *cache)
+{
+  gint generation = g_atomic_int_get(&self->generation);
+
+  if (G_LIKELY(generation == 0))
+    return;
+
+  if (dyn_metrics_cache_update_generation(self->id, generation))
+    dyn_metrics_store_remove_counters_by_name(cache, self->name);
+}
+
+StatsCounterItem *
+dyn_metrics_limiter_get_overflow_counter(DynMetricsLimiter *self)
+{
+  return self->overflow_counter;
+}
+
+static void
+_register_metrics(DynMetricsLimiter *self)
+{
+  StatsClusterKeyBuilder *kb = stats_cluster_key_builder_new();
+  stats_cluster_key_builder_add_label(kb, stats_cluster_label("metric", self->name));
+
+  stats_cluster_key_builder_set_name(kb, "dynamic_metric_memory_bytes");
+  self->metrics.memory_key = stats_cluster_key_builder_build_single(kb);
+  stats_cluster_key_builder_set_name(kb, "dynamic_metric_series");
+  self->metrics.series_key = stats_cluster_key_builder_build_single(kb);
+
+  stats_cluster_key_builder_free(kb);
+
+  stats_lock();
+  {
+    /* several copies of the same metric (e.g. after cloning) share these, they are updated with deltas */
+    stats_register_counter(self->level, self->metrics.memory_key, SC_TYPE_SINGLE_VALUE, &self->metrics.memory);
+    stats_register_counter(self->level, self->metrics.series_key, SC_TYPE_SINGLE_VALUE, &self->metrics.series);
+  }
+  stats_unlock();
+
+  StatsClusterLabel overflow_label = stats_cluster_label("overflow", "true");
+  StatsClusterKey overflow_key;
+  stats_cluster_single_key_set(&overflow_key, self->name, &overflow_label, 1);
+  self->overflow_cluster = stats_register_dynamic_counter_lockfree(self->level, &overflow_key, SC_TYPE_SINGLE_VALUE,
+                                                                   &self->overflow_counter);
+}
+
+static void
+_unregister_metrics(DynMetricsLimiter *self)
+{
+  stats_unregister_dynamic_counter_lockfree(self->overflow_cluster, SC_TYPE_SINGLE_VALUE, &self->overflow_counter);
+
+  stats_lock();
+  {
+    stats_unregister_counter(self->metrics.memory_key, SC_TYPE_SINGLE_VALUE, &self->metrics.memory);
+    stats_unregister_counter(self->metrics.series_key, SC_TYPE_SINGLE_VALUE, &self->metrics.series);
+  }
+  stats_unlock();
+
+  stats_cluster_key_free(self->metrics.memory_key);
+  stats_cluster_key_free(self->metrics.series_key);
+}
+
+DynMetricsLimiter *
+dyn_metrics_limiter_new(const gchar *name, gsize max_series, gint level)
+{
+  DynMetricsLimiter *self = g_new0(DynMetricsLimiter, 1);
+
+  g_assert(max_series > 0);
+
+  g_mutex_init(&self->lock);
+  self->id = (guint) g_atomic_int_add(&next_limiter_id, 1);
+  self->name = g_strdup(name);
+  self->max_series = max_series;
+  self->level = level;
+
+  self->exact = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, (GDestroyNotify) _free_exact_series);
+  _sketch_init(&self->sketch, MAX(max_series * SKETCH_SIZE_PER_SERIES, SKETCH_MIN_SIZE));
+
+  _register_metrics(self);
+  stats_counter_add(self->metrics.memory, _sketch_memory_usage(&self->sketch));
+
+  return self;
+}
+
+void
+dyn_metrics_limiter_free(DynMetricsLimiter *self)
+{
+  stats_counter_sub(self->metrics.memory, _sketch_memory_usage(&self->sketch));
+
+  GHashTableIter iter;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->exact);
+  while (g_hash_table_iter_next(&iter, NULL, &value))
+    {
+      ExactSeries *series = (ExactSeries *) value;
+
+      stats_counter_dec(self->metrics.series);
+      stats_counter_sub(self->metrics.memory, series->memory);
+    }
+  g_hash_table_destroy(self->exact);
+
+  _remove_demoted_series(self);
+  g_list_free_full(self->demoted, (GDestroyNotify) stats_cluster_key_free);
+
+  _unregister_metrics(self);
+  _sketch_destroy(&self->sketch);
+
+  g_free(self->name);
+  g_mutex_clear(&self->lock);
+  g_free(self);
+}
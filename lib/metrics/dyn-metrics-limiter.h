@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef DYN_METRICS_LIMITER_H_INCLUDED
+#define DYN_METRICS_LIMITER_H_INCLUDED
+
+#include "stats/stats-registry.h"
+#include "dyn-metrics-store.h"
+
+/*
+ * DynMetricsLimiter bounds the number of series (label sets) of a dynamic
+ * metric.
+ *
+ * At most max_series label sets are counted in their own series, the rest
+ * of the label sets are counted in a single overflow series, labeled with
+ * overflow="true".  Once the limit is reached, the label sets counted in
+ * the overflow series are tracked by a Space-Saving sketch of bounded
+ * size, and a label set that is guaranteed to be more frequent than the
+ * least frequent exact series takes its place.  The demoted series is not
+ * updated anymore, and is removed from the registry once no thread
+ * refers to it, so its last value disappears from the sums over the
+ * metric: they are not monotonic across demotions.
+ *
+ * The estimated memory usage and the number of exact series of the metric
+ * are reported as dynamic_metric_memory_bytes{metric="..."} and
+ * dynamic_metric_series{metric="..."}.
+ *
+ * The limiter is thread safe, but it is only consulted when a label set
+ * is not found in the DynMetricsStore of the thread.  Each thread also
+ * remembers the label sets it has seen overflowed, and counts them in the
+ * overflow series without locking until their accumulated weight could
+ * change the decision, or a series is demoted.
+ */
+
+typedef struct _DynMetricsLimiter DynMetricsLimiter;
+
+DynMetricsLimiter *dyn_metrics_limiter_new(const gchar *name, gsize max_series, gint level);
+void dyn_metrics_limiter_free(DynMetricsLimiter *self);
+
+gboolean dyn_metrics_limiter_admit(DynMetricsLimiter *self, const StatsClusterKey *key, gssize weight);
+void dyn_metrics_limiter_sync_cache(DynMetricsLimiter *self, DynMetricsStore *cache);
+StatsCounterItem *dyn_metrics_limiter_get_overflow_counter(DynMetricsLimiter *self);
+
+#endif
@@ -36,29 +36,19 @@ struct _DynMetricsStore
 };
 
 static StatsCluster *
-_register_single_cluster_locked(StatsClusterKey *key, gint stats_level)
+_register_single_cluster(StatsClusterKey *key, gint stats_level)
 {
-  StatsCluster *cluster;
+  StatsCounterItem *counter;
 
-  stats_lock();
-  {
-    StatsCounterItem *counter;
-    cluster = stats_register_dynamic_counter(stats_level, key, SC_TYPE_SINGLE_VALUE, &counter);
-  }
-  stats_unlock();
-
-  return cluster;
+  /* takes stats_lock() only if the cluster does not exist yet */
+  return stats_register_dynamic_counter_lockfree(stats_level, key, SC_TYPE_SINGLE_VALUE, &counter);
 }
 
 static void
-_unregister_single_cluster_locked(StatsCluster *cluster)
+_unregister_single_cluster(StatsCluster *cluster)
 {
-  stats_lock();
-  {
-    StatsCounterItem *counter = stats_cluster_single_get_counter(cluster);
-    stats_unregister_dynamic_counter(cluster, SC_TYPE_SINGLE_VALUE, &counter);
-  }
-  stats_unlock();
+  StatsCounterItem *counter = stats_cluster_single_get_counter(cluster);
+  stats_unregister_dynamic_counter_lockfree(cluster, SC_TYPE_SINGLE_VALUE, &counter);
 }
 
 DynMetricsStore *
@@ -69,7 +59,7 @@ dyn_metrics_store_new(void)
   self->clusters = g_hash_table_new_full((GHashFunc) stats_cluster_key_hash,
                                          (GEqualFunc) stats_cluster_key_equal,
                                          NULL,
-                                         (GDestroyNotify) _unregister_single_cluster_locked);
+                                         (GDestroyNotify) _unregister_single_cluster);
   self->label_buffers = g_array_new(FALSE, FALSE, sizeof(StatsClusterLabel));
 
   return self;
@@ -89,7 +79,7 @@ dyn_metrics_store_retrieve_counter(DynMetricsStore *self, StatsClusterKey *key,
   StatsCluster *cluster = g_hash_table_lookup(self->clusters, key);
   if (!cluster)
     {
-      cluster = _register_single_cluster_locked(key, level);
+      cluster = _register_single_cluster(key, level);
       if (cluster)
         g_hash_table_insert(self->clusters, &cluster->key, cluster);
     }
@@ -97,12 +87,35 @@ dyn_metrics_store_retrieve_counter(DynMetricsStore *self, StatsClusterKey *key,
   return stats_cluster_single_get_counter(cluster);
 }
 
+/* returns NULL if the counter is not in the store */
+StatsCounterItem *
+dyn_metrics_store_lookup_counter(DynMetricsStore *self, StatsClusterKey *key)
+{
+  StatsCluster *cluster = g_hash_table_lookup(self->clusters, key);
+  if (!cluster)
+    return NULL;
+
+  return stats_cluster_single_get_counter(cluster);
+}
+
 gboolean
 dyn_metrics_store_remove_counter(DynMetricsStore *self, StatsClusterKey *key)
 {
   return g_hash_table_remove(self->clusters, key);
 }
 
+static gboolean
+_cluster_has_name(gpointer key, gpointer value, gpointer user_data)
+{
+  return strcmp(((StatsClusterKey *) key)->name, (const gchar *) user_data) == 0;
+}
+
+void
+dyn_metrics_store_remove_counters_by_name(DynMetricsStore *self, const gchar *name)
+{
+  g_hash_table_foreach_remove(self->clusters, _cluster_has_name, (gpointer) name);
+}
+
 void
 dyn_metrics_store_reset(DynMetricsStore *self)
 {
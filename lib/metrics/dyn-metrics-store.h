@@ -56,7 +56,9 @@ DynMetricsStore *dyn_metrics_store_new(void);
 void dyn_metrics_store_free(DynMetricsStore *self);
 
 StatsCounterItem *dyn_metrics_store_retrieve_counter(DynMetricsStore *self, StatsClusterKey *key, gint level);
+StatsCounterItem *dyn_metrics_store_lookup_counter(DynMetricsStore *self, StatsClusterKey *key);
 gboolean dyn_metrics_store_remove_counter(DynMetricsStore *self, StatsClusterKey *key);
+void dyn_metrics_store_remove_counters_by_name(DynMetricsStore *self, const gchar *name);
 void dyn_metrics_store_reset(DynMetricsStore *self);
 void dyn_metrics_store_merge(DynMetricsStore *self, DynMetricsStore *other);
 
@@ -34,6 +34,12 @@ dyn_metrics_template_set_level(DynMetricsTemplate *self, gint level)
   self->level = level;
 }
 
+void
+dyn_metrics_template_set_max_series(DynMetricsTemplate *self, gsize max_series)
+{
+  self->max_series = max_series;
+}
+
 void
 dyn_metrics_template_add_label_template(DynMetricsTemplate *self, const gchar *label, LogTemplate *value_template)
 {
@@ -108,10 +114,14 @@ _build_sck(DynMetricsTemplate *self, LogTemplateOptions *template_options, LogMe
                                dyn_metrics_store_get_cached_labels_len(cache));
 }
 
+/*
+ * increment is the value the returned counter is going to be incremented
+ * with, it is used to rank the label sets when max-series() is set.
+ */
 StatsCounterItem *
 dyn_metrics_template_get_stats_counter(DynMetricsTemplate *self,
                                        LogTemplateOptions *template_options,
-                                       LogMessage *msg)
+                                       LogMessage *msg, gssize increment)
 {
   DynMetricsStore *cache = dyn_metrics_cache();
 
@@ -121,7 +131,17 @@ dyn_metrics_template_get_stats_counter(DynMetricsTemplate *self,
   scratch_buffers_mark(&marker);
   _build_sck(self, template_options, msg, cache, &key);
 
-  StatsCounterItem *counter = dyn_metrics_store_retrieve_counter(cache, &key, self->level);
+  if (self->limiter)
+    dyn_metrics_limiter_sync_cache(self->limiter, cache);
+
+  StatsCounterItem *counter = dyn_metrics_store_lookup_counter(cache, &key);
+  if (!counter)
+    {
+      if (!self->limiter || dyn_metrics_limiter_admit(self->limiter, &key, increment))
+        counter = dyn_metrics_store_retrieve_counter(cache, &key, self->level);
+      else
+        counter = dyn_metrics_limiter_get_overflow_counter(self->limiter);
+    }
 
   scratch_buffers_reclaim_marked(marker);
   return counter;
@@ -131,6 +151,10 @@ gboolean
 dyn_metrics_template_init(DynMetricsTemplate *self)
 {
   self->label_templates = g_list_sort(self->label_templates, (GCompareFunc) label_template_compare);
+
+  if (self->max_series > 0 && !self->limiter)
+    self->limiter = dyn_metrics_limiter_new(self->key, self->max_series, self->level);
+
   return TRUE;
 }
 
@@ -146,6 +170,8 @@ dyn_metrics_template_new(GlobalConfig *cfg)
 void
 dyn_metrics_template_free(DynMetricsTemplate *self)
 {
+  if (self->limiter)
+    dyn_metrics_limiter_free(self->limiter);
   g_free(self->key);
   g_list_free_full(self->label_templates, (GDestroyNotify) label_template_free);
   value_pairs_unref(self->vp);
@@ -158,6 +184,7 @@ dyn_metrics_template_clone(DynMetricsTemplate *self, GlobalConfig *cfg)
   DynMetricsTemplate *cloned = dyn_metrics_template_new(cfg);
   dyn_metrics_template_set_key(cloned, self->key);
   dyn_metrics_template_set_level(cloned, self->level);
+  dyn_metrics_template_set_max_series(cloned, self->max_series);
 
   for (GList *elem = g_list_first(self->label_templates); elem; elem = elem->next)
     {
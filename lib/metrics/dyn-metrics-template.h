@@ -27,6 +27,7 @@
 #include "template/templates.h"
 #include "value-pairs/value-pairs.h"
 #include "stats/stats-cluster.h"
+#include "dyn-metrics-limiter.h"
 
 /*
  * DynMetricsTemplate utilizes dyn-metrics-cache to achieve better performance
@@ -39,16 +40,19 @@ typedef struct _DynMetricsTemplate
   GList *label_templates;
   ValuePairs *vp;
   gint level;
+  gsize max_series;
+  DynMetricsLimiter *limiter;
 } DynMetricsTemplate;
 
 void dyn_metrics_template_set_key(DynMetricsTemplate *s, const gchar *key);
 void dyn_metrics_template_add_label_template(DynMetricsTemplate *s, const gchar *label, LogTemplate *value_template);
 void dyn_metrics_template_set_level(DynMetricsTemplate *s, gint level);
+void dyn_metrics_template_set_max_series(DynMetricsTemplate *s, gsize max_series);
 ValuePairs *dyn_metrics_template_get_value_pairs(DynMetricsTemplate *s);
 gboolean dyn_metrics_template_is_enabled(DynMetricsTemplate *self);
 StatsCounterItem *dyn_metrics_template_get_stats_counter(DynMetricsTemplate *self,
                                                          LogTemplateOptions *template_options,
-                                                         LogMessage *msg);
+                                                         LogMessage *msg, gssize increment);
 gboolean dyn_metrics_template_init(DynMetricsTemplate *self);
 
 DynMetricsTemplate *dyn_metrics_template_new(GlobalConfig *cfg);
@@ -55,31 +55,27 @@ msg_stats_update_counters(const gchar *source_id, const LogMessage *msg)
   if (stats_syslog_stats() == CYNA_YES
       || (stats_syslog_stats() == CYNA_AUTO && stats_check_level(2)))
     {
-      stats_lock();
-
       StatsClusterKey sc_key;
       stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_HOST | SCS_SOURCE, NULL, log_msg_get_value(msg, LM_V_HOST, NULL) );
-      stats_register_and_increment_dynamic_counter(0, &sc_key, msg->timestamps[LM_TS_RECVD].ut_sec);
+      stats_register_and_increment_dynamic_counter_lockfree(0, &sc_key, msg->timestamps[LM_TS_RECVD].ut_sec);
 
       if (stats_syslog_stats() == CYNA_YES
           || (stats_syslog_stats() == CYNA_AUTO && stats_check_level(3)))
         {
           stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_SENDER | SCS_SOURCE, NULL, log_msg_get_value(msg, LM_V_HOST_FROM,
                                                NULL) );
-          stats_register_and_increment_dynamic_counter(0, &sc_key, msg->timestamps[LM_TS_RECVD].ut_sec);
+          stats_register_and_increment_dynamic_counter_lockfree(0, &sc_key, msg->timestamps[LM_TS_RECVD].ut_sec);
           stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_PROGRAM | SCS_SOURCE, NULL, log_msg_get_value(msg, LM_V_PROGRAM,
                                                NULL) );
-          stats_register_and_increment_dynamic_counter(0, &sc_key, msg->timestamps[LM_TS_RECVD].ut_sec);
+          stats_register_and_increment_dynamic_counter_lockfree(0, &sc_key, msg->timestamps[LM_TS_RECVD].ut_sec);
 
           stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_HOST | SCS_SOURCE, source_id, log_msg_get_value(msg, LM_V_HOST,
                                                NULL));
-          stats_register_and_increment_dynamic_counter(0, &sc_key, msg->timestamps[LM_TS_RECVD].ut_sec);
+          stats_register_and_increment_dynamic_counter_lockfree(0, &sc_key, msg->timestamps[LM_TS_RECVD].ut_sec);
           stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_SENDER | SCS_SOURCE, source_id, log_msg_get_value(msg, LM_V_HOST_FROM,
                                                NULL));
-          stats_register_and_increment_dynamic_counter(0, &sc_key, msg->timestamps[LM_TS_RECVD].ut_sec);
+          stats_register_and_increment_dynamic_counter_lockfree(0, &sc_key, msg->timestamps[LM_TS_RECVD].ut_sec);
         }
-
-      stats_unlock();
     }
   _process_message_pri(msg->pri);
 }
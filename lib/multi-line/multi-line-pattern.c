@@ -67,6 +67,7 @@ multi_line_pattern_compile(const gchar *regexp, GError **error)
                 evt_tag_str("error", (gchar *) error_message));
     }
 
+  regexp_prefilter_init(&self->prefilter, self->pattern, regexp, FALSE);
   return self;
 error:
   if (self->pattern)
@@ -87,10 +88,12 @@ multi_line_pattern_find(MultiLinePattern *re, const guchar *str, gsize len, gint
   if (!re)
     return FALSE;
 
+  if (!regexp_prefilter_may_match(&re->prefilter, (const gchar *) str, len))
+    return FALSE;
+
   gboolean result = FALSE;
   pcre2_match_data *match_data = pcre2_match_data_create_from_pattern(re->pattern, NULL);
 
-
   if (multi_line_pattern_eval(re, str, len, match_data) < 0)
     goto exit;
 
@@ -114,6 +117,9 @@ multi_line_pattern_match(MultiLinePattern *re, const guchar *str, gsize len)
   if (!re)
     return FALSE;
 
+  if (!regexp_prefilter_may_match(&re->prefilter, (const gchar *) str, len))
+    return FALSE;
+
   gboolean result = FALSE;
   pcre2_match_data *match_data = pcre2_match_data_create_from_pattern(re->pattern, NULL);
 
@@ -145,6 +151,7 @@ multi_line_pattern_unref(MultiLinePattern *self)
     {
       if (self->pattern)
         pcre2_code_free(self->pattern);
+      regexp_prefilter_destroy(&self->prefilter);
       g_free(self);
     }
 }
@@ -28,12 +28,14 @@
 
 #include "syslog-ng.h"
 #include "compat/pcre.h"
+#include "regexp-prefilter.h"
 
 typedef struct _MultiLinePattern MultiLinePattern;
 struct _MultiLinePattern
 {
   gint ref_cnt;
   pcre2_code *pattern;
+  RegexpPrefilter prefilter;
 };
 
 gboolean multi_line_pattern_find(MultiLinePattern *re, const guchar *str, gsize len, gint *start, gint *end);
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "path-tracer.h"
+#include "logpipe.h"
+#include "cfg-tree.h"
+#include "mainloop-worker.h"
+#include "utf8utils.h"
+#include "tls-support.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct _PathTraceHop
+{
+  guint64 offset_ns;
+  const gchar *kind;
+  gint thread;
+  gchar name[PATH_TRACER_HOP_NAME_MAX];
+} PathTraceHop;
+
+typedef struct _PathTrace
+{
+  gint id;
+  UnixTime received;
+  guint64 start_ns;
+  guint64 duration_ns;
+  /* number of hops recorded, including the ones that did not fit into hops */
+  gint num_hops;
+  PathTraceHop hops[PATH_TRACER_MAX_HOPS];
+} PathTrace;
+
+/*
+ * Traces of the messages currently in flight, keyed by the message.  A
+ * slot is claimed with a CAS on msg and only released by the thread
+ * freeing the message, so a reader that finds its message in a slot can
+ * use the trace without further synchronization.
+ */
+typedef struct _PathTracerSlot
+{
+  LogMessage *msg;
+  PathTrace *trace;
+} PathTracerSlot;
+
+G_STATIC_ASSERT((PATH_TRACER_MAX_ACTIVE & (PATH_TRACER_MAX_ACTIVE - 1)) == 0);
+
+TLS_BLOCK_START
+{
+  /* messages left until the next traced one */
+  gint path_tracer_countdown;
+}
+TLS_BLOCK_END;
+
+#define path_tracer_countdown __tls_deref(path_tracer_countdown)
+
+gboolean path_tracer_running;
+
+static gint path_tracer_sampling = PATH_TRACER_DEFAULT_SAMPLING;
+static gint next_trace_id;
+static PathTracerSlot active_traces[PATH_TRACER_MAX_ACTIVE];
+
+/* the most recent completed traces, completed_head is the next slot to be written */
+static PathTrace *completed_traces[PATH_TRACER_RING_SIZE];
+static gint completed_head;
+
+static inline guint64
+_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (guint64) ts.tv_sec * G_USEC_PER_SEC * 1000 + ts.tv_nsec;
+}
+
+static PathTrace *
+_exchange_trace(PathTrace **location, PathTrace *new_trace)
+{
+  PathTrace *old_trace;
+
+  do
+    old_trace = g_atomic_pointer_get(location);
+  while (!g_atomic_pointer_compare_and_exchange(location, old_trace, new_trace));
+
+  return old_trace;
+}
+
+static inline guint
+_slot_index(LogMessage *msg)
+{
+  return (((gsize) msg >> 4) * 2654435761u) & (PATH_TRACER_MAX_ACTIVE - 1);
+}
+
+static gboolean
+_activate(LogMessage *msg, PathTrace *trace)
+{
+  guint start = _slot_index(msg);
+
+  for (guint probes = 0; probes < PATH_TRACER_MAX_ACTIVE; probes++)
+    {
+      PathTracerSlot *slot = &active_traces[(start + probes) & (PATH_TRACER_MAX_ACTIVE - 1)];
+
+      if (g_atomic_pointer_compare_and_exchange(&slot->msg, NULL, msg))
+        {
+          g_atomic_pointer_set(&slot->trace, trace);
+          return TRUE;
+        }
+    }
+  return FALSE;
+}
+
+static PathTracerSlot *
+_lookup_slot(LogMessage *msg)
+{
+  guint start = _slot_index(msg);
+
+  for (guint probes = 0; probes < PATH_TRACER_MAX_ACTIVE; probes++)
+    {
+      PathTracerSlot *slot = &active_traces[(start + probes) & (PATH_TRACER_MAX_ACTIVE - 1)];
+
+      if (g_atomic_pointer_get(&slot->msg) == msg)
+        return slot;
+    }
+  return NULL;
+}
+
+/* clones share the trace of the message they were cloned from */
+static PathTrace *
+_lookup_trace(LogMessage *msg)
+{
+  while (msg->original)
+    msg = msg->original;
+
+  PathTracerSlot *slot = _lookup_slot(msg);
+  return slot ? g_atomic_pointer_get(&slot->trace) : NULL;
+}
+
+static void
+_record(PathTrace *trace, const gchar *kind, const gchar *name)
+{
+  gint index = g_atomic_int_add(&trace->num_hops, 1);
+
+  if (index >= PATH_TRACER_MAX_HOPS)
+    return;
+
+  PathTraceHop *hop = &trace->hops[index];
+  hop->offset_ns = _now_ns() - trace->start_ns;
+  hop->kind = kind;
+  hop->thread = main_loop_worker_get_thread_index();
+  g_strlcpy(hop->name, name ? : "", sizeof(hop->name));
+}
+
+static const gchar *
+_format_pipe_name(LogPipe *pipe, gchar *buf, gsize buf_len)
+{
+  gchar location[PATH_TRACER_HOP_NAME_MAX];
+
+  g_snprintf(buf, buf_len, "%s@%s",
+             pipe->plugin_name ? : "pipe",
+             log_expr_node_format_location(pipe->expr_node, location, sizeof(location)));
+  return buf;
+}
+
+/*
+ * Called by sources for each message while the tracer is running, traces
+ * one out of every N messages on the thread.
+ */
+void
+path_tracer_sample(LogPipe *source, LogMessage *msg)
+{
+  if (path_tracer_countdown > 0)
+    {
+      path_tracer_countdown--;
+      return;
+    }
+  path_tracer_countdown = g_atomic_int_get(&path_tracer_sampling) - 1;
+
+  if (path_tracer_is_traced(msg) || msg->original)
+    return;
+
+  PathTrace *trace = g_new0(PathTrace, 1);
+  trace->id = g_atomic_int_add(&next_trace_id, 1) + 1;
+  trace->received = msg->timestamps[LM_TS_RECVD];
+  trace->start_ns = _now_ns();
+
+  /* too many messages in flight are traced already */
+  if (!_activate(msg, trace))
+    {
+      g_free(trace);
+      return;
+    }
+
+  msg->flags |= LF_STATE_PATH_TRACED;
+
+  gchar name[PATH_TRACER_HOP_NAME_MAX];
+  _record(trace, "source", _format_pipe_name(source, name, sizeof(name)));
+}
+
+void
+path_tracer_record_pipe(LogPipe *pipe, LogMessage *msg)
+{
+  PathTrace *trace = _lookup_trace(msg);
+
+  if (!trace)
+    return;
+
+  gchar name[PATH_TRACER_HOP_NAME_MAX];
+  _record(trace, "pipe", _format_pipe_name(pipe, name, sizeof(name)));
+}
+
+void
+path_tracer_record_hop(LogMessage *msg, const gchar *kind, const gchar *name)
+{
+  PathTrace *trace = _lookup_trace(msg);
+
+  if (!trace)
+    return;
+
+  _record(trace, kind, name);
+}
+
+static gint
+_compare_hops(gconstpointer a, gconstpointer b)
+{
+  const PathTraceHop *ha = a;
+  const PathTraceHop *hb = b;
+
+  if (ha->offset_ns == hb->offset_ns)
+    return 0;
+  return ha->offset_ns < hb->offset_ns ? -1 : 1;
+}
+
+/*
+ * Called when a traced message is freed: no other thread can refer to it
+ * or to its clones anymore, so the trace is complete.
+ */
+void
+path_tracer_finish(LogMessage *msg)
+{
+  PathTracerSlot *slot = _lookup_slot(msg);
+
+  if (!slot)
+    return;
+
+  PathTrace *trace = g_atomic_pointer_get(&slot->trace);
+  g_atomic_pointer_set(&slot->trace, NULL);
+  g_atomic_pointer_set(&slot->msg, NULL);
+
+  if (!trace)
+    return;
+
+  trace->duration_ns = _now_ns() - trace->start_ns;
+
+  /* hops of different threads may have been stored out of order */
+  qsort(trace->hops, MIN(trace->num_hops, PATH_TRACER_MAX_HOPS), sizeof(PathTraceHop), _compare_hops);
+
+  guint index = (guint) g_atomic_int_add(&completed_head, 1) % PATH_TRACER_RING_SIZE;
+  g_free(_exchange_trace(&completed_traces[index], trace));
+}
+
+/* traces in flight are completed even after the tracer is stopped */
+void
+path_tracer_start(gint sampling)
+{
+  g_atomic_int_set(&path_tracer_sampling, sampling > 0 ? sampling : PATH_TRACER_DEFAULT_SAMPLING);
+  g_atomic_int_set(&path_tracer_running, TRUE);
+}
+
+void
+path_tracer_stop(void)
+{
+  g_atomic_int_set(&path_tracer_running, FALSE);
+}
+
+static void
+_append_json_string(GString *result, const gchar *str)
+{
+  g_string_append_c(result, '"');
+  append_unsafe_utf8_as_escaped_text(result, str, -1, AUTF8_UNSAFE_QUOTE);
+  g_string_append_c(result, '"');
+}
+
+static void
+_format_trace(GString *result, PathTrace *trace)
+{
+  gint num_hops = MIN(trace->num_hops, PATH_TRACER_MAX_HOPS);
+
+  g_string_append_printf(result,
+                         "{\"id\":%d,\"received\":%" G_GINT64_FORMAT ".%06u,\"duration_ns\":%" G_GUINT64_FORMAT
+                         ",\"dropped_hops\":%d,\"hops\":[",
+                         trace->id, trace->received.ut_sec, trace->received.ut_usec, trace->duration_ns,
+                         trace->num_hops - num_hops);
+
+  for (gint i = 0; i < num_hops; i++)
+    {
+      PathTraceHop *hop = &trace->hops[i];
+
+      if (i > 0)
+        g_string_append_c(result, ',');
+      g_string_append_printf(result, "{\"offset_ns\":%" G_GUINT64_FORMAT ",\"thread\":%d,\"kind\":",
+                             hop->offset_ns, hop->thread);
+      _append_json_string(result, hop->kind);
+      g_string_append(result, ",\"name\":");
+      _append_json_string(result, hop->name);
+      g_string_append_c(result, '}');
+    }
+  g_string_append(result, "]}");
+}
+
+/*
+ * The completed traces as a JSON array, oldest first.  The ring buffer is
+ * not locked: each trace is taken out of its slot while being formatted,
+ * and put back unless a newer trace has been stored there in the meantime.
+ */
+void
+path_tracer_format_json(GString *result)
+{
+  gboolean first = TRUE;
+  guint head = (guint) g_atomic_int_get(&completed_head);
+
+  g_string_append_c(result, '[');
+  for (guint i = 0; i < PATH_TRACER_RING_SIZE; i++)
+    {
+      PathTrace **location = &completed_traces[(head + i) % PATH_TRACER_RING_SIZE];
+      PathTrace *trace = _exchange_trace(location, NULL);
+
+      if (!trace)
+        continue;
+
+      if (!first)
+        g_string_append_c(result, ',');
+      first = FALSE;
+      _format_trace(result, trace);
+
+      if (!g_atomic_pointer_compare_and_exchange(location, NULL, trace))
+        g_free(trace);
+    }
+  g_string_append_c(result, ']');
+}
+
+void
+path_tracer_global_deinit(void)
+{
+  path_tracer_stop();
+
+  for (gint i = 0; i < PATH_TRACER_MAX_ACTIVE; i++)
+    {
+      g_free(_exchange_trace(&active_traces[i].trace, NULL));
+      g_atomic_pointer_set(&active_traces[i].msg, NULL);
+    }
+
+  for (gint i = 0; i < PATH_TRACER_RING_SIZE; i++)
+    g_free(_exchange_trace(&completed_traces[i], NULL));
+}
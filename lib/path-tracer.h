@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef PATH_TRACER_H_INCLUDED
+#define PATH_TRACER_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "logmsg/logmsg.h"
+
+/*
+ * Sampled message path tracing.
+ *
+ * When running, one out of every N messages received by a source on a
+ * thread is marked with LF_STATE_PATH_TRACED.  Every config related
+ * LogPipe (parsers, filters, FilterX blocks, destinations, ...) and
+ * LogQueue the message (or any of its clones) passes records a hop with
+ * a monotonic timestamp, relative to the reception of the message.  The
+ * trace is complete when the message is freed, i.e. when every
+ * destination has acknowledged it, and is then kept in a ring buffer of
+ * the most recent traces.
+ *
+ * Unlike the debugger, tracing never blocks the processing of the
+ * message, recording a hop does not take any locks.  Messages not traced
+ * only pay for a flag check.
+ */
+
+#define PATH_TRACER_DEFAULT_SAMPLING 1000
+#define PATH_TRACER_MAX_HOPS 64
+#define PATH_TRACER_HOP_NAME_MAX 128
+/* messages traced at the same time */
+#define PATH_TRACER_MAX_ACTIVE 256
+/* completed traces kept */
+#define PATH_TRACER_RING_SIZE 128
+
+extern gboolean path_tracer_running;
+
+void path_tracer_sample(LogPipe *source, LogMessage *msg);
+void path_tracer_record_pipe(LogPipe *pipe, LogMessage *msg);
+void path_tracer_record_hop(LogMessage *msg, const gchar *kind, const gchar *name);
+void path_tracer_finish(LogMessage *msg);
+
+static inline gboolean
+path_tracer_is_traced(LogMessage *msg)
+{
+  return (msg->flags & LF_STATE_PATH_TRACED) != 0;
+}
+
+void path_tracer_start(gint sampling);
+void path_tracer_stop(void);
+
+void path_tracer_format_json(GString *result);
+
+void path_tracer_global_deinit(void);
+
+#endif
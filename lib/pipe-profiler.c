@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "pipe-profiler.h"
+#include "tls-support.h"
+
+#include <string.h>
+#include <time.h>
+
+typedef struct _PipeProfilerFrame
+{
+  gchar name[PIPE_PROFILER_FRAME_NAME_MAX];
+  guint64 start_ns;
+  guint64 child_ns;
+} PipeProfilerFrame;
+
+typedef struct _PipeProfilerNode
+{
+  guint64 calls;
+  guint64 self_ns;
+  guint64 total_ns;
+} PipeProfilerNode;
+
+TLS_BLOCK_START
+{
+  /* frames of the message being profiled on this thread */
+  PipeProfilerFrame profiler_frames[PIPE_PROFILER_MAX_DEPTH];
+  gint profiler_depth;
+
+  /* frames that did not fit into profiler_frames */
+  gint profiler_overflow;
+
+  /* nesting level of log_pipe_queue() calls of a message that is not sampled */
+  gint profiler_skip_depth;
+
+  /* messages left until the next sampled one */
+  gint profiler_countdown;
+}
+TLS_BLOCK_END;
+
+#define profiler_frames      __tls_deref(profiler_frames)
+#define profiler_depth       __tls_deref(profiler_depth)
+#define profiler_overflow    __tls_deref(profiler_overflow)
+#define profiler_skip_depth  __tls_deref(profiler_skip_depth)
+#define profiler_countdown   __tls_deref(profiler_countdown)
+
+gboolean pipe_profiler_running;
+
+static GMutex profiler_lock;
+static gint profiler_sampling = PIPE_PROFILER_DEFAULT_SAMPLING;
+static guint64 profiler_sampled_messages;
+static GHashTable *profiler_nodes;
+static GHashTable *profiler_stacks;
+
+static inline guint64
+_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (guint64) ts.tv_sec * G_USEC_PER_SEC * 1000 + ts.tv_nsec;
+}
+
+/*
+ * Called when a message enters a config related LogPipe.  Returns TRUE
+ * if the call is to be profiled, FALSE otherwise, in which case
+ * pipe_profiler_end_skip() must be called once the pipe returns.
+ *
+ * The decision is made when the message enters the pipeline (e.g. there's
+ * no ongoing call on this thread), everything called from there inherits
+ * it.
+ */
+gboolean
+pipe_profiler_should_sample(void)
+{
+  if (profiler_depth > 0)
+    return TRUE;
+
+  if (profiler_skip_depth > 0)
+    {
+      profiler_skip_depth++;
+      return FALSE;
+    }
+
+  if (profiler_countdown > 0)
+    {
+      profiler_countdown--;
+      profiler_skip_depth++;
+      return FALSE;
+    }
+
+  profiler_countdown = g_atomic_int_get(&profiler_sampling) - 1;
+  g_mutex_lock(&profiler_lock);
+  profiler_sampled_messages++;
+  g_mutex_unlock(&profiler_lock);
+  return TRUE;
+}
+
+void
+pipe_profiler_end_skip(void)
+{
+  g_assert(profiler_skip_depth > 0);
+  profiler_skip_depth--;
+}
+
+gboolean
+pipe_profiler_is_sampling(void)
+{
+  return profiler_depth > 0;
+}
+
+void
+pipe_profiler_enter(const gchar *frame_name)
+{
+  if (profiler_depth + profiler_overflow >= PIPE_PROFILER_MAX_DEPTH)
+    {
+      profiler_overflow++;
+      return;
+    }
+
+  PipeProfilerFrame *frame = &profiler_frames[profiler_depth++];
+
+  g_strlcpy(frame->name, frame_name, sizeof(frame->name));
+  frame->child_ns = 0;
+  frame->start_ns = _now_ns();
+}
+
+static void
+_append_stack(GString *stack)
+{
+  for (gint i = 0; i < profiler_depth; i++)
+    {
+      if (i > 0)
+        g_string_append_c(stack, ';');
+
+      /* ';' separates the frames in the collapsed stack format */
+      for (const gchar *p = profiler_frames[i].name; *p; p++)
+        g_string_append_c(stack, *p == ';' ? '_' : *p);
+    }
+}
+
+static void
+_record_frame(PipeProfilerFrame *frame, guint64 elapsed_ns, guint64 self_ns)
+{
+  GString *stack = g_string_sized_new(256);
+  _append_stack(stack);
+
+  g_mutex_lock(&profiler_lock);
+  if (!profiler_nodes)
+    goto exit;
+
+  PipeProfilerNode *node = g_hash_table_lookup(profiler_nodes, frame->name);
+  if (!node)
+    {
+      node = g_new0(PipeProfilerNode, 1);
+      g_hash_table_insert(profiler_nodes, g_strdup(frame->name), node);
+    }
+  node->calls++;
+  node->self_ns += self_ns;
+  node->total_ns += elapsed_ns;
+
+  guint64 *stack_ns = g_hash_table_lookup(profiler_stacks, stack->str);
+  if (!stack_ns)
+    {
+      stack_ns = g_new0(guint64, 1);
+      g_hash_table_insert(profiler_stacks, g_strdup(stack->str), stack_ns);
+    }
+  *stack_ns += self_ns;
+
+exit:
+  g_mutex_unlock(&profiler_lock);
+  g_string_free(stack, TRUE);
+}
+
+void
+pipe_profiler_leave(void)
+{
+  if (profiler_overflow > 0)
+    {
+      profiler_overflow--;
+      return;
+    }
+
+  g_assert(profiler_depth > 0);
+
+  PipeProfilerFrame *frame = &profiler_frames[profiler_depth - 1];
+  guint64 elapsed_ns = _now_ns() - frame->start_ns;
+  guint64 self_ns = elapsed_ns > frame->child_ns ? elapsed_ns - frame->child_ns : 0;
+
+  _record_frame(frame, elapsed_ns, self_ns);
+
+  profiler_depth--;
+  if (profiler_depth > 0)
+    profiler_frames[profiler_depth - 1].child_ns += elapsed_ns;
+}
+
+static void
+_reset_locked(void)
+{
+  if (profiler_nodes)
+    g_hash_table_remove_all(profiler_nodes);
+  else
+    profiler_nodes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+  if (profiler_stacks)
+    g_hash_table_remove_all(profiler_stacks);
+  else
+    profiler_stacks = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+  profiler_sampled_messages = 0;
+}
+
+void
+pipe_profiler_start(gint sampling)
+{
+  g_mutex_lock(&profiler_lock);
+  _reset_locked();
+  g_atomic_int_set(&profiler_sampling, sampling > 0 ? sampling : PIPE_PROFILER_DEFAULT_SAMPLING);
+  g_mutex_unlock(&profiler_lock);
+
+  g_atomic_int_set(&pipe_profiler_running, TRUE);
+}
+
+/* stops collecting samples, the results are kept until the next start/reset */
+void
+pipe_profiler_stop(void)
+{
+  g_atomic_int_set(&pipe_profiler_running, FALSE);
+}
+
+void
+pipe_profiler_reset(void)
+{
+  g_mutex_lock(&profiler_lock);
+  _reset_locked();
+  g_mutex_unlock(&profiler_lock);
+}
+
+typedef struct _PipeProfilerReportEntry
+{
+  const gchar *name;
+  PipeProfilerNode *node;
+} PipeProfilerReportEntry;
+
+static gint
+_compare_by_self_time(gconstpointer a, gconstpointer b)
+{
+  const PipeProfilerReportEntry *ea = a;
+  const PipeProfilerReportEntry *eb = b;
+
+  if (ea->node->self_ns != eb->node->self_ns)
+    return ea->node->self_ns < eb->node->self_ns ? 1 : -1;
+  return strcmp(ea->name, eb->name);
+}
+
+/*
+ * Frames ranked by the time spent in them, excluding the time of the
+ * frames called from them.
+ */
+void
+pipe_profiler_format_report(GString *result)
+{
+  g_mutex_lock(&profiler_lock);
+
+  g_string_append_printf(result, "profiler: %s, sampling: 1/%d, profiled messages: %" G_GUINT64_FORMAT "\n",
+                         pipe_profiler_running ? "running" : "stopped",
+                         g_atomic_int_get(&profiler_sampling), profiler_sampled_messages);
+
+  if (!profiler_nodes || g_hash_table_size(profiler_nodes) == 0)
+    goto exit;
+
+  GArray *entries = g_array_sized_new(FALSE, FALSE, sizeof(PipeProfilerReportEntry),
+                                      g_hash_table_size(profiler_nodes));
+  guint64 self_ns_total = 0;
+
+  GHashTableIter iter;
+  gpointer key, value;
+  g_hash_table_iter_init(&iter, profiler_nodes);
+  while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+      PipeProfilerReportEntry entry = { .name = key, .node = value };
+      g_array_append_val(entries, entry);
+      self_ns_total += entry.node->self_ns;
+    }
+  g_array_sort(entries, _compare_by_self_time);
+
+  g_string_append_printf(result, "%7s %14s %14s %10s %s\n", "self%", "self_ns", "total_ns", "calls", "frame");
+  for (guint i = 0; i < entries->len; i++)
+    {
+      PipeProfilerReportEntry *entry = &g_array_index(entries, PipeProfilerReportEntry, i);
+
+      g_string_append_printf(result, "%6.2f%% %14" G_GUINT64_FORMAT " %14" G_GUINT64_FORMAT " %10" G_GUINT64_FORMAT " %s\n",
+                             self_ns_total ? 100.0 * entry->node->self_ns / self_ns_total : 0.0,
+                             entry->node->self_ns, entry->node->total_ns, entry->node->calls, entry->name);
+    }
+  g_array_free(entries, TRUE);
+
+exit:
+  g_mutex_unlock(&profiler_lock);
+}
+
+/*
+ * One line per distinct stack with the self time of its innermost frame,
+ * in the format expected by flamegraph.pl and compatible tools.
+ */
+void
+pipe_profiler_format_collapsed_stacks(GString *result)
+{
+  g_mutex_lock(&profiler_lock);
+  if (!profiler_stacks)
+    goto exit;
+
+  GHashTableIter iter;
+  gpointer key, value;
+  g_hash_table_iter_init(&iter, profiler_stacks);
+  while (g_hash_table_iter_next(&iter, &key, &value))
+    g_string_append_printf(result, "%s %" G_GUINT64_FORMAT "\n", (const gchar *) key, *(guint64 *) value);
+
+exit:
+  g_mutex_unlock(&profiler_lock);
+}
+
+void
+pipe_profiler_global_deinit(void)
+{
+  pipe_profiler_stop();
+
+  g_mutex_lock(&profiler_lock);
+  g_clear_pointer(&profiler_nodes, g_hash_table_unref);
+  g_clear_pointer(&profiler_stacks, g_hash_table_unref);
+  g_mutex_unlock(&profiler_lock);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef PIPE_PROFILER_H_INCLUDED
+#define PIPE_PROFILER_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/*
+ * Built-in sampling profiler for the processing pipeline.
+ *
+ * When running, one out of every N messages entering the pipeline on a
+ * thread is profiled: the time spent in each config related LogPipe and
+ * FilterXExpr is measured and accumulated per frame (the location of the
+ * element in the configuration), both as self time (excluding the
+ * elements called from it) and as total time.  The call stacks are also
+ * recorded, so the results can be rendered as flame graphs.
+ *
+ * The per-element hooks only check pipe_profiler_running, unless the
+ * profiler is started, so it costs nothing when it is not in use.
+ */
+
+#define PIPE_PROFILER_MAX_DEPTH 32
+#define PIPE_PROFILER_FRAME_NAME_MAX 128
+#define PIPE_PROFILER_DEFAULT_SAMPLING 100
+
+extern gboolean pipe_profiler_running;
+
+gboolean pipe_profiler_should_sample(void);
+void pipe_profiler_end_skip(void);
+gboolean pipe_profiler_is_sampling(void);
+
+void pipe_profiler_enter(const gchar *frame_name);
+void pipe_profiler_leave(void);
+
+void pipe_profiler_start(gint sampling);
+void pipe_profiler_stop(void);
+void pipe_profiler_reset(void);
+
+void pipe_profiler_format_report(GString *result);
+void pipe_profiler_format_collapsed_stacks(GString *result);
+
+void pipe_profiler_global_deinit(void);
+
+#endif
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ * Copyright (c) 2024 shifter
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "regexp-prefilter.h"
+#include "stats/stats-registry.h"
+#include "apphook.h"
+
+#include <string.h>
+
+static StatsCounterItem *regexp_prefilter_rejections;
+
+static gboolean
+_is_metachar(gchar c)
+{
+  return strchr("\\^$.[]|()?*+{}", c) != NULL;
+}
+
+static gboolean
+_is_quantifier(gchar c)
+{
+  return c == '?' || c == '*' || c == '{';
+}
+
+/*
+ * Collects the literal characters the pattern starts with.  The analysis is
+ * conservative: it stops at the first metacharacter, escape sequence with a
+ * special meaning or non-ASCII character, and gives up completely if the
+ * pattern contains an alternation anywhere, as in that case the literal
+ * might belong to a single branch only.
+ */
+static void
+_extract_literal(RegexpPrefilter *self, const gchar *pattern)
+{
+  const gchar *p = pattern;
+  GString *literal;
+
+  if (strchr(pattern, '|'))
+    return;
+
+  if (*p == '^')
+    {
+      self->anchored = TRUE;
+      p++;
+    }
+  else if (p[0] == '\\' && p[1] == 'A')
+    {
+      self->anchored = TRUE;
+      p += 2;
+    }
+
+  literal = g_string_new("");
+  while (*p)
+    {
+      gchar c;
+
+      if (*p == '\\' && p[1] && g_ascii_ispunct(p[1]))
+        {
+          c = p[1];
+          p += 2;
+        }
+      else if (_is_metachar(*p) || !g_ascii_isprint(*p))
+        {
+          break;
+        }
+      else
+        {
+          c = *p;
+          p++;
+        }
+
+      /* an optional character is not part of the required literal */
+      if (_is_quantifier(*p))
+        break;
+
+      g_string_append_c(literal, c);
+    }
+
+  self->literal_len = literal->len;
+  if (literal->len > 0)
+    self->literal = g_string_free(literal, FALSE);
+  else
+    g_string_free(literal, TRUE);
+}
+
+void
+regexp_prefilter_init(RegexpPrefilter *self, pcre2_code *compiled, const gchar *pattern, gboolean caseless)
+{
+  uint32_t min_length = 0;
+
+  memset(self, 0, sizeof(*self));
+
+  /* in UTF mode this is a number of characters, which is never more than the number of bytes */
+  if (pcre2_pattern_info(compiled, PCRE2_INFO_MINLENGTH, &min_length) == 0)
+    self->min_length = min_length;
+
+  if (!caseless)
+    _extract_literal(self, pattern);
+}
+
+void
+regexp_prefilter_destroy(RegexpPrefilter *self)
+{
+  g_free(self->literal);
+  self->literal = NULL;
+  self->literal_len = 0;
+}
+
+/* memchr() is vectorized in every libc we care about, so it does the heavy lifting */
+static gboolean
+_find_literal(RegexpPrefilter *self, const gchar *value, gsize value_len)
+{
+  const gchar *end = value + value_len - self->literal_len + 1;
+  const gchar *p = value;
+
+  while (p < end)
+    {
+      p = memchr(p, self->literal[0], end - p);
+      if (!p)
+        return FALSE;
+      if (memcmp(p, self->literal, self->literal_len) == 0)
+        return TRUE;
+      p++;
+    }
+  return FALSE;
+}
+
+static gboolean
+_check(RegexpPrefilter *self, const gchar *value, gsize value_len)
+{
+  if (value_len < self->min_length)
+    return FALSE;
+
+  if (self->literal_len == 0)
+    return TRUE;
+
+  if (value_len < self->literal_len)
+    return FALSE;
+
+  if (self->anchored)
+    return memcmp(value, self->literal, self->literal_len) == 0;
+
+  return _find_literal(self, value, value_len);
+}
+
+gboolean
+regexp_prefilter_may_match(RegexpPrefilter *self, const gchar *value, gsize value_len)
+{
+  if (_check(self, value, value_len))
+    return TRUE;
+
+  stats_counter_inc(regexp_prefilter_rejections);
+  return FALSE;
+}
+
+static void
+_register_stats(void)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, "regexp_prefilter_rejections_total", NULL, 0);
+  stats_register_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &regexp_prefilter_rejections);
+  stats_unlock();
+}
+
+static void
+_unregister_stats(void)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, "regexp_prefilter_rejections_total", NULL, 0);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &regexp_prefilter_rejections);
+  stats_unlock();
+}
+
+void
+regexp_prefilter_global_init(void)
+{
+  register_application_hook(AH_RUNNING, (ApplicationHookFunc) _register_stats, NULL, AHM_RUN_ONCE);
+  register_application_hook(AH_SHUTDOWN, (ApplicationHookFunc) _unregister_stats, NULL, AHM_RUN_ONCE);
+}
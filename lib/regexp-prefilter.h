@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ * Copyright (c) 2024 shifter
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef REGEXP_PREFILTER_H_INCLUDED
+#define REGEXP_PREFILTER_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "compat/pcre.h"
+
+/*
+ * Cheap checks derived from a compiled regexp that reject values the regexp
+ * can never match, without creating match data or entering PCRE:
+ *   - the minimum length of a match, as computed by PCRE
+ *   - a literal the pattern starts with (right after an optional "^" or
+ *     "\A" anchor), which must be a prefix of the value if the pattern is
+ *     anchored, or must occur somewhere in it otherwise
+ */
+typedef struct _RegexpPrefilter
+{
+  gboolean anchored;
+  gsize min_length;
+  gchar *literal;
+  gsize literal_len;
+} RegexpPrefilter;
+
+void regexp_prefilter_init(RegexpPrefilter *self, pcre2_code *compiled, const gchar *pattern, gboolean caseless);
+void regexp_prefilter_destroy(RegexpPrefilter *self);
+gboolean regexp_prefilter_may_match(RegexpPrefilter *self, const gchar *value, gsize value_len);
+
+void regexp_prefilter_global_init(void);
+
+#endif
@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "stats/stats-cluster-index.h"
+
+/*
+ * Read-mostly index of the dynamic clusters, looked up without locking.
+ *
+ * The index is an open addressing hash table (linear probing) that is
+ * modified by a single writer at a time, holding stats_lock().  Entries
+ * are published with atomic stores, removed entries are replaced with a
+ * tombstone, and the table is copied to a larger one when it fills up.
+ *
+ * Memory that readers might still see (removed clusters, replaced tables)
+ * is reclaimed with a simple epoch scheme: every thread that has ever
+ * read the index owns a reader record, in which it publishes the global
+ * epoch while reading.  Retired memory is tagged with a new epoch and
+ * freed once no reader is active in an older one.
+ */
+
+#define STATS_CLUSTER_INDEX_MIN_SIZE 64
+
+static gchar tombstone;
+#define TOMBSTONE ((StatsCluster *) &tombstone)
+
+typedef struct _StatsClusterIndexEntry
+{
+  guint hash;
+  StatsCluster *cluster;
+} StatsClusterIndexEntry;
+
+typedef struct _StatsClusterIndexTable
+{
+  guint size;
+  /* non-empty entries, including tombstones */
+  guint used;
+  guint live;
+  StatsClusterIndexEntry entries[];
+} StatsClusterIndexTable;
+
+typedef struct _StatsClusterIndexReader
+{
+  /* the global epoch at the start of the ongoing read, 0 if not reading */
+  gint epoch;
+  gboolean in_use;
+} StatsClusterIndexReader;
+
+typedef struct _StatsClusterIndexRetired
+{
+  gint epoch;
+  gpointer data;
+  GDestroyNotify destroy;
+} StatsClusterIndexRetired;
+
+static struct
+{
+  StatsClusterIndexTable *table;
+  gint epoch;
+  GList *retired;
+} stats_cluster_index =
+{
+  .epoch = 1,
+};
+
+/* Reader records are reused by new threads but never freed: the thread
+ * exit notification of a thread might run after stats_cluster_index_deinit(). */
+static GMutex readers_lock;
+static GList *readers;
+
+static void _release_reader(gpointer data);
+static GPrivate current_reader = G_PRIVATE_INIT(_release_reader);
+
+static StatsClusterIndexReader *
+_acquire_reader(void)
+{
+  StatsClusterIndexReader *reader = NULL;
+
+  g_mutex_lock(&readers_lock);
+  for (GList *l = readers; l; l = l->next)
+    {
+      StatsClusterIndexReader *r = (StatsClusterIndexReader *) l->data;
+      if (!r->in_use)
+        {
+          reader = r;
+          break;
+        }
+    }
+
+  if (!reader)
+    {
+      reader = g_new0(StatsClusterIndexReader, 1);
+      readers = g_list_prepend(readers, reader);
+    }
+  reader->in_use = TRUE;
+  g_mutex_unlock(&readers_lock);
+
+  return reader;
+}
+
+static void
+_release_reader(gpointer data)
+{
+  StatsClusterIndexReader *reader = (StatsClusterIndexReader *) data;
+
+  g_mutex_lock(&readers_lock);
+  g_atomic_int_set(&reader->epoch, 0);
+  reader->in_use = FALSE;
+  g_mutex_unlock(&readers_lock);
+}
+
+static gint
+_oldest_active_epoch(void)
+{
+  gint oldest = G_MAXINT;
+
+  g_mutex_lock(&readers_lock);
+  for (GList *l = readers; l; l = l->next)
+    {
+      StatsClusterIndexReader *reader = (StatsClusterIndexReader *) l->data;
+      gint epoch = g_atomic_int_get(&reader->epoch);
+
+      if (epoch && epoch < oldest)
+        oldest = epoch;
+    }
+  g_mutex_unlock(&readers_lock);
+
+  return oldest;
+}
+
+static void
+_reclaim(gint oldest_active_epoch)
+{
+  GList *l = stats_cluster_index.retired;
+
+  while (l)
+    {
+      GList *next = l->next;
+      StatsClusterIndexRetired *retired = (StatsClusterIndexRetired *) l->data;
+
+      /* readers in this epoch or in a later one started after retired->data was unlinked */
+      if (retired->epoch <= oldest_active_epoch)
+        {
+          retired->destroy(retired->data);
+          g_free(retired);
+          stats_cluster_index.retired = g_list_delete_link(stats_cluster_index.retired, l);
+        }
+      l = next;
+    }
+}
+
+void
+stats_cluster_index_retire(gpointer data, GDestroyNotify destroy)
+{
+  StatsClusterIndexRetired *retired = g_new0(StatsClusterIndexRetired, 1);
+
+  retired->epoch = g_atomic_int_add(&stats_cluster_index.epoch, 1) + 1;
+  retired->data = data;
+  retired->destroy = destroy;
+  stats_cluster_index.retired = g_list_prepend(stats_cluster_index.retired, retired);
+
+  _reclaim(_oldest_active_epoch());
+}
+
+void
+stats_cluster_index_read_begin(void)
+{
+  StatsClusterIndexReader *reader = g_private_get(&current_reader);
+
+  if (!reader)
+    {
+      reader = _acquire_reader();
+      g_private_set(&current_reader, reader);
+    }
+
+  g_assert(reader->epoch == 0);
+  g_atomic_int_set(&reader->epoch, g_atomic_int_get(&stats_cluster_index.epoch));
+}
+
+void
+stats_cluster_index_read_end(void)
+{
+  StatsClusterIndexReader *reader = g_private_get(&current_reader);
+
+  g_atomic_int_set(&reader->epoch, 0);
+}
+
+StatsCluster *
+stats_cluster_index_lookup(const StatsClusterKey *sc_key)
+{
+  StatsClusterIndexTable *table = g_atomic_pointer_get(&stats_cluster_index.table);
+
+  if (!table)
+    return NULL;
+
+  guint hash = stats_cluster_key_hash(sc_key);
+  guint mask = table->size - 1;
+
+  for (guint i = hash & mask, probes = 0; probes < table->size; i = (i + 1) & mask, probes++)
+    {
+      StatsCluster *sc = g_atomic_pointer_get(&table->entries[i].cluster);
+
+      if (!sc)
+        return NULL;
+
+      if (sc != TOMBSTONE
+          && (guint) g_atomic_int_get(&table->entries[i].hash) == hash
+          && stats_cluster_key_equal(&sc->key, sc_key))
+        return sc;
+    }
+
+  return NULL;
+}
+
+static StatsClusterIndexTable *
+_table_new(guint size)
+{
+  StatsClusterIndexTable *table = g_malloc0(sizeof(StatsClusterIndexTable) + size * sizeof(StatsClusterIndexEntry));
+  table->size = size;
+  return table;
+}
+
+static void
+_table_add(StatsClusterIndexTable *table, guint hash, StatsCluster *sc)
+{
+  guint mask = table->size - 1;
+
+  for (guint i = hash & mask; ; i = (i + 1) & mask)
+    {
+      StatsCluster *entry = table->entries[i].cluster;
+
+      if (entry && entry != TOMBSTONE)
+        continue;
+
+      if (!entry)
+        table->used++;
+      table->live++;
+
+      /* the hash has to be visible before the cluster */
+      g_atomic_int_set(&table->entries[i].hash, hash);
+      g_atomic_pointer_set(&table->entries[i].cluster, sc);
+      return;
+    }
+}
+
+static void
+_grow_if_needed(void)
+{
+  StatsClusterIndexTable *table = stats_cluster_index.table;
+
+  /* keep the load factor (including tombstones) below 1/2 */
+  if (table && (table->used + 1) * 2 <= table->size)
+    return;
+
+  guint live = table ? table->live : 0;
+  guint size = STATS_CLUSTER_INDEX_MIN_SIZE;
+  while (size < (live + 1) * 4)
+    size <<= 1;
+
+  StatsClusterIndexTable *new_table = _table_new(size);
+  for (guint i = 0; table && i < table->size; i++)
+    {
+      StatsClusterIndexEntry *entry = &table->entries[i];
+      if (entry->cluster && entry->cluster != TOMBSTONE)
+        _table_add(new_table, entry->hash, entry->cluster);
+    }
+
+  g_atomic_pointer_set(&stats_cluster_index.table, new_table);
+  if (table)
+    stats_cluster_index_retire(table, g_free);
+}
+
+/* sc must not be in the index yet */
+void
+stats_cluster_index_insert(StatsCluster *sc)
+{
+  _grow_if_needed();
+  _table_add(stats_cluster_index.table, stats_cluster_key_hash(&sc->key), sc);
+}
+
+void
+stats_cluster_index_remove(StatsCluster *sc)
+{
+  StatsClusterIndexTable *table = stats_cluster_index.table;
+
+  if (!table)
+    return;
+
+  guint mask = table->size - 1;
+  guint hash = stats_cluster_key_hash(&sc->key);
+
+  for (guint i = hash & mask, probes = 0; probes < table->size; i = (i + 1) & mask, probes++)
+    {
+      StatsCluster *entry = table->entries[i].cluster;
+
+      if (!entry)
+        return;
+
+      if (entry == sc)
+        {
+          g_atomic_pointer_set(&table->entries[i].cluster, TOMBSTONE);
+          table->live--;
+          return;
+        }
+    }
+}
+
+void
+stats_cluster_index_init(void)
+{
+  g_assert(!stats_cluster_index.table);
+}
+
+/* no reader can be active at this point */
+void
+stats_cluster_index_deinit(void)
+{
+  _reclaim(G_MAXINT);
+  g_assert(!stats_cluster_index.retired);
+
+  g_free(stats_cluster_index.table);
+  stats_cluster_index.table = NULL;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef STATS_CLUSTER_INDEX_H_INCLUDED
+#define STATS_CLUSTER_INDEX_H_INCLUDED 1
+
+#include "stats/stats-cluster.h"
+
+/* readers, no locking needed, lookups must be done between read_begin() and read_end() */
+void stats_cluster_index_read_begin(void);
+void stats_cluster_index_read_end(void);
+StatsCluster *stats_cluster_index_lookup(const StatsClusterKey *sc_key);
+
+/* writers, must be called with stats_lock() held */
+void stats_cluster_index_insert(StatsCluster *sc);
+void stats_cluster_index_remove(StatsCluster *sc);
+void stats_cluster_index_retire(gpointer data, GDestroyNotify destroy);
+
+void stats_cluster_index_init(void);
+void stats_cluster_index_deinit(void);
+
+#endif
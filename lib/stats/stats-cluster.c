@@ -331,11 +331,46 @@ stats_cluster_track_counter(StatsCluster *self, gint type)
 
   g_assert(type < self->counter_group.capacity);
 
-  self->live_mask |= type_mask;
-  self->use_count++;
+  g_atomic_int_or(&self->live_mask, type_mask);
+  g_atomic_int_inc(&self->use_count);
   return &self->counter_group.counters[type];
 }
 
+/*
+ * Tracks an already live counter without stats_lock().  Fails if the
+ * counter has never been registered, or if the cluster is being removed
+ * from the registry, the caller should fall back to the locked path.
+ */
+StatsCounterItem *
+stats_cluster_try_track_live_counter(StatsCluster *self, gint type)
+{
+  g_assert(type < self->counter_group.capacity);
+
+  if (!(g_atomic_int_get(&self->live_mask) & (1 << type)))
+    return NULL;
+
+  gint use_count;
+  do
+    {
+      use_count = g_atomic_int_get(&self->use_count);
+      if (use_count < 0)
+        return NULL;
+    }
+  while (!g_atomic_int_compare_and_exchange(&self->use_count, use_count, use_count + 1));
+
+  return &self->counter_group.counters[type];
+}
+
+/*
+ * Marks an orphaned cluster as removed, so that it cannot be tracked
+ * anymore without stats_lock().  Returns FALSE if the cluster is in use.
+ */
+gboolean
+stats_cluster_try_retire(StatsCluster *self)
+{
+  return g_atomic_int_compare_and_exchange(&self->use_count, 0, -1);
+}
+
 StatsCounterItem *
 stats_cluster_get_counter(StatsCluster *self, gint type)
 {
@@ -343,7 +378,7 @@ stats_cluster_get_counter(StatsCluster *self, gint type)
 
   g_assert(type < self->counter_group.capacity);
 
-  if (!(self->live_mask & type_mask))
+  if (!(g_atomic_int_get(&self->live_mask) & type_mask))
     return NULL;
 
   return &self->counter_group.counters[type];
@@ -352,15 +387,17 @@ stats_cluster_get_counter(StatsCluster *self, gint type)
 void
 stats_cluster_untrack_counter(StatsCluster *self, gint type, StatsCounterItem **counter)
 {
-  g_assert(self && (self->live_mask & (1 << type)) && &self->counter_group.counters[type] == (*counter));
-  g_assert(self->use_count > 0);
-  self->use_count--;
+  g_assert(self && (g_atomic_int_get(&self->live_mask) & (1 << type))
+           && &self->counter_group.counters[type] == (*counter));
+  g_assert(g_atomic_int_get(&self->use_count) > 0);
 
-  if (self->use_count == 0 && (*counter)->external)
+  /* once use_count drops to 0, a dynamic cluster may be removed by another thread */
+  gboolean external = (*counter)->external;
+  if (g_atomic_int_dec_and_test(&self->use_count) && external)
     {
       stats_counter_clear(*counter);
       gint type_mask = 1 << type;
-      self->live_mask &= ~type_mask;
+      g_atomic_int_and(&self->live_mask, ~type_mask);
     }
 
   *counter = NULL;
@@ -416,7 +453,7 @@ stats_cluster_is_alive(StatsCluster *self, gint type)
 {
   g_assert(type < self->counter_group.capacity);
 
-  return !!((1<<type) & self->live_mask);
+  return !!((1<<type) & g_atomic_int_get(&self->live_mask));
 }
 
 StatsCluster *
@@ -459,6 +496,14 @@ void
 stats_cluster_free(StatsCluster *self)
 {
   stats_cluster_foreach_counter(self, stats_cluster_free_counter, NULL);
+
+  if (self->formatted_names)
+    {
+      for (gint type = 0; type < self->counter_group.capacity; type++)
+        g_free(self->formatted_names[type]);
+      g_free(self->formatted_names);
+    }
+
   stats_cluster_key_cloned_free(&self->key);
   g_free(self->query_key);
   stats_counter_group_free(&self->counter_group);
@@ -155,10 +155,17 @@ typedef struct _StatsCluster
 {
   StatsClusterKey key;
   StatsCounterGroup counter_group;
-  guint16 use_count;
-  guint16 live_mask;
+  /* use_count and live_mask are accessed atomically: dynamic counters
+   * can be tracked without stats_lock(), see stats_register_dynamic_counter_lockfree().
+   * A negative use_count means the cluster has been removed from the registry. */
+  gint use_count;
+  guint live_mask;
   guint16 dynamic:1;
   gchar *query_key;
+
+  /* metric name and labels of each counter as formatted by stats-prometheus,
+   * built on first use, protected by stats_lock() */
+  gchar **formatted_names;
 } StatsCluster;
 
 typedef void (*StatsForeachCounterFunc)(StatsCluster *sc, gint type, StatsCounterItem *counter, gpointer user_data);
@@ -179,6 +186,8 @@ gboolean stats_cluster_key_equal(const StatsClusterKey *key1, const StatsCluster
 guint stats_cluster_key_hash(const StatsClusterKey *self);
 
 StatsCounterItem *stats_cluster_track_counter(StatsCluster *self, gint type);
+StatsCounterItem *stats_cluster_try_track_live_counter(StatsCluster *self, gint type);
+gboolean stats_cluster_try_retire(StatsCluster *self);
 StatsCounterItem *stats_cluster_get_counter(StatsCluster *self, gint type);
 void stats_cluster_untrack_counter(StatsCluster *self, gint type, StatsCounterItem **counter);
 gboolean stats_cluster_is_alive(StatsCluster *self, gint type);
@@ -187,7 +196,7 @@ void stats_cluster_reset_counter_if_needed(StatsCluster *sc, StatsCounterItem *c
 static inline gboolean
 stats_cluster_is_orphaned(StatsCluster *self)
 {
-  return self->use_count == 0;
+  return g_atomic_int_get(&self->use_count) <= 0;
 }
 
 static inline gboolean
@@ -112,6 +112,19 @@ stats_counter_get(StatsCounterItem *counter)
   return result;
 }
 
+/* Raises the counter to value if it is lower, usable for high-water marks updated from several threads. */
+static inline void
+stats_counter_set_max(StatsCounterItem *counter, gsize value)
+{
+  if (counter && !stats_counter_read_only(counter))
+    {
+      gsize current = atomic_gssize_get_unsigned(&counter->value);
+
+      while (current < value && !atomic_gssize_compare_and_exchange(&counter->value, current, value))
+        current = atomic_gssize_get_unsigned(&counter->value);
+    }
+}
+
 /* Can only store positive values. Fixes overflow on 32 bit machines until 2106 if using seconds. */
 static inline void
 stats_counter_set_time(StatsCounterItem *counter, gint64 value)
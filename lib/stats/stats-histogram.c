@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include "stats/stats-histogram.h"
+#include "stats/stats-registry.h"
+
+/* upper bounds of the buckets in milliseconds, the last one is +Inf */
+static const gint64 bucket_bounds_msec[STATS_HISTOGRAM_NUM_BUCKETS - 1] =
+{
+  1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 60000
+};
+
+static const gchar *bucket_labels[STATS_HISTOGRAM_NUM_BUCKETS] =
+{
+  "0.001", "0.002", "0.005", "0.01", "0.02", "0.05", "0.1", "0.2", "0.5", "1", "2", "5", "10", "20", "60", "+Inf"
+};
+
+/*
+ * The counter is per histogram: a thread-wide countdown shared by several
+ * histograms observed in lockstep (e.g. the received-to-sent and
+ * sent-to-acked latencies of one destination) would hand every sample to
+ * one of them and none to the others.
+ */
+gboolean
+stats_histogram_should_sample(StatsHistogram *self)
+{
+  gint sampling = stats_latency_sampling();
+  if (sampling <= 0)
+    return FALSE;
+
+  guint observation = (guint) g_atomic_int_add(&self->observations, 1);
+  return observation % sampling == 0;
+}
+
+void
+stats_histogram_observe_msec(StatsHistogram *self, gint64 value_msec)
+{
+  if (value_msec < 0)
+    value_msec = 0;
+
+  /* buckets are cumulative, every bucket with a bound >= value counts it */
+  gint first_bucket = 0;
+  while (first_bucket < STATS_HISTOGRAM_NUM_BUCKETS - 1 && bucket_bounds_msec[first_bucket] < value_msec)
+    first_bucket++;
+
+  for (gint i = first_bucket; i < STATS_HISTOGRAM_NUM_BUCKETS; i++)
+    stats_counter_inc(self->buckets[i]);
+
+  stats_counter_add(self->sum, value_msec);
+  stats_counter_inc(self->count);
+}
+
+/*
+ * @kb has to have the name of the histogram set, the _bucket, _sum and
+ * _count suffixes and the "le" label are added here.  Must be called with
+ * stats_lock() held.  Nothing is registered if latency sampling is
+ * disabled.
+ */
+void
+stats_histogram_register(StatsHistogram *self, gint level, StatsClusterKeyBuilder *kb)
+{
+  if (stats_latency_sampling() <= 0)
+    return;
+
+  stats_cluster_key_builder_push(kb);
+  {
+    stats_cluster_key_builder_set_name_suffix(kb, "_bucket");
+    for (gint i = 0; i < STATS_HISTOGRAM_NUM_BUCKETS; i++)
+      {
+        stats_cluster_key_builder_push(kb);
+        stats_cluster_key_builder_add_label(kb, stats_cluster_label("le", bucket_labels[i]));
+        self->bucket_keys[i] = stats_cluster_key_builder_build_single(kb);
+        stats_cluster_key_builder_pop(kb);
+
+        stats_register_counter(level, self->bucket_keys[i], SC_TYPE_SINGLE_VALUE, &self->buckets[i]);
+      }
+
+    stats_cluster_key_builder_set_name_suffix(kb, "_count");
+    self->count_key = stats_cluster_key_builder_build_single(kb);
+    stats_register_counter(level, self->count_key, SC_TYPE_SINGLE_VALUE, &self->count);
+
+    stats_cluster_key_builder_set_name_suffix(kb, "_sum");
+    stats_cluster_key_builder_set_unit(kb, SCU_MILLISECONDS);
+    self->sum_key = stats_cluster_key_builder_build_single(kb);
+    stats_register_counter(level, self->sum_key, SC_TYPE_SINGLE_VALUE, &self->sum);
+  }
+  stats_cluster_key_builder_pop(kb);
+}
+
+/* Must be called with stats_lock() held. */
+void
+stats_histogram_unregister(StatsHistogram *self)
+{
+  for (gint i = 0; i < STATS_HISTOGRAM_NUM_BUCKETS; i++)
+    {
+      if (!self->bucket_keys[i])
+        continue;
+
+      stats_unregister_counter(self->bucket_keys[i], SC_TYPE_SINGLE_VALUE, &self->buckets[i]);
+      stats_cluster_key_free(self->bucket_keys[i]);
+      self->bucket_keys[i] = NULL;
+    }
+
+  if (self->count_key)
+    {
+      stats_unregister_counter(self->count_key, SC_TYPE_SINGLE_VALUE, &self->count);
+      stats_cluster_key_free(self->count_key);
+      self->count_key = NULL;
+    }
+
+  if (self->sum_key)
+    {
+      stats_unregister_counter(self->sum_key, SC_TYPE_SINGLE_VALUE, &self->sum);
+      stats_cluster_key_free(self->sum_key);
+      self->sum_key = NULL;
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef STATS_HISTOGRAM_H_INCLUDED
+#define STATS_HISTOGRAM_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "stats/stats-counter.h"
+#include "stats/stats-cluster-key-builder.h"
+#include "timeutils/unixtime.h"
+
+/*
+ * StatsHistogram is a latency histogram with fixed, log-linear (1-2-5)
+ * buckets between 1 millisecond and 1 minute.
+ *
+ * It is represented in the stats registry as a set of single value
+ * counters, following the naming of Prometheus histograms:
+ *   <name>_bucket{le="..."}   cumulative number of observations <= le
+ *   <name>_sum                sum of the observed values (in seconds)
+ *   <name>_count              number of observations
+ *
+ * Observations are sampled: only one out of stats(latency-sampling())
+ * observations is recorded by each histogram, and nothing is registered if
+ * sampling is disabled, so that unused histograms cost a NULL check.
+ */
+
+#define STATS_HISTOGRAM_NUM_BUCKETS 16
+
+typedef struct _StatsHistogram
+{
+  StatsClusterKey *bucket_keys[STATS_HISTOGRAM_NUM_BUCKETS];
+  StatsClusterKey *sum_key;
+  StatsClusterKey *count_key;
+
+  StatsCounterItem *buckets[STATS_HISTOGRAM_NUM_BUCKETS];
+  StatsCounterItem *sum;
+  StatsCounterItem *count;
+
+  gint observations;
+} StatsHistogram;
+
+void stats_histogram_register(StatsHistogram *self, gint level, StatsClusterKeyBuilder *kb);
+void stats_histogram_unregister(StatsHistogram *self);
+
+gboolean stats_histogram_should_sample(StatsHistogram *self);
+void stats_histogram_observe_msec(StatsHistogram *self, gint64 value_msec);
+
+static inline gboolean
+stats_histogram_is_enabled(StatsHistogram *self)
+{
+  return self->count != NULL;
+}
+
+static inline void
+stats_histogram_observe_elapsed(StatsHistogram *self, const UnixTime *since)
+{
+  UnixTime now;
+
+  unix_time_set_now(&now);
+  stats_histogram_observe_msec(self, unix_time_diff_in_msec(&now, since));
+}
+
+/* records the time elapsed since @since, if this observation is sampled */
+static inline void
+stats_histogram_sample_elapsed(StatsHistogram *self, const UnixTime *since)
+{
+  if (!stats_histogram_is_enabled(self) || !stats_histogram_should_sample(self))
+    return;
+
+  stats_histogram_observe_elapsed(self, since);
+}
+
+#endif
@@ -0,0 +1,404 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "stats/stats-prometheus-exporter.h"
+#include "stats/stats-prometheus.h"
+#include "gsockaddr.h"
+#include "gsocket.h"
+#include "messages.h"
+#include "apphook.h"
+#include "scratch-buffers.h"
+
+#include <iv.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/*
+ * A minimal HTTP endpoint serving the Prometheus text exposition of the
+ * metrics, so that they can be scraped without going through the control
+ * socket and syslog-ng-ctl.
+ *
+ * The listener runs in the main thread, each scrape is served by a
+ * dedicated thread, streaming the output of stats_generate_prometheus() as
+ * it is produced.
+ */
+
+#define MAX_CONCURRENT_SCRAPES 4
+#define MAX_REQUEST_SIZE 8192
+#define SOCKET_TIMEOUT_SEC 10
+
+typedef struct _PrometheusScrape
+{
+  gint fd;
+  gboolean cancelled;
+} PrometheusScrape;
+
+typedef struct _PrometheusExporter
+{
+  gchar *address;
+  gint port;
+  gint listen_fd;
+  struct iv_fd listen;
+
+  GMutex lock;
+  GCond scrape_finished;
+  GList *scrapes;
+} PrometheusExporter;
+
+static PrometheusExporter exporter =
+{
+  .listen_fd = -1,
+};
+
+static gboolean
+_write_all(gint fd, const gchar *buffer, gsize len)
+{
+  while (len > 0)
+    {
+      gssize rc = write(fd, buffer, len);
+      if (rc < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return FALSE;
+        }
+      buffer += rc;
+      len -= rc;
+    }
+  return TRUE;
+}
+
+static void
+_send_response_head(PrometheusScrape *scrape, gint status, const gchar *reason, const gchar *content_type)
+{
+  gchar head[256];
+  gint len = g_snprintf(head, sizeof(head),
+                        "HTTP/1.1 %d %s\r\n"
+                        "Content-Type: %s\r\n"
+                        "Connection: close\r\n"
+                        "\r\n",
+                        status, reason, content_type);
+
+  if (!_write_all(scrape->fd, head, len))
+    g_atomic_int_set(&scrape->cancelled, TRUE);
+}
+
+static void
+_send_error(PrometheusScrape *scrape, gint status, const gchar *reason)
+{
+  _send_response_head(scrape, status, reason, "text/plain; charset=utf-8");
+  if (!g_atomic_int_get(&scrape->cancelled))
+    _write_all(scrape->fd, reason, strlen(reason));
+}
+
+static void
+_send_records(const gchar *records, gpointer user_data)
+{
+  PrometheusScrape *scrape = (PrometheusScrape *) user_data;
+
+  if (g_atomic_int_get(&scrape->cancelled))
+    return;
+
+  if (!_write_all(scrape->fd, records, strlen(records)))
+    g_atomic_int_set(&scrape->cancelled, TRUE);
+}
+
+/*
+ * Only "GET /metrics" is served, the request headers are ignored.
+ */
+gboolean
+stats_prometheus_exporter_parse_request(const gchar *request, gint *status, const gchar **reason)
+{
+  const gchar *line_end = strstr(request, "\r\n");
+  if (!line_end)
+    line_end = request + strlen(request);
+
+  gchar *request_line = g_strndup(request, line_end - request);
+  gchar **fields = g_strsplit(request_line, " ", 3);
+  gboolean result = FALSE;
+
+  if (!fields[0] || !fields[1] || !fields[2] || !g_str_has_prefix(fields[2], "HTTP/"))
+    {
+      *status = 400;
+      *reason = "Bad Request";
+    }
+  else if (strcmp(fields[0], "GET") != 0)
+    {
+      *status = 405;
+      *reason = "Method Not Allowed";
+    }
+  else if (strcmp(fields[1], "/metrics") != 0 && !g_str_has_prefix(fields[1], "/metrics?"))
+    {
+      *status = 404;
+      *reason = "Not Found";
+    }
+  else
+    {
+      *status = 200;
+      *reason = "OK";
+      result = TRUE;
+    }
+
+  g_strfreev(fields);
+  g_free(request_line);
+  return result;
+}
+
+static gboolean
+_read_request(PrometheusScrape *scrape, GString *request)
+{
+  gchar buffer[1024];
+
+  while (!strstr(request->str, "\r\n\r\n"))
+    {
+      if (request->len > MAX_REQUEST_SIZE)
+        return FALSE;
+
+      gssize rc = read(scrape->fd, buffer, sizeof(buffer));
+      if (rc < 0 && errno == EINTR)
+        continue;
+      if (rc <= 0)
+        return FALSE;
+
+      g_string_append_len(request, buffer, rc);
+    }
+
+  return TRUE;
+}
+
+static void
+_serve_scrape(PrometheusScrape *scrape)
+{
+  GString *request = g_string_sized_new(256);
+
+  if (!_read_request(scrape, request))
+    {
+      msg_debug("Error reading Prometheus scrape request",
+                evt_tag_error("error"));
+      goto exit;
+    }
+
+  gint status;
+  const gchar *reason;
+  if (!stats_prometheus_exporter_parse_request(request->str, &status, &reason))
+    {
+      _send_error(scrape, status, reason);
+      goto exit;
+    }
+
+  _send_response_head(scrape, status, reason, "text/plain; version=0.0.4; charset=utf-8");
+  if (!g_atomic_int_get(&scrape->cancelled))
+    stats_generate_prometheus(_send_records, scrape, FALSE, &scrape->cancelled);
+
+exit:
+  g_string_free(request, TRUE);
+}
+
+static gpointer
+_scrape_thread(gpointer user_data)
+{
+  PrometheusScrape *scrape = (PrometheusScrape *) user_data;
+
+  iv_init();
+  app_thread_start();
+
+  _serve_scrape(scrape);
+
+  scratch_buffers_explicit_gc();
+  app_thread_stop();
+  iv_deinit();
+
+  g_mutex_lock(&exporter.lock);
+  exporter.scrapes = g_list_remove(exporter.scrapes, scrape);
+  close(scrape->fd);
+  g_free(scrape);
+  g_cond_broadcast(&exporter.scrape_finished);
+  g_mutex_unlock(&exporter.lock);
+
+  return NULL;
+}
+
+static void
+_set_socket_timeouts(gint fd)
+{
+  struct timeval timeout = { .tv_sec = SOCKET_TIMEOUT_SEC };
+
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+static void
+_start_scrape(gint fd)
+{
+  PrometheusScrape *scrape = g_new0(PrometheusScrape, 1);
+  scrape->fd = fd;
+  _set_socket_timeouts(fd);
+
+  g_mutex_lock(&exporter.lock);
+  if (g_list_length(exporter.scrapes) >= MAX_CONCURRENT_SCRAPES)
+    {
+      g_mutex_unlock(&exporter.lock);
+
+      msg_debug("Too many concurrent Prometheus scrapes, rejecting",
+                evt_tag_int("max_concurrent_scrapes", MAX_CONCURRENT_SCRAPES));
+      _send_error(scrape, 503, "Service Unavailable");
+      close(fd);
+      g_free(scrape);
+      return;
+    }
+  exporter.scrapes = g_list_prepend(exporter.scrapes, scrape);
+  g_mutex_unlock(&exporter.lock);
+
+  g_thread_unref(g_thread_new("prometheus", _scrape_thread, scrape));
+}
+
+static void
+_accept(void *cookie)
+{
+  gint fd;
+  GSockAddr *peer_addr;
+
+  if (g_accept(exporter.listen_fd, &fd, &peer_addr) != G_IO_STATUS_NORMAL)
+    {
+      msg_error("Error accepting Prometheus scrape connection",
+                evt_tag_error("error"));
+      return;
+    }
+
+  g_sockaddr_unref(peer_addr);
+  _start_scrape(fd);
+}
+
+static gboolean
+_start(const gchar *address, gint port)
+{
+  GSockAddr *saddr = g_sockaddr_inet_or_inet6_new(address, port);
+  if (!saddr)
+    {
+      msg_error("Error resolving the listen address of the Prometheus exporter",
+                evt_tag_str("address", address));
+      return FALSE;
+    }
+
+  exporter.listen_fd = socket(g_sockaddr_get_sa(saddr)->sa_family, SOCK_STREAM, 0);
+  if (exporter.listen_fd < 0)
+    {
+      msg_error("Error creating the socket of the Prometheus exporter",
+                evt_tag_error("error"));
+      goto error;
+    }
+
+  gint on = 1;
+  setsockopt(exporter.listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+  if (g_bind(exporter.listen_fd, saddr) != G_IO_STATUS_NORMAL || listen(exporter.listen_fd, 16) < 0)
+    {
+      msg_error("Error opening the listener of the Prometheus exporter",
+                evt_tag_str("address", address),
+                evt_tag_int("port", port),
+                evt_tag_error("error"));
+      goto error;
+    }
+
+  IV_FD_INIT(&exporter.listen);
+  exporter.listen.fd = exporter.listen_fd;
+  exporter.listen.handler_in = _accept;
+  iv_fd_register(&exporter.listen);
+
+  exporter.address = g_strdup(address);
+  exporter.port = port;
+
+  msg_verbose("Prometheus exporter listening",
+              evt_tag_str("address", address),
+              evt_tag_int("port", port));
+
+  g_sockaddr_unref(saddr);
+  return TRUE;
+
+error:
+  if (exporter.listen_fd >= 0)
+    {
+      close(exporter.listen_fd);
+      exporter.listen_fd = -1;
+    }
+  g_sockaddr_unref(saddr);
+  return FALSE;
+}
+
+static void
+_stop_listener(void)
+{
+  if (iv_fd_registered(&exporter.listen))
+    iv_fd_unregister(&exporter.listen);
+
+  if (exporter.listen_fd >= 0)
+    {
+      close(exporter.listen_fd);
+      exporter.listen_fd = -1;
+    }
+
+  g_clear_pointer(&exporter.address, g_free);
+  exporter.port = 0;
+}
+
+/* interrupts the ongoing scrapes and waits for their threads */
+static void
+_stop_scrapes(void)
+{
+  g_mutex_lock(&exporter.lock);
+  for (GList *l = exporter.scrapes; l; l = l->next)
+    {
+      PrometheusScrape *scrape = (PrometheusScrape *) l->data;
+
+      g_atomic_int_set(&scrape->cancelled, TRUE);
+      shutdown(scrape->fd, SHUT_RDWR);
+    }
+
+  while (exporter.scrapes)
+    g_cond_wait(&exporter.scrape_finished, &exporter.lock);
+  g_mutex_unlock(&exporter.lock);
+}
+
+void
+stats_prometheus_exporter_stop(void)
+{
+  _stop_listener();
+  _stop_scrapes();
+}
+
+void
+stats_prometheus_exporter_reinit(StatsOptions *options)
+{
+  const gchar *address = options->prometheus_address ? : STATS_PROMETHEUS_EXPORTER_DEFAULT_ADDRESS;
+
+  if (exporter.port == options->prometheus_port && g_strcmp0(exporter.address, address) == 0)
+    return;
+
+  /* the ongoing scrapes are not affected by a changed listener */
+  _stop_listener();
+
+  if (options->prometheus_port > 0)
+    _start(address, options->prometheus_port);
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef STATS_PROMETHEUS_EXPORTER_H_INCLUDED
+#define STATS_PROMETHEUS_EXPORTER_H_INCLUDED 1
+
+#include "stats/stats.h"
+
+#define STATS_PROMETHEUS_EXPORTER_DEFAULT_ADDRESS "127.0.0.1"
+
+void stats_prometheus_exporter_reinit(StatsOptions *options);
+void stats_prometheus_exporter_stop(void);
+
+gboolean stats_prometheus_exporter_parse_request(const gchar *request, gint *status, const gchar **reason);
+
+#endif
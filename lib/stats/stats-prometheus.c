@@ -31,6 +31,9 @@
 
 #include <string.h>
 
+/* number of clusters formatted while holding stats_lock() */
+#define STATS_PROMETHEUS_CHUNK_SIZE 1024
+
 
 /* Exposition format:
  *
@@ -210,10 +213,9 @@ _format_labels(StatsCluster *sc, gint type)
   return serialized_labels->str;
 }
 
-static GString *
-_format_legacy(StatsCluster *sc, gint type, StatsCounterItem *counter)
+static void
+_format_legacy_name(StatsCluster *sc, gint type, GString *record)
 {
-  GString *record = scratch_buffers_alloc();
   GString *labels = scratch_buffers_alloc();
 
   gchar component[64];
@@ -247,58 +249,108 @@ _format_legacy(StatsCluster *sc, gint type, StatsCounterItem *counter)
 
   if (labels->len != 0)
     g_string_append_printf(record, "{%s}", labels->str);
-
-  const gchar *metric_value = stats_format_prometheus_format_value(&sc->key, &sc->counter_group.counters[type]);
-  g_string_append_printf(record, " %s\n", metric_value);
-
-  return record;
 }
 
-GString *
-stats_prometheus_format_counter(StatsCluster *sc, gint type, StatsCounterItem *counter)
+static void
+_format_name(StatsCluster *sc, gint type, GString *record)
 {
-  if (_is_timestamp(sc, type))
-    return NULL;
-
   if (!sc->key.name)
-    return _format_legacy(sc, type, counter);
+    {
+      _format_legacy_name(sc, type, record);
+      return;
+    }
 
-  GString *record = scratch_buffers_alloc();
   g_string_append_printf(record, PROMETHEUS_METRIC_PREFIX "%s", stats_format_prometheus_sanitize_name(sc->key.name));
 
   const gchar *labels = _format_labels(sc, type);
   if (labels)
     g_string_append_printf(record, "{%s}", labels);
+}
+
+/*
+ * The metric name and the labels only depend on the key of the cluster,
+ * which never changes, so they are formatted once and reused by every
+ * scrape until the cluster is freed.
+ */
+static const gchar *
+_get_formatted_name(StatsCluster *sc, gint type)
+{
+  if (!sc->formatted_names)
+    sc->formatted_names = g_new0(gchar *, sc->counter_group.capacity);
+
+  if (!sc->formatted_names[type])
+    {
+      GString *name = scratch_buffers_alloc();
+      _format_name(sc, type, name);
+      sc->formatted_names[type] = g_strndup(name->str, name->len);
+    }
+
+  return sc->formatted_names[type];
+}
+
+static void
+_append_record(StatsCluster *sc, gint type, GString *record)
+{
+  g_string_append(record, _get_formatted_name(sc, type));
 
   const gchar *metric_value = stats_format_prometheus_format_value(&sc->key, &sc->counter_group.counters[type]);
-  g_string_append_printf(record, " %s\n", metric_value);
+  g_string_append_c(record, ' ');
+  g_string_append(record, metric_value);
+  g_string_append_c(record, '\n');
+}
+
+GString *
+stats_prometheus_format_counter(StatsCluster *sc, gint type, StatsCounterItem *counter)
+{
+  if (_is_timestamp(sc, type))
+    return NULL;
+
+  GString *record = scratch_buffers_alloc();
+  _append_record(sc, type, record);
 
   return record;
 }
 
+typedef struct _StatsPrometheusGenerator
+{
+  StatsPrometheusRecordFunc process_record;
+  gpointer process_record_arg;
+  gboolean with_legacy;
+  GString *chunk;
+} StatsPrometheusGenerator;
+
+/* runs with stats_lock() held, the records are only collected here */
 static void
 stats_format_prometheus(StatsCluster *sc, gint type, StatsCounterItem *counter, gpointer user_data)
 {
-  gpointer *args = (gpointer *) user_data;
-  StatsPrometheusRecordFunc process_record = (StatsPrometheusRecordFunc) args[0];
-  gpointer process_record_arg = args[1];
-  gboolean with_legacy = GPOINTER_TO_INT(args[2]);
+  StatsPrometheusGenerator *generator = (StatsPrometheusGenerator *) user_data;
 
-  if (!sc->key.name && !with_legacy)
+  if (!sc->key.name && !generator->with_legacy)
     return;
 
   if (stats_cluster_is_orphaned(sc))
     return;
 
+  if (_is_timestamp(sc, type))
+    return;
+
   ScratchBuffersMarker marker;
   scratch_buffers_mark(&marker);
+  _append_record(sc, type, generator->chunk);
+  scratch_buffers_reclaim_marked(marker);
+}
 
-  GString *record = stats_prometheus_format_counter(sc, type, counter);
-  if (!record)
+/* runs without stats_lock(), a slow consumer does not block the registry */
+static void
+stats_flush_prometheus_chunk(gpointer user_data)
+{
+  StatsPrometheusGenerator *generator = (StatsPrometheusGenerator *) user_data;
+
+  if (generator->chunk->len == 0)
     return;
 
-  process_record(record->str, process_record_arg);
-  scratch_buffers_reclaim_marked(marker);
+  generator->process_record(generator->chunk->str, generator->process_record_arg);
+  g_string_truncate(generator->chunk, 0);
 }
 
 void
@@ -319,12 +371,22 @@ stats_prometheus_format_labels_append(StatsClusterLabel *labels, gsize labels_le
     g_string_append_c(buf, '}');
 }
 
+/*
+ * process_record is called with a batch of records (lines) at a time.
+ */
 void
 stats_generate_prometheus(StatsPrometheusRecordFunc process_record, gpointer user_data, gboolean with_legacy,
                           gboolean *cancelled)
 {
-  gpointer format_prometheus_args[] = {process_record, user_data, GINT_TO_POINTER(with_legacy)};
-  stats_lock();
-  stats_foreach_counter(stats_format_prometheus, format_prometheus_args, cancelled);
-  stats_unlock();
+  StatsPrometheusGenerator generator =
+  {
+    .process_record = process_record,
+    .process_record_arg = user_data,
+    .with_legacy = with_legacy,
+    .chunk = g_string_sized_new(STATS_PROMETHEUS_CHUNK_SIZE * 128),
+  };
+
+  stats_foreach_counter_chunked(stats_format_prometheus, stats_flush_prometheus_chunk, &generator,
+                                STATS_PROMETHEUS_CHUNK_SIZE, cancelled);
+  g_string_free(generator.chunk, TRUE);
 }
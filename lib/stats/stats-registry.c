@@ -22,6 +22,7 @@
  *
  */
 #include "stats/stats-registry.h"
+#include "stats/stats-cluster-index.h"
 #include "stats/stats-query.h"
 #include "cfg.h"
 #include <string.h>
@@ -30,6 +31,11 @@ typedef struct _StatsClusterContainer
 {
   GHashTable *static_clusters;
   GHashTable *dynamic_clusters;
+
+  /* number of chunked walks in progress, clusters removed meanwhile are
+   * kept in removed_clusters until the last one finishes */
+  gint walks;
+  GList *removed_clusters;
 } StatsClusterContainer;
 
 static StatsClusterContainer stats_cluster_container;
@@ -47,11 +53,27 @@ static void
 _insert_cluster(StatsCluster *sc)
 {
   if (sc->dynamic)
-    g_hash_table_insert(stats_cluster_container.dynamic_clusters, &sc->key, sc);
+    {
+      g_hash_table_insert(stats_cluster_container.dynamic_clusters, &sc->key, sc);
+      stats_cluster_index_insert(sc);
+    }
   else
     g_hash_table_insert(stats_cluster_container.static_clusters, &sc->key, sc);
 }
 
+/* the cluster has already been removed from the hash tables */
+static void
+_free_removed_cluster(StatsCluster *sc)
+{
+  if (sc->dynamic)
+    stats_cluster_index_remove(sc);
+
+  if (stats_cluster_container.walks > 0)
+    stats_cluster_container.removed_clusters = g_list_prepend(stats_cluster_container.removed_clusters, sc);
+  else
+    stats_cluster_index_retire(sc, (GDestroyNotify) stats_cluster_free);
+}
+
 void
 stats_lock(void)
 {
@@ -248,6 +270,95 @@ stats_register_dynamic_counter(gint stats_level, const StatsClusterKey *sc_key,
   return _register_counter(stats_level, sc_key, type, TRUE, counter);
 }
 
+static StatsCounterItem *
+_track_dynamic_counter_lockfree(StatsCluster *sc, gint type)
+{
+  StatsCounterItem *counter = stats_cluster_try_track_live_counter(sc, type);
+  if (counter)
+    return counter;
+
+  stats_lock();
+  stats_register_associated_counter(sc, type, &counter);
+  stats_unlock();
+  return counter;
+}
+
+/*
+ * stats_register_dynamic_counter_lockfree:
+ *
+ * Same as stats_register_dynamic_counter(), but it must be called without
+ * holding stats_lock().  Counters of existing clusters are looked up and
+ * tracked without locking, stats_lock() is only taken when the cluster or
+ * the counter has to be created, so threads updating existing dynamic
+ * counters do not contend with each other.
+ */
+StatsCluster *
+stats_register_dynamic_counter_lockfree(gint stats_level, const StatsClusterKey *sc_key,
+                                        gint type, StatsCounterItem **counter)
+{
+  if (!stats_check_level(stats_level))
+    {
+      *counter = NULL;
+      return NULL;
+    }
+
+  stats_cluster_index_read_begin();
+  StatsCluster *sc = stats_cluster_index_lookup(sc_key);
+  *counter = sc ? stats_cluster_try_track_live_counter(sc, type) : NULL;
+  stats_cluster_index_read_end();
+
+  if (*counter)
+    return sc;
+
+  stats_lock();
+  sc = stats_register_dynamic_counter(stats_level, sc_key, type, counter);
+  stats_unlock();
+
+  return sc;
+}
+
+/* Must be called without holding stats_lock(). */
+void
+stats_unregister_dynamic_counter_lockfree(StatsCluster *sc, gint type, StatsCounterItem **counter)
+{
+  if (!sc)
+    return;
+
+  /* dynamic counters are never external, untracking them only touches atomics */
+  g_assert(sc->dynamic && !(*counter)->external);
+
+  /* the cluster can be removed as soon as it is untracked, keep it alive until we return */
+  stats_cluster_index_read_begin();
+  stats_cluster_untrack_counter(sc, type, counter);
+  stats_cluster_index_read_end();
+}
+
+/*
+ * stats_register_and_increment_dynamic_counter_lockfree
+ *
+ * Same as stats_register_and_increment_dynamic_counter(), but must be
+ * called without holding stats_lock(), see stats_register_dynamic_counter_lockfree().
+ */
+void
+stats_register_and_increment_dynamic_counter_lockfree(gint stats_level, const StatsClusterKey *sc_key,
+                                                      time_t timestamp)
+{
+  StatsCounterItem *counter, *stamp;
+  StatsCluster *handle;
+
+  handle = stats_register_dynamic_counter_lockfree(stats_level, sc_key, SC_TYPE_PROCESSED, &counter);
+  if (!handle)
+    return;
+  stats_counter_inc(counter);
+  if (timestamp >= 0)
+    {
+      stamp = _track_dynamic_counter_lockfree(handle, SC_TYPE_STAMP);
+      stats_counter_set(stamp, timestamp);
+      stats_unregister_dynamic_counter_lockfree(handle, SC_TYPE_STAMP, &stamp);
+    }
+  stats_unregister_dynamic_counter_lockfree(handle, SC_TYPE_PROCESSED, &counter);
+}
+
 /*
  * stats_instant_inc_dynamic_counter
  * @timestamp: if non-negative, an associated timestamp will be created and set
@@ -366,23 +477,20 @@ stats_remove_cluster(const StatsClusterKey *sc_key)
   g_assert(stats_locked);
   StatsCluster *sc;
 
-  sc = g_hash_table_lookup(stats_cluster_container.dynamic_clusters, sc_key);
-  if (sc)
+  GHashTable *clusters = stats_cluster_container.dynamic_clusters;
+  sc = g_hash_table_lookup(clusters, sc_key);
+  if (!sc)
     {
-      if (stats_cluster_is_orphaned(sc))
-        return g_hash_table_remove(stats_cluster_container.dynamic_clusters, sc_key);
-      return FALSE;
+      clusters = stats_cluster_container.static_clusters;
+      sc = g_hash_table_lookup(clusters, sc_key);
     }
 
-  sc = g_hash_table_lookup(stats_cluster_container.static_clusters, sc_key);
-  if (sc)
-    {
-      if (stats_cluster_is_orphaned(sc))
-        return g_hash_table_remove(stats_cluster_container.static_clusters, sc_key);
-      return FALSE;
-    }
+  if (!sc || !stats_cluster_try_retire(sc))
+    return FALSE;
 
-  return FALSE;
+  g_hash_table_steal(clusters, sc_key);
+  _free_removed_cluster(sc);
+  return TRUE;
 }
 
 gboolean
@@ -455,7 +563,9 @@ _foreach_cluster_remove_helper(gpointer key, gpointer value, gpointer user_data)
   gpointer func_data = args[1];
   StatsCluster *sc = (StatsCluster *) value;
 
-  gboolean should_be_removed = func(sc, func_data) && stats_cluster_is_orphaned(sc);
+  gboolean should_be_removed = func(sc, func_data) && stats_cluster_try_retire(sc);
+  if (should_be_removed)
+    _free_removed_cluster(sc);
   return should_be_removed;
 }
 
@@ -463,8 +573,8 @@ void
 stats_foreach_cluster_remove(StatsForeachClusterRemoveFunc func, gpointer user_data)
 {
   gpointer args[] = { func, user_data };
-  g_hash_table_foreach_remove(stats_cluster_container.static_clusters, _foreach_cluster_remove_helper, args);
-  g_hash_table_foreach_remove(stats_cluster_container.dynamic_clusters, _foreach_cluster_remove_helper, args);
+  g_hash_table_foreach_steal(stats_cluster_container.static_clusters, _foreach_cluster_remove_helper, args);
+  g_hash_table_foreach_steal(stats_cluster_container.dynamic_clusters, _foreach_cluster_remove_helper, args);
 }
 
 static void
@@ -493,6 +603,83 @@ stats_foreach_counter(StatsForeachCounterFunc func, gpointer user_data, gboolean
   stats_foreach_cluster(_foreach_counter_helper, args, cancelled);
 }
 
+static void
+_append_cluster(gpointer key, gpointer value, gpointer user_data)
+{
+  g_ptr_array_add((GPtrArray *) user_data, value);
+}
+
+static GPtrArray *
+_begin_walk(void)
+{
+  stats_lock();
+  GPtrArray *clusters = g_ptr_array_sized_new(g_hash_table_size(stats_cluster_container.static_clusters) +
+                                              g_hash_table_size(stats_cluster_container.dynamic_clusters));
+  g_hash_table_foreach(stats_cluster_container.static_clusters, _append_cluster, clusters);
+  g_hash_table_foreach(stats_cluster_container.dynamic_clusters, _append_cluster, clusters);
+  stats_cluster_container.walks++;
+  stats_unlock();
+
+  return clusters;
+}
+
+static void
+_end_walk(GPtrArray *clusters)
+{
+  stats_lock();
+  stats_cluster_container.walks--;
+  if (stats_cluster_container.walks == 0)
+    {
+      for (GList *l = stats_cluster_container.removed_clusters; l; l = l->next)
+        stats_cluster_index_retire(l->data, (GDestroyNotify) stats_cluster_free);
+      g_list_free(stats_cluster_container.removed_clusters);
+      stats_cluster_container.removed_clusters = NULL;
+    }
+  stats_unlock();
+
+  g_ptr_array_free(clusters, TRUE);
+}
+
+/*
+ * Iterates over the counters like stats_foreach_counter(), but holds
+ * stats_lock() only while processing chunk_size clusters, so that a walk
+ * over a large registry does not block counter registration for its whole
+ * duration.  func is called with the lock held, chunk_done (if set)
+ * without it, after each chunk.
+ *
+ * The clusters are collected when the walk starts: clusters registered
+ * afterwards are not visited, clusters removed meanwhile are kept alive
+ * until the walk finishes and are seen as orphaned.
+ *
+ * Must be called without holding stats_lock().
+ */
+void
+stats_foreach_counter_chunked(StatsForeachCounterFunc func, StatsForeachChunkDoneFunc chunk_done,
+                              gpointer user_data, gsize chunk_size, gboolean *cancelled)
+{
+  g_assert(chunk_size > 0);
+
+  GPtrArray *clusters = _begin_walk();
+
+  for (guint start = 0; start < clusters->len; start += chunk_size)
+    {
+      if (cancelled && g_atomic_int_get(cancelled))
+        break;
+
+      guint end = MIN(start + chunk_size, clusters->len);
+
+      stats_lock();
+      for (guint i = start; i < end; i++)
+        stats_cluster_foreach_counter(g_ptr_array_index(clusters, i), func, user_data);
+      stats_unlock();
+
+      if (chunk_done)
+        chunk_done(user_data);
+    }
+
+  _end_walk(clusters);
+}
+
 void
 stats_foreach_legacy_counter(StatsForeachCounterFunc func, gpointer user_data, gboolean *cancelled)
 {
@@ -512,15 +699,19 @@ stats_registry_init(void)
                                              (GEqualFunc) stats_cluster_key_equal, NULL,
                                              (GDestroyNotify) stats_cluster_free);
 
+  stats_cluster_index_init();
   g_mutex_init(&stats_mutex);
 }
 
 void
 stats_registry_deinit(void)
 {
+  g_assert(stats_cluster_container.walks == 0);
+
   g_hash_table_destroy(stats_cluster_container.static_clusters);
   g_hash_table_destroy(stats_cluster_container.dynamic_clusters);
   stats_cluster_container.static_clusters = NULL;
   stats_cluster_container.dynamic_clusters = NULL;
+  stats_cluster_index_deinit();
   g_mutex_clear(&stats_mutex);
 }
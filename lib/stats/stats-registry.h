@@ -29,6 +29,7 @@
 
 typedef void (*StatsForeachClusterFunc)(StatsCluster *sc, gpointer user_data);
 typedef gboolean (*StatsForeachClusterRemoveFunc)(StatsCluster *sc, gpointer user_data);
+typedef void (*StatsForeachChunkDoneFunc)(gpointer user_data);
 
 void stats_lock(void);
 void stats_unlock(void);
@@ -46,12 +47,17 @@ StatsCluster *stats_register_counter_and_index(gint level, const StatsClusterKey
 StatsCluster *stats_register_dynamic_counter(gint stats_level, const StatsClusterKey *sc_key, gint type,
                                              StatsCounterItem **counter);
 void stats_register_and_increment_dynamic_counter(gint stats_level, const StatsClusterKey *sc_key, time_t timestamp);
+StatsCluster *stats_register_dynamic_counter_lockfree(gint stats_level, const StatsClusterKey *sc_key, gint type,
+                                                      StatsCounterItem **counter);
+void stats_register_and_increment_dynamic_counter_lockfree(gint stats_level, const StatsClusterKey *sc_key,
+                                                           time_t timestamp);
 void stats_register_associated_counter(StatsCluster *handle, gint type, StatsCounterItem **counter);
 void stats_unregister_counter(const StatsClusterKey *sc_key, gint type, StatsCounterItem **counter);
 void stats_unregister_external_counter(const StatsClusterKey *sc_key, gint type,
                                        atomic_gssize *external_counter);
 void stats_unregister_alias_counter(const StatsClusterKey *sc_key, gint type, StatsCounterItem *aliased_counter);
 void stats_unregister_dynamic_counter(StatsCluster *handle, gint type, StatsCounterItem **counter);
+void stats_unregister_dynamic_counter_lockfree(StatsCluster *handle, gint type, StatsCounterItem **counter);
 
 gboolean stats_contains_counter(const StatsClusterKey *sc_key, gint type);
 StatsCounterItem *stats_get_counter(const StatsClusterKey *sc_key, gint type);
@@ -60,6 +66,8 @@ gboolean stats_remove_cluster(const StatsClusterKey *sc_key);
 
 void stats_foreach_counter(StatsForeachCounterFunc func, gpointer user_data, gboolean *cancelled);
 void stats_foreach_legacy_counter(StatsForeachCounterFunc func, gpointer user_data, gboolean *cancelled);
+void stats_foreach_counter_chunked(StatsForeachCounterFunc func, StatsForeachChunkDoneFunc chunk_done,
+                                   gpointer user_data, gsize chunk_size, gboolean *cancelled);
 void stats_foreach_cluster(StatsForeachClusterFunc func, gpointer user_data, gboolean *cancelled);
 void stats_foreach_cluster_remove(StatsForeachClusterRemoveFunc func, gpointer user_data);
 
@@ -69,5 +77,6 @@ void stats_registry_deinit(void);
 gboolean stats_check_dynamic_clusters_limit(guint number_of_clusters);
 gint stats_number_of_dynamic_clusters_limit(void);
 CfgYesNoAuto stats_syslog_stats(void);
+gint stats_latency_sampling(void);
 
 #endif
@@ -26,6 +26,7 @@
 #include "stats/stats-log.h"
 #include "stats/stats-query.h"
 #include "stats/stats-registry.h"
+#include "stats/stats-prometheus-exporter.h"
 #include "stats/aggregator/stats-aggregator-registry.h"
 #include "stats/stats-cluster-single.h"
 #include "stats/stats.h"
@@ -101,7 +102,7 @@ stats_cluster_is_expired(StatsOptions *options, StatsCluster *sc, time_t now)
 
   /* check if timestamp is stored, no timestamp means we can't expire it.
    * All dynamic entries should have a timestamp.  */
-  if ((sc->live_mask & (1 << SC_TYPE_STAMP)) == 0)
+  if ((g_atomic_int_get(&sc->live_mask) & (1 << SC_TYPE_STAMP)) == 0)
     return FALSE;
 
   tstamp = atomic_gssize_racy_get(&(sc->counter_group.counters[SC_TYPE_STAMP].value));
@@ -266,6 +267,7 @@ stats_reinit(StatsOptions *options)
   stats_options = options;
   stats_timer_reinit(options);
   stats_update_self_metrics(options);
+  stats_prometheus_exporter_reinit(options);
 }
 
 void
@@ -280,6 +282,7 @@ stats_init(void)
 void
 stats_destroy(void)
 {
+  stats_prometheus_exporter_stop();
   stats_unregister_self_metrics();
   stats_aggregator_registry_deinit();
   stats_registry_deinit();
@@ -294,6 +297,16 @@ stats_options_defaults(StatsOptions *options)
   options->lifetime = 600;
   options->max_dynamic = -1;
   options->syslog_stats = CYNA_AUTO;
+  options->latency_sampling = 0;
+  options->prometheus_port = 0;
+  options->prometheus_address = NULL;
+}
+
+void
+stats_options_destroy(StatsOptions *options)
+{
+  g_free(options->prometheus_address);
+  options->prometheus_address = NULL;
 }
 
 gboolean
@@ -330,3 +343,11 @@ stats_syslog_stats(void)
     return (stats_options->syslog_stats);
   return CYNA_AUTO;
 }
+
+gint
+stats_latency_sampling(void)
+{
+  if (stats_options)
+    return stats_options->latency_sampling;
+  return 0;
+}
@@ -36,6 +36,9 @@ typedef struct _StatsOptions
   gint lifetime;
   gint max_dynamic;
   CfgYesNoAuto syslog_stats;
+  gint latency_sampling;
+  gint prometheus_port;
+  gchar *prometheus_address;
 } StatsOptions;
 
 enum
@@ -51,6 +54,7 @@ void stats_init(void);
 void stats_destroy(void);
 
 void stats_options_defaults(StatsOptions *options);
+void stats_options_destroy(StatsOptions *options);
 
 #endif
 
@@ -83,3 +83,119 @@ Test(stats_dynamic_clusters, register_limited)
   stats_unlock();
 }
 
+
+Test(stats_dynamic_clusters, register_lockfree_finds_existing_clusters)
+{
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 3;
+  stats_reinit(&stats_opts);
+
+  StatsClusterKey sc_key;
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_HOST | SCS_SENDER, NULL, "testhost1");
+
+  StatsCounterItem *counter = NULL;
+  stats_lock();
+  StatsCluster *sc = stats_register_dynamic_counter(1, &sc_key, SC_TYPE_PROCESSED, &counter);
+  stats_unlock();
+  cr_assert_not_null(sc);
+
+  StatsCounterItem *lockfree_counter = NULL;
+  StatsCluster *lockfree_sc = stats_register_dynamic_counter_lockfree(1, &sc_key, SC_TYPE_PROCESSED,
+                                                                      &lockfree_counter);
+  cr_assert_eq(lockfree_sc, sc);
+  cr_assert_eq(lockfree_counter, counter);
+  cr_assert_eq(sc->use_count, 2);
+
+  stats_unregister_dynamic_counter_lockfree(lockfree_sc, SC_TYPE_PROCESSED, &lockfree_counter);
+  cr_assert_null(lockfree_counter);
+  stats_lock();
+  stats_unregister_dynamic_counter(sc, SC_TYPE_PROCESSED, &counter);
+  stats_unlock();
+
+  stats_register_and_increment_dynamic_counter_lockfree(1, &sc_key, 1234);
+  stats_register_and_increment_dynamic_counter_lockfree(1, &sc_key, 5678);
+
+  stats_lock();
+  cr_assert_eq(stats_counter_get(stats_get_counter(&sc_key, SC_TYPE_PROCESSED)), 2);
+  cr_assert_eq(stats_counter_get(stats_get_counter(&sc_key, SC_TYPE_STAMP)), 5678);
+  cr_assert(stats_cluster_is_orphaned(sc));
+  stats_unlock();
+}
+
+Test(stats_dynamic_clusters, register_lockfree_does_not_resurrect_removed_clusters)
+{
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 3;
+  stats_reinit(&stats_opts);
+
+  StatsClusterKey sc_key;
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_HOST | SCS_SENDER, NULL, "testhost1");
+  stats_register_and_increment_dynamic_counter_lockfree(1, &sc_key, 1234);
+
+  stats_lock();
+  cr_assert(stats_remove_cluster(&sc_key));
+  cr_assert_null(stats_get_cluster(&sc_key));
+  stats_unlock();
+
+  StatsCounterItem *counter = NULL;
+  StatsCluster *sc = stats_register_dynamic_counter_lockfree(1, &sc_key, SC_TYPE_PROCESSED, &counter);
+  cr_assert_not_null(sc);
+  cr_assert_eq(stats_counter_get(counter), 0);
+
+  stats_lock();
+  cr_assert_eq(stats_get_cluster(&sc_key), sc);
+  stats_unregister_dynamic_counter(sc, SC_TYPE_PROCESSED, &counter);
+  stats_unlock();
+}
+
+#define UNTRACK_RACE_THREADS 4
+#define UNTRACK_RACE_ITERATIONS 10000
+
+static gint untrack_race_running;
+
+static gpointer
+_register_and_increment_until_stopped(gpointer user_data)
+{
+  StatsClusterKey *sc_key = (StatsClusterKey *) user_data;
+
+  while (g_atomic_int_get(&untrack_race_running))
+    stats_register_and_increment_dynamic_counter_lockfree(1, sc_key, 1234);
+
+  return NULL;
+}
+
+Test(stats_dynamic_clusters, unregister_lockfree_races_with_cluster_removal)
+{
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 3;
+  stats_reinit(&stats_opts);
+
+  StatsClusterKey sc_key;
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_HOST | SCS_SENDER, NULL, "testhost1");
+
+  GThread *threads[UNTRACK_RACE_THREADS];
+  g_atomic_int_set(&untrack_race_running, TRUE);
+  for (gint i = 0; i < UNTRACK_RACE_THREADS; i++)
+    threads[i] = g_thread_new(NULL, _register_and_increment_until_stopped, &sc_key);
+
+  /* removal succeeds whenever the last untrack of a worker has just dropped use_count to 0 */
+  for (gint i = 0; i < UNTRACK_RACE_ITERATIONS; i++)
+    {
+      stats_lock();
+      stats_remove_cluster(&sc_key);
+      stats_unlock();
+    }
+
+  g_atomic_int_set(&untrack_race_running, FALSE);
+  for (gint i = 0; i < UNTRACK_RACE_THREADS; i++)
+    g_thread_join(threads[i]);
+
+  stats_lock();
+  StatsCluster *sc = stats_get_cluster(&sc_key);
+  if (sc)
+    cr_assert(stats_cluster_is_orphaned(sc));
+  stats_unlock();
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/stopwatch.h"
+
+#include "apphook.h"
+#include "stats/stats-cluster-logpipe.h"
+#include "stats/stats-registry.h"
+
+#define NUM_OF_THREADS 4
+#define NUM_OF_HOSTS 256
+#define ITERATIONS_PER_THREAD 200000
+
+typedef void (*IncrementFunc)(const StatsClusterKey *sc_key);
+
+static StatsClusterKey host_keys[NUM_OF_HOSTS];
+static gchar host_names[NUM_OF_HOSTS][32];
+
+static void
+_increment_locked(const StatsClusterKey *sc_key)
+{
+  stats_lock();
+  stats_register_and_increment_dynamic_counter(0, sc_key, 1);
+  stats_unlock();
+}
+
+static void
+_increment_lockfree(const StatsClusterKey *sc_key)
+{
+  stats_register_and_increment_dynamic_counter_lockfree(0, sc_key, 1);
+}
+
+static gpointer
+_update_counters(gpointer user_data)
+{
+  IncrementFunc increment = (IncrementFunc) user_data;
+
+  for (gint i = 0; i < ITERATIONS_PER_THREAD; i++)
+    increment(&host_keys[i % NUM_OF_HOSTS]);
+
+  return NULL;
+}
+
+static gsize
+_sum_of_counters(void)
+{
+  gsize sum = 0;
+
+  stats_lock();
+  for (gint i = 0; i < NUM_OF_HOSTS; i++)
+    sum += stats_counter_get(stats_get_counter(&host_keys[i], SC_TYPE_PROCESSED));
+  stats_unlock();
+
+  return sum;
+}
+
+static void
+_run_threads(IncrementFunc increment, const gchar *name)
+{
+  GThread *threads[NUM_OF_THREADS];
+  gsize sum_before = _sum_of_counters();
+
+  start_stopwatch();
+  for (gint i = 0; i < NUM_OF_THREADS; i++)
+    threads[i] = g_thread_new(name, _update_counters, increment);
+  for (gint i = 0; i < NUM_OF_THREADS; i++)
+    g_thread_join(threads[i]);
+  stop_stopwatch_and_display_result(NUM_OF_THREADS * ITERATIONS_PER_THREAD,
+                                    "Updating existing dynamic counters from %d threads, %-10s",
+                                    NUM_OF_THREADS, name);
+
+  cr_assert_eq(_sum_of_counters() - sum_before, NUM_OF_THREADS * ITERATIONS_PER_THREAD);
+}
+
+Test(dynamic_ctr_speed, test_updating_existing_dynamic_counters)
+{
+  for (gint i = 0; i < NUM_OF_HOSTS; i++)
+    {
+      g_snprintf(host_names[i], sizeof(host_names[i]), "host%d", i);
+      stats_cluster_logpipe_key_legacy_set(&host_keys[i], SCS_HOST | SCS_SOURCE, NULL, host_names[i]);
+      stats_register_and_increment_dynamic_counter_lockfree(0, &host_keys[i], 1);
+    }
+
+  _run_threads(_increment_locked, "locked");
+  _run_threads(_increment_lockfree, "lockfree");
+}
+
+TestSuite(dynamic_ctr_speed, .init = app_startup, .fini = app_shutdown);
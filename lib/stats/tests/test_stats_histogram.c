@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "stats/stats.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-histogram.h"
+#include "stats/stats-prometheus.h"
+#include "scratch-buffers.h"
+#include "apphook.h"
+
+static StatsOptions stats_opts;
+
+static void
+_set_latency_sampling(gint latency_sampling)
+{
+  stats_options_defaults(&stats_opts);
+  stats_opts.latency_sampling = latency_sampling;
+  stats_reinit(&stats_opts);
+}
+
+static void
+_register_histogram(StatsHistogram *histogram)
+{
+  StatsClusterKeyBuilder *kb = stats_cluster_key_builder_new();
+  stats_cluster_key_builder_add_label(kb, stats_cluster_label("id", "d_test"));
+  stats_cluster_key_builder_set_name(kb, "test_latency_seconds");
+
+  stats_lock();
+  stats_histogram_register(histogram, STATS_LEVEL0, kb);
+  stats_unlock();
+
+  stats_cluster_key_builder_free(kb);
+}
+
+static void
+_unregister_histogram(StatsHistogram *histogram)
+{
+  stats_lock();
+  stats_histogram_unregister(histogram);
+  stats_unlock();
+}
+
+static void
+_assert_prometheus_record(StatsClusterKey *key, const gchar *expected)
+{
+  stats_lock();
+  StatsCluster *sc = stats_get_cluster(key);
+  cr_assert_not_null(sc);
+
+  GString *record = stats_prometheus_format_counter(sc, SC_TYPE_SINGLE_VALUE,
+                                                    stats_cluster_get_counter(sc, SC_TYPE_SINGLE_VALUE));
+  cr_assert_str_eq(record->str, expected);
+  stats_unlock();
+}
+
+Test(stats_histogram, not_registered_without_sampling)
+{
+  StatsHistogram histogram = { 0 };
+
+  _set_latency_sampling(0);
+  _register_histogram(&histogram);
+
+  cr_assert_not(stats_histogram_is_enabled(&histogram));
+  cr_assert_null(histogram.count_key);
+
+  _unregister_histogram(&histogram);
+}
+
+Test(stats_histogram, buckets_are_cumulative)
+{
+  StatsHistogram histogram = { 0 };
+
+  _set_latency_sampling(1);
+  _register_histogram(&histogram);
+  cr_assert(stats_histogram_is_enabled(&histogram));
+
+  stats_histogram_observe_msec(&histogram, 0);
+  stats_histogram_observe_msec(&histogram, 2);
+  stats_histogram_observe_msec(&histogram, 5);
+  stats_histogram_observe_msec(&histogram, 1493);
+  stats_histogram_observe_msec(&histogram, 3600 * 1000);
+
+  /* le="0.001" */
+  cr_assert_eq(stats_counter_get(histogram.buckets[0]), 1);
+  /* le="0.002" */
+  cr_assert_eq(stats_counter_get(histogram.buckets[1]), 2);
+  /* le="0.005" */
+  cr_assert_eq(stats_counter_get(histogram.buckets[2]), 3);
+  /* le="1" */
+  cr_assert_eq(stats_counter_get(histogram.buckets[9]), 3);
+  /* le="2" */
+  cr_assert_eq(stats_counter_get(histogram.buckets[10]), 4);
+  /* le="60" */
+  cr_assert_eq(stats_counter_get(histogram.buckets[STATS_HISTOGRAM_NUM_BUCKETS - 2]), 4);
+  /* le="+Inf" */
+  cr_assert_eq(stats_counter_get(histogram.buckets[STATS_HISTOGRAM_NUM_BUCKETS - 1]), 5);
+
+  cr_assert_eq(stats_counter_get(histogram.count), 5);
+  cr_assert_eq(stats_counter_get(histogram.sum), 3600 * 1000 + 1493 + 5 + 2);
+
+  _assert_prometheus_record(histogram.bucket_keys[2],
+                            "syslogng_test_latency_seconds_bucket{id=\"d_test\",le=\"0.005\"} 3\n");
+  _assert_prometheus_record(histogram.bucket_keys[STATS_HISTOGRAM_NUM_BUCKETS - 1],
+                            "syslogng_test_latency_seconds_bucket{id=\"d_test\",le=\"+Inf\"} 5\n");
+  _assert_prometheus_record(histogram.count_key, "syslogng_test_latency_seconds_count{id=\"d_test\"} 5\n");
+  _assert_prometheus_record(histogram.sum_key, "syslogng_test_latency_seconds_sum{id=\"d_test\"} 3601.5\n");
+
+  _unregister_histogram(&histogram);
+  cr_assert_not(stats_histogram_is_enabled(&histogram));
+}
+
+Test(stats_histogram, sampling)
+{
+  StatsHistogram histogram = { 0 };
+
+  _set_latency_sampling(4);
+
+  gint sampled = 0;
+  for (gint i = 0; i < 100; i++)
+    {
+      if (stats_histogram_should_sample(&histogram))
+        sampled++;
+    }
+
+  cr_assert_eq(sampled, 25);
+}
+
+Test(stats_histogram, histograms_observed_in_lockstep_are_sampled_independently)
+{
+  StatsHistogram received_to_sent = { 0 };
+  StatsHistogram sent_to_acked = { 0 };
+
+  _set_latency_sampling(2);
+
+  gint sampled_received_to_sent = 0;
+  gint sampled_sent_to_acked = 0;
+  for (gint i = 0; i < 100; i++)
+    {
+      if (stats_histogram_should_sample(&received_to_sent))
+        sampled_received_to_sent++;
+      if (stats_histogram_should_sample(&sent_to_acked))
+        sampled_sent_to_acked++;
+    }
+
+  cr_assert_eq(sampled_received_to_sent, 50);
+  cr_assert_eq(sampled_sent_to_acked, 50);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+}
+
+static void
+teardown(void)
+{
+  scratch_buffers_explicit_gc();
+  app_shutdown();
+}
+
+TestSuite(stats_histogram, .init = setup, .fini = teardown);
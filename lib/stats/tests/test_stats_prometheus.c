@@ -29,6 +29,8 @@
 #include "stats/stats-cluster-single.h"
 #include "stats/stats-cluster-logpipe.h"
 #include "stats/stats-prometheus.h"
+#include "stats/stats-prometheus-exporter.h"
+#include "stats/stats-registry.h"
 #include "timeutils/unixtime.h"
 #include "scratch-buffers.h"
 #include "mainloop.h"
@@ -37,6 +39,7 @@
 
 #include <float.h>
 #include <limits.h>
+#include <string.h>
 
 static void
 setup(void)
@@ -307,3 +310,112 @@ Test(stats_prometheus, test_prometheus_format_legacy_alias_is_ignored)
   assert_prometheus_format(cluster, SC_TYPE_SINGLE_VALUE, "syslogng_name 0\n");
   stats_cluster_free(cluster);
 }
+
+#define NUM_OF_TEST_COUNTERS 3000
+
+typedef struct _GeneratedRecords
+{
+  gint test_counters;
+  gint batches;
+  gboolean unregister_after_first_batch;
+  StatsClusterKey *keys;
+  StatsCounterItem **counters;
+} GeneratedRecords;
+
+static void
+_register_test_counters(StatsClusterKey *keys, StatsCounterItem **counters)
+{
+  stats_lock();
+  for (gint i = 0; i < NUM_OF_TEST_COUNTERS; i++)
+    {
+      gchar name[32];
+      g_snprintf(name, sizeof(name), "test_counter_%d", i);
+      stats_cluster_single_key_set(&keys[i], name, NULL, 0);
+      stats_register_counter(0, &keys[i], SC_TYPE_SINGLE_VALUE, &counters[i]);
+    }
+  stats_unlock();
+}
+
+static void
+_unregister_test_counters(StatsClusterKey *keys, StatsCounterItem **counters)
+{
+  stats_lock();
+  for (gint i = 0; i < NUM_OF_TEST_COUNTERS; i++)
+    {
+      if (!counters[i])
+        continue;
+
+      stats_unregister_counter(&keys[i], SC_TYPE_SINGLE_VALUE, &counters[i]);
+      stats_remove_cluster(&keys[i]);
+    }
+  stats_unlock();
+}
+
+static void
+_count_records(const gchar *records, gpointer user_data)
+{
+  GeneratedRecords *generated = (GeneratedRecords *) user_data;
+
+  generated->batches++;
+  for (const gchar *p = records; (p = strstr(p, "syslogng_test_counter_")); p++)
+    generated->test_counters++;
+
+  if (generated->unregister_after_first_batch && generated->batches == 1)
+    _unregister_test_counters(generated->keys, generated->counters);
+}
+
+Test(stats_prometheus, test_generate_prometheus_walks_the_registry_in_chunks)
+{
+  StatsClusterKey keys[NUM_OF_TEST_COUNTERS];
+  StatsCounterItem *counters[NUM_OF_TEST_COUNTERS] = { 0 };
+  _register_test_counters(keys, counters);
+
+  GeneratedRecords generated = { 0 };
+  stats_generate_prometheus(_count_records, &generated, FALSE, NULL);
+  cr_assert_eq(generated.test_counters, NUM_OF_TEST_COUNTERS);
+  cr_assert_gt(generated.batches, 1, "records should be passed in more than one batch");
+
+  /* formatted names are cached by now */
+  generated = (GeneratedRecords) { 0 };
+  stats_generate_prometheus(_count_records, &generated, FALSE, NULL);
+  cr_assert_eq(generated.test_counters, NUM_OF_TEST_COUNTERS);
+
+  _unregister_test_counters(keys, counters);
+}
+
+Test(stats_prometheus, test_clusters_removed_during_generation_are_skipped)
+{
+  StatsClusterKey keys[NUM_OF_TEST_COUNTERS];
+  StatsCounterItem *counters[NUM_OF_TEST_COUNTERS] = { 0 };
+  _register_test_counters(keys, counters);
+
+  GeneratedRecords generated = { .unregister_after_first_batch = TRUE, .keys = keys, .counters = counters };
+  stats_generate_prometheus(_count_records, &generated, FALSE, NULL);
+  cr_assert_lt(generated.test_counters, NUM_OF_TEST_COUNTERS);
+
+  stats_lock();
+  for (gint i = 0; i < NUM_OF_TEST_COUNTERS; i++)
+    cr_assert_null(stats_get_cluster(&keys[i]));
+  stats_unlock();
+}
+
+Test(stats_prometheus, test_exporter_request_parsing)
+{
+  gint status;
+  const gchar *reason;
+
+  cr_assert(stats_prometheus_exporter_parse_request("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n",
+                                                    &status, &reason));
+  cr_assert_eq(status, 200);
+
+  cr_assert(stats_prometheus_exporter_parse_request("GET /metrics?name[]=foo HTTP/1.0\r\n\r\n", &status, &reason));
+
+  cr_assert_not(stats_prometheus_exporter_parse_request("POST /metrics HTTP/1.1\r\n\r\n", &status, &reason));
+  cr_assert_eq(status, 405);
+
+  cr_assert_not(stats_prometheus_exporter_parse_request("GET / HTTP/1.1\r\n\r\n", &status, &reason));
+  cr_assert_eq(status, 404);
+
+  cr_assert_not(stats_prometheus_exporter_parse_request("garbage\r\n\r\n", &status, &reason));
+  cr_assert_eq(status, 400);
+}
@@ -343,10 +343,31 @@ log_macro_expand_date_time(gint id,
    *   message specific timezone, if one is specified
    *   local timezone
    */
+  glong zone_offset = time_zone_info_get_offset(options->opts->time_zone_info[options->tz], stamp->ut_sec);
+
+  /* full timestamps are formatted from the per-thread formatted time cache,
+   * without breaking them down to a WallClockTime first */
+  switch (id)
+    {
+    case M_DATE:
+      append_format_unix_time(stamp, result, TS_FMT_BSD, zone_offset, options->opts->frac_digits);
+      return;
+    case M_STAMP:
+      append_format_unix_time(stamp, result, options->opts->ts_format, zone_offset, options->opts->frac_digits);
+      return;
+    case M_ISODATE:
+      append_format_unix_time(stamp, result, TS_FMT_ISO, zone_offset, options->opts->frac_digits);
+      return;
+    case M_FULLDATE:
+      append_format_unix_time(stamp, result, TS_FMT_FULL, zone_offset, options->opts->frac_digits);
+      return;
+    default:
+      break;
+    }
+
   WallClockTime wct;
 
-  convert_unix_time_to_wall_clock_time_with_tz_override(stamp, &wct,
-                                                        time_zone_info_get_offset(options->opts->time_zone_info[options->tz], stamp->ut_sec));
+  convert_unix_time_to_wall_clock_time_with_tz_override(stamp, &wct, zone_offset);
   switch (id)
     {
     case M_WEEK_DAY_ABBREV:
@@ -415,21 +436,6 @@ log_macro_expand_date_time(gint id,
     case M_AMPM:
       g_string_append(result, wct.wct_hour < 12 ? "AM" : "PM");
       break;
-    case M_DATE:
-      append_format_wall_clock_time(&wct, result, TS_FMT_BSD, options->opts->frac_digits);
-      break;
-    case M_STAMP:
-      if (options->opts->ts_format == TS_FMT_UNIX)
-        append_format_unix_time(stamp, result, TS_FMT_UNIX, wct.wct_gmtoff, options->opts->frac_digits);
-      else
-        append_format_wall_clock_time(&wct, result, options->opts->ts_format, options->opts->frac_digits);
-      break;
-    case M_ISODATE:
-      append_format_wall_clock_time(&wct, result, TS_FMT_ISO, options->opts->frac_digits);
-      break;
-    case M_FULLDATE:
-      append_format_wall_clock_time(&wct, result, TS_FMT_FULL, options->opts->frac_digits);
-      break;
     case M_UNIXTIME:
       *type = LM_VT_DATETIME;
       append_format_unix_time(stamp, result, TS_FMT_UNIX, wct.wct_gmtoff, options->opts->frac_digits);
@@ -48,6 +48,10 @@ Test(template_speed, test_template_speed)
   perftest_template("$DATE $HOST $MSGHDR$MSG\n");
   perftest_template("$DATE $HOST $MSGHDR$MSG value\n");
   perftest_template("$DATE $HOST $MSGHDR$MSG ${APP.VALUE}\n");
+  perftest_template("$ISODATE\n");
+  perftest_template("$R_ISODATE\n");
+  perftest_template("$FULLDATE\n");
+  perftest_template("$ISODATE $R_ISODATE $S_ISODATE\n");
   perftest_template("$MSG\n");
   perftest_template("$TAGS\n");
   perftest_template("$(echo $MSG)\n");
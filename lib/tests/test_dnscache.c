@@ -24,6 +24,8 @@
 #include <criterion/criterion.h>
 
 #include "dnscache.h"
+#include "host-resolve.h"
+#include "gsockaddr.h"
 #include "apphook.h"
 #include "timeutils/cache.h"
 #include "timeutils/misc.h"
@@ -239,3 +241,118 @@ Test(dnscache, test_lru_lists)
   _fill_dns_cache(cache, cache_size);
   dns_cache_free(cache);
 }
+
+static gpointer
+_store_from_thread(gpointer user_data)
+{
+  guint32 *ni = (guint32 *) user_data;
+
+  dns_caching_store(AF_INET, (void *) ni, positive_hostname, TRUE);
+  return NULL;
+}
+
+Test(dnscache, test_shared_cache_is_visible_from_other_threads)
+{
+  guint32 ni = htonl(0x0a000001);
+  gchar hn[256];
+  gsize hn_len;
+  gboolean positive;
+
+  cr_assert_not(dns_caching_lookup(AF_INET, (void *) &ni, hn, sizeof(hn), &hn_len, &positive));
+
+  GThread *thread = g_thread_new("dns-store", _store_from_thread, &ni);
+  g_thread_join(thread);
+
+  cr_assert(dns_caching_lookup(AF_INET, (void *) &ni, hn, sizeof(hn), &hn_len, &positive));
+  cr_assert(positive);
+  cr_assert_str_eq(hn, positive_hostname);
+  cr_assert_eq(hn_len, strlen(positive_hostname));
+}
+
+Test(dnscache, test_shared_cache_lookup_truncates_to_buffer_size)
+{
+  guint32 ni = htonl(0x0a000002);
+  gchar hn[5];
+  gsize hn_len;
+  gboolean positive;
+
+  dns_caching_store(AF_INET, (void *) &ni, negative_hostname, FALSE);
+
+  cr_assert(dns_caching_lookup(AF_INET, (void *) &ni, hn, sizeof(hn), &hn_len, &positive));
+  cr_assert_not(positive);
+  cr_assert_str_eq(hn, "nega");
+  cr_assert_eq(hn_len, 4);
+}
+
+Test(dnscache, test_hosts_file_is_shared_by_all_shards)
+{
+  gchar hosts_file[] = "test_dnscache_hosts.XXXXXX";
+  const gchar *hosts = "192.0.2.1 first\n192.0.2.2 second\n";
+  gint fd = g_mkstemp(hosts_file);
+  cr_assert_geq(fd, 0);
+  cr_assert_eq(write(fd, hosts, strlen(hosts)), strlen(hosts));
+  close(fd);
+
+  DNSCacheOptions options;
+  dns_cache_options_defaults(&options);
+  options.hosts = g_strdup(hosts_file);
+  dns_caching_update_options(&options);
+
+  guint32 first = htonl(0xc0000201);
+  guint32 second = htonl(0xc0000202);
+  gchar hn[256];
+  gsize hn_len;
+  gboolean positive;
+
+  cr_assert(dns_caching_lookup(AF_INET, (void *) &first, hn, sizeof(hn), &hn_len, &positive));
+  cr_assert(positive);
+  cr_assert_str_eq(hn, "first");
+  cr_assert(dns_caching_lookup(AF_INET, (void *) &second, hn, sizeof(hn), &hn_len, &positive));
+  cr_assert(positive);
+  cr_assert_str_eq(hn, "second");
+
+  unlink(hosts_file);
+  dns_cache_options_destroy(&options);
+}
+
+Test(dnscache, test_async_reverse_lookup_stores_the_result_in_the_cache)
+{
+  HostResolveOptions options =
+  {
+    .use_dns = TRUE,
+    .use_fqdn = TRUE,
+    .use_dns_cache = TRUE,
+    .normalize_hostnames = FALSE,
+  };
+  GSockAddr *saddr = g_sockaddr_inet_new("127.0.0.1", 0);
+  guint32 ni = htonl(INADDR_LOOPBACK);
+  const gchar *result;
+  gsize result_len;
+  gchar hn[256];
+  gsize hn_len;
+  gboolean positive;
+
+  host_resolve_set_resolver_threads(1);
+
+  /* the cache miss is not waited for, the message gets the address */
+  result = resolve_sockaddr_to_hostname(&result_len, saddr, &options);
+  cr_assert_str_eq(result, "127.0.0.1");
+  cr_assert_eq(result_len, strlen("127.0.0.1"));
+
+  gboolean found = FALSE;
+  for (gint i = 0; i < 500 && !found; i++)
+    {
+      found = dns_caching_lookup(AF_INET, (void *) &ni, hn, sizeof(hn), &hn_len, &positive);
+      if (!found)
+        g_usleep(10000);
+    }
+  cr_assert(found, "the resolver thread did not store its result in the DNS cache");
+
+  /* subsequent lookups are served from the cache */
+  result = resolve_sockaddr_to_hostname(&result_len, saddr, &options);
+  cr_assert_str_eq(result, hn);
+  cr_assert_eq(result_len, hn_len);
+
+  host_resolve_set_resolver_threads(0);
+  g_sockaddr_unref(saddr);
+}
@@ -284,6 +284,30 @@ Test(logqueue, log_queue_fifo_rewind_all_and_memory_usage)
   log_queue_unref(q);
 }
 
+Test(logqueue, log_queue_fifo_keeps_the_peak_of_queued_messages)
+{
+  StatsClusterKeyBuilder *driver_sck_builder = stats_cluster_key_builder_new();
+  StatsClusterKeyBuilder *queue_sck_builder = stats_cluster_key_builder_new();
+  LogQueue *q = log_queue_fifo_new(OVERFLOW_SIZE, NULL, STATS_LEVEL0, driver_sck_builder, queue_sck_builder);
+  stats_cluster_key_builder_free(driver_sck_builder);
+  stats_cluster_key_builder_free(queue_sck_builder);
+
+  feed_some_messages(q, 10);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.queued_messages_peak), 10);
+
+  send_some_messages(q, 8, TRUE);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.queued_messages), 2);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.queued_messages_peak), 10);
+
+  feed_some_messages(q, 3);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.queued_messages_peak), 10);
+
+  feed_some_messages(q, 6);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.queued_messages_peak), 11);
+
+  log_queue_unref(q);
+}
+
 Test(logqueue, log_queue_fifo_should_drop_only_non_flow_controlled_messages,
      .description = "Flow-controlled messages should never be dropped")
 {
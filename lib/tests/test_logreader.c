@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/mock-transport.h"
+#include "libtest/grab-logging.h"
+
+#include "logreader.h"
+#include "logproto/logproto-text-server.h"
+#include "ack-tracker/ack_tracker_factory.h"
+#include "cfg.h"
+#include "apphook.h"
+
+#include <errno.h>
+
+/* receives the notifications of the reader, e.g. NC_CLOSE */
+typedef struct _TestControl
+{
+  LogPipe super;
+  gint notify_code;
+} TestControl;
+
+/* keeps the posted messages unacked, so they stay in the window */
+typedef struct _TestCapture
+{
+  LogPipe super;
+  GPtrArray *messages;
+} TestCapture;
+
+static LogReaderOptions reader_options;
+static TestControl *control;
+static TestCapture *capture;
+static PollEvents *poll_events;
+
+static void
+_control_notify(LogPipe *s, gint notify_code, gpointer user_data)
+{
+  TestControl *self = (TestControl *) s;
+
+  self->notify_code = notify_code;
+}
+
+static void
+_capture_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
+{
+  TestCapture *self = (TestCapture *) s;
+
+  g_ptr_array_add(self->messages, log_msg_ref(msg));
+}
+
+static void
+_ack_captured_messages(void)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  for (guint i = 0; i < capture->messages->len; i++)
+    log_msg_ack(g_ptr_array_index(capture->messages, i), &path_options, AT_PROCESSED);
+  g_ptr_array_set_size(capture->messages, 0);
+}
+
+/* the fetches are triggered by hand, the watches have nothing to do */
+static void
+_poll_events_noop(PollEvents *s)
+{
+}
+
+static void
+_poll_events_update_noop(PollEvents *s, GIOCondition cond)
+{
+}
+
+static PollEvents *
+_poll_events_new(void)
+{
+  PollEvents *self = g_new0(PollEvents, 1);
+
+  poll_events_init(self);
+  self->stop_watches = _poll_events_noop;
+  self->update_watches = _poll_events_update_noop;
+  return self;
+}
+
+static LogReader *
+_construct_reader(LogTransport *transport, gssize window_size)
+{
+  reader_options.super.init_window_size = window_size;
+  log_reader_options_init(&reader_options, configuration, "test_logreader");
+  reader_options.flags &= ~LR_THREADED;
+
+  LogReader *reader = log_reader_new(configuration);
+  poll_events = _poll_events_new();
+  log_reader_open(reader, log_proto_text_server_new(transport, &reader_options.proto_options.super), poll_events);
+  log_reader_set_options(reader, &control->super, &reader_options, "test_logreader", stats_cluster_key_builder_new());
+  log_pipe_append(&reader->super.super, &capture->super);
+
+  cr_assert(log_pipe_init(&reader->super.super));
+
+  /* the first fetch completes the handshake */
+  poll_events_invoke_callback(poll_events);
+  return reader;
+}
+
+static void
+_fetch(LogReader *reader)
+{
+  g_assert(poll_events->callback_data == reader);
+  poll_events_invoke_callback(poll_events);
+}
+
+static void
+_destroy_reader(LogReader *reader)
+{
+  _ack_captured_messages();
+  log_pipe_deinit(&reader->super.super);
+  log_pipe_unref(&reader->super.super);
+}
+
+void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  cfg_load_module(configuration, "syslogformat");
+
+  log_reader_options_defaults(&reader_options);
+  reader_options.flags |= LR_BATCHED_PARSING;
+
+  control = g_new0(TestControl, 1);
+  log_pipe_init_instance(&control->super, configuration);
+  control->super.notify = _control_notify;
+
+  capture = g_new0(TestCapture, 1);
+  log_pipe_init_instance(&capture->super, configuration);
+  capture->super.queue = _capture_queue;
+  capture->messages = g_ptr_array_new_with_free_func((GDestroyNotify) log_msg_unref);
+}
+
+void
+teardown(void)
+{
+  g_ptr_array_free(capture->messages, TRUE);
+  log_pipe_unref(&capture->super);
+  log_pipe_unref(&control->super);
+  log_reader_options_destroy(&reader_options);
+  cfg_free(configuration);
+  configuration = NULL;
+  app_shutdown();
+}
+
+TestSuite(logreader_batch, .init = setup, .fini = teardown);
+
+Test(logreader_batch, batch_does_not_overrun_the_free_window)
+{
+  LogReader *reader = _construct_reader(log_transport_mock_stream_new("1\n2\n3\n4\n5\n", -1, LTM_EOF), 3);
+
+  cr_assert_not_null(reader->batch.records);
+  cr_assert_gt(reader->batch.size, 3);
+
+  _fetch(reader);
+  cr_assert_eq(capture->messages->len, 3, "the batch was not capped at the free window, posted: %d",
+               capture->messages->len);
+  cr_assert_eq(control->notify_code, 0);
+
+  _destroy_reader(reader);
+}
+
+Test(logreader_batch, batch_is_flushed_on_eof)
+{
+  LogReader *reader = _construct_reader(log_transport_mock_stream_new("1\n2\n", -1, LTM_EOF), 100);
+
+  _fetch(reader);
+  cr_assert_eq(capture->messages->len, 2);
+  cr_assert_eq(control->notify_code, NC_CLOSE);
+
+  _destroy_reader(reader);
+}
+
+Test(logreader_batch, batch_is_flushed_on_error)
+{
+  LogReader *reader = _construct_reader(log_transport_mock_stream_new("1\n2\n", -1,
+                                        LTM_INJECT_ERROR(ECONNRESET),
+                                        LTM_EOF), 100);
+
+  _fetch(reader);
+  cr_assert_eq(capture->messages->len, 2);
+  cr_assert_eq(control->notify_code, NC_READ_ERROR);
+
+  _destroy_reader(reader);
+}
+
+Test(logreader_batch, batching_is_disabled_for_position_tracked_sources)
+{
+  log_proto_server_options_set_ack_tracker_factory(&reader_options.proto_options.super,
+                                                   consecutive_ack_tracker_factory_new());
+
+  start_grabbing_messages();
+  LogReader *reader = _construct_reader(log_transport_mock_stream_new("1\n2\n", -1, LTM_EOF), 100);
+  assert_grabbed_log_contains("flags(batched-parsing) is not supported");
+  stop_grabbing_messages();
+
+  cr_assert_null(reader->batch.records);
+
+  _destroy_reader(reader);
+}
@@ -352,6 +352,39 @@ Test(log_source, test_forced_suspend_and_wakeup)
   test_source_destroy(source);
 }
 
+Test(log_source, test_flow_control_suspensions_are_counted)
+{
+  source_options.init_window_size = 2;
+
+  LogSource *source = test_source_init(&source_options);
+  TestPipe *next_pipe = test_pipe_init();
+  log_pipe_append(&source->super, &next_pipe->super);
+
+  cr_assert_eq(stats_counter_get(source->metrics.flow_control_suspensions), 0);
+
+  _post_messages(source, 2);
+  cr_assert_not(log_source_free_to_send(source));
+  cr_assert_eq(stats_counter_get(source->metrics.flow_control_suspensions), 1);
+  cr_assert_neq(atomic_gssize_get(&source->suspended_since), 0, "suspension should be timed");
+
+  /* suspending an already suspended source is not a new suspension */
+  log_source_flow_control_suspend(source);
+  cr_assert_eq(stats_counter_get(source->metrics.flow_control_suspensions), 1);
+
+  test_pipe_ack_messages(next_pipe, 2);
+  cr_assert(log_source_free_to_send(source));
+  cr_assert_eq(atomic_gssize_get(&source->suspended_since), 0, "suspension should be over");
+
+  log_source_flow_control_suspend(source);
+  cr_assert_eq(stats_counter_get(source->metrics.flow_control_suspensions), 2);
+  log_source_flow_control_adjust(source, 0);
+  cr_assert(log_source_free_to_send(source));
+  cr_assert_eq(atomic_gssize_get(&source->suspended_since), 0);
+
+  test_pipe_destroy(next_pipe);
+  test_source_destroy(source);
+}
+
 static DynamicWindowPool *
 test_dynamic_window_pool_init(gsize pool_size)
 {
@@ -25,6 +25,7 @@
 #include "libtest/cr_template.h"
 
 #include "logmatcher.h"
+#include "regexp-prefilter.h"
 #include "apphook.h"
 #include "plugin.h"
 #include "cfg.h"
@@ -593,3 +594,65 @@ Test(matcher, test_replace_works_correctly_if_input_is_a_match_value_that_gets_t
   log_matcher_unref(m);
   log_msg_unref(msg);
 }
+
+static void
+_assert_prefilter(const gchar *pattern, const gchar *expected_literal, gboolean expected_anchored)
+{
+  RegexpPrefilter prefilter;
+  gint rc;
+  PCRE2_SIZE error_offset;
+  pcre2_code *compiled = pcre2_compile((PCRE2_SPTR) pattern, PCRE2_ZERO_TERMINATED, 0, &rc, &error_offset, NULL);
+
+  cr_assert(compiled);
+  regexp_prefilter_init(&prefilter, compiled, pattern, FALSE);
+
+  if (expected_literal)
+    {
+      cr_assert_eq(prefilter.literal_len, strlen(expected_literal), "pattern=%s", pattern);
+      cr_assert_arr_eq(prefilter.literal, expected_literal, prefilter.literal_len, "pattern=%s", pattern);
+      cr_assert_eq(prefilter.anchored, expected_anchored, "pattern=%s", pattern);
+    }
+  else
+    {
+      cr_assert_eq(prefilter.literal_len, 0, "pattern=%s, literal=%s", pattern, prefilter.literal);
+    }
+
+  regexp_prefilter_destroy(&prefilter);
+  pcre2_code_free(compiled);
+}
+
+Test(matcher, test_prefilter_extracts_leading_literals)
+{
+  _assert_prefilter("^Traceback", "Traceback", TRUE);
+  _assert_prefilter("\\ATraceback \\(most", "Traceback (most", TRUE);
+  _assert_prefilter("Exception: .*", "Exception: ", FALSE);
+  _assert_prefilter("^abc?d", "ab", TRUE);
+  _assert_prefilter("^ab+c", "ab", TRUE);
+  _assert_prefilter("^ab{2}", "a", TRUE);
+  _assert_prefilter("^\\d{4}-", NULL, TRUE);
+  _assert_prefilter("^foo|bar", NULL, TRUE);
+  _assert_prefilter("(foo)bar", NULL, FALSE);
+  _assert_prefilter("árvíz", NULL, FALSE);
+}
+
+Test(matcher, test_prefilter_does_not_change_results)
+{
+  testcase_match("Traceback (most recent call last):", "^Traceback", TRUE,
+                 _construct_matcher(0, log_matcher_pcre_re_new));
+  testcase_match("  Traceback (most recent call last):", "^Traceback", FALSE,
+                 _construct_matcher(0, log_matcher_pcre_re_new));
+  testcase_match("java.lang.NullPointerException: foo", "Exception: ", TRUE,
+                 _construct_matcher(0, log_matcher_pcre_re_new));
+  testcase_match("java.lang.NullPointerExceptio", "Exception", FALSE,
+                 _construct_matcher(0, log_matcher_pcre_re_new));
+  testcase_match("TRACEBACK", "^traceback", TRUE,
+                 _construct_matcher(LMF_ICASE, log_matcher_pcre_re_new));
+  testcase_match("2024-", "^\\d{4}-", TRUE,
+                 _construct_matcher(0, log_matcher_pcre_re_new));
+  testcase_match("024-", "^\\d{4}-", FALSE,
+                 _construct_matcher(0, log_matcher_pcre_re_new));
+  testcase_replace("foo ExceptionException", "Exception", "E", "foo EE",
+                   _construct_matcher(LMF_GLOBAL, log_matcher_pcre_re_new));
+  testcase_replace("foo", "Exception", "E", "foo",
+                   _construct_matcher(LMF_GLOBAL, log_matcher_pcre_re_new));
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "path-tracer.h"
+#include "logpipe.h"
+#include "apphook.h"
+
+#include <string.h>
+
+static LogPipe *source;
+
+static gchar *
+_format_json(void)
+{
+  GString *result = g_string_new("");
+  path_tracer_format_json(result);
+  return g_string_free(result, FALSE);
+}
+
+static gint
+_count_occurrences(const gchar *haystack, const gchar *needle)
+{
+  gint count = 0;
+
+  for (const gchar *p = strstr(haystack, needle); p; p = strstr(p + 1, needle))
+    count++;
+  return count;
+}
+
+Test(path_tracer, test_hops_of_the_message_and_its_clones_are_recorded)
+{
+  path_tracer_start(1);
+
+  LogMessage *msg = log_msg_new_empty();
+  path_tracer_sample(source, msg);
+  cr_assert(path_tracer_is_traced(msg));
+
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessage *clone = log_msg_clone_cow(msg, &path_options);
+  cr_assert(path_tracer_is_traced(clone));
+
+  path_tracer_record_hop(clone, "queue-push", "d_file#0");
+  path_tracer_record_hop(clone, "queue-pop", "d_file#0");
+  log_msg_unref(clone);
+
+  gchar *json = _format_json();
+  cr_assert_str_eq(json, "[]", "trace is only completed when the message is freed: %s", json);
+  g_free(json);
+
+  log_msg_unref(msg);
+  path_tracer_stop();
+
+  json = _format_json();
+  cr_assert(strstr(json, "\"kind\":\"source\",\"name\":\"test-source@#unknown\""), "%s", json);
+  cr_assert(strstr(json, "\"kind\":\"queue-push\",\"name\":\"d_file#0\""), "%s", json);
+  cr_assert(strstr(json, "\"kind\":\"queue-pop\",\"name\":\"d_file#0\""), "%s", json);
+  cr_assert(strstr(json, "\"dropped_hops\":0"), "%s", json);
+  cr_assert_eq(_count_occurrences(json, "\"id\":"), 1, "%s", json);
+  g_free(json);
+}
+
+Test(path_tracer, test_one_out_of_n_messages_is_traced)
+{
+  path_tracer_start(3);
+
+  gint traced = 0;
+  for (gint i = 0; i < 9; i++)
+    {
+      LogMessage *msg = log_msg_new_empty();
+      path_tracer_sample(source, msg);
+      if (path_tracer_is_traced(msg))
+        traced++;
+      log_msg_unref(msg);
+    }
+  path_tracer_stop();
+
+  cr_assert_eq(traced, 3);
+
+  gchar *json = _format_json();
+  cr_assert_eq(_count_occurrences(json, "\"id\":"), 3, "%s", json);
+  g_free(json);
+}
+
+Test(path_tracer, test_hops_beyond_the_limit_are_counted_as_dropped)
+{
+  path_tracer_start(1);
+
+  LogMessage *msg = log_msg_new_empty();
+  path_tracer_sample(source, msg);
+  for (gint i = 0; i < PATH_TRACER_MAX_HOPS + 4; i++)
+    path_tracer_record_hop(msg, "pipe", "filter@a.conf:1:1");
+  log_msg_unref(msg);
+  path_tracer_stop();
+
+  gchar *json = _format_json();
+  cr_assert(strstr(json, "\"dropped_hops\":5"), "%s", json);
+  cr_assert_eq(_count_occurrences(json, "\"kind\":"), PATH_TRACER_MAX_HOPS, "%s", json);
+  g_free(json);
+}
+
+Test(path_tracer, test_the_ring_buffer_keeps_the_most_recent_traces)
+{
+  path_tracer_start(1);
+
+  for (gint i = 0; i < PATH_TRACER_RING_SIZE + 10; i++)
+    {
+      LogMessage *msg = log_msg_new_empty();
+      path_tracer_sample(source, msg);
+      log_msg_unref(msg);
+    }
+  path_tracer_stop();
+
+  gchar *json = _format_json();
+  cr_assert_eq(_count_occurrences(json, "\"id\":"), PATH_TRACER_RING_SIZE, "%s", json);
+  cr_assert_not(strstr(json, "{\"id\":1,"), "%s", json);
+  cr_assert(strstr(json, "{\"id\":11,"), "%s", json);
+  g_free(json);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  source = log_pipe_new(NULL);
+  source->plugin_name = g_strdup("test-source");
+}
+
+static void
+teardown(void)
+{
+  log_pipe_unref(source);
+  app_shutdown();
+}
+
+TestSuite(path_tracer, .init = setup, .fini = teardown);
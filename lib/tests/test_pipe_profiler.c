@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "pipe-profiler.h"
+#include "apphook.h"
+
+#include <string.h>
+
+static void
+_profile_message(void)
+{
+  if (!pipe_profiler_should_sample())
+    {
+      pipe_profiler_end_skip();
+      return;
+    }
+
+  pipe_profiler_enter("source@a.conf:1:1");
+  pipe_profiler_enter("filter@a.conf:2:1");
+  pipe_profiler_leave();
+  pipe_profiler_enter("destination@a.conf:3:1");
+  pipe_profiler_leave();
+  pipe_profiler_leave();
+}
+
+static gchar *
+_format_report(void)
+{
+  GString *result = g_string_new("");
+  pipe_profiler_format_report(result);
+  return g_string_free(result, FALSE);
+}
+
+static gchar *
+_format_collapsed_stacks(void)
+{
+  GString *result = g_string_new("");
+  pipe_profiler_format_collapsed_stacks(result);
+  return g_string_free(result, FALSE);
+}
+
+Test(pipe_profiler, test_every_message_is_profiled_with_sampling_one)
+{
+  pipe_profiler_start(1);
+  for (gint i = 0; i < 5; i++)
+    _profile_message();
+  pipe_profiler_stop();
+
+  gchar *report = _format_report();
+  cr_assert(strstr(report, "profiled messages: 5\n"), "%s", report);
+  cr_assert(strstr(report, " 5 source@a.conf:1:1\n"), "%s", report);
+  cr_assert(strstr(report, " 5 filter@a.conf:2:1\n"), "%s", report);
+  cr_assert(strstr(report, " 5 destination@a.conf:3:1\n"), "%s", report);
+  g_free(report);
+}
+
+Test(pipe_profiler, test_sampling_skips_messages_and_their_nested_calls)
+{
+  pipe_profiler_start(3);
+  for (gint i = 0; i < 9; i++)
+    {
+      if (!pipe_profiler_should_sample())
+        {
+          /* nested pipes of an unsampled message are not sampled either */
+          cr_assert_not(pipe_profiler_should_sample());
+          pipe_profiler_end_skip();
+          pipe_profiler_end_skip();
+          continue;
+        }
+      pipe_profiler_enter("source@a.conf:1:1");
+      cr_assert(pipe_profiler_should_sample());
+      pipe_profiler_leave();
+    }
+  pipe_profiler_stop();
+
+  gchar *report = _format_report();
+  cr_assert(strstr(report, "sampling: 1/3, profiled messages: 3\n"), "%s", report);
+  g_free(report);
+}
+
+Test(pipe_profiler, test_collapsed_stacks_contain_the_call_chain)
+{
+  pipe_profiler_start(1);
+  _profile_message();
+  pipe_profiler_enter("rewrite@b;c.conf:1:1");
+  pipe_profiler_leave();
+  pipe_profiler_stop();
+
+  gchar *stacks = _format_collapsed_stacks();
+  cr_assert(strstr(stacks, "source@a.conf:1:1 "), "%s", stacks);
+  cr_assert(strstr(stacks, "source@a.conf:1:1;filter@a.conf:2:1 "), "%s", stacks);
+  cr_assert(strstr(stacks, "source@a.conf:1:1;destination@a.conf:3:1 "), "%s", stacks);
+  cr_assert(strstr(stacks, "rewrite@b_c.conf:1:1 "), "%s", stacks);
+  g_free(stacks);
+}
+
+Test(pipe_profiler, test_reset_clears_the_results)
+{
+  pipe_profiler_start(1);
+  _profile_message();
+  pipe_profiler_reset();
+
+  gchar *report = _format_report();
+  cr_assert(strstr(report, "profiled messages: 0\n"), "%s", report);
+  cr_assert_not(strstr(report, "source@a.conf:1:1"), "%s", report);
+  g_free(report);
+
+  gchar *stacks = _format_collapsed_stacks();
+  cr_assert_str_empty(stacks);
+  g_free(stacks);
+  pipe_profiler_stop();
+}
+
+static void
+setup(void)
+{
+  app_startup();
+}
+
+static void
+teardown(void)
+{
+  app_shutdown();
+}
+
+TestSuite(pipe_profiler, .init = setup, .fini = teardown);
@@ -64,6 +64,10 @@ TLS_BLOCK_START
       struct tm mutated_key;
       time_t value;
     } mktime;
+    struct
+    {
+      FormattedTimeCache buckets[FORMATTED_TIME_CACHE_FORMATS];
+    } formatted_time;
   } cache;
   struct
   {
@@ -202,6 +206,7 @@ _clean_timeutils_cache(void)
   memset(&cache.gmtime.buckets, 0, sizeof(cache.gmtime.buckets));
   memset(&cache.localtime.buckets, 0, sizeof(cache.localtime.buckets));
   memset(&cache.mktime.key, 0, sizeof(cache.mktime.key));
+  memset(&cache.formatted_time.buckets, 0, sizeof(cache.formatted_time.buckets));
   if (cache.tzinfo.zones)
     cache_clear(cache.tzinfo.zones);
 
@@ -408,6 +413,16 @@ cached_get_time_zone_info(const gchar *tz)
   return result;
 }
 
+/* one entry per timestamp format, as a thread usually formats the same
+ * second over and over again with the same format */
+FormattedTimeCache *
+cached_formatted_time(gint ts_format)
+{
+  g_assert(ts_format >= 0 && ts_format < FORMATTED_TIME_CACHE_FORMATS);
+
+  return &cache.formatted_time.buckets[ts_format];
+}
+
 glong
 cached_get_system_tzofs(void)
 {
@@ -68,6 +68,25 @@ time_t get_cached_realtime_sec(void);
 
 TimeZoneInfo *cached_get_time_zone_info(const gchar *tz);
 
+/* the formatted version of a timestamp (without its fractional part) for a
+ * given second and zone offset, see append_format_unix_time() */
+#define FORMATTED_TIME_PREFIX_MAX 32
+#define FORMATTED_TIME_SUFFIX_MAX 16
+#define FORMATTED_TIME_CACHE_FORMATS 3
+
+typedef struct _FormattedTimeCache
+{
+  gboolean valid;
+  time_t sec;
+  glong gmtoff;
+  gchar prefix[FORMATTED_TIME_PREFIX_MAX];
+  gsize prefix_len;
+  gchar suffix[FORMATTED_TIME_SUFFIX_MAX];
+  gsize suffix_len;
+} FormattedTimeCache;
+
+FormattedTimeCache *cached_formatted_time(gint ts_format);
+
 void invalidate_timeutils_cache(void);
 
 #endif
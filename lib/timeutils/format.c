@@ -27,6 +27,8 @@
 #include "timeutils/conv.h"
 #include "str-format.h"
 
+#include <string.h>
+
 static void
 _append_frac_digits(glong usecs, GString *target, gint frac_digits)
 {
@@ -55,6 +57,126 @@ append_format_zone_info(GString *target, glong gmtoff)
   format_uint32_padded(target, 2, '0', 10, ((gmtoff < 0 ? -gmtoff : gmtoff) % 3600) / 60);
 }
 
+/* the part of the timestamp before the fractional digits */
+static void
+_append_format_wall_clock_time_prefix(const WallClockTime *wct, GString *target, gint ts_format)
+{
+  switch (ts_format)
+    {
+    case TS_FMT_BSD:
+      g_string_append_len(target, month_names_abbrev[wct->wct_mon], MONTH_NAME_ABBREV_LEN);
+      g_string_append_c(target, ' ');
+      format_uint32_padded(target, 2, ' ', 10, wct->wct_mday);
+      g_string_append_c(target, ' ');
+      format_uint32_padded(target, 2, '0', 10, wct->wct_hour);
+      g_string_append_c(target, ':');
+      format_uint32_padded(target, 2, '0', 10, wct->wct_min);
+      g_string_append_c(target, ':');
+      format_uint32_padded(target, 2, '0', 10, wct->wct_sec);
+      break;
+    case TS_FMT_ISO:
+      format_uint32_padded(target, 0, 0, 10, wct->wct_year + 1900);
+      g_string_append_c(target, '-');
+      format_uint32_padded(target, 2, '0', 10, wct->wct_mon + 1);
+      g_string_append_c(target, '-');
+      format_uint32_padded(target, 2, '0', 10, wct->wct_mday);
+      g_string_append_c(target, 'T');
+      format_uint32_padded(target, 2, '0', 10, wct->wct_hour);
+      g_string_append_c(target, ':');
+      format_uint32_padded(target, 2, '0', 10, wct->wct_min);
+      g_string_append_c(target, ':');
+      format_uint32_padded(target, 2, '0', 10, wct->wct_sec);
+      break;
+    case TS_FMT_FULL:
+      format_uint32_padded(target, 0, 0, 10, wct->wct_year + 1900);
+      g_string_append_c(target, ' ');
+      g_string_append_len(target, month_names_abbrev[wct->wct_mon], MONTH_NAME_ABBREV_LEN);
+      g_string_append_c(target, ' ');
+      format_uint32_padded(target, 2, ' ', 10, wct->wct_mday);
+      g_string_append_c(target, ' ');
+      format_uint32_padded(target, 2, '0', 10, wct->wct_hour);
+      g_string_append_c(target, ':');
+      format_uint32_padded(target, 2, '0', 10, wct->wct_min);
+      g_string_append_c(target, ':');
+      format_uint32_padded(target, 2, '0', 10, wct->wct_sec);
+      break;
+    default:
+      g_assert_not_reached();
+      break;
+    }
+}
+
+/* the part of the timestamp after the fractional digits */
+static void
+_append_format_wall_clock_time_suffix(const WallClockTime *wct, GString *target, gint ts_format)
+{
+  if (ts_format == TS_FMT_ISO)
+    append_format_zone_info(target, wct->wct_gmtoff);
+}
+
+/*
+ * Formats the timestamp into @target (which is used as a scratch area and
+ * is restored to its original length), then stores the parts before and
+ * after the fractional digits in the cache.
+ */
+static void
+_update_formatted_time_cache(FormattedTimeCache *ftc, const UnixTime *ut, gint ts_format, glong gmtoff,
+                             GString *target)
+{
+  WallClockTime wct = WALL_CLOCK_TIME_INIT;
+  gsize start = target->len;
+  gsize prefix_len, suffix_len;
+
+  convert_unix_time_to_wall_clock_time_with_tz_override(ut, &wct, gmtoff);
+
+  _append_format_wall_clock_time_prefix(&wct, target, ts_format);
+  prefix_len = target->len - start;
+  _append_format_wall_clock_time_suffix(&wct, target, ts_format);
+  suffix_len = target->len - start - prefix_len;
+
+  ftc->valid = prefix_len <= sizeof(ftc->prefix) && suffix_len <= sizeof(ftc->suffix);
+  if (ftc->valid)
+    {
+      memcpy(ftc->prefix, target->str + start, prefix_len);
+      ftc->prefix_len = prefix_len;
+      memcpy(ftc->suffix, target->str + start + prefix_len, suffix_len);
+      ftc->suffix_len = suffix_len;
+      ftc->sec = ut->ut_sec;
+      ftc->gmtoff = gmtoff;
+    }
+
+  g_string_truncate(target, start);
+}
+
+/*
+ * Messages arrive in bursts sharing the same second, so the formatted
+ * timestamp (without the fractional part, which is appended separately) is
+ * cached per thread and per format.
+ */
+static gboolean
+_append_format_unix_time_cached(const UnixTime *ut, GString *target, gint ts_format, glong zone_offset,
+                                gint frac_digits)
+{
+  glong gmtoff = zone_offset != -1 ? zone_offset : ut->ut_gmtoff;
+
+  /* the local zone offset depends on the timestamp itself, don't bother */
+  if (gmtoff == -1)
+    return FALSE;
+
+  FormattedTimeCache *ftc = cached_formatted_time(ts_format);
+  if (!ftc->valid || ftc->sec != ut->ut_sec || ftc->gmtoff != gmtoff)
+    {
+      _update_formatted_time_cache(ftc, ut, ts_format, gmtoff, target);
+      if (!ftc->valid)
+        return FALSE;
+    }
+
+  g_string_append_len(target, ftc->prefix, ftc->prefix_len);
+  _append_frac_digits(ut->ut_usec, target, frac_digits);
+  g_string_append_len(target, ftc->suffix, ftc->suffix_len);
+  return TRUE;
+}
+
 void
 append_format_unix_time(const UnixTime *ut, GString *target, gint ts_format, glong zone_offset, gint frac_digits)
 {
@@ -65,7 +187,7 @@ append_format_unix_time(const UnixTime *ut, GString *target, gint ts_format, glo
       format_uint32_padded(target, 0, 0, 10, (int) ut->ut_sec);
       _append_frac_digits(ut->ut_usec, target, frac_digits);
     }
-  else
+  else if (!_append_format_unix_time_cached(ut, target, ts_format, zone_offset, frac_digits))
     {
       convert_unix_time_to_wall_clock_time_with_tz_override(ut, &wct, zone_offset);
       append_format_wall_clock_time(&wct, target, ts_format, frac_digits);
@@ -97,47 +219,11 @@ append_format_wall_clock_time(const WallClockTime *wct, GString *target, gint ts
   switch (ts_format)
     {
     case TS_FMT_BSD:
-      g_string_append_len(target, month_names_abbrev[wct->wct_mon], MONTH_NAME_ABBREV_LEN);
-      g_string_append_c(target, ' ');
-      format_uint32_padded(target, 2, ' ', 10, wct->wct_mday);
-      g_string_append_c(target, ' ');
-      format_uint32_padded(target, 2, '0', 10, wct->wct_hour);
-      g_string_append_c(target, ':');
-      format_uint32_padded(target, 2, '0', 10, wct->wct_min);
-      g_string_append_c(target, ':');
-      format_uint32_padded(target, 2, '0', 10, wct->wct_sec);
-      _append_frac_digits(wct->wct_usec, target, frac_digits);
-      break;
     case TS_FMT_ISO:
-      format_uint32_padded(target, 0, 0, 10, wct->wct_year + 1900);
-      g_string_append_c(target, '-');
-      format_uint32_padded(target, 2, '0', 10, wct->wct_mon + 1);
-      g_string_append_c(target, '-');
-      format_uint32_padded(target, 2, '0', 10, wct->wct_mday);
-      g_string_append_c(target, 'T');
-      format_uint32_padded(target, 2, '0', 10, wct->wct_hour);
-      g_string_append_c(target, ':');
-      format_uint32_padded(target, 2, '0', 10, wct->wct_min);
-      g_string_append_c(target, ':');
-      format_uint32_padded(target, 2, '0', 10, wct->wct_sec);
-
-      _append_frac_digits(wct->wct_usec, target, frac_digits);
-      append_format_zone_info(target, wct->wct_gmtoff);
-      break;
     case TS_FMT_FULL:
-      format_uint32_padded(target, 0, 0, 10, wct->wct_year + 1900);
-      g_string_append_c(target, ' ');
-      g_string_append_len(target, month_names_abbrev[wct->wct_mon], MONTH_NAME_ABBREV_LEN);
-      g_string_append_c(target, ' ');
-      format_uint32_padded(target, 2, ' ', 10, wct->wct_mday);
-      g_string_append_c(target, ' ');
-      format_uint32_padded(target, 2, '0', 10, wct->wct_hour);
-      g_string_append_c(target, ':');
-      format_uint32_padded(target, 2, '0', 10, wct->wct_min);
-      g_string_append_c(target, ':');
-      format_uint32_padded(target, 2, '0', 10, wct->wct_sec);
-
+      _append_format_wall_clock_time_prefix(wct, target, ts_format);
       _append_frac_digits(wct->wct_usec, target, frac_digits);
+      _append_format_wall_clock_time_suffix(wct, target, ts_format);
       break;
     case TS_FMT_UNIX:
       convert_wall_clock_time_to_unix_time(wct, &ut);
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "timeutils/unixtime.h"
+#include "timeutils/format.h"
+#include "timeutils/conv.h"
+#include "apphook.h"
+
+#include <string.h>
+
+static void
+assert_unix_time_formats_to(const UnixTime *ut, gint ts_format, glong zone_offset, gint frac_digits,
+                            const gchar *expected)
+{
+  GString *result = g_string_new("prefix:");
+
+  append_format_unix_time(ut, result, ts_format, zone_offset, frac_digits);
+  cr_assert_str_eq(result->str + strlen("prefix:"), expected, "format mismatch, ts_format=%d", ts_format);
+
+  g_string_free(result, TRUE);
+}
+
+/* Thu Dec 19 21:25:44 UTC 2019 */
+#define TEST_STAMP 1576790744
+
+Test(format, formats_of_the_same_second_differ_only_in_fraction)
+{
+  UnixTime ut = { .ut_sec = TEST_STAMP, .ut_usec = 123456, .ut_gmtoff = 3600 };
+
+  assert_unix_time_formats_to(&ut, TS_FMT_ISO, -1, 3, "2019-12-19T22:25:44.123+01:00");
+  ut.ut_usec = 987654;
+  assert_unix_time_formats_to(&ut, TS_FMT_ISO, -1, 3, "2019-12-19T22:25:44.987+01:00");
+  assert_unix_time_formats_to(&ut, TS_FMT_ISO, -1, 6, "2019-12-19T22:25:44.987654+01:00");
+  assert_unix_time_formats_to(&ut, TS_FMT_ISO, -1, 0, "2019-12-19T22:25:44+01:00");
+  assert_unix_time_formats_to(&ut, TS_FMT_BSD, -1, 0, "Dec 19 22:25:44");
+  assert_unix_time_formats_to(&ut, TS_FMT_BSD, -1, 2, "Dec 19 22:25:44.98");
+  assert_unix_time_formats_to(&ut, TS_FMT_FULL, -1, 0, "2019 Dec 19 22:25:44");
+  assert_unix_time_formats_to(&ut, TS_FMT_UNIX, -1, 3, "1576790744.987");
+}
+
+Test(format, cached_timestamp_is_refreshed_on_second_or_zone_change)
+{
+  UnixTime ut = { .ut_sec = TEST_STAMP, .ut_usec = 0, .ut_gmtoff = 3600 };
+
+  assert_unix_time_formats_to(&ut, TS_FMT_ISO, -1, 0, "2019-12-19T22:25:44+01:00");
+
+  ut.ut_sec++;
+  assert_unix_time_formats_to(&ut, TS_FMT_ISO, -1, 0, "2019-12-19T22:25:45+01:00");
+
+  assert_unix_time_formats_to(&ut, TS_FMT_ISO, -5 * 3600, 0, "2019-12-19T16:25:45-05:00");
+  assert_unix_time_formats_to(&ut, TS_FMT_ISO, 0, 0, "2019-12-19T21:25:45+00:00");
+
+  ut.ut_gmtoff = 7200;
+  assert_unix_time_formats_to(&ut, TS_FMT_ISO, -1, 0, "2019-12-19T23:25:45+02:00");
+}
+
+Test(format, unknown_zone_offset_is_formatted_without_the_cache)
+{
+  UnixTime ut = { .ut_sec = TEST_STAMP, .ut_usec = 0, .ut_gmtoff = -1 };
+  GString *expected = g_string_new("");
+  WallClockTime wct = WALL_CLOCK_TIME_INIT;
+
+  convert_unix_time_to_wall_clock_time(&ut, &wct);
+  append_format_wall_clock_time(&wct, expected, TS_FMT_ISO, 0);
+
+  assert_unix_time_formats_to(&ut, TS_FMT_ISO, -1, 0, expected->str);
+  g_string_free(expected, TRUE);
+}
+
+TestSuite(format, .init = app_startup, .fini = app_shutdown);
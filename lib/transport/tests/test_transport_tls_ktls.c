@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "transport/transport-stack.h"
+#include "transport/transport-socket.h"
+#include "transport/transport-tls.h"
+#include "transport/transport-factory-tls.h"
+#include "transport/tls-context.h"
+#include "apphook.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+static TLSContext *
+_create_tls_context(gboolean enable_ktls)
+{
+  TLSContext *ctx = tls_context_new(TM_CLIENT, "test");
+
+  if (enable_ktls)
+    {
+      GList *options = g_list_append(NULL, "enable-ktls");
+      cr_assert(tls_context_set_ssl_options_by_name(ctx, options));
+      g_list_free(options);
+    }
+
+  cr_assert_eq(tls_context_setup_context(ctx), TLS_CONTEXT_SETUP_OK);
+  return ctx;
+}
+
+static gboolean
+_is_attached_to_the_socket(LogTransport *transport)
+{
+  SSL *ssl = log_tansport_tls_get_session(transport)->ssl;
+
+  return BIO_method_type(SSL_get_rbio(ssl)) == BIO_TYPE_SOCKET
+         && BIO_method_type(SSL_get_wbio(ssl)) == BIO_TYPE_SOCKET;
+}
+
+typedef struct
+{
+  LogTransportStack stack;
+  gint peer_fd;
+} TestStack;
+
+static void
+_init_stack(TestStack *test_stack, TLSContext *ctx)
+{
+  gint fds[2];
+
+  cr_assert_eq(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  test_stack->peer_fd = fds[1];
+
+  log_transport_stack_init(&test_stack->stack, log_transport_stream_socket_new(fds[0]));
+  log_transport_stack_add_factory(&test_stack->stack, transport_factory_tls_new(ctx, NULL));
+}
+
+static void
+_deinit_stack(TestStack *test_stack)
+{
+  log_transport_stack_deinit(&test_stack->stack);
+  close(test_stack->peer_fd);
+}
+
+Test(transport_tls_ktls, tls_transport_uses_the_base_transport_without_ktls)
+{
+  TLSContext *ctx = _create_tls_context(FALSE);
+  TestStack test_stack;
+
+  _init_stack(&test_stack, ctx);
+  LogTransport *transport = log_transport_stack_get_or_create_transport(&test_stack.stack, LOG_TRANSPORT_TLS);
+
+  cr_assert_not_null(transport);
+  cr_assert_not(_is_attached_to_the_socket(transport));
+
+  _deinit_stack(&test_stack);
+  tls_context_unref(ctx);
+}
+
+Test(transport_tls_ktls, failing_to_attach_to_the_socket_falls_back_to_the_base_transport)
+{
+  TLSContext *ctx = _create_tls_context(FALSE);
+  TLSSession *session = tls_context_setup_session(ctx);
+
+  LogTransport *transport = log_transport_tls_new_on_fd(session, LOG_TRANSPORT_SOCKET, -1);
+
+  cr_assert_not_null(transport, "a failed socket setup should not fail the connection");
+  cr_assert_not(_is_attached_to_the_socket(transport));
+
+  log_transport_free(transport);
+  tls_context_unref(ctx);
+}
+
+#ifdef SSL_OP_ENABLE_KTLS
+
+Test(transport_tls_ktls, tls_transport_is_attached_to_the_socket_with_ktls)
+{
+  TLSContext *ctx = _create_tls_context(TRUE);
+  TestStack test_stack;
+
+  cr_assert(tls_context_ktls_enabled(ctx));
+
+  _init_stack(&test_stack, ctx);
+  LogTransport *transport = log_transport_stack_get_or_create_transport(&test_stack.stack, LOG_TRANSPORT_TLS);
+
+  cr_assert_not_null(transport);
+  cr_assert(_is_attached_to_the_socket(transport));
+
+  _deinit_stack(&test_stack);
+  tls_context_unref(ctx);
+}
+
+Test(transport_tls_ktls, buffered_data_of_the_base_transport_disables_ktls)
+{
+  TLSContext *ctx = _create_tls_context(TRUE);
+  TestStack test_stack;
+  gchar buf[16];
+  gboolean moved_forward;
+
+  _init_stack(&test_stack, ctx);
+
+  /* protocol detection peeks into the stream, which stays buffered in the base transport */
+  cr_assert_eq(write(test_stack.peer_fd, "\x16\x03\x01", 3), 3);
+  cr_assert_eq(log_transport_stack_read_ahead(&test_stack.stack, buf, 3, &moved_forward), 3);
+
+  LogTransport *transport = log_transport_stack_get_or_create_transport(&test_stack.stack, LOG_TRANSPORT_TLS);
+
+  cr_assert_not_null(transport);
+  cr_assert_not(_is_attached_to_the_socket(transport));
+
+  _deinit_stack(&test_stack);
+  tls_context_unref(ctx);
+}
+
+#else
+
+Test(transport_tls_ktls, enable_ktls_is_rejected_without_openssl_support)
+{
+  TLSContext *ctx = tls_context_new(TM_CLIENT, "test");
+  GList *options = g_list_append(NULL, "enable-ktls");
+
+  cr_assert_not(tls_context_set_ssl_options_by_name(ctx, options));
+
+  g_list_free(options);
+  tls_context_unref(ctx);
+}
+
+#endif
+
+TestSuite(transport_tls_ktls, .init = app_startup, .fini = app_shutdown);
@@ -235,6 +235,11 @@ tls_context_setup_ssl_options(TLSContext *self)
         ssl_options |= SSL_OP_IGNORE_UNEXPECTED_EOF;
 #endif
 
+#ifdef SSL_OP_ENABLE_KTLS
+      if (self->ssl_options & TSO_ENABLE_KTLS)
+        ssl_options |= SSL_OP_ENABLE_KTLS;
+#endif
+
 
 #ifdef SSL_OP_CIPHER_SERVER_PREFERENCE
       if (self->mode == TM_SERVER)
@@ -741,6 +746,10 @@ tls_context_set_ssl_options_by_name(TLSContext *self, GList *options)
 #ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
       else if (strcasecmp(l->data, "ignore-unexpected-eof") == 0 || strcasecmp(l->data, "ignore_unexpected_eof") == 0)
         self->ssl_options |= TSO_IGNORE_UNEXPECTED_EOF;
+#endif
+#ifdef SSL_OP_ENABLE_KTLS
+      else if (strcasecmp(l->data, "enable-ktls") == 0 || strcasecmp(l->data, "enable_ktls") == 0)
+        self->ssl_options |= TSO_ENABLE_KTLS;
 #endif
       else if (strcasecmp(l->data, "ignore-hostname-mismatch") == 0 || strcasecmp(l->data, "ignore_hostname_mismatch") == 0)
         self->ssl_options |= TSO_IGNORE_HOSTNAME_MISMATCH;
@@ -777,6 +786,12 @@ tls_context_ignore_validity_period(TLSContext *self)
   return self->ssl_options & TSO_IGNORE_VALIDITY_PERIOD;
 }
 
+gboolean
+tls_context_ktls_enabled(TLSContext *self)
+{
+  return self->ssl_options & TSO_ENABLE_KTLS;
+}
+
 static int
 _pem_passwd_callback(char *buf, int size, int rwflag, void *user_data)
 {
@@ -26,6 +26,15 @@
 #include "transport/transport-factory-tls.h"
 #include "transport/transport-tls.h"
 
+/* data peeked by the base transport would be lost if OpenSSL read the socket directly */
+static gboolean
+_base_transport_has_buffered_data(LogTransportStack *stack)
+{
+  LogTransport *base = log_transport_stack_get_transport(stack, LOG_TRANSPORT_SOCKET);
+
+  return base && base->ra.buf_len != base->ra.pos;
+}
+
 static LogTransport *
 _construct_transport(const LogTransportFactory *s, LogTransportStack *stack)
 {
@@ -37,6 +46,9 @@ _construct_transport(const LogTransportFactory *s, LogTransportStack *stack)
 
   tls_session_set_verifier(tls_session, self->tls_verifier);
 
+  if (tls_context_ktls_enabled(self->tls_context) && !_base_transport_has_buffered_data(stack))
+    return log_transport_tls_new_on_fd(tls_session, LOG_TRANSPORT_SOCKET, stack->fd);
+
   return log_transport_tls_new(tls_session, LOG_TRANSPORT_SOCKET);
 }
 
@@ -27,6 +27,9 @@
 #include "transport/transport-adapter.h"
 
 #include "messages.h"
+#include "apphook.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
 
 #include <openssl/ssl.h>
 #include <openssl/err.h>
@@ -37,11 +40,20 @@ typedef struct _LogTransportTLS
   LogTransportAdapter super;
   TLSSession *tls_session;
   gboolean sending_shutdown;
+  struct
+  {
+    gboolean checked;
+    gboolean send;
+    gboolean recv;
+  } ktls;
 } LogTransportTLS;
 
 const gchar *TLS_TRANSPORT_NAME = "tls";
 static BIO_METHOD *meth_transport = NULL;
 
+static StatsCounterItem *stats_ktls_send_connections;
+static StatsCounterItem *stats_ktls_recv_connections;
+
 static int
 _BIO_transport_write(BIO *bio, const char *buf, size_t buflen, size_t *written_bytes)
 {
@@ -187,6 +199,40 @@ log_transport_tls_send_shutdown(LogTransportTLS *self)
   return shutdown_rc;
 }
 
+/*
+ * With the enable-ktls ssl-option, OpenSSL hands the record layer over to
+ * the kernel after the handshake, if both the kernel and the negotiated
+ * cipher support it.  This only works with OpenSSL's own socket BIO, so
+ * we can only tell whether it happened once the handshake is over.
+ */
+static void
+_check_ktls_offload(LogTransportTLS *self)
+{
+  if (G_LIKELY(self->ktls.checked) || SSL_in_init(self->tls_session->ssl))
+    return;
+
+  self->ktls.checked = TRUE;
+
+  if (!tls_context_ktls_enabled(self->tls_session->ctx))
+    return;
+
+#ifdef BIO_get_ktls_send
+  self->ktls.send = BIO_get_ktls_send(SSL_get_wbio(self->tls_session->ssl));
+  self->ktls.recv = BIO_get_ktls_recv(SSL_get_rbio(self->tls_session->ssl));
+#endif
+
+  if (self->ktls.send)
+    stats_counter_inc(stats_ktls_send_connections);
+  if (self->ktls.recv)
+    stats_counter_inc(stats_ktls_recv_connections);
+
+  msg_debug("TLS connection established, checking kernel TLS offload",
+            evt_tag_str("ktls_send", self->ktls.send ? "yes" : "no"),
+            evt_tag_str("ktls_recv", self->ktls.recv ? "yes" : "no"),
+            evt_tag_str("cipher", SSL_get_cipher_name(self->tls_session->ssl)),
+            tls_context_format_location_tag(self->tls_session->ctx));
+}
+
 static gssize
 log_transport_tls_read_method(LogTransport *s, gpointer buf, gsize buflen, LogTransportAuxData *aux)
 {
@@ -257,7 +303,10 @@ log_transport_tls_read_method(LogTransport *s, gpointer buf, gsize buflen, LogTr
   while (rc == -1 && errno == EINTR);
 
   if (rc > 0)
-    self->super.super.cond = 0;
+    {
+      self->super.super.cond = 0;
+      _check_ktls_offload(self);
+    }
 
   return rc;
 tls_error:
@@ -320,6 +369,7 @@ log_transport_tls_write_method(LogTransport *s, const gpointer buf, gsize buflen
   else
     {
       self->super.super.cond = 0;
+      _check_ktls_offload(self);
     }
 
   return rc;
@@ -347,8 +397,8 @@ log_tansport_tls_get_session(LogTransport *s)
 
 static void log_transport_tls_free_method(LogTransport *s);
 
-LogTransport *
-log_transport_tls_new(TLSSession *tls_session, LogTransportIndex base)
+static LogTransportTLS *
+_tls_transport_new(TLSSession *tls_session, LogTransportIndex base)
 {
   LogTransportTLS *self = g_new0(LogTransportTLS, 1);
 
@@ -359,8 +409,47 @@ log_transport_tls_new(TLSSession *tls_session, LogTransportIndex base)
   self->super.super.free_fn = log_transport_tls_free_method;
   self->tls_session = tls_session;
 
+  return self;
+}
+
+static void
+_set_transport_bio(LogTransportTLS *self)
+{
   BIO *bio = BIO_transport_new(self);
   SSL_set_bio(self->tls_session->ssl, bio, bio);
+}
+
+LogTransport *
+log_transport_tls_new(TLSSession *tls_session, LogTransportIndex base)
+{
+  LogTransportTLS *self = _tls_transport_new(tls_session, base);
+
+  _set_transport_bio(self);
+  return &self->super.super;
+}
+
+/*
+ * Lets OpenSSL do the I/O on the socket directly instead of going through
+ * the base transport, which is required for kernel TLS offload.  The caller
+ * must make sure that the base transport has no buffered data.  If the
+ * socket cannot be attached, the transport falls back to the I/O of the
+ * base transport, without kTLS.
+ */
+LogTransport *
+log_transport_tls_new_on_fd(TLSSession *tls_session, LogTransportIndex base, gint fd)
+{
+  LogTransportTLS *self = _tls_transport_new(tls_session, base);
+
+  if (fd < 0 || !SSL_set_fd(self->tls_session->ssl, fd))
+    {
+      msg_warning("Error setting up the TLS transport on a socket, kernel TLS offload disabled for this connection",
+                  evt_tag_int("fd", fd),
+                  tls_context_format_tls_error_tag(self->tls_session->ctx),
+                  tls_context_format_location_tag(self->tls_session->ctx));
+      ERR_clear_error();
+      _set_transport_bio(self);
+    }
+
   return &self->super.super;
 }
 
@@ -373,19 +462,61 @@ log_transport_tls_free_method(LogTransport *s)
   if (!SSL_in_init(self->tls_session->ssl))
     log_transport_tls_send_shutdown(self);
 
+  if (self->ktls.send)
+    stats_counter_dec(stats_ktls_send_connections);
+  if (self->ktls.recv)
+    stats_counter_dec(stats_ktls_recv_connections);
+
   tls_session_free(self->tls_session);
   log_transport_adapter_free_method(s);
 }
 
+static void
+_ktls_stats_key_set(StatsClusterKey *sc_key, StatsClusterLabel *labels, const gchar *direction)
+{
+  labels[0] = stats_cluster_label("direction", direction);
+  stats_cluster_single_key_set(sc_key, "tls_ktls_offloaded_connections", labels, 1);
+}
+
+static void
+_register_ktls_stats(void)
+{
+  StatsClusterKey sc_key;
+  StatsClusterLabel labels[1];
+
+  stats_lock();
+  _ktls_stats_key_set(&sc_key, labels, "send");
+  stats_register_counter(STATS_LEVEL0, &sc_key, SC_TYPE_SINGLE_VALUE, &stats_ktls_send_connections);
+  _ktls_stats_key_set(&sc_key, labels, "recv");
+  stats_register_counter(STATS_LEVEL0, &sc_key, SC_TYPE_SINGLE_VALUE, &stats_ktls_recv_connections);
+  stats_unlock();
+}
+
+static void
+_unregister_ktls_stats(void)
+{
+  StatsClusterKey sc_key;
+  StatsClusterLabel labels[1];
+
+  stats_lock();
+  _ktls_stats_key_set(&sc_key, labels, "send");
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &stats_ktls_send_connections);
+  _ktls_stats_key_set(&sc_key, labels, "recv");
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &stats_ktls_recv_connections);
+  stats_unlock();
+}
+
 void
 log_transport_tls_global_init(void)
 {
   meth_transport = BIO_s_transport();
+  register_application_hook(AH_RUNNING, (ApplicationHookFunc) _register_ktls_stats, NULL, AHM_RUN_ONCE);
 }
 
 void
 log_transport_tls_global_deinit(void)
 {
+  _unregister_ktls_stats();
   BIO_meth_free(meth_transport);
   meth_transport = NULL;
 }
@@ -28,6 +28,7 @@
 #include "transport/tls-context.h"
 
 LogTransport *log_transport_tls_new(TLSSession *tls_session, LogTransportIndex base_index);
+LogTransport *log_transport_tls_new_on_fd(TLSSession *tls_session, LogTransportIndex base_index, gint fd);
 TLSSession *log_tansport_tls_get_session(LogTransport *s);
 
 void log_transport_tls_global_init(void);
@@ -62,6 +62,8 @@
  *   - currently opened destination files are checked regularly and closed
  *     if they are idle for a given amount of time (time_reap) (this is done
  *     in the main thread)
+ *   - if max_open_files() is set, the least recently written idle files are
+ *     closed before a new one is opened (also in the main thread)
  *
  * Some of these operations have to be performed in the main thread, others
  * are done in the queue call.
@@ -78,11 +80,14 @@
  *    - looked up in _queue() (in the source thread)
  *    - cleaned up in reap callback (in the main thread)
  *
- * writer_hash is locked (currently a simple mutex) using
- * AFFileDestDriver->lock.  The "queue" method cannot hold the lock while
- * forwarding it to the next pipe, thus a reference is taken under the
- * protection of the lock, keeping a the next pipe alive, even if that would
- * go away in a parallel reaper process.
+ * writer_hash is locked using AFFileDestDriver->lock, which is a
+ * reader-writer lock: lookups in _queue() only take the reader side, so
+ * source threads writing to already opened files do not serialize on each
+ * other, while the main thread takes the writer side to insert and remove
+ * entries.  The "queue" method cannot hold the lock while forwarding it to
+ * the next pipe, thus a reference is taken under the protection of the lock,
+ * keeping a the next pipe alive, even if that would go away in a parallel
+ * reaper process.
  */
 
 static GList *affile_dest_drivers = NULL;
@@ -96,7 +101,9 @@ struct _AFFileDestWriter
   LogWriter *writer;
   time_t last_msg_stamp;
   time_t last_open_stamp;
-  gboolean reopen_pending, queue_pending;
+  gboolean reopen_pending;
+  /* number of threads forwarding a message to the writer, see affile_dw_is_idle() */
+  gint queue_pending;
 };
 
 static gchar *
@@ -112,6 +119,19 @@ affile_dw_format_persist_name(AFFileDestWriter *self)
 
 static void affile_dd_reap_writer(AFFileDestDriver *self, AFFileDestWriter *dw);
 
+/*
+ * queue_pending is incremented while holding the DestDriver lock (or in
+ * the main thread), and decremented once the message is in the queue of
+ * the LogWriter.  As writers are only reaped from the main thread, holding
+ * the writer side of the lock, a writer found idle cannot be picked up by
+ * another thread before it is removed.
+ */
+static gboolean
+affile_dw_is_idle(AFFileDestWriter *self)
+{
+  return g_atomic_int_get(&self->queue_pending) == 0 && !log_writer_has_pending_writes(self->writer);
+}
+
 static void
 affile_dw_reap(AFFileDestWriter *self)
 {
@@ -119,15 +139,15 @@ affile_dw_reap(AFFileDestWriter *self)
 
   main_loop_assert_main_thread();
 
-  g_mutex_lock(&owner->lock);
-  if (!log_writer_has_pending_writes((LogWriter *) self->writer) && !self->queue_pending)
+  g_rw_lock_writer_lock(&owner->lock);
+  if (affile_dw_is_idle(self))
     {
       msg_verbose("Destination timed out, reaping",
                   evt_tag_str("template", self->owner->filename_template->template_str),
                   evt_tag_str("filename", self->filename));
       affile_dd_reap_writer(self->owner, self);
     }
-  g_mutex_unlock(&owner->lock);
+  g_rw_lock_writer_unlock(&owner->lock);
 }
 
 static gboolean
@@ -462,6 +482,14 @@ affile_dd_get_time_reap(AFFileDestDriver *self)
   return log_proto_client_options_get_timeout(&self->writer_options.proto_options.super);
 }
 
+void
+affile_dd_set_max_open_files(LogDriver *s, gint max_open_files)
+{
+  AFFileDestDriver *self = (AFFileDestDriver *) s;
+
+  self->max_open_files = max_open_files;
+}
+
 static inline const gchar *
 affile_dd_format_persist_name(const LogPipe *s)
 {
@@ -489,6 +517,7 @@ affile_dd_reap_writer(AFFileDestDriver *self, AFFileDestWriter *dw)
     {
       /* remove from hash table */
       g_hash_table_remove(self->writer_hash, dw->filename);
+      stats_counter_set(self->metrics.open_writers, g_hash_table_size(self->writer_hash));
     }
   else
     {
@@ -502,6 +531,139 @@ affile_dd_reap_writer(AFFileDestDriver *self, AFFileDestWriter *dw)
   log_pipe_unref(&dw->super);
 }
 
+static gint
+_compare_writers_by_last_msg_stamp(gconstpointer a, gconstpointer b)
+{
+  const AFFileDestWriter *dw_a = *(const AFFileDestWriter **) a;
+  const AFFileDestWriter *dw_b = *(const AFFileDestWriter **) b;
+
+  if (dw_a->last_msg_stamp < dw_b->last_msg_stamp)
+    return -1;
+  return dw_a->last_msg_stamp > dw_b->last_msg_stamp ? 1 : 0;
+}
+
+static void
+_collect_idle_writer(gpointer key, gpointer value, gpointer user_data)
+{
+  AFFileDestWriter *dw = (AFFileDestWriter *) value;
+  GPtrArray *idle_writers = (GPtrArray *) user_data;
+
+  if (affile_dw_is_idle(dw))
+    g_ptr_array_add(idle_writers, dw);
+}
+
+/*
+ * Closes the least recently written idle files, so that there is room for a
+ * new one within max_open_files().  A batch of files is closed at once, so
+ * that a steady stream of new filenames does not cause a scan of
+ * writer_hash for every single open.  Writers that have messages in flight
+ * are never closed, so if every file is busy, the limit is temporarily
+ * exceeded.
+ *
+ * DestDriver lock must be held before calling this function.
+ */
+static void
+affile_dd_evict_writers(AFFileDestDriver *self)
+{
+  gint open_writers = g_hash_table_size(self->writer_hash);
+
+  main_loop_assert_main_thread();
+
+  if (self->max_open_files <= 0 || open_writers < self->max_open_files)
+    return;
+
+  GPtrArray *idle_writers = g_ptr_array_sized_new(open_writers);
+  g_hash_table_foreach(self->writer_hash, _collect_idle_writer, idle_writers);
+  g_ptr_array_sort(idle_writers, _compare_writers_by_last_msg_stamp);
+
+  gint to_evict = MAX(open_writers - self->max_open_files + 1, self->max_open_files / 16);
+  to_evict = MIN(to_evict, (gint) idle_writers->len);
+
+  if (to_evict == 0)
+    msg_debug("Number of open files exceeds max-open-files(), but all of them are busy",
+              evt_tag_str("template", self->filename_template->template_str),
+              evt_tag_int("max_open_files", self->max_open_files),
+              evt_tag_int("open_files", open_writers));
+
+  for (gint i = 0; i < to_evict; i++)
+    {
+      AFFileDestWriter *dw = g_ptr_array_index(idle_writers, i);
+
+      msg_verbose("Too many open files, closing least recently used one",
+                  evt_tag_str("template", self->filename_template->template_str),
+                  evt_tag_str("filename", dw->filename),
+                  evt_tag_int("max_open_files", self->max_open_files));
+      affile_dd_reap_writer(self, dw);
+      stats_counter_inc(self->metrics.writer_evictions);
+    }
+
+  g_ptr_array_free(idle_writers, TRUE);
+}
+
+static void
+affile_dd_register_stats(AFFileDestDriver *self)
+{
+  StatsClusterLabel labels[] =
+  {
+    stats_cluster_label("id", self->super.super.id),
+    stats_cluster_label("driver", "file"),
+    stats_cluster_label("result", NULL),
+  };
+
+  gint level = log_pipe_is_internal(&self->super.super.super) ? STATS_LEVEL3 : self->writer_options.stats_level;
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, "output_file_writer_opens_total", labels, 2);
+  stats_register_counter(level, &sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics.writer_opens);
+
+  stats_cluster_single_key_set(&sc_key, "output_file_writer_evictions_total", labels, 2);
+  stats_register_counter(level, &sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics.writer_evictions);
+
+  stats_cluster_single_key_set(&sc_key, "output_file_writers_open", labels, 2);
+  stats_register_counter(level, &sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics.open_writers);
+
+  labels[2].value = "hit";
+  stats_cluster_single_key_set(&sc_key, "output_file_writer_lookups_total", labels, G_N_ELEMENTS(labels));
+  stats_register_counter(level, &sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics.writer_lookup_hits);
+
+  labels[2].value = "miss";
+  stats_cluster_single_key_set(&sc_key, "output_file_writer_lookups_total", labels, G_N_ELEMENTS(labels));
+  stats_register_counter(level, &sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics.writer_lookup_misses);
+  stats_unlock();
+}
+
+static void
+affile_dd_unregister_stats(AFFileDestDriver *self)
+{
+  StatsClusterLabel labels[] =
+  {
+    stats_cluster_label("id", self->super.super.id),
+    stats_cluster_label("driver", "file"),
+    stats_cluster_label("result", NULL),
+  };
+
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, "output_file_writer_opens_total", labels, 2);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics.writer_opens);
+
+  stats_cluster_single_key_set(&sc_key, "output_file_writer_evictions_total", labels, 2);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics.writer_evictions);
+
+  stats_cluster_single_key_set(&sc_key, "output_file_writers_open", labels, 2);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics.open_writers);
+
+  labels[2].value = "hit";
+  stats_cluster_single_key_set(&sc_key, "output_file_writer_lookups_total", labels, G_N_ELEMENTS(labels));
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics.writer_lookup_hits);
+
+  labels[2].value = "miss";
+  stats_cluster_single_key_set(&sc_key, "output_file_writer_lookups_total", labels, G_N_ELEMENTS(labels));
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics.writer_lookup_misses);
+  stats_unlock();
+}
 
 /**
  * affile_dd_reuse_writer:
@@ -546,9 +708,14 @@ affile_dd_init(LogPipe *s)
 
   if (self->filename_is_a_template)
     {
+      affile_dd_register_stats(self);
+
       self->writer_hash = cfg_persist_config_fetch(cfg, affile_dd_format_persist_name(s));
       if (self->writer_hash)
-        g_hash_table_foreach(self->writer_hash, affile_dd_reuse_writer, self);
+        {
+          g_hash_table_foreach(self->writer_hash, affile_dd_reuse_writer, self);
+          stats_counter_set(self->metrics.open_writers, g_hash_table_size(self->writer_hash));
+        }
     }
   else
     {
@@ -640,6 +807,9 @@ affile_dd_deinit(LogPipe *s)
       self->writer_hash = NULL;
     }
 
+  if (self->filename_is_a_template)
+    affile_dd_unregister_stats(self);
+
   if (!log_dest_driver_deinit_method(s))
     return FALSE;
 
@@ -668,9 +838,9 @@ affile_dd_open_writer(gpointer args[])
           if (next && log_pipe_init(&next->super))
             {
               log_pipe_ref(&next->super);
-              g_mutex_lock(&self->lock);
+              g_rw_lock_writer_lock(&self->lock);
               self->single_writer = next;
-              g_mutex_unlock(&self->lock);
+              g_rw_lock_writer_unlock(&self->lock);
             }
           else
             {
@@ -700,6 +870,10 @@ affile_dd_open_writer(gpointer args[])
       next = g_hash_table_lookup(self->writer_hash, filename->str);
       if (!next)
         {
+          g_rw_lock_writer_lock(&self->lock);
+          affile_dd_evict_writers(self);
+          g_rw_lock_writer_unlock(&self->lock);
+
           next = affile_dw_new(filename->str, log_pipe_get_config(&self->super.super.super));
           affile_dw_set_owner(next, self);
           if (!log_pipe_init(&next->super))
@@ -710,9 +884,11 @@ affile_dd_open_writer(gpointer args[])
           else
             {
               log_pipe_ref(&next->super);
-              g_mutex_lock(&self->lock);
+              g_rw_lock_writer_lock(&self->lock);
               g_hash_table_insert(self->writer_hash, next->filename, next);
-              g_mutex_unlock(&self->lock);
+              stats_counter_set(self->metrics.open_writers, g_hash_table_size(self->writer_hash));
+              g_rw_lock_writer_unlock(&self->lock);
+              stats_counter_inc(self->metrics.writer_opens);
             }
         }
       else
@@ -723,7 +899,7 @@ affile_dd_open_writer(gpointer args[])
 
   if (next)
     {
-      next->queue_pending = TRUE;
+      g_atomic_int_inc(&next->queue_pending);
       /* we're returning a reference */
       return &next->super;
     }
@@ -743,18 +919,18 @@ affile_dd_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
       /* we need to lock single_writer in order to get a reference and
        * make sure it is not a stale pointer by the time we ref it */
 
-      g_mutex_lock(&self->lock);
+      g_rw_lock_reader_lock(&self->lock);
       if (!self->single_writer)
         {
-          g_mutex_unlock(&self->lock);
+          g_rw_lock_reader_unlock(&self->lock);
           next = main_loop_call((void *(*)(void *)) affile_dd_open_writer, args, TRUE);
         }
       else
         {
           next = self->single_writer;
-          next->queue_pending = TRUE;
+          g_atomic_int_inc(&next->queue_pending);
           log_pipe_ref(&next->super);
-          g_mutex_unlock(&self->lock);
+          g_rw_lock_reader_unlock(&self->lock);
         }
     }
   else
@@ -765,7 +941,7 @@ affile_dd_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
       LogTemplateEvalOptions options = {&self->writer_options.template_options, LTZ_LOCAL, 0, NULL, LM_VT_STRING};
       log_template_format(self->filename_template, msg, &options, filename);
 
-      g_mutex_lock(&self->lock);
+      g_rw_lock_reader_lock(&self->lock);
       if (self->writer_hash)
         next = g_hash_table_lookup(self->writer_hash, filename->str);
       else
@@ -774,12 +950,14 @@ affile_dd_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
       if (next)
         {
           log_pipe_ref(&next->super);
-          next->queue_pending = TRUE;
-          g_mutex_unlock(&self->lock);
+          g_atomic_int_inc(&next->queue_pending);
+          g_rw_lock_reader_unlock(&self->lock);
+          stats_counter_inc(self->metrics.writer_lookup_hits);
         }
       else
         {
-          g_mutex_unlock(&self->lock);
+          g_rw_lock_reader_unlock(&self->lock);
+          stats_counter_inc(self->metrics.writer_lookup_misses);
           args[1] = filename;
           next = main_loop_call((void *(*)(void *)) affile_dd_open_writer, args, TRUE);
         }
@@ -789,7 +967,7 @@ affile_dd_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
     {
       log_msg_add_ack(msg, path_options);
       log_pipe_queue(&next->super, log_msg_ref(msg), path_options);
-      next->queue_pending = FALSE;
+      g_atomic_int_add(&next->queue_pending, -1);
       log_pipe_unref(&next->super);
     }
 
@@ -801,7 +979,7 @@ affile_dd_free(LogPipe *s)
 {
   AFFileDestDriver *self = (AFFileDestDriver *) s;
 
-  g_mutex_clear(&self->lock);
+  g_rw_lock_clear(&self->lock);
   affile_dest_drivers = g_list_remove(affile_dest_drivers, self);
 
   /* NOTE: this must be NULL as deinit has freed it, otherwise we'd have circular references */
@@ -839,7 +1017,7 @@ affile_dd_new_instance(LogTemplate *filename_template, GlobalConfig *cfg)
   file_opener_options_defaults(&self->file_opener_options);
 
   affile_dd_set_time_reap(&self->super.super, self->filename_is_a_template ? -1 : 0);
-  g_mutex_init(&self->lock);
+  g_rw_lock_init(&self->lock);
 
   affile_dest_drivers = g_list_append(affile_dest_drivers, self);
 
@@ -33,7 +33,7 @@ typedef struct _AFFileDestWriter AFFileDestWriter;
 typedef struct _AFFileDestDriver
 {
   LogDestDriver super;
-  GMutex lock;
+  GRWLock lock;
   LogTemplate *filename_template;
   AFFileDestWriter *single_writer;
   gboolean filename_is_a_template;
@@ -49,6 +49,16 @@ typedef struct _AFFileDestDriver
   gint overwrite_if_older;
   gchar *symlink_as;
   gboolean use_time_recvd;
+  gint max_open_files;
+
+  struct
+  {
+    StatsCounterItem *writer_opens;
+    StatsCounterItem *writer_evictions;
+    StatsCounterItem *writer_lookup_hits;
+    StatsCounterItem *writer_lookup_misses;
+    StatsCounterItem *open_writers;
+  } metrics;
 } AFFileDestDriver;
 
 AFFileDestDriver *affile_dd_new_instance(LogTemplate *filename_template, GlobalConfig *cfg);
@@ -60,6 +70,7 @@ void affile_dd_set_overwrite_if_older(LogDriver *s, gint overwrite_if_older);
 void affile_dd_set_symlink_as(LogDriver *s, const gchar *symlink_as);
 void affile_dd_set_local_time_zone(LogDriver *s, const gchar *local_time_zone);
 void affile_dd_set_time_reap(LogDriver *s, gint time_reap);
+void affile_dd_set_max_open_files(LogDriver *s, gint max_open_files);
 void affile_dd_global_init(void);
 
 #endif
@@ -52,6 +52,7 @@ static CfgLexerKeyword affile_keywords[] =
   { "follow_freq",        KW_FOLLOW_FREQ },
   { "multi_line_timeout", KW_MULTI_LINE_TIMEOUT },
   { "time_reap",          KW_TIME_REAP },
+  { "max_open_files",     KW_MAX_OPEN_FILES },
   { NULL }
 };
 
@@ -96,6 +96,13 @@ _is_fd_pollable(gint fd)
 static PollEvents *
 _construct_poll_events(FileReader *self, gint fd)
 {
+  if (self->construct_poll_events)
+    {
+      PollEvents *poll_events = self->construct_poll_events(self, fd);
+      if (poll_events)
+        return poll_events;
+    }
+
   if (self->options->follow_freq > 0)
     {
       LogProtoFileReaderOptions *proto_opts = file_reader_options_get_log_proto_options(self->options);
@@ -42,6 +42,9 @@ typedef struct _FileReader
   FileReaderOptions *options;
   FileOpener *opener;
   LogReader *reader;
+
+  /* optional, returns NULL to fall back to the default */
+  PollEvents *(*construct_poll_events)(struct _FileReader *self, gint fd);
 } FileReader;
 
 static inline LogProtoFileReaderOptions *
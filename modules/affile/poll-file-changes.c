@@ -168,7 +168,7 @@ poll_file_changes_stop_watches(PollEvents *s)
     iv_timer_unregister(&self->follow_timer);
 }
 
-static void
+void
 poll_file_changes_rearm_timer(PollFileChanges *self, glong delay)
 {
   iv_validate_now();
@@ -54,6 +54,7 @@ void poll_file_changes_init_instance(PollFileChanges *self, gint fd, const gchar
 void poll_file_changes_update_watches(PollEvents *s, GIOCondition cond);
 void poll_file_changes_stop_watches(PollEvents *s);
 void poll_file_changes_stop_on_eof(PollEvents *s);
+void poll_file_changes_rearm_timer(PollFileChanges *self, glong delay);
 void poll_file_changes_free(PollEvents *s);
 
 #endif
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include "poll-inotify-file-changes.h"
+#include "messages.h"
+
+/*
+ * PollFileChanges that is woken up by inotify instead of waiting for the
+ * follow timer when it is idle at the end of the file.
+ *
+ * The watch is kept for the lifetime of the reader.  Changes reported while
+ * a read is in progress are only recorded, the next update_watches() turns
+ * them into an immediate check.  The follow timer still runs, with a much
+ * longer period, to catch what inotify cannot report (e.g. a new file
+ * created in place of the followed one).
+ */
+typedef struct _PollInotifyFileChanges
+{
+  PollFileChanges super;
+  struct iv_inotify *inotify;
+  struct iv_inotify_watch watch;
+  gboolean watch_registered;
+  gboolean change_pending;
+  gint follow_freq;
+} PollInotifyFileChanges;
+
+static void
+_on_file_changed(gpointer s, struct inotify_event *event)
+{
+  PollInotifyFileChanges *self = (PollInotifyFileChanges *) s;
+
+  /* the kernel has already dropped the watch, e.g. the file was deleted */
+  if (event->mask & IN_IGNORED)
+    self->watch_registered = FALSE;
+
+  /* a read is in progress or the reader is suspended, leave it to the next update_watches() */
+  if (!iv_timer_registered(&self->super.follow_timer))
+    {
+      self->change_pending = TRUE;
+      return;
+    }
+
+  msg_trace("poll-inotify-file-changes: file changed",
+            evt_tag_str("follow_filename", self->super.follow_filename),
+            evt_tag_printf("mask", "0x%x", event->mask));
+
+  /* run the check from the timer, so a burst of writes results in a single read */
+  iv_timer_unregister(&self->super.follow_timer);
+  poll_file_changes_rearm_timer(&self->super, 0);
+}
+
+static gboolean
+_register_watch(PollInotifyFileChanges *self)
+{
+  if (self->watch_registered)
+    return TRUE;
+
+  IV_INOTIFY_WATCH_INIT(&self->watch);
+  self->watch.inotify = self->inotify;
+  self->watch.pathname = self->super.follow_filename;
+  self->watch.mask = IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF;
+#ifdef IN_MASK_CREATE
+  /* another path of the same inode is already watched, the two watches would share a descriptor */
+  self->watch.mask |= IN_MASK_CREATE;
+#endif
+  self->watch.cookie = self;
+  self->watch.handler = _on_file_changed;
+
+  if (iv_inotify_watch_register(&self->watch) < 0)
+    {
+      msg_debug("poll-inotify-file-changes: could not add inotify watch, polling the file instead, you may need to "
+                "increase /proc/sys/fs/inotify/max_user_watches",
+                evt_tag_str("follow_filename", self->super.follow_filename),
+                evt_tag_error("error"));
+      return FALSE;
+    }
+
+  self->watch_registered = TRUE;
+  return TRUE;
+}
+
+static void
+_unregister_watch(PollInotifyFileChanges *self)
+{
+  if (!self->watch_registered)
+    return;
+
+  iv_inotify_watch_unregister(&self->watch);
+  self->watch_registered = FALSE;
+}
+
+static void
+poll_inotify_file_changes_update_watches(PollEvents *s, GIOCondition cond)
+{
+  PollInotifyFileChanges *self = (PollInotifyFileChanges *) s;
+
+  if (self->super.fd >= 0 && _register_watch(self))
+    self->super.follow_freq = MAX(self->follow_freq, POLL_INOTIFY_FILE_CHANGES_RECHECK_FREQ);
+  else
+    self->super.follow_freq = self->follow_freq;
+
+  poll_file_changes_update_watches(s, cond);
+
+  if (self->change_pending && iv_timer_registered(&self->super.follow_timer))
+    {
+      iv_timer_unregister(&self->super.follow_timer);
+      poll_file_changes_rearm_timer(&self->super, 0);
+    }
+  self->change_pending = FALSE;
+}
+
+static void
+poll_inotify_file_changes_free(PollEvents *s)
+{
+  PollInotifyFileChanges *self = (PollInotifyFileChanges *) s;
+
+  _unregister_watch(self);
+  poll_file_changes_free(s);
+}
+
+PollEvents *
+poll_inotify_file_changes_new(gint fd, const gchar *follow_filename, gint follow_freq,
+                              struct iv_inotify *inotify, LogPipe *control)
+{
+  PollInotifyFileChanges *self = g_new0(PollInotifyFileChanges, 1);
+
+  poll_file_changes_init_instance(&self->super, fd, follow_filename, follow_freq, control);
+  self->super.super.update_watches = poll_inotify_file_changes_update_watches;
+  self->super.super.free_fn = poll_inotify_file_changes_free;
+
+  self->inotify = inotify;
+  self->follow_freq = follow_freq;
+
+  return &self->super.super;
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#ifndef POLL_INOTIFY_FILE_CHANGES_H_INCLUDED
+#define POLL_INOTIFY_FILE_CHANGES_H_INCLUDED
+
+#include "poll-file-changes.h"
+#include <iv_inotify.h>
+
+/* the follow timer is only a safety net next to inotify, so it can run rarely */
+#define POLL_INOTIFY_FILE_CHANGES_RECHECK_FREQ 10000
+
+PollEvents *poll_inotify_file_changes_new(gint fd, const gchar *follow_filename, gint follow_freq,
+                                          struct iv_inotify *inotify, LogPipe *control);
+
+#endif
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+#include "libtest/config_parse_lib.h"
+#include "libtest/fake-time.h"
+
+#include "affile-dest.h"
+#include "cfg.h"
+#include "cfg-tree.h"
+#include "mainloop.h"
+#include "timeutils/misc.h"
+#include "apphook.h"
+
+#include <iv.h>
+#include <glib/gstdio.h>
+
+static gchar *test_dir;
+
+static void
+_init(void)
+{
+  app_startup();
+  main_thread_handle = get_thread_id();
+  configuration = cfg_new_snippet();
+  cr_assert(cfg_load_module(configuration, "affile"));
+
+  test_dir = g_dir_make_tmp("test_affile_dest_XXXXXX", NULL);
+  cr_assert_not_null(test_dir);
+}
+
+static void
+_deinit(void)
+{
+  cfg_deinit(configuration);
+  cfg_free(configuration);
+
+  GDir *dir = g_dir_open(test_dir, 0, NULL);
+  const gchar *name;
+  while ((name = g_dir_read_name(dir)))
+    {
+      gchar *path = g_build_filename(test_dir, name, NULL);
+      g_unlink(path);
+      g_free(path);
+    }
+  g_dir_close(dir);
+  g_rmdir(test_dir);
+  g_free(test_dir);
+
+  app_shutdown();
+}
+
+TestSuite(affile_dest, .init = _init, .fini = _deinit);
+
+static AFFileDestDriver *
+_create_templated_file_destination(gint max_open_files)
+{
+  /* writers flush in the main thread, which is driven by _run_main_loop_until_written() */
+  gchar *raw_config = g_strdup_printf("options { threaded(no); };"
+                                      "destination d_test { file(\"%s/${HOST}.log\" max-open-files(%d)); };"
+                                      "log { destination(d_test); };", test_dir, max_open_files);
+  cr_assert(parse_config(raw_config, LL_CONTEXT_ROOT, NULL, NULL), "Parsing the given configuration failed");
+  g_free(raw_config);
+
+  cr_assert(cfg_init(configuration), "Config initialization failed");
+  LogExprNode *expr_node = cfg_tree_get_object(&configuration->tree, ENC_DESTINATION, "d_test");
+  cr_assert_not_null(expr_node);
+
+  AFFileDestDriver *driver = (AFFileDestDriver *) expr_node->children->children->object;
+  cr_assert_not_null(driver);
+  return driver;
+}
+
+static void
+_send_message(AFFileDestDriver *driver, const gchar *host, time_t now)
+{
+  LogMessage *msg = log_msg_new_empty();
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  log_msg_set_value(msg, LM_V_HOST, host, -1);
+  log_msg_set_value(msg, LM_V_MESSAGE, "message", -1);
+
+  /* the last message timestamp of a writer decides its position in the LRU */
+  fake_time(now);
+  log_pipe_queue(&driver->super.super.super, msg, &path_options);
+}
+
+static gsize
+_count_lines(const gchar *host)
+{
+  gchar *path = g_strdup_printf("%s/%s.log", test_dir, host);
+  gchar *contents = NULL;
+  gsize lines = 0;
+
+  if (g_file_get_contents(path, &contents, NULL, NULL))
+    {
+      for (gchar *p = contents; *p; p++)
+        lines += (*p == '\n');
+    }
+
+  g_free(contents);
+  g_free(path);
+  return lines;
+}
+
+typedef struct
+{
+  struct iv_timer timer;
+  const gchar *host;
+  gsize expected_lines;
+  gint deadline;
+} WaitForWrite;
+
+static void
+_check_written(gpointer user_data)
+{
+  WaitForWrite *wait = (WaitForWrite *) user_data;
+
+  if (_count_lines(wait->host) >= wait->expected_lines || --wait->deadline == 0)
+    {
+      iv_quit();
+      return;
+    }
+
+  iv_validate_now();
+  wait->timer.expires = iv_now;
+  timespec_add_msec(&wait->timer.expires, 10);
+  iv_timer_register(&wait->timer);
+}
+
+static void
+_run_main_loop_until_written(const gchar *host, gsize expected_lines)
+{
+  WaitForWrite wait = { .host = host, .expected_lines = expected_lines, .deadline = 500 };
+
+  IV_TIMER_INIT(&wait.timer);
+  wait.timer.handler = _check_written;
+  wait.timer.cookie = &wait;
+  iv_validate_now();
+  wait.timer.expires = iv_now;
+  iv_timer_register(&wait.timer);
+
+  iv_main();
+
+  cr_assert_eq(_count_lines(host), expected_lines, "%s.log was not written in time", host);
+}
+
+static gboolean
+_is_open(AFFileDestDriver *driver, const gchar *host)
+{
+  gchar *path = g_strdup_printf("%s/%s.log", test_dir, host);
+  gboolean open = g_hash_table_lookup(driver->writer_hash, path) != NULL;
+
+  g_free(path);
+  return open;
+}
+
+Test(affile_dest, least_recently_written_idle_file_is_closed_over_max_open_files)
+{
+  AFFileDestDriver *driver = _create_templated_file_destination(2);
+
+  _send_message(driver, "a", 1000);
+  _run_main_loop_until_written("a", 1);
+  _send_message(driver, "b", 2000);
+  _run_main_loop_until_written("b", 1);
+
+  /* a was written least recently, but it is written again now */
+  _send_message(driver, "a", 3000);
+  _run_main_loop_until_written("a", 2);
+
+  cr_assert_eq(g_hash_table_size(driver->writer_hash), 2);
+  cr_assert_eq(stats_counter_get(driver->metrics.writer_evictions), 0);
+
+  _send_message(driver, "c", 4000);
+  _run_main_loop_until_written("c", 1);
+
+  cr_assert_eq(g_hash_table_size(driver->writer_hash), 2);
+  cr_assert_eq(stats_counter_get(driver->metrics.writer_evictions), 1);
+  cr_assert_eq(stats_counter_get(driver->metrics.open_writers), 2);
+  cr_assert(_is_open(driver, "a"));
+  cr_assert_not(_is_open(driver, "b"), "the least recently written file should be closed");
+  cr_assert(_is_open(driver, "c"));
+}
+
+Test(affile_dest, evicted_file_is_reopened_and_appended_to)
+{
+  AFFileDestDriver *driver = _create_templated_file_destination(1);
+
+  _send_message(driver, "a", 1000);
+  _run_main_loop_until_written("a", 1);
+  _send_message(driver, "b", 2000);
+  _run_main_loop_until_written("b", 1);
+
+  cr_assert_not(_is_open(driver, "a"));
+  cr_assert_eq(stats_counter_get(driver->metrics.writer_opens), 2);
+
+  _send_message(driver, "a", 3000);
+  _run_main_loop_until_written("a", 2);
+
+  cr_assert(_is_open(driver, "a"));
+  cr_assert_not(_is_open(driver, "b"));
+  cr_assert_eq(stats_counter_get(driver->metrics.writer_opens), 3);
+  cr_assert_eq(stats_counter_get(driver->metrics.writer_evictions), 2);
+
+  /* the earlier contents of both files are kept */
+  cr_assert_eq(_count_lines("b"), 1);
+}
+
+Test(affile_dest, files_are_not_closed_below_max_open_files)
+{
+  AFFileDestDriver *driver = _create_templated_file_destination(10);
+
+  _send_message(driver, "a", 1000);
+  _run_main_loop_until_written("a", 1);
+  _send_message(driver, "b", 2000);
+  _run_main_loop_until_written("b", 1);
+  _send_message(driver, "c", 3000);
+  _run_main_loop_until_written("c", 1);
+
+  cr_assert_eq(g_hash_table_size(driver->writer_hash), 3);
+  cr_assert_eq(stats_counter_get(driver->metrics.writer_evictions), 0);
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "syslog-ng.h"
+#include "apphook.h"
+#include "logpipe.h"
+
+TestSuite(poll_inotify_file_changes, .init = app_startup, .fini = app_shutdown);
+
+#if SYSLOG_NG_HAVE_INOTIFY
+
+#include "poll-inotify-file-changes.h"
+#include "timeutils/misc.h"
+
+#include <iv.h>
+#include <iv_inotify.h>
+#include <glib/gstdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define TEST_TIMEOUT 5000
+
+typedef struct _TestReader
+{
+  gchar filename[32];
+  gint fd;
+  gint write_fd;
+  struct iv_inotify inotify;
+  LogPipe *control;
+  PollEvents *poll;
+  struct iv_timer append_timer;
+  struct iv_timer timeout_timer;
+  gboolean read_initiated;
+} TestReader;
+
+static void
+_on_read(gpointer s)
+{
+  TestReader *self = (TestReader *) s;
+
+  self->read_initiated = TRUE;
+  poll_events_stop_watches(self->poll);
+  iv_quit();
+}
+
+static void
+_append_line(gpointer s)
+{
+  TestReader *self = (TestReader *) s;
+  const gchar *line = "new line\n";
+
+  cr_assert_eq(write(self->write_fd, line, strlen(line)), strlen(line));
+}
+
+static void
+_on_timeout(gpointer s)
+{
+  iv_quit();
+}
+
+static void
+_start_timer(struct iv_timer *timer, void (*handler)(void *), gpointer cookie, glong delay)
+{
+  IV_TIMER_INIT(timer);
+  timer->handler = handler;
+  timer->cookie = cookie;
+  iv_validate_now();
+  timer->expires = iv_now;
+  timespec_add_msec(&timer->expires, delay);
+  iv_timer_register(timer);
+}
+
+static void
+_stop_timer(struct iv_timer *timer)
+{
+  if (iv_timer_registered(timer))
+    iv_timer_unregister(timer);
+}
+
+static void
+_test_reader_init(TestReader *self, gboolean unlink_file, gint follow_freq)
+{
+  g_strlcpy(self->filename, "test_poll_inotify.XXXXXX", sizeof(self->filename));
+  self->fd = g_mkstemp(self->filename);
+  cr_assert_geq(self->fd, 0);
+  self->write_fd = open(self->filename, O_WRONLY | O_APPEND);
+  cr_assert_geq(self->write_fd, 0);
+
+  /* without the path the watch cannot be added, the reader has to poll */
+  if (unlink_file)
+    unlink(self->filename);
+
+  IV_INOTIFY_INIT(&self->inotify);
+  cr_assert_eq(iv_inotify_register(&self->inotify), 0);
+
+  self->control = log_pipe_new(NULL);
+  self->poll = poll_inotify_file_changes_new(self->fd, self->filename, follow_freq, &self->inotify, self->control);
+  poll_events_set_callback(self->poll, _on_read, self);
+}
+
+static void
+_test_reader_run(TestReader *self)
+{
+  /* at the end of the (empty) file, waiting for new data */
+  poll_events_update_watches(self->poll, G_IO_IN);
+  cr_assert_not(self->read_initiated);
+
+  _start_timer(&self->append_timer, _append_line, self, 50);
+  _start_timer(&self->timeout_timer, _on_timeout, self, TEST_TIMEOUT);
+  iv_main();
+  _stop_timer(&self->append_timer);
+  _stop_timer(&self->timeout_timer);
+}
+
+static void
+_test_reader_deinit(TestReader *self)
+{
+  poll_events_stop_watches(self->poll);
+  poll_events_free(self->poll);
+  log_pipe_unref(self->control);
+  iv_inotify_unregister(&self->inotify);
+  close(self->write_fd);
+  close(self->fd);
+  unlink(self->filename);
+}
+
+static gint
+_get_follow_freq(TestReader *self)
+{
+  return ((PollFileChanges *) self->poll)->follow_freq;
+}
+
+Test(poll_inotify_file_changes, inotify_wakes_up_the_reader_before_the_follow_timer)
+{
+  TestReader reader = {0};
+
+  _test_reader_init(&reader, FALSE, 3 * TEST_TIMEOUT);
+  _test_reader_run(&reader);
+
+  cr_assert(reader.read_initiated, "the reader was not woken up by inotify");
+  cr_assert_eq(_get_follow_freq(&reader), 3 * TEST_TIMEOUT);
+
+  _test_reader_deinit(&reader);
+}
+
+Test(poll_inotify_file_changes, follow_timer_only_rechecks_rarely_while_inotify_is_active)
+{
+  TestReader reader = {0};
+
+  _test_reader_init(&reader, FALSE, 100);
+  poll_events_update_watches(reader.poll, G_IO_IN);
+
+  cr_assert_eq(_get_follow_freq(&reader), POLL_INOTIFY_FILE_CHANGES_RECHECK_FREQ);
+
+  _test_reader_deinit(&reader);
+}
+
+Test(poll_inotify_file_changes, falls_back_to_polling_if_the_watch_cannot_be_added)
+{
+  TestReader reader = {0};
+
+  _test_reader_init(&reader, TRUE, 100);
+  _test_reader_run(&reader);
+
+  cr_assert(reader.read_initiated, "the follow timer did not pick up the change");
+  cr_assert_eq(_get_follow_freq(&reader), 100);
+
+  _test_reader_deinit(&reader);
+}
+
+#endif
@@ -26,6 +26,10 @@
 #include "mainloop.h"
 #include "poll-file-changes.h"
 
+#if SYSLOG_NG_HAVE_INOTIFY
+#include "poll-inotify-file-changes.h"
+#endif
+
 static inline const gchar *
 _format_persist_name(const LogPipe *s)
 {
@@ -178,6 +182,27 @@ _handle_file_state_event(gpointer s)
     _deleted_file_eof(&self->file_state_event, &self->super);
 }
 
+static PollEvents *
+_construct_poll_events(FileReader *s, gint fd)
+{
+#if SYSLOG_NG_HAVE_INOTIFY
+  WildcardFileReader *self = (WildcardFileReader *) s;
+  LogProtoFileReaderOptions *proto_opts = file_reader_options_get_log_proto_options(s->options);
+
+  /* multi-line files have their own timer for flushing partial messages, they stay on polling */
+  if (self->inotify && s->options->follow_freq > 0 && proto_opts->multi_line_options.mode == MLM_NONE)
+    return poll_inotify_file_changes_new(fd, s->filename->str, s->options->follow_freq, self->inotify, &s->super);
+#endif
+
+  return NULL;
+}
+
+void
+wildcard_file_reader_set_inotify(WildcardFileReader *self, struct iv_inotify *inotify)
+{
+  self->inotify = inotify;
+}
+
 void
 wildcard_file_reader_on_deleted_file_eof(WildcardFileReader *self,
                                          FileStateEventCallback cb,
@@ -203,6 +228,7 @@ wildcard_file_reader_new(const gchar *filename, FileReaderOptions *options, File
   self->super.super.notify = _notify;
   self->super.super.deinit = _deinit;
   self->super.super.generate_persist_name = _format_persist_name;
+  self->super.construct_poll_events = _construct_poll_events;
   IV_TASK_INIT(&self->file_state_event_handler);
   self->file_state_event_handler.cookie = self;
   self->file_state_event_handler.handler = _handle_file_state_event;
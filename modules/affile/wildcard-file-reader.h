@@ -31,6 +31,8 @@
 
 typedef struct _WildcardFileReader WildcardFileReader;
 
+struct iv_inotify;
+
 typedef void (*FileStateEventCallback)(FileReader *file_reader, gpointer user_data);
 
 typedef struct _FileStateEvent
@@ -52,6 +54,7 @@ struct _WildcardFileReader
   FileState file_state;
   FileStateEvent file_state_event;
   struct iv_task file_state_event_handler;
+  struct iv_inotify *inotify;
 };
 
 WildcardFileReader *
@@ -61,6 +64,7 @@ wildcard_file_reader_new(const gchar *filename, FileReaderOptions *options,
 
 void wildcard_file_reader_on_deleted_file_eof(WildcardFileReader *self, FileStateEventCallback cb, gpointer user_data);
 gboolean wildcard_file_reader_is_deleted(WildcardFileReader *self);
+void wildcard_file_reader_set_inotify(WildcardFileReader *self, struct iv_inotify *inotify);
 
 
 #endif /* MODULES_AFFILE_WILDCARD_FILE_READER_H_ */
@@ -118,6 +118,10 @@ _create_file_reader(WildcardSourceDriver *self, const gchar *full_path)
                                     &self->super,
                                     cfg);
   log_pipe_set_options(&reader->super.super, &self->super.super.super.options);
+#if SYSLOG_NG_HAVE_INOTIFY
+  if (self->file_inotify_registered)
+    wildcard_file_reader_set_inotify(reader, &self->file_inotify);
+#endif
 
   wildcard_file_reader_on_deleted_file_eof(reader, _remove_file_reader, self);
 
@@ -320,6 +324,50 @@ _add_directory_monitor(WildcardSourceDriver *self, const gchar *directory)
   return monitor;
 }
 
+#if SYSLOG_NG_HAVE_INOTIFY
+
+static void
+_init_file_inotify(WildcardSourceDriver *self)
+{
+  if (self->monitor_method != MM_AUTO && self->monitor_method != MM_INOTIFY)
+    return;
+
+  IV_INOTIFY_INIT(&self->file_inotify);
+  if (iv_inotify_register(&self->file_inotify))
+    {
+      msg_warning("wildcard-file(): could not create inotify object for the followed files, polling them instead, "
+                  "you may need to increase /proc/sys/fs/inotify/max_user_instances",
+                  evt_tag_error("errno"),
+                  log_pipe_location_tag(&self->super.super.super));
+      return;
+    }
+  self->file_inotify_registered = TRUE;
+}
+
+static void
+_deinit_file_inotify(WildcardSourceDriver *self)
+{
+  if (!self->file_inotify_registered)
+    return;
+
+  iv_inotify_unregister(&self->file_inotify);
+  self->file_inotify_registered = FALSE;
+}
+
+#else
+
+static void
+_init_file_inotify(WildcardSourceDriver *self)
+{
+}
+
+static void
+_deinit_file_inotify(WildcardSourceDriver *self)
+{
+}
+
+#endif
+
 static gboolean
 _init(LogPipe *s)
 {
@@ -344,9 +392,13 @@ _init(LogPipe *s)
     return FALSE;
 
   _init_opener_options(self, cfg);
+  _init_file_inotify(self);
 
   if (!_add_directory_monitor(self, self->base_dir))
-    return FALSE;
+    {
+      _deinit_file_inotify(self);
+      return FALSE;
+    }
 
   return TRUE;
 }
@@ -367,6 +419,7 @@ _deinit(LogPipe *s)
   g_pattern_spec_free(self->compiled_pattern);
   g_hash_table_foreach(self->file_readers, _deinit_reader, NULL);
   g_hash_table_remove_all(self->directory_monitors);
+  _deinit_file_inotify(self);
   return TRUE;
 }
 
@@ -29,6 +29,10 @@
 #include "directory-monitor.h"
 #include "directory-monitor-factory.h"
 
+#if SYSLOG_NG_HAVE_INOTIFY
+#include <iv_inotify.h>
+#endif
+
 #define DEFAULT_MAX_FILES 100
 
 typedef struct _WildcardSourceDriver
@@ -51,6 +55,12 @@ typedef struct _WildcardSourceDriver
   FileOpener *file_opener;
 
   PendingFileList *waiting_list;
+
+#if SYSLOG_NG_HAVE_INOTIFY
+  /* shared by the readers to get notified about file modifications */
+  struct iv_inotify file_inotify;
+  gboolean file_inotify_registered;
+#endif
 } WildcardSourceDriver;
 
 LogDriver *wildcard_sd_new(GlobalConfig *cfg);
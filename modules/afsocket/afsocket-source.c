@@ -62,6 +62,8 @@ typedef struct _AFSocketSourceConnection
   int sock;
   GSockAddr *peer_addr;
   GSockAddr *local_addr;
+  /* the listen shard the connection was accepted on, -1 if not sharded */
+  gint shard_index;
 } AFSocketSourceConnection;
 
 static void afsocket_sd_close_connection(AFSocketSourceDriver *self, AFSocketSourceConnection *sc);
@@ -90,6 +92,34 @@ _connections_count_dec(AFSocketSourceDriver *self)
   atomic_gssize_dec(&self->num_connections);
 }
 
+static AFSocketListenShard *
+_lookup_connection_shard(AFSocketSourceDriver *self, AFSocketSourceConnection *sc)
+{
+  /* connections kept alive across reloads may come from a different number of shards */
+  if (!self->shards || sc->shard_index < 0 || sc->shard_index >= self->listen_shards)
+    return NULL;
+
+  return &self->shards[sc->shard_index];
+}
+
+static void
+_shard_connections_count_inc(AFSocketSourceDriver *self, AFSocketSourceConnection *sc)
+{
+  AFSocketListenShard *shard = _lookup_connection_shard(self, sc);
+
+  if (shard)
+    atomic_gssize_inc(&shard->num_connections);
+}
+
+static void
+_shard_connections_count_dec(AFSocketSourceDriver *self, AFSocketSourceConnection *sc)
+{
+  AFSocketListenShard *shard = _lookup_connection_shard(self, sc);
+
+  if (shard)
+    atomic_gssize_dec(&shard->num_connections);
+}
+
 static gchar *
 _format_sc_name(AFSocketSourceConnection *self, gint format_type)
 {
@@ -275,6 +305,7 @@ afsocket_sc_new(GSockAddr *peer_addr, GSockAddr *local_addr, int fd, GlobalConfi
   self->peer_addr = g_sockaddr_ref(peer_addr);
   self->local_addr = g_sockaddr_ref(local_addr);
   self->sock = fd;
+  self->shard_index = -1;
   return self;
 }
 
@@ -345,6 +376,14 @@ afsocket_sd_set_listen_backlog(LogDriver *s, gint listen_backlog)
   self->listen_backlog = listen_backlog;
 }
 
+void
+afsocket_sd_set_listen_shards(LogDriver *s, gint listen_shards)
+{
+  AFSocketSourceDriver *self = (AFSocketSourceDriver *) s;
+
+  self->listen_shards = listen_shards;
+}
+
 void
 afsocket_sd_set_dynamic_window_size(LogDriver *s, gint dynamic_window_size)
 {
@@ -403,6 +442,17 @@ afsocket_sd_format_listener_name(const AFSocketSourceDriver *self)
   return persist_name;
 }
 
+static const gchar *
+afsocket_sd_format_shard_listener_name(const AFSocketSourceDriver *self, gint shard_index)
+{
+  static gchar persist_name[1024];
+
+  g_snprintf(persist_name, sizeof(persist_name), "%s.listen_fd.%d",
+             afsocket_sd_format_name((const LogPipe *)self), shard_index);
+
+  return persist_name;
+}
+
 static const gchar *
 afsocket_sd_format_connections_name(const AFSocketSourceDriver *self)
 {
@@ -426,7 +476,8 @@ afsocket_sd_format_dynamic_window_pool_name(const AFSocketSourceDriver *self)
 }
 
 static gboolean
-afsocket_sd_process_connection(AFSocketSourceDriver *self, GSockAddr *client_addr, GSockAddr *local_addr, gint fd)
+afsocket_sd_process_connection(AFSocketSourceDriver *self, GSockAddr *client_addr, GSockAddr *local_addr, gint fd,
+                               AFSocketListenShard *shard)
 {
   gchar buf[MAX_SOCKADDR_STRING], buf2[MAX_SOCKADDR_STRING];
 #if SYSLOG_NG_ENABLE_TCP_WRAPPER
@@ -470,10 +521,14 @@ afsocket_sd_process_connection(AFSocketSourceDriver *self, GSockAddr *client_add
 
       conn = afsocket_sc_new(client_addr, local_addr, fd, self->super.super.super.cfg);
       afsocket_sc_set_owner(conn, self);
+      if (shard)
+        conn->shard_index = shard->index;
+
       if (log_pipe_init(&conn->super))
         {
           afsocket_sd_add_connection(self, conn);
           _connections_count_inc(self);
+          _shard_connections_count_inc(self, conn);
           log_pipe_append(&conn->super, &self->super.super.super);
         }
       else
@@ -487,59 +542,125 @@ afsocket_sd_process_connection(AFSocketSourceDriver *self, GSockAddr *client_add
 
 #define MAX_ACCEPTS_AT_A_TIME 30
 
-static void
-afsocket_sd_accept(gpointer s)
+typedef struct _AFSocketAcceptedConnection
 {
-  AFSocketSourceDriver *self = (AFSocketSourceDriver *) s;
+  gint fd;
   GSockAddr *peer_addr;
   GSockAddr *local_addr;
+} AFSocketAcceptedConnection;
+
+static gboolean
+_accept_connection(gint listen_fd, AFSocketAcceptedConnection *accepted)
+{
+  GIOStatus status = g_accept(listen_fd, &accepted->fd, &accepted->peer_addr);
+
+  if (status == G_IO_STATUS_AGAIN)
+    {
+      /* no more connections to accept */
+      return FALSE;
+    }
+  else if (status != G_IO_STATUS_NORMAL)
+    {
+      msg_error("Error accepting new connection",
+                evt_tag_error(EVT_TAG_OSERROR));
+      return FALSE;
+    }
+
+  g_fd_set_nonblock(accepted->fd, TRUE);
+  g_fd_set_cloexec(accepted->fd, TRUE);
+
+  accepted->local_addr = g_socket_get_local_name(accepted->fd);
+  return TRUE;
+}
+
+static void
+_setup_accepted_connection(AFSocketSourceDriver *self, AFSocketAcceptedConnection *accepted,
+                           AFSocketListenShard *shard)
+{
   gchar buf1[256], buf2[256];
-  gint new_fd;
-  gboolean res;
-  int accepts = 0;
 
-  while (accepts < MAX_ACCEPTS_AT_A_TIME)
+  if (afsocket_sd_process_connection(self, accepted->peer_addr, accepted->local_addr, accepted->fd, shard))
     {
-      GIOStatus status;
+      socket_options_setup_peer_socket(self->socket_options, accepted->fd, accepted->peer_addr);
 
-      status = g_accept(self->fd, &new_fd, &peer_addr);
-      if (status == G_IO_STATUS_AGAIN)
-        {
-          /* no more connections to accept */
-          break;
-        }
-      else if (status != G_IO_STATUS_NORMAL)
-        {
-          msg_error("Error accepting new connection",
-                    evt_tag_error(EVT_TAG_OSERROR));
-          return;
-        }
+      msg_verbose("Syslog connection accepted",
+                  evt_tag_int("fd", accepted->fd),
+                  evt_tag_str("client", g_sockaddr_format(accepted->peer_addr, buf1, sizeof(buf1), GSA_FULL)),
+                  evt_tag_str("local", g_sockaddr_format(self->bind_addr, buf2, sizeof(buf2), GSA_FULL)));
+    }
+  else
+    {
+      close(accepted->fd);
+    }
 
-      g_fd_set_nonblock(new_fd, TRUE);
-      g_fd_set_cloexec(new_fd, TRUE);
+  g_sockaddr_unref(accepted->local_addr);
+  g_sockaddr_unref(accepted->peer_addr);
+}
 
-      local_addr = g_socket_get_local_name(new_fd);
-      res = afsocket_sd_process_connection(self, peer_addr, local_addr, new_fd);
-      g_sockaddr_unref(local_addr);
+static void
+afsocket_sd_accept(gpointer s)
+{
+  AFSocketSourceDriver *self = (AFSocketSourceDriver *) s;
+  AFSocketAcceptedConnection accepted;
 
-      if (res)
-        {
-          socket_options_setup_peer_socket(self->socket_options, new_fd, peer_addr);
+  for (gint accepts = 0; accepts < MAX_ACCEPTS_AT_A_TIME && _accept_connection(self->fd, &accepted); accepts++)
+    _setup_accepted_connection(self, &accepted, NULL);
+}
 
-          msg_verbose("Syslog connection accepted",
-                      evt_tag_int("fd", new_fd),
-                      evt_tag_str("client", g_sockaddr_format(peer_addr, buf1, sizeof(buf1), GSA_FULL)),
-                      evt_tag_str("local", g_sockaddr_format(self->bind_addr, buf2, sizeof(buf2), GSA_FULL)));
-        }
-      else
-        {
-          close(new_fd);
-        }
+/* NOTE: runs in the shard's own thread.  Only the accept() calls happen
+ * here, setting up the connection touches the configuration and the
+ * pipeline, so that is handed over to the main thread.  Every shard has
+ * its own accept budget per poll iteration. */
+static void
+afsocket_sd_accept_on_shard(gpointer s)
+{
+  AFSocketListenShard *shard = (AFSocketListenShard *) s;
+  AFSocketAcceptedConnection accepted;
+  gint accepts;
 
-      g_sockaddr_unref(peer_addr);
-      accepts++;
+  for (accepts = 0; accepts < MAX_ACCEPTS_AT_A_TIME && _accept_connection(shard->fd, &accepted); accepts++)
+    {
+      g_mutex_lock(&shard->lock);
+      g_queue_push_tail(&shard->accepted, g_memdup2(&accepted, sizeof(accepted)));
+      g_mutex_unlock(&shard->lock);
+    }
+
+  if (accepts > 0)
+    iv_event_post(&shard->accepted_event);
+}
+
+/* runs in the main thread */
+static void
+_shard_setup_accepted_connections(gpointer s)
+{
+  AFSocketListenShard *shard = (AFSocketListenShard *) s;
+  GQueue accepted = G_QUEUE_INIT;
+
+  g_mutex_lock(&shard->lock);
+  accepted = shard->accepted;
+  g_queue_init(&shard->accepted);
+  g_mutex_unlock(&shard->lock);
+
+  AFSocketAcceptedConnection *connection;
+  while ((connection = g_queue_pop_head(&accepted)))
+    {
+      _setup_accepted_connection(shard->owner, connection, shard);
+      g_free(connection);
+    }
+}
+
+static void
+_shard_drop_accepted_connections(AFSocketListenShard *shard)
+{
+  AFSocketAcceptedConnection *connection;
+
+  while ((connection = g_queue_pop_head(&shard->accepted)))
+    {
+      close(connection->fd);
+      g_sockaddr_unref(connection->local_addr);
+      g_sockaddr_unref(connection->peer_addr);
+      g_free(connection);
     }
-  return;
 }
 
 static void
@@ -555,6 +676,7 @@ afsocket_sd_close_connection(AFSocketSourceDriver *self, AFSocketSourceConnectio
   log_reader_close_proto(sc->reader);
   log_pipe_deinit(&sc->super);
   self->connections = g_list_remove(self->connections, sc);
+  _shard_connections_count_dec(self, sc);
   afsocket_sd_kill_connection(sc);
   _connections_count_dec(self);
 }
@@ -584,6 +706,164 @@ _listen_fd_stop(AFSocketSourceDriver *self)
     iv_fd_unregister(&self->listen_fd);
 }
 
+/*
+ * listen-shards(N) opens N listening sockets for the same address with
+ * SO_REUSEPORT, so the kernel distributes incoming connections between
+ * their accept queues.  Shard 0 is the regular listener (self->fd).  Each
+ * shard accepts in its own thread, started once the configuration is
+ * committed (post_config_init) and stopped by the main loop before deinit,
+ * like any other threaded worker.
+ */
+static gboolean
+_shard_thread_init(MainLoopThreadedWorker *s)
+{
+  AFSocketListenShard *shard = (AFSocketListenShard *) s->data;
+
+  iv_event_register(&shard->shutdown_event);
+  iv_fd_register(&shard->listen_fd);
+  return TRUE;
+}
+
+static void
+_shard_thread_deinit(MainLoopThreadedWorker *s)
+{
+  AFSocketListenShard *shard = (AFSocketListenShard *) s->data;
+
+  if (iv_fd_registered(&shard->listen_fd))
+    iv_fd_unregister(&shard->listen_fd);
+  iv_event_unregister(&shard->shutdown_event);
+}
+
+static void
+_shard_thread_run(MainLoopThreadedWorker *s)
+{
+  iv_main();
+}
+
+static void
+_shard_thread_request_exit(MainLoopThreadedWorker *s)
+{
+  AFSocketListenShard *shard = (AFSocketListenShard *) s->data;
+
+  iv_event_post(&shard->shutdown_event);
+}
+
+static void
+_shard_stop(gpointer s)
+{
+  iv_quit();
+}
+
+static void
+_shard_init(AFSocketListenShard *shard, AFSocketSourceDriver *owner, gint index)
+{
+  shard->owner = owner;
+  shard->index = index;
+  shard->fd = -1;
+
+  IV_FD_INIT(&shard->listen_fd);
+  shard->listen_fd.fd = -1;
+  shard->listen_fd.cookie = shard;
+  shard->listen_fd.handler_in = afsocket_sd_accept_on_shard;
+
+  IV_EVENT_INIT(&shard->shutdown_event);
+  shard->shutdown_event.cookie = shard;
+  shard->shutdown_event.handler = _shard_stop;
+
+  IV_EVENT_INIT(&shard->accepted_event);
+  shard->accepted_event.cookie = shard;
+  shard->accepted_event.handler = _shard_setup_accepted_connections;
+
+  g_mutex_init(&shard->lock);
+  g_queue_init(&shard->accepted);
+
+  main_loop_threaded_worker_init(&shard->thread, MLW_THREADED_INPUT_WORKER, shard);
+  shard->thread.thread_init = _shard_thread_init;
+  shard->thread.thread_deinit = _shard_thread_deinit;
+  shard->thread.run = _shard_thread_run;
+  shard->thread.request_exit = _shard_thread_request_exit;
+}
+
+static void
+_shard_clear(AFSocketListenShard *shard, gboolean started)
+{
+  /* the thread has been stopped by the main loop by now */
+  main_loop_threaded_worker_clear(&shard->thread);
+
+  if (started)
+    iv_event_unregister(&shard->accepted_event);
+  _shard_drop_accepted_connections(shard);
+  g_mutex_clear(&shard->lock);
+}
+
+static gboolean
+_shards_init(AFSocketSourceDriver *self)
+{
+  if (self->listen_shards <= 1 || self->transport_mapper->sock_type != SOCK_STREAM)
+    return TRUE;
+
+  if (g_sockaddr_get_sa(self->bind_addr)->sa_family == AF_UNIX)
+    {
+      msg_warning("WARNING: listen-shards() is only supported for TCP sources, ignoring",
+                  evt_tag_int("listen_shards", self->listen_shards),
+                  log_pipe_location_tag(&self->super.super.super));
+      return TRUE;
+    }
+
+  if (!self->socket_options->so_reuseport)
+    {
+      msg_error("listen-shards() requires so-reuseport(yes)",
+                evt_tag_int("listen_shards", self->listen_shards),
+                log_pipe_location_tag(&self->super.super.super));
+      return FALSE;
+    }
+
+  self->shards = g_new0(AFSocketListenShard, self->listen_shards);
+  for (gint i = 0; i < self->listen_shards; i++)
+    _shard_init(&self->shards[i], self, i);
+
+  self->shards_startable = FALSE;
+  self->shards_started = FALSE;
+  return TRUE;
+}
+
+/* called both when the listeners are set up and at post_config_init, as
+ * with a password protected key the former may happen later */
+static void
+_shards_start(AFSocketSourceDriver *self)
+{
+  if (!self->shards || !self->shards_startable || self->shards_started || self->shards[0].fd == -1)
+    return;
+
+  for (gint i = 0; i < self->listen_shards; i++)
+    {
+      iv_event_register(&self->shards[i].accepted_event);
+      g_assert(main_loop_threaded_worker_start(&self->shards[i].thread));
+    }
+  self->shards_started = TRUE;
+}
+
+static void
+_shards_free(AFSocketSourceDriver *self)
+{
+  for (gint i = 0; self->shards && i < self->listen_shards; i++)
+    _shard_clear(&self->shards[i], self->shards_started);
+
+  g_free(self->shards);
+  self->shards = NULL;
+}
+
+static void
+_shards_close_sockets(AFSocketSourceDriver *self)
+{
+  for (gint i = 1; i < self->listen_shards; i++)
+    {
+      if (self->shards[i].fd != -1)
+        close(self->shards[i].fd);
+      self->shards[i].fd = -1;
+    }
+}
+
 static void
 _dynamic_window_timer_start(AFSocketSourceDriver *self)
 {
@@ -1000,6 +1280,7 @@ afsocket_sd_restore_kept_alive_connections(AFSocketSourceDriver *self)
           if (log_pipe_init((LogPipe *) p->data))
             {
               _connections_count_inc(self);
+              _shard_connections_count_inc(self, (AFSocketSourceConnection *) p->data);
             }
           else
             {
@@ -1049,14 +1330,42 @@ _sd_open_stream_finalize(gpointer arg)
                 evt_tag_error(EVT_TAG_OSERROR));
       close(self->fd);
       self->fd = -1;
+      if (self->shards)
+        _shards_close_sockets(self);
       return FALSE;
     }
 
-  self->listen_fd.fd = self->fd;
+  if (self->shards)
+    {
+      for (gint i = 1; i < self->listen_shards; i++)
+        {
+          if (listen(self->shards[i].fd, self->listen_backlog) < 0)
+            {
+              msg_error("Error during listen() on listen shard",
+                        evt_tag_int("shard", i),
+                        evt_tag_error(EVT_TAG_OSERROR));
+              close(self->fd);
+              self->fd = -1;
+              _shards_close_sockets(self);
+              return FALSE;
+            }
+        }
+
+      self->shards[0].fd = self->fd;
+      for (gint i = 0; i < self->listen_shards; i++)
+        self->shards[i].listen_fd.fd = self->shards[i].fd;
+    }
+  else
+    {
+      self->listen_fd.fd = self->fd;
+    }
+
   afsocket_sd_start_watches(self);
+  _shards_start(self);
   char buf[256];
   msg_info("Accepting connections",
-           evt_tag_str("addr", g_sockaddr_format(self->bind_addr, buf, sizeof(buf), GSA_FULL)));
+           evt_tag_str("addr", g_sockaddr_format(self->bind_addr, buf, sizeof(buf), GSA_FULL)),
+           evt_tag_int("listen_shards", self->shards ? self->listen_shards : 1));
   return TRUE;
 }
 
@@ -1074,6 +1383,50 @@ afsocket_sd_open_socket(AFSocketSourceDriver *self, gint *sock)
   return !signal_data.failure;
 }
 
+static gboolean
+_listener_has_reuseport(gint fd)
+{
+  gint on = 0;
+  socklen_t len = sizeof(on);
+
+#if defined(SO_REUSEPORT_LB)
+  if (getsockopt(fd, SOL_SOCKET, SO_REUSEPORT_LB, &on, &len) < 0)
+    return FALSE;
+#elif defined(SO_REUSEPORT)
+  if (getsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, &len) < 0)
+    return FALSE;
+#endif
+
+  return on != 0;
+}
+
+static gboolean
+_sd_open_shards(AFSocketSourceDriver *self)
+{
+  GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super);
+
+  for (gint i = 1; i < self->listen_shards; i++)
+    {
+      gint sock = -1;
+
+      if (self->connections_kept_alive_across_reloads)
+        {
+          gpointer config_result = cfg_persist_config_fetch(cfg, afsocket_sd_format_shard_listener_name(self, i));
+          sock = GPOINTER_TO_UINT(config_result) - 1;
+        }
+
+      if (sock == -1 && !afsocket_sd_open_socket(self, &sock))
+        {
+          _shards_close_sockets(self);
+          return FALSE;
+        }
+
+      self->shards[i].fd = sock;
+    }
+
+  return TRUE;
+}
+
 static gboolean
 _sd_open_stream(AFSocketSourceDriver *self)
 {
@@ -1096,6 +1449,27 @@ _sd_open_stream(AFSocketSourceDriver *self)
         return self->super.super.optional;
     }
   self->fd = sock;
+
+  if (self->shards && !_listener_has_reuseport(self->fd))
+    {
+      /* a listener inherited from systemd or kept alive from the previous
+       * configuration, without SO_REUSEPORT our shards could not bind */
+      msg_error("listen-shards() cannot be used with a listening socket that has no SO_REUSEPORT set, "
+                "restart syslog-ng to reopen it",
+                evt_tag_int("listen_shards", self->listen_shards),
+                log_pipe_location_tag(&self->super.super.super));
+      close(self->fd);
+      self->fd = -1;
+      return FALSE;
+    }
+
+  if (self->shards && !_sd_open_shards(self))
+    {
+      close(self->fd);
+      self->fd = -1;
+      return self->super.super.optional;
+    }
+
   return transport_mapper_async_init(self->transport_mapper, _sd_open_stream_finalize, self);
 }
 
@@ -1113,7 +1487,7 @@ _sd_open_dgram(AFSocketSourceDriver *self)
   self->fd = -1;
 
   /* we either have self->connections != NULL, or sock contains a new fd */
-  if (!(self->connections || afsocket_sd_process_connection(self, NULL, self->bind_addr, sock)))
+  if (!(self->connections || afsocket_sd_process_connection(self, NULL, self->bind_addr, sock, NULL)))
     return FALSE;
 
   if (!transport_mapper_init(self->transport_mapper))
@@ -1176,6 +1550,19 @@ afsocket_sd_save_listener(AFSocketSourceDriver *self)
           cfg_persist_config_add(cfg, afsocket_sd_format_listener_name(self),
                                  GUINT_TO_POINTER(self->fd + 1), afsocket_sd_close_fd);
         }
+
+      for (gint i = 1; self->shards && i < self->listen_shards; i++)
+        {
+          if (self->shards[i].fd == -1)
+            continue;
+
+          if (!self->connections_kept_alive_across_reloads)
+            close(self->shards[i].fd);
+          else
+            cfg_persist_config_add(cfg, afsocket_sd_format_shard_listener_name(self, i),
+                                   GUINT_TO_POINTER(self->shards[i].fd + 1), afsocket_sd_close_fd);
+          self->shards[i].fd = -1;
+        }
     }
 }
 
@@ -1186,6 +1573,23 @@ afsocket_sd_setup_addresses_method(AFSocketSourceDriver *self)
   return TRUE;
 }
 
+static StatsClusterLabel *
+_shard_stats_labels_new(StatsClusterLabel *labels, gsize labels_len, gint shard_index)
+{
+  StatsClusterLabel *shard_labels = g_new(StatsClusterLabel, labels_len + 1);
+
+  memcpy(shard_labels, labels, labels_len * sizeof(StatsClusterLabel));
+  shard_labels[labels_len] = stats_cluster_label("shard", g_strdup_printf("%d", shard_index));
+  return shard_labels;
+}
+
+static void
+_shard_stats_labels_free(StatsClusterLabel *shard_labels, gsize labels_len)
+{
+  g_free((gchar *) shard_labels[labels_len].value);
+  g_free(shard_labels);
+}
+
 static void
 _register_stream_stats(AFSocketSourceDriver *self, StatsClusterLabel *labels, gsize labels_len)
 {
@@ -1210,6 +1614,15 @@ _register_stream_stats(AFSocketSourceDriver *self, StatsClusterLabel *labels, gs
 
   stats_cluster_single_key_set(&sc_key, "socket_rejected_connections_total", labels, labels_len);
   stats_register_counter(level, &sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics.rejected_connections);
+
+  for (gint i = 0; self->shards && i < self->listen_shards; i++)
+    {
+      StatsClusterLabel *shard_labels = _shard_stats_labels_new(labels, labels_len, i);
+
+      stats_cluster_single_key_set(&sc_key, "socket_listen_shard_connections", shard_labels, labels_len + 1);
+      stats_register_external_counter(level, &sc_key, SC_TYPE_SINGLE_VALUE, &self->shards[i].num_connections);
+      _shard_stats_labels_free(shard_labels, labels_len);
+    }
 }
 
 static void
@@ -1231,6 +1644,15 @@ _unregister_stream_stats(AFSocketSourceDriver *self, StatsClusterLabel *labels,
 
   stats_cluster_single_key_set(&sc_key, "socket_rejected_connections_total", labels, labels_len);
   stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics.rejected_connections);
+
+  for (gint i = 0; self->shards && i < self->listen_shards; i++)
+    {
+      StatsClusterLabel *shard_labels = _shard_stats_labels_new(labels, labels_len, i);
+
+      stats_cluster_single_key_set(&sc_key, "socket_listen_shard_connections", shard_labels, labels_len + 1);
+      stats_unregister_external_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &self->shards[i].num_connections);
+      _shard_stats_labels_free(shard_labels, labels_len);
+    }
 }
 
 static void
@@ -1300,6 +1722,9 @@ afsocket_sd_init_method(LogPipe *s)
   if (!afsocket_sd_setup_transport(self) || !afsocket_sd_setup_addresses(self))
     return FALSE;
 
+  if (!_shards_init(self))
+    return FALSE;
+
   afsocket_sd_register_stats(self);
   afsocket_sd_dynamic_window_init(self);
   afsocket_sd_restore_kept_alive_connections(self);
@@ -1309,12 +1734,24 @@ afsocket_sd_init_method(LogPipe *s)
       /* returning FALSE, so deinit is not called */
       afsocket_sd_unregister_stats(self);
       afsocket_sd_drop_dynamic_window_pool(self);
+      _shards_free(self);
       return FALSE;
     }
 
   return TRUE;
 }
 
+static gboolean
+afsocket_sd_post_config_init_method(LogPipe *s)
+{
+  AFSocketSourceDriver *self = (AFSocketSourceDriver *) s;
+
+  self->shards_startable = TRUE;
+  _shards_start(self);
+
+  return log_pipe_post_config_init_method(s);
+}
+
 gboolean
 afsocket_sd_deinit_method(LogPipe *s)
 {
@@ -1324,6 +1761,7 @@ afsocket_sd_deinit_method(LogPipe *s)
   afsocket_sd_save_connections(self);
   afsocket_sd_dynamic_window_deinit(self);
   afsocket_sd_unregister_stats(self);
+  _shards_free(self);
 
   return log_src_driver_deinit_method(s);
 }
@@ -1382,6 +1820,7 @@ afsocket_sd_init_instance(AFSocketSourceDriver *self,
 
   self->super.super.super.queue = afsocket_sd_queue;
   self->super.super.super.init = afsocket_sd_init_method;
+  self->super.super.super.post_config_init = afsocket_sd_post_config_init_method;
   self->super.super.super.deinit = afsocket_sd_deinit_method;
   self->super.super.super.free_fn = afsocket_sd_free_method;
   self->super.super.super.notify = afsocket_sd_notify;
@@ -1391,6 +1830,7 @@ afsocket_sd_init_instance(AFSocketSourceDriver *self,
   self->transport_mapper = transport_mapper;
   atomic_gssize_set(&self->max_connections, 10);
   self->listen_backlog = 255;
+  self->listen_shards = 1;
   self->dynamic_window_stats_freq = DYNAMIC_WINDOW_TIMER_MSECS;
   self->dynamic_window_realloc_ticks = DYNAMIC_WINDOW_REALLOC_TICKS;
   self->connections_kept_alive_across_reloads = TRUE;
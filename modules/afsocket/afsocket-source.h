@@ -32,11 +32,29 @@
 #include "dynamic-window-pool.h"
 #include "atomic-gssize.h"
 #include "stats/stats-counter.h"
+#include "mainloop-threaded-worker.h"
 
 #include <iv.h>
+#include <iv_event.h>
 
 typedef struct _AFSocketSourceDriver AFSocketSourceDriver;
 
+/* one of the SO_REUSEPORT listeners of a sharded stream source, accepting
+ * connections in its own thread and handing them over to the main thread */
+typedef struct _AFSocketListenShard
+{
+  AFSocketSourceDriver *owner;
+  gint index;
+  gint fd;
+  MainLoopThreadedWorker thread;
+  struct iv_fd listen_fd;
+  struct iv_event shutdown_event;
+  struct iv_event accepted_event;
+  GMutex lock;
+  GQueue accepted;
+  atomic_gssize num_connections;
+} AFSocketListenShard;
+
 struct _AFSocketSourceDriver
 {
   LogSrcDriver super;
@@ -67,6 +85,10 @@ struct _AFSocketSourceDriver
   atomic_gssize max_connections;
   atomic_gssize num_connections;
   gint listen_backlog;
+  gint listen_shards;
+  AFSocketListenShard *shards;
+  gboolean shards_startable;
+  gboolean shards_started;
   GList *connections;
   SocketOptions *socket_options;
   TransportMapper *transport_mapper;
@@ -90,6 +112,7 @@ struct _AFSocketSourceDriver
 void afsocket_sd_set_keep_alive(LogDriver *self, gint enable);
 void afsocket_sd_set_max_connections(LogDriver *self, gint max_connections);
 void afsocket_sd_set_listen_backlog(LogDriver *self, gint listen_backlog);
+void afsocket_sd_set_listen_shards(LogDriver *self, gint listen_shards);
 void afsocket_sd_set_dynamic_window_size(LogDriver *self, gint dynamic_window_size);
 void afsocket_sd_set_dynamic_window_stats_freq(LogDriver *self, gdouble stats_freq);
 void afsocket_sd_set_dynamic_window_realloc_ticks(LogDriver *self, gint realloc_ticks);
@@ -271,7 +271,7 @@ log_queue_disk_peek_message(LogQueueDisk *self)
 void
 log_queue_disk_drop_message(LogQueueDisk *self, LogMessage *msg, const LogPathOptions *path_options)
 {
-  log_queue_dropped_messages_inc(&self->super);
+  log_queue_message_dropped(&self->super, msg);
 
   if (path_options->flow_control_requested)
     log_msg_drop(msg, path_options, AT_SUSPENDED);
@@ -60,12 +60,26 @@ DestinationWorker::~DestinationWorker()
 {
 }
 
+/* the channel pool of the driver is deinitialized right after the workers have exited */
+void
+DestinationWorker::deinit()
+{
+  if (this->channel)
+    {
+      this->release_channel(this->channel_index);
+      this->stub.reset();
+      this->channel.reset();
+    }
+
+  DestWorker::deinit();
+}
+
 bool
 DestinationWorker::connect()
 {
   if (!this->channel)
     {
-      this->channel = this->create_channel();
+      this->channel = this->open_channel();
       if (!this->channel)
         return false;
 
@@ -272,11 +286,14 @@ error:
   return result;
 }
 
+/*
+ * The rows are sent on a long-lived AppendRows stream, so with
+ * channel-pool-size() set, each worker keeps the least loaded channel of
+ * the pool for its lifetime, instead of picking one for each request.
+ */
 std::shared_ptr<::grpc::Channel>
-DestinationWorker::create_channel()
+DestinationWorker::open_channel()
 {
-  DestinationDriver *owner_ = this->get_owner();
-
   ::grpc::ChannelArguments args = this->create_channel_args();
   auto credentials = this->create_credentials();
   if (!credentials)
@@ -285,13 +302,16 @@ DestinationWorker::create_channel()
       return nullptr;
     }
 
-  auto channel_ = ::grpc::CreateCustomChannel(owner_->get_url(), credentials, args);
+  size_t index = this->acquire_channel();
+  auto channel_ = this->create_channel(index, credentials, args);
   if (!channel_)
     {
       msg_error("Error creating BigQuery gRPC channel", log_pipe_location_tag((LogPipe *) this->super->super.owner));
+      this->release_channel(index);
       return nullptr;
     }
 
+  this->channel_index = index;
   return channel_;
 }
 
@@ -55,13 +55,14 @@ public:
   DestinationWorker(GrpcDestWorker *s);
   ~DestinationWorker();
 
+  void deinit();
   bool connect();
   void disconnect();
   LogThreadedResult insert(LogMessage *msg);
   LogThreadedResult flush(LogThreadedFlushMode mode);
 
 private:
-  std::shared_ptr<::grpc::Channel> create_channel();
+  std::shared_ptr<::grpc::Channel> open_channel();
   void construct_write_stream();
   void prepare_batch();
   bool should_initiate_flush();
@@ -73,6 +74,7 @@ private:
   bool connected;
 
   std::shared_ptr<::grpc::Channel> channel;
+  size_t channel_index = 0;
   std::unique_ptr<google::cloud::bigquery::storage::v1::BigQueryWrite::Stub> stub;
 
   google::cloud::bigquery::storage::v1::WriteStream write_stream;
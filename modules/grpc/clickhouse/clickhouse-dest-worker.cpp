@@ -43,8 +43,8 @@ DestWorker::DestWorker(GrpcDestWorker *s)
 
   ::grpc::ChannelArguments args = this->create_channel_args();
 
-  this->channel = ::grpc::CreateCustomChannel(this->owner.get_url(), credentials, args);
-  this->stub = ::clickhouse::grpc::ClickHouse::NewStub(this->channel);
+  for (size_t i = 0; i < this->get_channel_count(); i++)
+    this->stubs.push_back(::clickhouse::grpc::ClickHouse::NewStub(this->create_channel(i, credentials, args)));
 }
 
 bool
@@ -180,7 +180,10 @@ DestWorker::flush(LogThreadedFlushMode mode)
 
   this->prepare_query_info(query_info);
 
-  ::grpc::Status status = this->stub->ExecuteQuery(this->client_context.get(), query_info, &query_result);
+  size_t channel_index = this->acquire_channel();
+  ::grpc::Status status = this->stubs[channel_index]->ExecuteQuery(this->client_context.get(), query_info,
+                          &query_result);
+  this->release_channel(channel_index);
 
   LogThreadedResult result;
   if (owner.handle_response(status, &result))
@@ -28,6 +28,7 @@
 #include "grpc-dest-worker.hpp"
 
 #include <sstream>
+#include <vector>
 
 #include "clickhouse_grpc.grpc.pb.h"
 
@@ -50,8 +51,7 @@ private:
   DestDriver *get_owner();
 
 private:
-  std::shared_ptr<::grpc::Channel> channel;
-  std::unique_ptr<::clickhouse::grpc::ClickHouse::Stub> stub;
+  std::vector<std::unique_ptr<::clickhouse::grpc::ClickHouse::Stub>> stubs;
   std::unique_ptr<::grpc::ClientContext> client_context;
 
   std::ostringstream query_data;
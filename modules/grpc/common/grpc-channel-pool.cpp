@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "grpc-channel-pool.hpp"
+
+using namespace syslogng::grpc;
+
+/* Does not take the ownership of kb. */
+void
+ChannelPool::init(StatsClusterKeyBuilder *kb, int stats_level)
+{
+  if (!this->is_enabled())
+    return;
+
+  this->channels.assign(this->size, nullptr);
+  this->in_flight.reset(new std::atomic<size_t>[this->size]);
+  this->in_flight_sc_keys.assign(this->size, nullptr);
+  this->in_flight_counters.assign(this->size, nullptr);
+
+  for (size_t i = 0; i < this->size; i++)
+    this->in_flight[i] = 0;
+
+  stats_lock();
+  for (size_t i = 0; i < this->size; i++)
+    {
+      std::string channel_label = std::to_string(i);
+
+      stats_cluster_key_builder_push(kb);
+      {
+        stats_cluster_key_builder_set_name(kb, "output_grpc_channel_requests_in_flight");
+        stats_cluster_key_builder_add_label(kb, stats_cluster_label("channel", channel_label.c_str()));
+        this->in_flight_sc_keys[i] = stats_cluster_key_builder_build_single(kb);
+      }
+      stats_cluster_key_builder_pop(kb);
+
+      stats_register_counter(stats_level, this->in_flight_sc_keys[i], SC_TYPE_SINGLE_VALUE,
+                             &this->in_flight_counters[i]);
+    }
+  stats_unlock();
+}
+
+void
+ChannelPool::deinit()
+{
+  stats_lock();
+  for (size_t i = 0; i < this->in_flight_sc_keys.size(); i++)
+    {
+      stats_unregister_counter(this->in_flight_sc_keys[i], SC_TYPE_SINGLE_VALUE, &this->in_flight_counters[i]);
+      stats_cluster_key_free(this->in_flight_sc_keys[i]);
+    }
+  stats_unlock();
+
+  this->in_flight_sc_keys.clear();
+  this->in_flight_counters.clear();
+
+  std::lock_guard<std::mutex> guard(this->lock);
+  this->channels.clear();
+}
+
+/*
+ * Channels are created by the first worker asking for them, with the
+ * credentials and channel arguments of that worker, which are the same for
+ * all workers of a driver.
+ */
+std::shared_ptr<::grpc::Channel>
+ChannelPool::get_channel(size_t index, const std::string &url,
+                         const std::shared_ptr<::grpc::ChannelCredentials> &credentials,
+                         const ::grpc::ChannelArguments &args)
+{
+  g_assert(index < this->size);
+
+  std::lock_guard<std::mutex> guard(this->lock);
+
+  if (!this->channels[index])
+    {
+      ::grpc::ChannelArguments channel_args = args;
+
+      /* makes the channel args unique, so that channels never share their subchannels */
+      channel_args.SetInt("syslogng.channel_pool_index", index);
+
+      this->channels[index] = ::grpc::CreateCustomChannel(url, credentials, channel_args);
+    }
+
+  return this->channels[index];
+}
+
+/*
+ * The scan starts at a rotating position, so that idle channels are used in
+ * a round-robin fashion instead of always sending on the first one.
+ */
+size_t
+ChannelPool::acquire()
+{
+  g_assert(this->is_enabled());
+
+  size_t start = this->next.fetch_add(1, std::memory_order_relaxed) % this->size;
+  size_t least_loaded = start;
+  size_t least_in_flight = this->in_flight[start].load(std::memory_order_relaxed);
+
+  for (size_t i = 1; i < this->size && least_in_flight > 0; i++)
+    {
+      size_t index = (start + i) % this->size;
+      size_t current = this->in_flight[index].load(std::memory_order_relaxed);
+      if (current < least_in_flight)
+        {
+          least_loaded = index;
+          least_in_flight = current;
+        }
+    }
+
+  this->in_flight[least_loaded].fetch_add(1, std::memory_order_relaxed);
+  stats_counter_inc(this->in_flight_counters[least_loaded]);
+
+  return least_loaded;
+}
+
+void
+ChannelPool::release(size_t index)
+{
+  g_assert(index < this->size);
+
+  this->in_flight[index].fetch_sub(1, std::memory_order_relaxed);
+  stats_counter_dec(this->in_flight_counters[index]);
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef GRPC_CHANNEL_POOL_HPP
+#define GRPC_CHANNEL_POOL_HPP
+
+#include "syslog-ng.h"
+
+#include "compat/cpp-start.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-key-builder.h"
+#include "compat/cpp-end.h"
+
+#include <grpcpp/channel.h>
+#include <grpcpp/create_channel.h>
+#include <grpcpp/security/credentials.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace syslogng {
+namespace grpc {
+
+/*
+ * A fixed set of channels shared by all workers of a destination.
+ *
+ * Every channel uses its own (local) subchannel pool, so each of them has a
+ * separate HTTP/2 connection with its own flow control window.  Requests are
+ * striped over the channels by picking the one with the fewest requests in
+ * flight.
+ */
+class ChannelPool
+{
+public:
+  void set_size(size_t size_)
+  {
+    this->size = size_;
+  }
+
+  size_t get_size() const
+  {
+    return this->size;
+  }
+
+  bool is_enabled() const
+  {
+    return this->size > 0;
+  }
+
+  void init(StatsClusterKeyBuilder *kb, int stats_level);
+  void deinit();
+
+  std::shared_ptr<::grpc::Channel> get_channel(size_t index, const std::string &url,
+                                               const std::shared_ptr<::grpc::ChannelCredentials> &credentials,
+                                               const ::grpc::ChannelArguments &args);
+
+  size_t acquire();
+  void release(size_t index);
+
+private:
+  size_t size = 0;
+
+  std::mutex lock;
+  std::vector<std::shared_ptr<::grpc::Channel>> channels;
+  std::unique_ptr<std::atomic<size_t>[]> in_flight;
+  std::atomic<size_t> next{0};
+
+  std::vector<StatsClusterKey *> in_flight_sc_keys;
+  std::vector<StatsCounterItem *> in_flight_counters;
+};
+
+}
+}
+
+#endif
@@ -74,6 +74,46 @@ DestWorker::create_channel_args()
   return args;
 }
 
+/*
+ * With channel-pool-size() set, the channels are shared between the workers
+ * of the driver, otherwise each worker has a single channel of its own.
+ */
+std::shared_ptr<::grpc::Channel>
+DestWorker::create_channel(size_t index, const std::shared_ptr<::grpc::ChannelCredentials> &credentials,
+                           const ::grpc::ChannelArguments &args)
+{
+  if (!this->owner.channel_pool.is_enabled())
+    {
+      g_assert(index == 0);
+      return ::grpc::CreateCustomChannel(this->owner.get_url(), credentials, args);
+    }
+
+  return this->owner.channel_pool.get_channel(index, this->owner.get_url(), credentials, args);
+}
+
+size_t
+DestWorker::get_channel_count() const
+{
+  return this->owner.channel_pool.is_enabled() ? this->owner.channel_pool.get_size() : 1;
+}
+
+/* returns the index of the channel to send the next request on */
+size_t
+DestWorker::acquire_channel()
+{
+  if (!this->owner.channel_pool.is_enabled())
+    return 0;
+
+  return this->owner.channel_pool.acquire();
+}
+
+void
+DestWorker::release_channel(size_t index)
+{
+  if (this->owner.channel_pool.is_enabled())
+    this->owner.channel_pool.release(index);
+}
+
 bool
 DestWorker::init()
 {
@@ -54,6 +54,12 @@ protected:
   void prepare_context_dynamic(::grpc::ClientContext &context, LogMessage *msg);
   std::shared_ptr<::grpc::ChannelCredentials> create_credentials();
   ::grpc::ChannelArguments create_channel_args();
+  std::shared_ptr<::grpc::Channel> create_channel(size_t index,
+                                                  const std::shared_ptr<::grpc::ChannelCredentials> &credentials,
+                                                  const ::grpc::ChannelArguments &args);
+  size_t get_channel_count() const;
+  size_t acquire_channel();
+  void release_channel(size_t index);
 
 protected:
   GrpcDestWorker *super;
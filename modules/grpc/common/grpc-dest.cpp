@@ -124,7 +124,9 @@ DestDriver::init()
 
   StatsClusterKeyBuilder *kb = stats_cluster_key_builder_new();
   format_stats_key(kb);
-  metrics.init(kb, log_pipe_is_internal(&super->super.super.super.super) ? STATS_LEVEL3 : STATS_LEVEL1);
+  int stats_level = log_pipe_is_internal(&super->super.super.super.super) ? STATS_LEVEL3 : STATS_LEVEL1;
+  channel_pool.init(kb, stats_level);
+  metrics.init(kb, stats_level);
 
   return true;
 }
@@ -133,6 +135,7 @@ bool
 DestDriver::deinit()
 {
   metrics.deinit();
+  channel_pool.deinit();
   return log_threaded_dest_driver_deinit_method(&super->super.super.super.super);
 }
 
@@ -249,6 +252,13 @@ grpc_dd_set_keepalive_max_pings(LogDriver *s, gint p)
   self->cpp->set_keepalive_max_pings(p);
 }
 
+void
+grpc_dd_set_channel_pool_size(LogDriver *s, gint size)
+{
+  GrpcDestDriver *self = (GrpcDestDriver *) s;
+  self->cpp->set_channel_pool_size(size);
+}
+
 void
 grpc_dd_add_int_channel_arg(LogDriver *s, const gchar *name, glong value)
 {
@@ -70,6 +70,7 @@ void grpc_dd_set_batch_bytes(LogDriver *s, glong b);
 void grpc_dd_set_keepalive_time(LogDriver *s, gint t);
 void grpc_dd_set_keepalive_timeout(LogDriver *s, gint t);
 void grpc_dd_set_keepalive_max_pings(LogDriver *s, gint p);
+void grpc_dd_set_channel_pool_size(LogDriver *s, gint size);
 void grpc_dd_add_int_channel_arg(LogDriver *s, const gchar *name, glong value);
 void grpc_dd_add_string_channel_arg(LogDriver *s, const gchar *name, const gchar *value);
 gboolean grpc_dd_add_header(LogDriver *s, const gchar *name, LogTemplate *value);
@@ -34,6 +34,7 @@
 #include "credentials/grpc-credentials-builder.hpp"
 #include "metrics/grpc-metrics.hpp"
 #include "schema/grpc-schema.hpp"
+#include "grpc-channel-pool.hpp"
 
 #include <grpcpp/server.h>
 
@@ -103,6 +104,11 @@ public:
     this->keepalive_max_pings_without_data = p;
   }
 
+  void set_channel_pool_size(size_t s)
+  {
+    this->channel_pool.set_size(s);
+  }
+
   void add_extra_channel_arg(std::string name, long value)
   {
     this->int_extra_channel_args.push_back(std::make_pair(name, value));
@@ -185,6 +191,8 @@ protected:
   int keepalive_timeout;
   int keepalive_max_pings_without_data;
 
+  ChannelPool channel_pool;
+
   std::stringstream worker_partition_key;
   bool flush_on_key_change;
 
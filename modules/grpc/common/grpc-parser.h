@@ -41,6 +41,7 @@
   { "compression",               KW_COMPRESSION }, \
   { "batch_bytes",               KW_BATCH_BYTES }, \
   { "channel_args",              KW_CHANNEL_ARGS }, \
+  { "channel_pool_size",         KW_CHANNEL_POOL_SIZE }, \
   { "headers",                   KW_HEADERS }, \
   { "schema",                    KW_SCHEMA }, \
   { "protobuf_schema",           KW_PROTOBUF_SCHEMA }, \
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "grpc-channel-pool.hpp"
+
+#include "compat/cpp-start.h"
+#include "apphook.h"
+#include "stats/stats-cluster-single.h"
+#include "compat/cpp-end.h"
+
+#include <criterion/criterion.h>
+
+#include <set>
+
+using namespace syslogng::grpc;
+
+static StatsClusterKeyBuilder *kb;
+
+static gsize
+_get_in_flight(const gchar *channel)
+{
+  StatsClusterLabel labels[] = { stats_cluster_label("channel", channel) };
+  StatsClusterKey sc_key;
+  stats_cluster_single_key_set(&sc_key, "output_grpc_channel_requests_in_flight", labels, G_N_ELEMENTS(labels));
+
+  stats_lock();
+  StatsCounterItem *counter = stats_get_counter(&sc_key, SC_TYPE_SINGLE_VALUE);
+  cr_assert(counter, "in-flight counter does not exist for channel %s", channel);
+  gsize value = stats_counter_get(counter);
+  stats_unlock();
+
+  return value;
+}
+
+static std::shared_ptr<::grpc::Channel>
+_get_channel(ChannelPool &pool, size_t index)
+{
+  ::grpc::ChannelArguments args;
+
+  /* channels connect lazily, nothing listens here */
+  return pool.get_channel(index, "localhost:1", ::grpc::InsecureChannelCredentials(), args);
+}
+
+Test(grpc_channel_pool, disabled_by_default)
+{
+  ChannelPool pool;
+
+  cr_assert_not(pool.is_enabled());
+  cr_assert_eq(pool.get_size(), 0);
+
+  pool.init(kb, STATS_LEVEL1);
+  pool.deinit();
+}
+
+Test(grpc_channel_pool, idle_channels_are_used_round_robin)
+{
+  ChannelPool pool;
+  pool.set_size(3);
+  pool.init(kb, STATS_LEVEL1);
+
+  std::set<size_t> used;
+  for (int i = 0; i < 3; i++)
+    {
+      size_t index = pool.acquire();
+      pool.release(index);
+      used.insert(index);
+    }
+
+  cr_assert_eq(used.size(), 3);
+
+  pool.deinit();
+}
+
+Test(grpc_channel_pool, acquire_picks_the_least_loaded_channel)
+{
+  ChannelPool pool;
+  pool.set_size(3);
+  pool.init(kb, STATS_LEVEL1);
+
+  std::set<size_t> busy;
+  for (int i = 0; i < 3; i++)
+    busy.insert(pool.acquire());
+  cr_assert_eq(busy.size(), 3, "concurrent requests should be striped over all channels");
+
+  cr_assert_eq(_get_in_flight("0"), 1);
+  cr_assert_eq(_get_in_flight("1"), 1);
+  cr_assert_eq(_get_in_flight("2"), 1);
+
+  pool.release(1);
+  cr_assert_eq(_get_in_flight("1"), 0);
+
+  /* wherever the scan starts, the only idle channel is picked */
+  cr_assert_eq(pool.acquire(), 1);
+  cr_assert_eq(_get_in_flight("1"), 1);
+
+  for (size_t i = 0; i < 3; i++)
+    pool.release(i);
+
+  pool.deinit();
+}
+
+Test(grpc_channel_pool, channels_are_created_once_and_not_shared)
+{
+  ChannelPool pool;
+  pool.set_size(2);
+  pool.init(kb, STATS_LEVEL1);
+
+  std::shared_ptr<::grpc::Channel> first = _get_channel(pool, 0);
+  std::shared_ptr<::grpc::Channel> second = _get_channel(pool, 1);
+
+  cr_assert(first);
+  cr_assert(second);
+  cr_assert_neq(first.get(), second.get());
+  cr_assert_eq(_get_channel(pool, 0).get(), first.get());
+
+  pool.deinit();
+}
+
+void
+setup(void)
+{
+  app_startup();
+  kb = stats_cluster_key_builder_new();
+}
+
+void
+teardown(void)
+{
+  stats_cluster_key_builder_free(kb);
+  app_shutdown();
+}
+
+TestSuite(grpc_channel_pool, .init = setup, .fini = teardown);
@@ -68,10 +68,77 @@ DestinationDriver::init()
       log_template_compile(this->message, DEFAULT_MESSAGE_TEMPLATE, NULL);
     }
 
-  for (const auto &label : this->labels)
-    this->extend_worker_partition_key(label.name + "=" + label.value->template_str);
+  /* entries of different label sets are batched as separate streams, so
+   * labels only need to be part of the partition key to keep each stream
+   * on the same worker, at the price of flushing on label set changes */
+  if (this->super->super.num_workers > 1)
+    {
+      for (const auto &label : this->labels)
+        this->extend_worker_partition_key(label.name + "=" + label.value->template_str);
+    }
+
+  if (!syslogng::grpc::DestDriver::init())
+    return false;
+
+  this->register_stream_stats();
+  return true;
+}
+
+bool
+DestinationDriver::deinit()
+{
+  this->unregister_stream_stats();
+  return syslogng::grpc::DestDriver::deinit();
+}
+
+void
+DestinationDriver::register_stream_stats()
+{
+  int level = log_pipe_is_internal(&this->super->super.super.super.super) ? STATS_LEVEL3 : STATS_LEVEL1;
+
+  StatsClusterKeyBuilder *kb = stats_cluster_key_builder_new();
+  this->format_stats_key(kb);
+
+  stats_cluster_key_builder_set_name(kb, "output_loki_batches_total");
+  this->stream_stats.batches_sc_key = stats_cluster_key_builder_build_single(kb);
+
+  stats_cluster_key_builder_set_name(kb, "output_loki_batch_streams_total");
+  this->stream_stats.streams_sc_key = stats_cluster_key_builder_build_single(kb);
 
-  return syslogng::grpc::DestDriver::init();
+  stats_cluster_key_builder_free(kb);
+
+  stats_lock();
+  {
+    stats_register_counter(level, this->stream_stats.batches_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &this->stream_stats.batches);
+    stats_register_counter(level, this->stream_stats.streams_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &this->stream_stats.streams);
+  }
+  stats_unlock();
+}
+
+void
+DestinationDriver::unregister_stream_stats()
+{
+  stats_lock();
+  {
+    if (this->stream_stats.batches_sc_key)
+      {
+        stats_unregister_counter(this->stream_stats.batches_sc_key, SC_TYPE_SINGLE_VALUE,
+                                 &this->stream_stats.batches);
+        stats_cluster_key_free(this->stream_stats.batches_sc_key);
+        this->stream_stats.batches_sc_key = nullptr;
+      }
+
+    if (this->stream_stats.streams_sc_key)
+      {
+        stats_unregister_counter(this->stream_stats.streams_sc_key, SC_TYPE_SINGLE_VALUE,
+                                 &this->stream_stats.streams);
+        stats_cluster_key_free(this->stream_stats.streams_sc_key);
+        this->stream_stats.streams_sc_key = nullptr;
+      }
+  }
+  stats_unlock();
 }
 
 const gchar *
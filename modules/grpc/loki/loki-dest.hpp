@@ -30,6 +30,7 @@
 #include "compat/cpp-start.h"
 #include "template/templates.h"
 #include "stats/stats-cluster-key-builder.h"
+#include "stats/stats-registry.h"
 #include "logmsg/logmsg.h"
 #include "compat/cpp-end.h"
 
@@ -49,6 +50,7 @@ public:
   DestinationDriver(GrpcDestDriver *s);
   ~DestinationDriver();
   bool init();
+  bool deinit();
   const gchar *generate_persist_name();
   const gchar *format_stats_key(StatsClusterKeyBuilder *kb);
   LogThreadedDestWorker *construct_worker(int worker_index);
@@ -79,7 +81,16 @@ public:
     this->tenant_id = tid;
   }
 
+  void insert_batch_stream_stats(size_t num_streams)
+  {
+    stats_counter_inc(this->stream_stats.batches);
+    stats_counter_add(this->stream_stats.streams, num_streams);
+  }
+
 private:
+  void register_stream_stats();
+  void unregister_stream_stats();
+
   friend class DestinationWorker;
 
   std::string tenant_id;
@@ -87,6 +98,15 @@ private:
   LogTemplate *message = nullptr;
   std::vector<NameValueTemplatePair> labels;
   LogMessageTimeStamp timestamp;
+
+  /* streams per batch = streams / batches */
+  struct
+  {
+    StatsClusterKey *batches_sc_key = nullptr;
+    StatsClusterKey *streams_sc_key = nullptr;
+    StatsCounterItem *batches = nullptr;
+    StatsCounterItem *streams = nullptr;
+  } stream_stats;
 };
 
 
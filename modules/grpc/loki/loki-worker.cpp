@@ -49,6 +49,9 @@ using syslogng::grpc::loki::DestinationWorker;
 using syslogng::grpc::loki::DestinationDriver;
 using google::protobuf::FieldDescriptor;
 
+/* the interned label sets are dropped when this many distinct streams were seen */
+constexpr size_t MAX_INTERNED_LABEL_SETS = 16384;
+
 struct _LokiDestWorker
 {
   LogThreadedDestWorker super;
@@ -68,17 +71,23 @@ DestinationWorker::init()
       return false;
     }
 
-  this->channel = ::grpc::CreateCustomChannel(this->owner.get_url(), credentials, args);
-  if (!this->channel)
+  this->channels.clear();
+  this->stubs.clear();
+  for (size_t i = 0; i < this->get_channel_count(); i++)
     {
-      msg_error("Error creating Loki gRPC channel",
-                evt_tag_str("url", this->owner.get_url().c_str()),
-                log_pipe_location_tag((LogPipe *) this->super->super.owner));
-      return false;
+      std::shared_ptr<::grpc::Channel> channel = this->create_channel(i, credentials, args);
+      if (!channel)
+        {
+          msg_error("Error creating Loki gRPC channel",
+                    evt_tag_str("url", this->owner.get_url().c_str()),
+                    log_pipe_location_tag((LogPipe *) this->super->super.owner));
+          return false;
+        }
+
+      this->channels.push_back(channel);
+      this->stubs.push_back(logproto::Pusher().NewStub(channel));
     }
 
-  this->stub = logproto::Pusher().NewStub(channel);
-
   return syslogng::grpc::DestWorker::init();
 }
 
@@ -94,12 +103,15 @@ DestinationWorker::connect()
   std::chrono::system_clock::time_point connect_timeout =
     std::chrono::system_clock::now() + std::chrono::seconds(10);
 
-  if (!this->channel->WaitForConnected(connect_timeout))
+  for (const auto &channel : this->channels)
     {
-      msg_error("Time out connecting to Loki",
-                evt_tag_str("url", owner_->get_url().c_str()),
-                log_pipe_location_tag((LogPipe *) this->super->super.owner));
-      return false;
+      if (!channel->WaitForConnected(connect_timeout))
+        {
+          msg_error("Time out connecting to Loki",
+                    evt_tag_str("url", owner_->get_url().c_str()),
+                    log_pipe_location_tag((LogPipe *) this->super->super.owner));
+          return false;
+        }
     }
 
   this->connected = true;
@@ -119,7 +131,7 @@ void
 DestinationWorker::prepare_batch()
 {
   this->current_batch = logproto::PushRequest{};
-  this->current_batch.add_streams();
+  this->current_batch_streams.clear();
   this->current_batch_bytes = 0;
   this->client_context.reset();
 }
@@ -131,38 +143,85 @@ DestinationWorker::should_initiate_flush()
 }
 
 void
-DestinationWorker::set_labels(LogMessage *msg)
+DestinationWorker::format_label_values(LogMessage *msg, std::string &label_set_key)
 {
   DestinationDriver *owner_ = this->get_owner();
-  logproto::StreamAdapter *stream = this->current_batch.mutable_streams(0);
 
   LogTemplateEvalOptions options = {&owner_->template_options, LTZ_SEND, this->super->super.seq_num, NULL, LM_VT_STRING};
 
   ScratchBuffersMarker m;
   GString *buf = scratch_buffers_alloc_and_mark(&m);
-  GString *sanitized_value = scratch_buffers_alloc();
 
-  std::stringstream formatted_labels;
-  bool comma_needed = false;
-  formatted_labels << "{";
+  label_set_key.clear();
+  this->label_value_lengths.clear();
   for (const auto &label : owner_->labels)
     {
-      if (comma_needed)
-        formatted_labels << ", ";
-
       log_template_format(label.value, msg, &options, buf);
+      label_set_key.append(buf->str, buf->len);
+      label_set_key.push_back('\0');
+      this->label_value_lengths.push_back(buf->len);
+    }
 
-      g_string_truncate(sanitized_value, 0);
-      append_unsafe_utf8_as_escaped_binary(sanitized_value, buf->str, -1, AUTF8_UNSAFE_QUOTE);
+  scratch_buffers_reclaim_marked(m);
+}
 
-      formatted_labels << label.name << "=\"" << sanitized_value->str << "\"";
+/* label_value_lengths must belong to label_set_key, e.g. this must be
+ * called right after format_label_values() */
+const std::string &
+DestinationWorker::intern_label_set(const std::string &label_set_key)
+{
+  auto interned = this->interned_label_sets.find(label_set_key);
+  if (interned != this->interned_label_sets.end())
+    return interned->second;
+
+  if (this->interned_label_sets.size() >= MAX_INTERNED_LABEL_SETS)
+    this->interned_label_sets.clear();
+
+  DestinationDriver *owner_ = this->get_owner();
 
-      comma_needed = true;
+  ScratchBuffersMarker m;
+  GString *sanitized_value = scratch_buffers_alloc_and_mark(&m);
+
+  std::string formatted_labels = "{";
+  const gchar *value = label_set_key.c_str();
+  size_t label_index = 0;
+  for (const auto &label : owner_->labels)
+    {
+      if (label_index > 0)
+        formatted_labels.append(", ");
+
+      gsize value_len = this->label_value_lengths[label_index++];
+
+      g_string_truncate(sanitized_value, 0);
+      append_unsafe_utf8_as_escaped_binary(sanitized_value, value, value_len, AUTF8_UNSAFE_QUOTE);
+
+      formatted_labels.append(label.name).append("=\"").append(sanitized_value->str).append("\"");
+      value += value_len + 1;
     }
-  formatted_labels << "}";
-  stream->set_labels(formatted_labels.str());
+  formatted_labels.append("}");
 
   scratch_buffers_reclaim_marked(m);
+
+  return this->interned_label_sets.emplace(label_set_key, std::move(formatted_labels)).first->second;
+}
+
+/* Entries with the same label set are grouped into a single stream.  The
+ * label values are looked up by their hash, the label set is only
+ * formatted and escaped the first time the stream is seen. */
+logproto::StreamAdapter *
+DestinationWorker::lookup_stream(LogMessage *msg)
+{
+  this->format_label_values(msg, this->label_set_key);
+
+  auto it = this->current_batch_streams.find(this->label_set_key);
+  if (it != this->current_batch_streams.end())
+    return this->current_batch.mutable_streams(it->second);
+
+  logproto::StreamAdapter *stream = this->current_batch.add_streams();
+  stream->set_labels(this->intern_label_set(this->label_set_key));
+  this->current_batch_streams.emplace(this->label_set_key, this->current_batch.streams_size() - 1);
+
+  return stream;
 }
 
 void
@@ -185,10 +244,7 @@ LogThreadedResult
 DestinationWorker::insert(LogMessage *msg)
 {
   DestinationDriver *owner_ = this->get_owner();
-  logproto::StreamAdapter *stream = this->current_batch.mutable_streams(0);
-
-  if (stream->entries_size() == 0)
-    this->set_labels(msg);
+  logproto::StreamAdapter *stream = this->lookup_stream(msg);
 
   logproto::EntryAdapter *entry = stream->add_entries();
 
@@ -233,7 +289,9 @@ DestinationWorker::flush(LogThreadedFlushMode mode)
   LogThreadedResult result;
   logproto::PushResponse response{};
 
-  ::grpc::Status status = this->stub->Push(client_context.get(), this->current_batch, &response);
+  size_t channel_index = this->acquire_channel();
+  ::grpc::Status status = this->stubs[channel_index]->Push(client_context.get(), this->current_batch, &response);
+  this->release_channel(channel_index);
   this->get_owner()->metrics.insert_grpc_request_stats(status);
 
   if (this->get_owner()->handle_response(status, &result))
@@ -256,8 +314,11 @@ DestinationWorker::flush(LogThreadedFlushMode mode)
 success:
   log_threaded_dest_worker_written_bytes_add(&this->super->super, this->current_batch_bytes);
   log_threaded_dest_driver_insert_batch_length_stats(this->super->super.owner, this->current_batch_bytes);
+  owner_->insert_batch_stream_stats(this->current_batch.streams_size());
 
-  msg_debug("Loki batch delivered", log_pipe_location_tag((LogPipe *) this->super->super.owner));
+  msg_debug("Loki batch delivered",
+            evt_tag_int("streams", this->current_batch.streams_size()),
+            log_pipe_location_tag((LogPipe *) this->super->super.owner));
   result = LTR_SUCCESS;
 
 error:
@@ -36,6 +36,8 @@
 
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "push.grpc.pb.h"
 
@@ -58,18 +60,28 @@ public:
 private:
   void prepare_batch();
   bool should_initiate_flush();
-  void set_labels(LogMessage *msg);
+  void format_label_values(LogMessage *msg, std::string &label_set_key);
+  const std::string &intern_label_set(const std::string &label_set_key);
+  logproto::StreamAdapter *lookup_stream(LogMessage *msg);
   void set_timestamp(logproto::EntryAdapter *entry, LogMessage *msg);
   DestinationDriver *get_owner();
 
 private:
   bool connected;
 
-  std::shared_ptr<::grpc::Channel> channel;
+  std::vector<std::shared_ptr<::grpc::Channel>> channels;
   std::unique_ptr<::grpc::ClientContext> client_context;
-  std::unique_ptr<logproto::Pusher::Stub> stub;
+  std::vector<std::unique_ptr<logproto::Pusher::Stub>> stubs;
   logproto::PushRequest current_batch;
   size_t current_batch_bytes = 0;
+
+  /* raw label values of a stream (NUL separated) -> index in current_batch */
+  std::unordered_map<std::string, int> current_batch_streams;
+
+  /* raw label values -> formatted and escaped Loki label set, kept across batches */
+  std::unordered_map<std::string, std::string> interned_label_sets;
+  std::string label_set_key;
+  std::vector<gsize> label_value_lengths;
 };
 
 }
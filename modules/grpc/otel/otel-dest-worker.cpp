@@ -57,10 +57,13 @@ DestWorker::DestWorker(GrpcDestWorker *s)
 
   ::grpc::ChannelArguments args = this->create_channel_args();
 
-  channel = ::grpc::CreateCustomChannel(owner.get_url(), credentials, args);
-  logs_service_stub = LogsService::NewStub(channel);
-  metrics_service_stub = MetricsService::NewStub(channel);
-  trace_service_stub = TraceService::NewStub(channel);
+  for (size_t i = 0; i < get_channel_count(); i++)
+    {
+      std::shared_ptr<::grpc::Channel> channel = create_channel(i, credentials, args);
+      logs_service_stubs.push_back(LogsService::NewStub(channel));
+      metrics_service_stubs.push_back(MetricsService::NewStub(channel));
+      trace_service_stubs.push_back(TraceService::NewStub(channel));
+    }
 }
 
 void
@@ -415,8 +418,10 @@ LogThreadedResult
 DestWorker::flush_log_records()
 {
   logs_service_response.Clear();
-  ::grpc::Status status = logs_service_stub->Export(client_context.get(), logs_service_request,
-                                                    &logs_service_response);
+  size_t channel_index = acquire_channel();
+  ::grpc::Status status = logs_service_stubs[channel_index]->Export(client_context.get(), logs_service_request,
+                                                                    &logs_service_response);
+  release_channel(channel_index);
   owner.metrics.insert_grpc_request_stats(status);
 
   LogThreadedResult result;
@@ -436,8 +441,10 @@ LogThreadedResult
 DestWorker::flush_metrics()
 {
   metrics_service_response.Clear();
-  ::grpc::Status status = metrics_service_stub->Export(client_context.get(), metrics_service_request,
-                                                       &metrics_service_response);
+  size_t channel_index = acquire_channel();
+  ::grpc::Status status = metrics_service_stubs[channel_index]->Export(client_context.get(), metrics_service_request,
+                                                                       &metrics_service_response);
+  release_channel(channel_index);
   owner.metrics.insert_grpc_request_stats(status);
 
   LogThreadedResult result;
@@ -457,8 +464,10 @@ LogThreadedResult
 DestWorker::flush_spans()
 {
   trace_service_response.Clear();
-  ::grpc::Status status = trace_service_stub->Export(client_context.get(), trace_service_request,
-                                                     &trace_service_response);
+  size_t channel_index = acquire_channel();
+  ::grpc::Status status = trace_service_stubs[channel_index]->Export(client_context.get(), trace_service_request,
+                                                                     &trace_service_response);
+  release_channel(channel_index);
   owner.metrics.insert_grpc_request_stats(status);
 
   LogThreadedResult result;
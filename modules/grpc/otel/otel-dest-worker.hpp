@@ -35,6 +35,8 @@
 #include "otel-dest.hpp"
 #include "otel-protobuf-formatter.hpp"
 
+#include <vector>
+
 namespace syslogng {
 namespace grpc {
 namespace otel {
@@ -81,11 +83,10 @@ protected:
   LogThreadedResult flush_spans();
 
 protected:
-  std::shared_ptr<::grpc::Channel> channel;
   std::unique_ptr<::grpc::ClientContext> client_context;
-  std::unique_ptr<LogsService::Stub> logs_service_stub;
-  std::unique_ptr<MetricsService::Stub> metrics_service_stub;
-  std::unique_ptr<TraceService::Stub> trace_service_stub;
+  std::vector<std::unique_ptr<LogsService::Stub>> logs_service_stubs;
+  std::vector<std::unique_ptr<MetricsService::Stub>> metrics_service_stubs;
+  std::vector<std::unique_ptr<TraceService::Stub>> trace_service_stubs;
 
   ExportLogsServiceRequest logs_service_request;
   ExportLogsServiceResponse logs_service_response;
@@ -1114,30 +1114,60 @@ _unset_raw_fields(LogMessage *msg)
   log_msg_unset_value(msg, logmsg_handle::RAW_SPAN);
 }
 
+syslogng::grpc::otel::RawMetadata::RawMetadata(const ::grpc::string &peer)
+  : saddr(_extract_saddr(peer))
+{
+}
+
+syslogng::grpc::otel::RawMetadata::~RawMetadata()
+{
+  g_sockaddr_unref(this->saddr);
+}
+
 void
-syslogng::grpc::otel::ProtobufParser::store_raw_metadata(LogMessage *msg, const ::grpc::string &peer,
-                                                         const Resource &resource,
-                                                         const std::string &resource_schema_url,
-                                                         const InstrumentationScope &scope,
-                                                         const std::string &scope_schema_url)
+syslogng::grpc::otel::RawMetadata::set_resource(const Resource &resource_, const std::string &schema_url)
+{
+  resource_.SerializePartialToString(&this->resource);
+  this->resource_schema_url = schema_url;
+}
+
+void
+syslogng::grpc::otel::RawMetadata::set_scope(const InstrumentationScope &scope_, const std::string &schema_url)
 {
-  std::string serialized;
+  scope_.SerializePartialToString(&this->scope);
+  this->scope_schema_url = schema_url;
+}
 
-  msg->saddr = _extract_saddr(peer);
+void
+syslogng::grpc::otel::RawMetadata::store(LogMessage *msg) const
+{
+  log_msg_set_saddr(msg, this->saddr);
 
   /* .otel_raw.resource */
-  resource.SerializePartialToString(&serialized);
-  _set_value(msg, logmsg_handle::RAW_RESOURCE, serialized, LM_VT_PROTOBUF);
+  _set_value(msg, logmsg_handle::RAW_RESOURCE, this->resource, LM_VT_PROTOBUF);
 
   /* .otel_raw.resource_schema_url */
-  _set_value(msg, logmsg_handle::RAW_RESOURCE_SCHEMA_URL, resource_schema_url, LM_VT_STRING);
+  _set_value(msg, logmsg_handle::RAW_RESOURCE_SCHEMA_URL, this->resource_schema_url, LM_VT_STRING);
 
   /* .otel_raw.scope */
-  scope.SerializePartialToString(&serialized);
-  _set_value(msg, logmsg_handle::RAW_SCOPE, serialized, LM_VT_PROTOBUF);
+  _set_value(msg, logmsg_handle::RAW_SCOPE, this->scope, LM_VT_PROTOBUF);
 
   /* .otel_raw.scope_schema_url */
-  _set_value(msg, logmsg_handle::RAW_SCOPE_SCHEMA_URL, scope_schema_url, LM_VT_STRING);
+  _set_value(msg, logmsg_handle::RAW_SCOPE_SCHEMA_URL, this->scope_schema_url, LM_VT_STRING);
+}
+
+void
+syslogng::grpc::otel::ProtobufParser::store_raw_metadata(LogMessage *msg, const ::grpc::string &peer,
+                                                         const Resource &resource,
+                                                         const std::string &resource_schema_url,
+                                                         const InstrumentationScope &scope,
+                                                         const std::string &scope_schema_url)
+{
+  RawMetadata metadata(peer);
+
+  metadata.set_resource(resource, resource_schema_url);
+  metadata.set_scope(scope, scope_schema_url);
+  metadata.store(msg);
 }
 
 void
@@ -50,6 +50,34 @@ using opentelemetry::proto::logs::v1::LogRecord;
 using opentelemetry::proto::metrics::v1::Metric;
 using opentelemetry::proto::trace::v1::Span;
 
+/*
+ * The raw resource and scope metadata of a request.
+ *
+ * The peer address, the resource and the scope are serialized only once and
+ * stored into every message of the same scope, instead of serializing them
+ * again for each record.
+ */
+class RawMetadata
+{
+public:
+  RawMetadata(const ::grpc::string &peer);
+  ~RawMetadata();
+
+  RawMetadata(const RawMetadata &) = delete;
+  RawMetadata &operator=(const RawMetadata &) = delete;
+
+  void set_resource(const Resource &resource, const std::string &schema_url);
+  void set_scope(const InstrumentationScope &scope, const std::string &schema_url);
+  void store(LogMessage *msg) const;
+
+private:
+  GSockAddr *saddr;
+  std::string resource;
+  std::string resource_schema_url;
+  std::string scope;
+  std::string scope_schema_url;
+};
+
 class ProtobufParser
 {
 public:
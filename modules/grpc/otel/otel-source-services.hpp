@@ -103,17 +103,22 @@ syslogng::grpc::otel::TraceServiceCall::Proceed(bool ok)
   ::grpc::Status response_status = ::grpc::Status::OK;
 
   int msgs_in_fetch_round = 0;
+  RawMetadata raw_metadata(ctx.peer());
 
   for (const ResourceSpans &resource_spans : request.resource_spans())
     {
       const Resource &resource = resource_spans.resource();
       const std::string &resource_spans_schema_url = resource_spans.schema_url();
 
+      raw_metadata.set_resource(resource, resource_spans_schema_url);
+
       for (const ScopeSpans &scope_spans : resource_spans.scope_spans())
         {
           const InstrumentationScope &scope = scope_spans.scope();
           const std::string &scope_spans_schema_url = scope_spans.schema_url();
 
+          raw_metadata.set_scope(scope, scope_spans_schema_url);
+
           for (const Span &span : scope_spans.spans())
             {
               if (worker.super->super.under_termination)
@@ -125,8 +130,7 @@ syslogng::grpc::otel::TraceServiceCall::Proceed(bool ok)
               LogMessage *msg = log_msg_new_empty();
               log_msg_set_recvd_rawmsg_size(msg, span.ByteSizeLong());
 
-              ProtobufParser::store_raw_metadata(msg, ctx.peer(), resource, resource_spans_schema_url, scope,
-                                                 scope_spans_schema_url);
+              raw_metadata.store(msg);
               ProtobufParser::store_raw(msg, span);
               worker.post(msg);
 
@@ -162,17 +166,32 @@ syslogng::grpc::otel::LogsServiceCall::Proceed(bool ok)
   ::grpc::Status response_status = ::grpc::Status::OK;
 
   int msgs_in_fetch_round = 0;
+  RawMetadata raw_metadata(ctx.peer());
 
   for (const ResourceLogs &resource_logs : request.resource_logs())
     {
       const Resource &resource = resource_logs.resource();
       const std::string &resource_logs_schema_url = resource_logs.schema_url();
+      bool resource_serialized = false;
 
       for (const ScopeLogs &scope_logs : resource_logs.scope_logs())
         {
           const InstrumentationScope &scope = scope_logs.scope();
           const std::string &scope_logs_schema_url = scope_logs.schema_url();
 
+          bool is_syslog_ng_scope = ProtobufParser::is_syslog_ng_log_record(resource, resource_logs_schema_url, scope,
+                                    scope_logs_schema_url);
+          if (!is_syslog_ng_scope)
+            {
+              /* serialized lazily, syslog-ng-otlp() senders do not need it */
+              if (!resource_serialized)
+                {
+                  raw_metadata.set_resource(resource, resource_logs_schema_url);
+                  resource_serialized = true;
+                }
+              raw_metadata.set_scope(scope, scope_logs_schema_url);
+            }
+
           for (const LogRecord &log_record : scope_logs.log_records())
             {
               if (worker.super->super.under_termination)
@@ -184,15 +203,13 @@ syslogng::grpc::otel::LogsServiceCall::Proceed(bool ok)
               LogMessage *msg = log_msg_new_empty();
               log_msg_set_recvd_rawmsg_size(msg, log_record.ByteSizeLong());
 
-              if (ProtobufParser::is_syslog_ng_log_record(resource, resource_logs_schema_url, scope,
-                                                          scope_logs_schema_url))
+              if (is_syslog_ng_scope)
                 {
                   ProtobufParser::store_syslog_ng(msg, log_record);
                 }
               else
                 {
-                  ProtobufParser::store_raw_metadata(msg, ctx.peer(), resource, resource_logs_schema_url, scope,
-                                                     scope_logs_schema_url);
+                  raw_metadata.store(msg);
                   ProtobufParser::store_raw(msg, log_record);
                 }
               worker.post(msg);
@@ -229,17 +246,22 @@ syslogng::grpc::otel::MetricsServiceCall::Proceed(bool ok)
   ::grpc::Status response_status = ::grpc::Status::OK;
 
   int msgs_in_fetch_round = 0;
+  RawMetadata raw_metadata(ctx.peer());
 
   for (const ResourceMetrics &resource_metrics : request.resource_metrics())
     {
       const Resource &resource = resource_metrics.resource();
       const std::string &resource_metrics_schema_url = resource_metrics.schema_url();
 
+      raw_metadata.set_resource(resource, resource_metrics_schema_url);
+
       for (const ScopeMetrics &scope_metrics : resource_metrics.scope_metrics())
         {
           const InstrumentationScope &scope = scope_metrics.scope();
           const std::string &scope_metrics_schema_url = scope_metrics.schema_url();
 
+          raw_metadata.set_scope(scope, scope_metrics_schema_url);
+
           for (const Metric &metric : scope_metrics.metrics())
             {
               if (worker.super->super.under_termination)
@@ -251,8 +273,7 @@ syslogng::grpc::otel::MetricsServiceCall::Proceed(bool ok)
               LogMessage *msg = log_msg_new_empty();
               log_msg_set_recvd_rawmsg_size(msg, metric.ByteSizeLong());
 
-              ProtobufParser::store_raw_metadata(msg, ctx.peer(), resource, resource_metrics_schema_url, scope,
-                                                 scope_metrics_schema_url);
+              raw_metadata.store(msg);
               ProtobufParser::store_raw(msg, metric);
               worker.post(msg);
 
@@ -186,6 +186,60 @@ Test(otel_protobuf_parser, metadata)
   log_msg_unref(msg);
 }
 
+Test(otel_protobuf_parser, raw_metadata_shared_between_records)
+{
+  Resource resource;
+  KeyValue *hostname = resource.add_attributes();
+  hostname->set_key("host.name");
+  hostname->mutable_value()->set_string_value("myhost");
+
+  InstrumentationScope scope_1;
+  scope_1.set_name("scope_1");
+  InstrumentationScope scope_2;
+  scope_2.set_name("scope_2");
+
+  RawMetadata raw_metadata("ipv4:127.0.0.5:36372");
+  raw_metadata.set_resource(resource, "my_resource_schema_url");
+
+  raw_metadata.set_scope(scope_1, "my_scope_1_schema_url");
+  LogMessage *msg_1 = log_msg_new_empty();
+  raw_metadata.store(msg_1);
+  ProtobufParser::store_raw(msg_1, LogRecord());
+
+  LogMessage *msg_2 = log_msg_new_empty();
+  raw_metadata.store(msg_2);
+  ProtobufParser::store_raw(msg_2, LogRecord());
+
+  raw_metadata.set_scope(scope_2, "my_scope_2_schema_url");
+  LogMessage *msg_3 = log_msg_new_empty();
+  raw_metadata.store(msg_3);
+  ProtobufParser::store_raw(msg_3, LogRecord());
+
+  cr_assert(ProtobufParser().process(msg_1));
+  cr_assert(ProtobufParser().process(msg_2));
+  cr_assert(ProtobufParser().process(msg_3));
+
+  LogMessage *msgs[] = {msg_1, msg_2, msg_3};
+  for (LogMessage *msg : msgs)
+    {
+      cr_assert(msg->saddr != NULL);
+      _assert_log_msg_value(msg, "SOURCEIP", "127.0.0.5", -1, LM_VT_STRING);
+      _assert_log_msg_value(msg, "HOST", "myhost", -1, LM_VT_STRING);
+      _assert_log_msg_value(msg, ".otel.resource.schema_url", "my_resource_schema_url", -1, LM_VT_STRING);
+    }
+
+  _assert_log_msg_value(msg_1, ".otel.scope.name", "scope_1", -1, LM_VT_STRING);
+  _assert_log_msg_value(msg_1, ".otel.scope.schema_url", "my_scope_1_schema_url", -1, LM_VT_STRING);
+  _assert_log_msg_value(msg_2, ".otel.scope.name", "scope_1", -1, LM_VT_STRING);
+  _assert_log_msg_value(msg_2, ".otel.scope.schema_url", "my_scope_1_schema_url", -1, LM_VT_STRING);
+  _assert_log_msg_value(msg_3, ".otel.scope.name", "scope_2", -1, LM_VT_STRING);
+  _assert_log_msg_value(msg_3, ".otel.scope.schema_url", "my_scope_2_schema_url", -1, LM_VT_STRING);
+
+  log_msg_unref(msg_1);
+  log_msg_unref(msg_2);
+  log_msg_unref(msg_3);
+}
+
 Test(otel_protobuf_parser, log_record)
 {
   LogMessage *msg = _create_dummy_log_msg();
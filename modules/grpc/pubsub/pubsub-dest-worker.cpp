@@ -45,8 +45,8 @@ DestWorker::DestWorker(GrpcDestWorker *s)
 
   ::grpc::ChannelArguments args = this->create_channel_args();
 
-  this->channel = ::grpc::CreateCustomChannel(this->owner.get_url(), credentials, args);
-  this->stub = ::google::pubsub::v1::Publisher::NewStub(this->channel);
+  for (size_t i = 0; i < this->get_channel_count(); i++)
+    this->stubs.push_back(::google::pubsub::v1::Publisher::NewStub(this->create_channel(i, credentials, args)));
 }
 
 bool
@@ -261,7 +261,9 @@ DestWorker::flush(LogThreadedFlushMode mode)
 
   ::google::pubsub::v1::PublishResponse response;
 
-  ::grpc::Status status = this->stub->Publish(this->client_context.get(), this->request, &response);
+  size_t channel_index = this->acquire_channel();
+  ::grpc::Status status = this->stubs[channel_index]->Publish(this->client_context.get(), this->request, &response);
+  this->release_channel(channel_index);
 
   LogThreadedResult result;
   if (!owner.handle_response(status, &result))
@@ -27,6 +27,8 @@
 #include "pubsub-dest.hpp"
 #include "grpc-dest-worker.hpp"
 
+#include <vector>
+
 #include "google/pubsub/v1/pubsub.grpc.pb.h"
 
 namespace syslogng {
@@ -57,8 +59,7 @@ private:
   DestDriver *get_owner();
 
 private:
-  std::shared_ptr<::grpc::Channel> channel;
-  std::unique_ptr<::google::pubsub::v1::Publisher::Stub> stub;
+  std::vector<std::unique_ptr<::google::pubsub::v1::Publisher::Stub>> stubs;
   std::unique_ptr<::grpc::ClientContext> client_context;
 
   ::google::pubsub::v1::PublishRequest request;
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "kafka-batch.h"
+
+gboolean
+kafka_batch_is_error_retriable(rd_kafka_resp_err_t err)
+{
+  return err == RD_KAFKA_RESP_ERR__QUEUE_FULL;
+}
+
+void
+kafka_batch_append(KafkaBatch *self, rd_kafka_topic_t *topic, KafkaPayload *payload)
+{
+  /* the payload is passed to librdkafka by reference, _private becomes the
+   * msg_opaque of the delivery report, which returns it to the pool */
+  rd_kafka_message_t rkmessage =
+  {
+    .rkt = topic,
+    .partition = RD_KAFKA_PARTITION_UA,
+    .payload = payload->message->str,
+    .len = payload->message->len,
+    .key = payload->key->len ? payload->key->str : NULL,
+    .key_len = payload->key->len,
+    ._private = payload,
+  };
+
+  g_array_append_val(self->messages, rkmessage);
+}
+
+static guint
+_find_end_of_topic_run(rd_kafka_message_t *rkmessages, guint start, guint len)
+{
+  guint end = start + 1;
+
+  while (end < len && rkmessages[end].rkt == rkmessages[start].rkt)
+    end++;
+  return end;
+}
+
+/*
+ * Produces the batch in backlog order and returns the number of leading
+ * messages whose fate is settled: accepted by librdkafka (err is
+ * RD_KAFKA_RESP_ERR_NO_ERROR) or rejected for good (any other err).  The
+ * rest starts with the first message rejected due to a full local queue,
+ * it is to be rewound and retried.
+ *
+ * Producing stops at the first topic run that is not fully accepted.
+ * Messages after the retriable one in that run that librdkafka accepted
+ * anyway are going to be sent again after the rewind: that is a
+ * duplicate, not a loss.
+ */
+gint
+kafka_batch_produce(KafkaBatch *self, gint msgflags)
+{
+  rd_kafka_message_t *rkmessages = (rd_kafka_message_t *) self->messages->data;
+  guint len = self->messages->len;
+  guint start = 0;
+
+  while (start < len)
+    {
+      guint end = _find_end_of_topic_run(rkmessages, start, len);
+      gint produced = self->produce(rkmessages[start].rkt, RD_KAFKA_PARTITION_UA, msgflags,
+                                    &rkmessages[start], end - start);
+
+      gint first_retriable = -1;
+      for (guint i = start; i < end; i++)
+        {
+          if (rkmessages[i].err == RD_KAFKA_RESP_ERR_NO_ERROR)
+            {
+              /* librdkafka owns the payload until the delivery report */
+              rkmessages[i]._private = NULL;
+            }
+          else if (first_retriable < 0 && kafka_batch_is_error_retriable(rkmessages[i].err))
+            {
+              first_retriable = i;
+            }
+        }
+
+      if (produced != end - start && first_retriable >= 0)
+        return first_retriable;
+
+      start = end;
+    }
+
+  return len;
+}
+
+/* returns the payloads not handed over to librdkafka to the pool */
+void
+kafka_batch_clear(KafkaBatch *self)
+{
+  for (guint i = 0; i < self->messages->len; i++)
+    {
+      KafkaPayload *payload = (KafkaPayload *) kafka_batch_get_message(self, i)->_private;
+
+      if (payload)
+        kafka_payload_pool_release(self->payload_pool, payload);
+    }
+  g_array_set_size(self->messages, 0);
+}
+
+KafkaBatch *
+kafka_batch_new(KafkaPayloadPool *payload_pool)
+{
+  KafkaBatch *self = g_new0(KafkaBatch, 1);
+
+  self->messages = g_array_sized_new(FALSE, TRUE, sizeof(rd_kafka_message_t), 64);
+  self->payload_pool = payload_pool;
+  self->produce = rd_kafka_produce_batch;
+  return self;
+}
+
+void
+kafka_batch_free(KafkaBatch *self)
+{
+  kafka_batch_clear(self);
+  g_array_free(self->messages, TRUE);
+  g_free(self);
+}
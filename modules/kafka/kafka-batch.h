@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef KAFKA_BATCH_H_INCLUDED
+#define KAFKA_BATCH_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "kafka-payload-pool.h"
+#include <librdkafka/rdkafka.h>
+
+typedef gint (*KafkaProduceBatchFunc)(rd_kafka_topic_t *rkt, gint32 partition, gint msgflags,
+                                      rd_kafka_message_t *rkmessages, gint message_cnt);
+
+/* Messages collected for rd_kafka_produce_batch(), kept in the order they
+ * were taken from the LogQueue backlog, as the results of a flush are
+ * acked and rewound positionally.  Each message carries its own topic,
+ * consecutive messages of the same topic are produced with a single
+ * call. */
+typedef struct _KafkaBatch
+{
+  GArray *messages;
+  KafkaPayloadPool *payload_pool;
+  KafkaProduceBatchFunc produce;
+} KafkaBatch;
+
+void kafka_batch_append(KafkaBatch *self, rd_kafka_topic_t *topic, KafkaPayload *payload);
+gint kafka_batch_produce(KafkaBatch *self, gint msgflags);
+void kafka_batch_clear(KafkaBatch *self);
+
+static inline guint
+kafka_batch_get_length(KafkaBatch *self)
+{
+  return self->messages->len;
+}
+
+static inline rd_kafka_message_t *
+kafka_batch_get_message(KafkaBatch *self, guint index)
+{
+  return &g_array_index(self->messages, rd_kafka_message_t, index);
+}
+
+gboolean kafka_batch_is_error_retriable(rd_kafka_resp_err_t err);
+
+KafkaBatch *kafka_batch_new(KafkaPayloadPool *payload_pool);
+void kafka_batch_free(KafkaBatch *self);
+
+#endif
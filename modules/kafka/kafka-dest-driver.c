@@ -31,6 +31,9 @@
 #include <librdkafka/rdkafka.h>
 #include <stdlib.h>
 
+/* number of idle payload buffers kept around for reuse by produce-batch() */
+#define KAFKA_PAYLOAD_POOL_MAX_FREE 8192
+
 /*
  * Configuration
  */
@@ -124,6 +127,14 @@ kafka_dd_set_transaction_commit(LogDriver *d, gboolean transaction_commit)
 #endif
 }
 
+void
+kafka_dd_set_produce_batch(LogDriver *d, gboolean produce_batch)
+{
+  KafkaDestDriver *self = (KafkaDestDriver *)d;
+
+  self->produce_batch = produce_batch;
+}
+
 LogTemplateOptions *
 kafka_dd_get_template_options(LogDriver *d)
 {
@@ -311,6 +322,11 @@ _kafka_delivery_report_cb(rd_kafka_t *rk,
                 evt_tag_str("driver", self->super.super.super.id),
                 log_pipe_location_tag(&self->super.super.super.super));
     }
+
+  /* messages sent via rd_kafka_produce_batch() carry their pooled buffer
+   * as msg_opaque, librdkafka is done with it at this point */
+  if (msg_opaque)
+    kafka_payload_pool_release(self->payload_pool, (KafkaPayload *) msg_opaque);
 }
 
 static gboolean
@@ -617,6 +633,13 @@ kafka_dd_init(LogPipe *s)
           log_threaded_dest_driver_set_num_workers(&self->super.super.super, 1);
         }
 
+      if (self->produce_batch)
+        {
+          msg_warning("kafka: produce-batch() is not supported together with sync-send(yes), disabling it",
+                      evt_tag_str("driver", self->super.super.super.id),
+                      log_pipe_location_tag(&self->super.super.super.super));
+          self->produce_batch = FALSE;
+        }
     }
 
   if (!log_threaded_dest_driver_init_method(s))
@@ -691,6 +714,7 @@ kafka_dd_free(LogPipe *d)
   g_mutex_clear(&self->topics_lock);
   g_free(self->bootstrap_servers);
   kafka_property_list_free(self->config);
+  kafka_payload_pool_free(self->payload_pool);
   log_threaded_dest_driver_free(d);
 }
 
@@ -716,6 +740,7 @@ kafka_dd_new(GlobalConfig *cfg)
   self->flush_timeout_on_shutdown = 60000;
   self->flush_timeout_on_reload = 1000;
   self->poll_timeout = 1000;
+  self->payload_pool = kafka_payload_pool_new(KAFKA_PAYLOAD_POOL_MAX_FREE);
 
   g_mutex_init(&self->topics_lock);
 
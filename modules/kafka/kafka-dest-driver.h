@@ -27,6 +27,7 @@
 
 #include "logthrdest/logthrdestdrv.h"
 #include <librdkafka/rdkafka.h>
+#include "kafka-payload-pool.h"
 
 typedef struct
 {
@@ -49,6 +50,8 @@ typedef struct
   gint flush_timeout_on_reload;
   gint poll_timeout;
   gboolean transaction_inited;
+  gboolean produce_batch;
+  KafkaPayloadPool *payload_pool;
 } KafkaDestDriver;
 
 #define TOPIC_NAME_ERROR topic_name_error_quark()
@@ -75,6 +78,7 @@ void kafka_dd_set_flush_timeout_on_shutdown(LogDriver *d, gint shutdown_timeout)
 void kafka_dd_set_flush_timeout_on_reload(LogDriver *d, gint reload_timeout);
 void kafka_dd_set_poll_timeout(LogDriver *d, gint poll_timeout);
 void kafka_dd_set_transaction_commit(LogDriver *d, gboolean transaction_commit);
+void kafka_dd_set_produce_batch(LogDriver *d, gboolean produce_batch);
 
 gboolean kafka_dd_validate_topic_name(const gchar *name, GError **error);
 gboolean kafka_dd_is_topic_name_a_template(KafkaDestDriver *self);
@@ -241,6 +241,81 @@ _publish_message(KafkaDestWorker *self, LogMessage *msg)
   return TRUE;
 }
 
+static void
+_format_payload(KafkaDestWorker *self, LogMessage *msg, KafkaPayload *payload)
+{
+  KafkaDestDriver *owner = (KafkaDestDriver *) self->super.owner;
+
+  LogTemplateEvalOptions options = {&owner->template_options, LTZ_SEND, self->super.seq_num, NULL, LM_VT_STRING};
+  log_template_format(owner->message, msg, &options, payload->message);
+
+  if (owner->key)
+    log_template_format(owner->key, msg, &options, payload->key);
+}
+
+static void
+_queue_message(KafkaDestWorker *self, LogMessage *msg)
+{
+  KafkaDestDriver *owner = (KafkaDestDriver *) self->super.owner;
+  rd_kafka_topic_t *topic = kafka_dest_worker_calculate_topic(self, msg);
+  KafkaPayload *payload = kafka_payload_pool_acquire(owner->payload_pool);
+
+  _format_payload(self, msg, payload);
+  kafka_batch_append(self->pending_batch, topic, payload);
+}
+
+/* acks and drops the settled messages, keeping their backlog order */
+static void
+_account_settled_messages(KafkaDestWorker *self, gint settled)
+{
+  gint i = 0;
+
+  while (i < settled)
+    {
+      gboolean accepted = kafka_batch_get_message(self->pending_batch, i)->err == RD_KAFKA_RESP_ERR_NO_ERROR;
+      gint run = 1;
+
+      while (i + run < settled &&
+             (kafka_batch_get_message(self->pending_batch, i + run)->err == RD_KAFKA_RESP_ERR_NO_ERROR) == accepted)
+        run++;
+
+      if (accepted)
+        log_threaded_dest_worker_ack_messages(&self->super, run);
+      else
+        log_threaded_dest_worker_drop_messages(&self->super, run);
+      i += run;
+    }
+}
+
+static void
+_log_batch_errors(KafkaDestWorker *self, gint settled)
+{
+  KafkaDestDriver *owner = (KafkaDestDriver *) self->super.owner;
+  guint len = kafka_batch_get_length(self->pending_batch);
+
+  for (guint i = 0; i < len; i++)
+    {
+      rd_kafka_message_t *rkmessage = kafka_batch_get_message(self->pending_batch, i);
+
+      if ((gint) i >= settled || rkmessage->err != RD_KAFKA_RESP_ERR_NO_ERROR)
+        {
+          msg_error("kafka: failed to publish some messages of a batch",
+                    evt_tag_str("topic", rd_kafka_topic_name(rkmessage->rkt)),
+                    evt_tag_int("batch_size", len),
+                    evt_tag_int("settled", settled),
+                    evt_tag_str("error", rd_kafka_err2str(rkmessage->err)),
+                    evt_tag_str("driver", owner->super.super.super.id),
+                    log_pipe_location_tag(&owner->super.super.super.super));
+          return;
+        }
+    }
+
+  msg_debug("kafka: batch published",
+            evt_tag_int("batch_size", len),
+            evt_tag_str("driver", owner->super.super.super.id),
+            log_pipe_location_tag(&owner->super.super.super.super));
+}
+
 static void
 _update_drain_timer(KafkaDestWorker *self)
 {
@@ -363,10 +438,51 @@ kafka_dest_worker_transactional_flush(LogThreadedDestWorker *s, LogThreadedFlush
   return LTR_SUCCESS;
 }
 
+static LogThreadedResult
+kafka_dest_worker_batch_insert(LogThreadedDestWorker *s, LogMessage *msg)
+{
+  KafkaDestWorker *self = (KafkaDestWorker *)s;
+
+  _queue_message(self, msg);
+  _drain_responses(self);
+  return LTR_QUEUED;
+}
+
+static LogThreadedResult
+kafka_dest_worker_batch_flush(LogThreadedDestWorker *s, LogThreadedFlushMode expedite)
+{
+  KafkaDestWorker *self = (KafkaDestWorker *)s;
+  guint len = kafka_batch_get_length(self->pending_batch);
+
+  if (len == 0)
+    return LTR_SUCCESS;
+
+  log_threaded_dest_driver_insert_batch_length_stats(self->super.owner, len);
+
+  int block_flag = _is_poller_thread(self) ? 0 : RD_KAFKA_MSG_F_BLOCK;
+  gint settled = kafka_batch_produce(self->pending_batch, block_flag);
+
+  _log_batch_errors(self, settled);
+  _account_settled_messages(self, settled);
+  kafka_batch_clear(self->pending_batch);
+
+  _drain_responses(self);
+
+  /* the remaining batch_size covers the messages from the first one
+   * rejected with a full queue, which are rewound by the LTR_RETRY logic */
+  if ((guint) settled < len)
+    return LTR_RETRY;
+
+  return LTR_EXPLICIT_ACK_MGMT;
+}
+
 static void
 kafka_dest_worker_free(LogThreadedDestWorker *s)
 {
   KafkaDestWorker *self = (KafkaDestWorker *)s;
+
+  if (self->pending_batch)
+    kafka_batch_free(self->pending_batch);
   g_string_free(self->key, TRUE);
   g_string_free(self->message, TRUE);
   g_string_free(self->topic_name_buffer, TRUE);
@@ -436,6 +552,12 @@ _set_methods(KafkaDestWorker *self)
           self->super.insert = kafka_dest_worker_transactional_insert;
         }
     }
+  else if (owner->produce_batch)
+    {
+      self->super.insert = kafka_dest_worker_batch_insert;
+      self->super.flush = kafka_dest_worker_batch_flush;
+      self->pending_batch = kafka_batch_new(owner->payload_pool);
+    }
   else
     {
       self->super.insert = kafka_dest_worker_insert;
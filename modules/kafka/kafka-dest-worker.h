@@ -26,6 +26,7 @@
 #define KAFKA_DEST_WORKER_H_INCLUDED
 
 #include "logthrdest/logthrdestdrv.h"
+#include "kafka-batch.h"
 
 typedef struct _KafkaDestWorker
 {
@@ -34,6 +35,9 @@ typedef struct _KafkaDestWorker
   GString *key;
   GString *message;
   GString *topic_name_buffer;
+
+  /* produce-batch(yes) */
+  KafkaBatch *pending_batch;
 } KafkaDestWorker;
 
 LogThreadedDestWorker *kafka_dest_worker_new(LogThreadedDestDriver *owner, gint worker_index);
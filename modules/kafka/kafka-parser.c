@@ -42,6 +42,7 @@ static CfgLexerKeyword kafka_keywords[] =
   { "key",            KW_KEY },
   { "message",        KW_MESSAGE },
   { "sync_send",      KW_SYNC_SEND},
+  { "produce_batch",  KW_PRODUCE_BATCH },
   { "bootstrap_servers", KW_BOOTSTRAP_SERVERS },
   { "poll_timeout",   KW_POLL_TIMEOUT },
   { "kafka_c",        KW_KAFKA },   /* compatibility with incubator naming */
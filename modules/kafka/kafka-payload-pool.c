@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "kafka-payload-pool.h"
+
+#define KAFKA_PAYLOAD_INITIAL_MESSAGE_SIZE 1024
+#define KAFKA_PAYLOAD_INITIAL_KEY_SIZE 64
+
+/* buffers that grew beyond this are not kept around, so that a single
+ * huge message does not pin its memory forever */
+#define KAFKA_PAYLOAD_MAX_RETAINED_SIZE (64 * 1024)
+
+struct _KafkaPayloadPool
+{
+  GMutex lock;
+  GQueue free_list;
+  gsize max_free;
+};
+
+static KafkaPayload *
+_payload_new(void)
+{
+  KafkaPayload *self = g_new0(KafkaPayload, 1);
+
+  self->message = g_string_sized_new(KAFKA_PAYLOAD_INITIAL_MESSAGE_SIZE);
+  self->key = g_string_sized_new(KAFKA_PAYLOAD_INITIAL_KEY_SIZE);
+  return self;
+}
+
+static void
+_payload_free(KafkaPayload *self)
+{
+  g_string_free(self->message, TRUE);
+  g_string_free(self->key, TRUE);
+  g_free(self);
+}
+
+static gboolean
+_payload_is_reusable(KafkaPayload *self)
+{
+  return self->message->allocated_len <= KAFKA_PAYLOAD_MAX_RETAINED_SIZE &&
+         self->key->allocated_len <= KAFKA_PAYLOAD_MAX_RETAINED_SIZE;
+}
+
+KafkaPayload *
+kafka_payload_pool_acquire(KafkaPayloadPool *self)
+{
+  g_mutex_lock(&self->lock);
+  KafkaPayload *payload = g_queue_pop_head(&self->free_list);
+  g_mutex_unlock(&self->lock);
+
+  if (!payload)
+    return _payload_new();
+
+  g_string_truncate(payload->message, 0);
+  g_string_truncate(payload->key, 0);
+  return payload;
+}
+
+/* NOTE: called from the thread that runs rd_kafka_poll(), which is not
+ * necessarily the thread that acquired the payload */
+void
+kafka_payload_pool_release(KafkaPayloadPool *self, KafkaPayload *payload)
+{
+  if (_payload_is_reusable(payload))
+    {
+      g_mutex_lock(&self->lock);
+      if (self->free_list.length < self->max_free)
+        {
+          g_queue_push_head(&self->free_list, payload);
+          payload = NULL;
+        }
+      g_mutex_unlock(&self->lock);
+    }
+
+  if (payload)
+    _payload_free(payload);
+}
+
+gsize
+kafka_payload_pool_get_free_count(KafkaPayloadPool *self)
+{
+  g_mutex_lock(&self->lock);
+  gsize free_count = self->free_list.length;
+  g_mutex_unlock(&self->lock);
+
+  return free_count;
+}
+
+KafkaPayloadPool *
+kafka_payload_pool_new(gsize max_free)
+{
+  KafkaPayloadPool *self = g_new0(KafkaPayloadPool, 1);
+
+  g_mutex_init(&self->lock);
+  g_queue_init(&self->free_list);
+  self->max_free = max_free;
+  return self;
+}
+
+void
+kafka_payload_pool_free(KafkaPayloadPool *self)
+{
+  g_queue_foreach(&self->free_list, (GFunc) _payload_free, NULL);
+  g_queue_clear(&self->free_list);
+  g_mutex_clear(&self->lock);
+  g_free(self);
+}
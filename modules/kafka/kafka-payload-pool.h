@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef KAFKA_PAYLOAD_POOL_H_INCLUDED
+#define KAFKA_PAYLOAD_POOL_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/* A formatted message handed over to librdkafka without copying.  The
+ * buffers are owned by the pool: librdkafka references the payload until
+ * the delivery report arrives, at which point the entry is released back
+ * for reuse. */
+typedef struct _KafkaPayload
+{
+  GString *message;
+  GString *key;
+} KafkaPayload;
+
+typedef struct _KafkaPayloadPool KafkaPayloadPool;
+
+KafkaPayload *kafka_payload_pool_acquire(KafkaPayloadPool *self);
+void kafka_payload_pool_release(KafkaPayloadPool *self, KafkaPayload *payload);
+gsize kafka_payload_pool_get_free_count(KafkaPayloadPool *self);
+
+KafkaPayloadPool *kafka_payload_pool_new(gsize max_free);
+void kafka_payload_pool_free(KafkaPayloadPool *self);
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "kafka-batch.h"
+
+#define TOPIC_A ((rd_kafka_topic_t *) GINT_TO_POINTER(1))
+#define TOPIC_B ((rd_kafka_topic_t *) GINT_TO_POINTER(2))
+
+/* fake rd_kafka_produce_batch(): accepts the first N messages of each
+ * call, rejects the rest with the configured error */
+static struct
+{
+  gint calls;
+  rd_kafka_topic_t *topics[16];
+  gint accepted_per_call[16];
+  rd_kafka_resp_err_t error;
+  /* index of a message in the batch rejected with error_at_error */
+  gint error_at;
+  rd_kafka_resp_err_t error_at_error;
+} fake;
+
+static gint
+_fake_produce_batch(rd_kafka_topic_t *rkt, gint32 partition, gint msgflags,
+                    rd_kafka_message_t *rkmessages, gint message_cnt)
+{
+  gint call = fake.calls++;
+  gint accepted = 0;
+
+  fake.topics[call] = rkt;
+  for (gint i = 0; i < message_cnt; i++)
+    {
+      cr_assert_eq(rkmessages[i].rkt, rkt, "a produce call mixes topics");
+
+      if (GPOINTER_TO_INT(rkmessages[i].key) == fake.error_at)
+        rkmessages[i].err = fake.error_at_error;
+      else if (i >= fake.accepted_per_call[call])
+        rkmessages[i].err = fake.error;
+      else
+        accepted++;
+    }
+  return accepted;
+}
+
+static KafkaPayloadPool *pool;
+static KafkaBatch *batch;
+
+static void
+_append(rd_kafka_topic_t *topic, gint index)
+{
+  KafkaPayload *payload = kafka_payload_pool_acquire(pool);
+  g_string_printf(payload->message, "message%d", index);
+  kafka_batch_append(batch, topic, payload);
+
+  /* the key identifies the message for the fake */
+  kafka_batch_get_message(batch, index)->key = GINT_TO_POINTER(index);
+}
+
+static void
+setup(void)
+{
+  memset(&fake, 0, sizeof(fake));
+  fake.error = RD_KAFKA_RESP_ERR__QUEUE_FULL;
+  fake.error_at = -1;
+  for (gint i = 0; i < G_N_ELEMENTS(fake.accepted_per_call); i++)
+    fake.accepted_per_call[i] = G_MAXINT;
+
+  pool = kafka_payload_pool_new(64);
+  batch = kafka_batch_new(pool);
+  batch->produce = _fake_produce_batch;
+}
+
+static void
+teardown(void)
+{
+  kafka_batch_free(batch);
+  kafka_payload_pool_free(pool);
+}
+
+TestSuite(kafka_batch, .init = setup, .fini = teardown);
+
+Test(kafka_batch, consecutive_messages_of_a_topic_are_produced_together)
+{
+  _append(TOPIC_A, 0);
+  _append(TOPIC_A, 1);
+  _append(TOPIC_B, 2);
+  _append(TOPIC_A, 3);
+
+  cr_assert_eq(kafka_batch_produce(batch, 0), 4);
+  cr_assert_eq(fake.calls, 3);
+  cr_assert_eq(fake.topics[0], TOPIC_A);
+  cr_assert_eq(fake.topics[1], TOPIC_B);
+  cr_assert_eq(fake.topics[2], TOPIC_A);
+
+  /* every payload is owned by librdkafka now */
+  kafka_batch_clear(batch);
+  cr_assert_eq(kafka_payload_pool_get_free_count(pool), 0);
+}
+
+Test(kafka_batch, partial_acceptance_across_two_topics_settles_the_prefix_in_backlog_order)
+{
+  _append(TOPIC_A, 0);
+  _append(TOPIC_A, 1);
+  _append(TOPIC_B, 2);
+  _append(TOPIC_B, 3);
+  _append(TOPIC_A, 4);
+
+  /* topic A is fully accepted, topic B only accepts its first message */
+  fake.accepted_per_call[1] = 1;
+
+  gint settled = kafka_batch_produce(batch, 0);
+  cr_assert_eq(settled, 3, "messages up to the first full queue rejection should be settled");
+  for (gint i = 0; i < settled; i++)
+    cr_assert_eq(kafka_batch_get_message(batch, i)->err, RD_KAFKA_RESP_ERR_NO_ERROR);
+
+  /* the last message of topic A comes after the rejected one, it is not produced */
+  cr_assert_eq(fake.calls, 2);
+
+  /* the rejected and the not produced payloads are returned to the pool */
+  kafka_batch_clear(batch);
+  cr_assert_eq(kafka_payload_pool_get_free_count(pool), 2);
+  cr_assert_eq(kafka_batch_get_length(batch), 0);
+}
+
+Test(kafka_batch, first_message_rejected_with_full_queue_settles_nothing)
+{
+  _append(TOPIC_B, 0);
+  _append(TOPIC_A, 1);
+
+  fake.accepted_per_call[0] = 0;
+
+  cr_assert_eq(kafka_batch_produce(batch, 0), 0);
+  cr_assert_eq(fake.calls, 1);
+
+  kafka_batch_clear(batch);
+  cr_assert_eq(kafka_payload_pool_get_free_count(pool), 2);
+}
+
+Test(kafka_batch, non_retriable_rejections_are_settled_in_place)
+{
+  _append(TOPIC_A, 0);
+  _append(TOPIC_A, 1);
+  _append(TOPIC_B, 2);
+
+  fake.error_at = 1;
+  fake.error_at_error = RD_KAFKA_RESP_ERR_MSG_SIZE_TOO_LARGE;
+
+  cr_assert_eq(kafka_batch_produce(batch, 0), 3);
+  cr_assert_eq(fake.calls, 2);
+  cr_assert_eq(kafka_batch_get_message(batch, 0)->err, RD_KAFKA_RESP_ERR_NO_ERROR);
+  cr_assert_eq(kafka_batch_get_message(batch, 1)->err, RD_KAFKA_RESP_ERR_MSG_SIZE_TOO_LARGE);
+  cr_assert_eq(kafka_batch_get_message(batch, 2)->err, RD_KAFKA_RESP_ERR_NO_ERROR);
+
+  kafka_batch_clear(batch);
+  cr_assert_eq(kafka_payload_pool_get_free_count(pool), 1);
+}
+
+Test(kafka_batch, retriable_rejection_after_a_dropped_message_keeps_the_drop_settled)
+{
+  _append(TOPIC_A, 0);
+  _append(TOPIC_A, 1);
+  _append(TOPIC_A, 2);
+
+  fake.error_at = 0;
+  fake.error_at_error = RD_KAFKA_RESP_ERR_MSG_SIZE_TOO_LARGE;
+  fake.accepted_per_call[0] = 2;
+
+  cr_assert_eq(kafka_batch_produce(batch, 0), 2);
+  cr_assert_eq(kafka_batch_get_message(batch, 0)->err, RD_KAFKA_RESP_ERR_MSG_SIZE_TOO_LARGE);
+  cr_assert_eq(kafka_batch_get_message(batch, 1)->err, RD_KAFKA_RESP_ERR_NO_ERROR);
+  cr_assert_eq(kafka_batch_get_message(batch, 2)->err, RD_KAFKA_RESP_ERR__QUEUE_FULL);
+}
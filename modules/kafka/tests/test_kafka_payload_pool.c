@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "kafka-payload-pool.h"
+
+Test(kafka_payload_pool, released_payloads_are_reused)
+{
+  KafkaPayloadPool *pool = kafka_payload_pool_new(16);
+
+  KafkaPayload *payload = kafka_payload_pool_acquire(pool);
+  g_string_assign(payload->message, "message");
+  g_string_assign(payload->key, "key");
+  kafka_payload_pool_release(pool, payload);
+  cr_assert_eq(kafka_payload_pool_get_free_count(pool), 1);
+
+  KafkaPayload *reused = kafka_payload_pool_acquire(pool);
+  cr_assert_eq(reused, payload);
+  cr_assert_eq(reused->message->len, 0, "reused payload should be truncated");
+  cr_assert_eq(reused->key->len, 0, "reused key should be truncated");
+  cr_assert_eq(kafka_payload_pool_get_free_count(pool), 0);
+
+  kafka_payload_pool_release(pool, reused);
+  kafka_payload_pool_free(pool);
+}
+
+Test(kafka_payload_pool, number_of_idle_payloads_is_bounded)
+{
+  KafkaPayloadPool *pool = kafka_payload_pool_new(2);
+  KafkaPayload *payloads[4];
+
+  for (gint i = 0; i < G_N_ELEMENTS(payloads); i++)
+    payloads[i] = kafka_payload_pool_acquire(pool);
+
+  for (gint i = 0; i < G_N_ELEMENTS(payloads); i++)
+    kafka_payload_pool_release(pool, payloads[i]);
+
+  cr_assert_eq(kafka_payload_pool_get_free_count(pool), 2);
+  kafka_payload_pool_free(pool);
+}
+
+Test(kafka_payload_pool, oversized_payloads_are_not_retained)
+{
+  KafkaPayloadPool *pool = kafka_payload_pool_new(16);
+
+  KafkaPayload *payload = kafka_payload_pool_acquire(pool);
+  g_string_set_size(payload->message, 1024 * 1024);
+  kafka_payload_pool_release(pool, payload);
+
+  cr_assert_eq(kafka_payload_pool_get_free_count(pool), 0);
+  kafka_payload_pool_free(pool);
+}
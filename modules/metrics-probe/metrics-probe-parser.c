@@ -35,6 +35,7 @@ static CfgLexerKeyword metrics_probe_keywords[] =
   { "labels",                      KW_LABELS },
   { "increment",                   KW_INCREMENT },
   { "level",                       KW_LEVEL },
+  { "max_series",                  KW_MAX_SERIES },
   { NULL }
 };
 
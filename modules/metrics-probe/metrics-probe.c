@@ -101,9 +101,9 @@ _process(LogParser *s, LogMessage **pmsg, const LogPathOptions *path_options, co
   if (!dyn_metrics_template_is_enabled(self->metrics_template))
     return TRUE;
 
-  StatsCounterItem *counter = dyn_metrics_template_get_stats_counter(self->metrics_template,
-                              &self->template_options, *pmsg);
   gssize increment = _calculate_increment(self, *pmsg);
+  StatsCounterItem *counter = dyn_metrics_template_get_stats_counter(self->metrics_template,
+                              &self->template_options, *pmsg, increment);
   stats_counter_add(counter, increment);
 
   return TRUE;
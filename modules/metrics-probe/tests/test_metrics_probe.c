@@ -26,6 +26,7 @@
 #include "metrics-probe-test.h"
 #include "apphook.h"
 #include "stats/stats-cluster-single.h"
+#include "metrics/dyn-metrics-cache.h"
 
 static void
 _add_label(LogParser *s, const gchar *label, const gchar *value_template_str)
@@ -349,6 +350,203 @@ Test(metrics_probe, test_metrics_probe_dynamic_labels)
   log_pipe_unref(&metrics_probe->super);
 }
 
+static void
+_process_with_test_field(LogParser *metrics_probe, const gchar *value)
+{
+  LogMessage *msg = log_msg_new_empty();
+  log_msg_set_value_by_name(msg, "test_field", value, -1);
+  cr_assert(log_parser_process(metrics_probe, &msg, NULL, "", -1), "Failed to apply metrics-probe");
+  log_msg_unref(msg);
+}
+
+/* the metrics of the limiter are not dynamic */
+static gsize
+_get_limiter_metric_value(const gchar *name)
+{
+  StatsClusterLabel labels[] = { stats_cluster_label("metric", "custom_key") };
+  StatsClusterKey sc_key;
+  stats_cluster_single_key_set(&sc_key, name, labels, G_N_ELEMENTS(labels));
+
+  stats_lock();
+  StatsCounterItem *counter = stats_get_counter(&sc_key, SC_TYPE_SINGLE_VALUE);
+  cr_assert(counter, "Limiter metric does not exist: %s", name);
+  gsize value = stats_counter_get(counter);
+  stats_unlock();
+
+  return value;
+}
+
+Test(metrics_probe, test_metrics_probe_max_series)
+{
+  LogParser *tmp_metrics_probe = metrics_probe_new(configuration);
+  dyn_metrics_template_set_key(metrics_probe_get_metrics_template(tmp_metrics_probe), "custom_key");
+  dyn_metrics_template_set_max_series(metrics_probe_get_metrics_template(tmp_metrics_probe), 2);
+  _add_label(tmp_metrics_probe, "test_label", "${test_field}");
+
+  LogParser *metrics_probe = (LogParser *) log_pipe_clone(&tmp_metrics_probe->super);
+  log_pipe_unref(&tmp_metrics_probe->super);
+  cr_assert(log_pipe_init(&metrics_probe->super), "Failed to init metrics-probe");
+
+  StatsClusterLabel labels_a[] = { stats_cluster_label("test_label", "a") };
+  StatsClusterLabel labels_b[] = { stats_cluster_label("test_label", "b") };
+  StatsClusterLabel labels_c[] = { stats_cluster_label("test_label", "c") };
+  StatsClusterLabel overflow_labels[] = { stats_cluster_label("overflow", "true") };
+
+  for (gint i = 0; i < 3; i++)
+    _process_with_test_field(metrics_probe, "a");
+  _process_with_test_field(metrics_probe, "b");
+
+  metrics_probe_test_assert_counter_value("custom_key", labels_a, G_N_ELEMENTS(labels_a), 3);
+  metrics_probe_test_assert_counter_value("custom_key", labels_b, G_N_ELEMENTS(labels_b), 1);
+  metrics_probe_test_assert_counter_value("custom_key", overflow_labels, G_N_ELEMENTS(overflow_labels), 0);
+  cr_assert_eq(_get_limiter_metric_value("dynamic_metric_series"), 2);
+
+  /* not more frequent than "b" yet */
+  _process_with_test_field(metrics_probe, "c");
+  cr_assert_not(metrics_probe_test_stats_cluster_exists("custom_key", labels_c, G_N_ELEMENTS(labels_c)));
+  metrics_probe_test_assert_counter_value("custom_key", overflow_labels, G_N_ELEMENTS(overflow_labels), 1);
+
+  /* "c" takes the place of "b" */
+  _process_with_test_field(metrics_probe, "c");
+  _process_with_test_field(metrics_probe, "c");
+  metrics_probe_test_assert_counter_value("custom_key", labels_c, G_N_ELEMENTS(labels_c), 2);
+  metrics_probe_test_assert_counter_value("custom_key", overflow_labels, G_N_ELEMENTS(overflow_labels), 1);
+  cr_assert_eq(_get_limiter_metric_value("dynamic_metric_series"), 2);
+
+  /* "b" is counted in the overflow series from now on */
+  _process_with_test_field(metrics_probe, "b");
+  metrics_probe_test_assert_counter_value("custom_key", overflow_labels, G_N_ELEMENTS(overflow_labels), 2);
+  metrics_probe_test_assert_counter_value("custom_key", labels_b, G_N_ELEMENTS(labels_b), 1);
+  metrics_probe_test_assert_counter_value("custom_key", labels_a, G_N_ELEMENTS(labels_a), 3);
+  cr_assert_gt(_get_limiter_metric_value("dynamic_metric_memory_bytes"), 0);
+
+  log_pipe_deinit(&metrics_probe->super);
+  log_pipe_unref(&metrics_probe->super);
+}
+
+static LogParser *
+_create_metrics_probe(const gchar *key, gsize max_series)
+{
+  LogParser *tmp_metrics_probe = metrics_probe_new(configuration);
+  dyn_metrics_template_set_key(metrics_probe_get_metrics_template(tmp_metrics_probe), key);
+  dyn_metrics_template_set_max_series(metrics_probe_get_metrics_template(tmp_metrics_probe), max_series);
+  _add_label(tmp_metrics_probe, "test_label", "${test_field}");
+
+  LogParser *metrics_probe = (LogParser *) log_pipe_clone(&tmp_metrics_probe->super);
+  log_pipe_unref(&tmp_metrics_probe->super);
+  cr_assert(log_pipe_init(&metrics_probe->super), "Failed to init metrics-probe");
+  return metrics_probe;
+}
+
+static gboolean
+_is_cached(const gchar *key, StatsClusterLabel *labels, gsize labels_len)
+{
+  StatsClusterKey sc_key;
+  stats_cluster_single_key_set(&sc_key, key, labels, labels_len);
+
+  return dyn_metrics_store_lookup_counter(dyn_metrics_cache(), &sc_key) != NULL;
+}
+
+Test(metrics_probe, test_metrics_probe_demotion_keeps_the_cached_series_of_other_metrics)
+{
+  LogParser *limited_metrics_probe = _create_metrics_probe("custom_key", 2);
+  LogParser *other_metrics_probe = _create_metrics_probe("other_key", 0);
+
+  StatsClusterLabel labels_a[] = { stats_cluster_label("test_label", "a") };
+  StatsClusterLabel labels_b[] = { stats_cluster_label("test_label", "b") };
+
+  _process_with_test_field(other_metrics_probe, "a");
+  for (gint i = 0; i < 3; i++)
+    _process_with_test_field(limited_metrics_probe, "a");
+  _process_with_test_field(limited_metrics_probe, "b");
+  cr_assert(_is_cached("custom_key", labels_b, G_N_ELEMENTS(labels_b)));
+
+  /* "c" takes the place of "b" */
+  _process_with_test_field(limited_metrics_probe, "c");
+  _process_with_test_field(limited_metrics_probe, "c");
+
+  /* the next access of the limited metric drops its cached series */
+  _process_with_test_field(limited_metrics_probe, "a");
+  cr_assert_not(_is_cached("custom_key", labels_b, G_N_ELEMENTS(labels_b)));
+  cr_assert(_is_cached("custom_key", labels_a, G_N_ELEMENTS(labels_a)));
+  cr_assert(_is_cached("other_key", labels_a, G_N_ELEMENTS(labels_a)));
+
+  _process_with_test_field(other_metrics_probe, "a");
+  metrics_probe_test_assert_counter_value("other_key", labels_a, G_N_ELEMENTS(labels_a), 2);
+
+  log_pipe_deinit(&limited_metrics_probe->super);
+  log_pipe_unref(&limited_metrics_probe->super);
+  log_pipe_deinit(&other_metrics_probe->super);
+  log_pipe_unref(&other_metrics_probe->super);
+}
+
+Test(metrics_probe, test_metrics_probe_max_series_overflowed_labels_are_promoted_on_time)
+{
+  LogParser *metrics_probe = _create_metrics_probe("custom_key", 2);
+
+  StatsClusterLabel labels_c[] = { stats_cluster_label("test_label", "c") };
+  StatsClusterLabel overflow_labels[] = { stats_cluster_label("overflow", "true") };
+
+  for (gint i = 0; i < 5; i++)
+    _process_with_test_field(metrics_probe, "a");
+  for (gint i = 0; i < 3; i++)
+    _process_with_test_field(metrics_probe, "b");
+
+  /* the overflowed "c" skips the limiter until it could overtake "b" */
+  for (gint i = 0; i < 3; i++)
+    _process_with_test_field(metrics_probe, "c");
+  cr_assert_not(metrics_probe_test_stats_cluster_exists("custom_key", labels_c, G_N_ELEMENTS(labels_c)));
+  metrics_probe_test_assert_counter_value("custom_key", overflow_labels, G_N_ELEMENTS(overflow_labels), 3);
+
+  _process_with_test_field(metrics_probe, "c");
+  metrics_probe_test_assert_counter_value("custom_key", labels_c, G_N_ELEMENTS(labels_c), 1);
+  metrics_probe_test_assert_counter_value("custom_key", overflow_labels, G_N_ELEMENTS(overflow_labels), 3);
+
+  log_pipe_deinit(&metrics_probe->super);
+  log_pipe_unref(&metrics_probe->super);
+}
+
+static void
+_process_with_test_field_and_increment(LogParser *metrics_probe, const gchar *value, const gchar *increment)
+{
+  LogMessage *msg = log_msg_new_empty();
+  log_msg_set_value_by_name(msg, "test_field", value, -1);
+  log_msg_set_value_by_name(msg, "custom_increment", increment, -1);
+  cr_assert(log_parser_process(metrics_probe, &msg, NULL, "", -1), "Failed to apply metrics-probe");
+  log_msg_unref(msg);
+}
+
+Test(metrics_probe, test_metrics_probe_max_series_negative_increment)
+{
+  LogParser *tmp_metrics_probe = metrics_probe_new(configuration);
+  dyn_metrics_template_set_key(metrics_probe_get_metrics_template(tmp_metrics_probe), "custom_key");
+  dyn_metrics_template_set_max_series(metrics_probe_get_metrics_template(tmp_metrics_probe), 1);
+  _add_label(tmp_metrics_probe, "test_label", "${test_field}");
+  LogTemplate *increment_template = log_template_new(tmp_metrics_probe->super.cfg, NULL);
+  log_template_compile(increment_template, "${custom_increment}", NULL);
+  metrics_probe_set_increment_template(tmp_metrics_probe, increment_template);
+  log_template_unref(increment_template);
+
+  LogParser *metrics_probe = (LogParser *) log_pipe_clone(&tmp_metrics_probe->super);
+  log_pipe_unref(&tmp_metrics_probe->super);
+  cr_assert(log_pipe_init(&metrics_probe->super), "Failed to init metrics-probe");
+
+  StatsClusterLabel labels_b[] = { stats_cluster_label("test_label", "b") };
+  StatsClusterLabel overflow_labels[] = { stats_cluster_label("overflow", "true") };
+
+  /* takes the counter of "a" below its value at the promotion */
+  _process_with_test_field_and_increment(metrics_probe, "a", "1");
+  _process_with_test_field_and_increment(metrics_probe, "a", "-5");
+
+  /* "a" has no frequency left, "b" takes its place right away */
+  _process_with_test_field_and_increment(metrics_probe, "b", "1");
+  metrics_probe_test_assert_counter_value("custom_key", labels_b, G_N_ELEMENTS(labels_b), 1);
+  metrics_probe_test_assert_counter_value("custom_key", overflow_labels, G_N_ELEMENTS(overflow_labels), 0);
+
+  log_pipe_deinit(&metrics_probe->super);
+  log_pipe_unref(&metrics_probe->super);
+}
+
 void setup(void)
 {
   app_startup();
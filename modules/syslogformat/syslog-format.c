@@ -39,8 +39,15 @@
 #include <regex.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define SD_NAME_SIZE 256
 
+/* HOSTNAME, APP-NAME, PROCID and MSGID with their separators, see RFC5424 */
+#define RFC5424_HEADER_COLUMNS_MAX_LEN (255 + 48 + 128 + 32 + 4)
+
 static const char aix_fwd_string[] = "Message forwarded from ";
 static const char repeat_msg_string[] = "last message repeated";
 static struct
@@ -118,6 +125,43 @@ _skip_chars_until(const guchar **data, gint *length, const gchar *delims)
   return num_skipped;
 }
 
+/*
+ * Collects the positions of the first @max_delims occurrences of @delim
+ * within the first @length bytes of @src and returns the number of
+ * delimiters found.  Header fields are separated by single characters, so
+ * locating all of them in one pass (16 bytes at a time where SSE2 is
+ * available) is cheaper than advancing through the fields char-by-char.
+ */
+static gint
+_find_delimiters(const guchar *src, gint length, guchar delim, const guchar **delims, gint max_delims)
+{
+  gint found = 0;
+  gint i = 0;
+
+#if defined(__SSE2__)
+  const __m128i needle = _mm_set1_epi8((gchar) delim);
+
+  for (; i + 16 <= length && found < max_delims; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *) (src + i));
+      guint mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+
+      while (mask && found < max_delims)
+        {
+          delims[found++] = src + i + g_bit_nth_lsf(mask, -1);
+          mask &= mask - 1;
+        }
+    }
+#endif
+
+  for (; i < length && found < max_delims; i++)
+    {
+      if (src[i] == delim)
+        delims[found++] = src + i;
+    }
+  return found;
+}
+
 static gboolean
 _syslog_format_parse_pri(LogMessage *msg, const guchar **data, gint *length, guint flags, guint16 default_pri)
 {
@@ -160,6 +204,15 @@ _syslog_format_parse_pri(LogMessage *msg, const guchar **data, gint *length, gui
   return success;
 }
 
+static inline void
+_syslog_format_set_column_value(LogMessage *msg, NVHandle handle, const guchar *value, gint value_len,
+                                gint max_length)
+{
+  /* "-" is the NILVALUE */
+  if (value_len > 1 || value[0] != '-')
+    log_msg_set_value(msg, handle, (gchar *) value, MIN(value_len, max_length));
+}
+
 static void
 _syslog_format_parse_column(LogMessage *msg, NVHandle handle, const guchar **data, gint *length, gint max_length)
 {
@@ -180,13 +233,7 @@ _syslog_format_parse_column(LogMessage *msg, NVHandle handle, const guchar **dat
       left = 0;
     }
   if (left)
-    {
-      if ((*length - left) > 1 || (*data)[0] != '-')
-        {
-          gint len = (*length - left) > max_length ? max_length : (*length - left);
-          log_msg_set_value(msg, handle, (gchar *) *data, len);
-        }
-    }
+    _syslog_format_set_column_value(msg, handle, *data, *length - left, max_length);
   *data = src;
   *length = left;
 }
@@ -478,6 +525,66 @@ ipv6_heuristics_feed_gchar(IPv6Heuristics *self, gchar c)
   return TRUE;
 }
 
+/*
+ * A hostname is plain if it can be accepted without running it through the
+ * char-by-char parser below: it contains neither '[' nor ':' (which need the
+ * IPv6 heuristics to tell an address from a program name), and if
+ * check-hostname() is enabled, only valid characters.
+ */
+static gboolean
+_is_plain_hostname(const guchar *hostname, gint hostname_len, guint flags)
+{
+  if (hostname_len > 255)
+    return FALSE;
+
+  if (memchr(hostname, '[', hostname_len) || memchr(hostname, ':', hostname_len))
+    return FALSE;
+
+  if (flags & LP_CHECK_HOSTNAME)
+    {
+      for (gint i = 0; i < hostname_len; i++)
+        {
+          if (_is_invalid_hostname_char(hostname[i]))
+            return FALSE;
+        }
+    }
+  return TRUE;
+}
+
+static gboolean
+_is_bad_hostname(const guchar *hostname, gint hostname_len, regex_t *bad_hostname)
+{
+  gchar hostname_buf[256];
+
+  if (!bad_hostname)
+    return FALSE;
+
+  memcpy(hostname_buf, hostname, hostname_len);
+  hostname_buf[hostname_len] = 0;
+  return regexec(bad_hostname, hostname_buf, 0, NULL, 0) == 0;
+}
+
+static gboolean
+_syslog_format_parse_hostname_fast(const guchar **data, gint *length,
+                                   const guchar **hostname_start, int *hostname_len,
+                                   guint flags, regex_t *bad_hostname)
+{
+  const guchar *space;
+
+  if (_find_delimiters(*data, MIN(*length, 256), ' ', &space, 1) == 0)
+    return FALSE;
+
+  gint len = space - *data;
+  if (!_is_plain_hostname(*data, len, flags) || _is_bad_hostname(*data, len, bad_hostname))
+    return FALSE;
+
+  *hostname_start = *data;
+  *hostname_len = len;
+  *data = space;
+  *length -= len;
+  return TRUE;
+}
+
 static void
 _syslog_format_parse_hostname(LogMessage *msg, const guchar **data, gint *length,
                               const guchar **hostname_start, int *hostname_len,
@@ -491,6 +598,9 @@ _syslog_format_parse_hostname(LogMessage *msg, const guchar **data, gint *length
 
   IPv6Heuristics ipv6_heuristics = {0};
 
+  if (_syslog_format_parse_hostname_fast(data, length, hostname_start, hostname_len, flags, bad_hostname))
+    return;
+
   src = *data;
   left = *length;
 
@@ -1077,6 +1187,89 @@ _syslog_format_parse_legacy(const MsgFormatOptions *parse_options,
   return TRUE;
 }
 
+/*
+ * Fast path for the HOSTNAME SP APP-NAME SP PROCID SP MSGID SP part of
+ * well-formed RFC5424 headers: the four separators are located in a single
+ * pass.  Returns FALSE without touching @msg if anything is unusual, in
+ * which case the regular, column-by-column parser takes over.
+ */
+static gboolean
+_syslog_format_parse_rfc5424_columns_fast(LogMessage *msg, const guchar **data, gint *length, guint flags)
+{
+  const guchar *src = *data;
+  const guchar *delims[4];
+
+  if (_find_delimiters(src, MIN(*length, RFC5424_HEADER_COLUMNS_MAX_LEN), ' ', delims, 4) < 4)
+    return FALSE;
+
+  gint hostname_len = delims[0] - src;
+  if (hostname_len == 0 || !_is_plain_hostname(src, hostname_len, flags))
+    return FALSE;
+
+  if (hostname_len != 1 || src[0] != '-')
+    log_msg_set_value(msg, LM_V_HOST, (gchar *) src, hostname_len);
+
+  _syslog_format_set_column_value(msg, LM_V_PROGRAM, delims[0] + 1, delims[1] - delims[0] - 1, 48);
+  _syslog_format_set_column_value(msg, LM_V_PID, delims[1] + 1, delims[2] - delims[1] - 1, 128);
+  _syslog_format_set_column_value(msg, LM_V_MSGID, delims[2] + 1, delims[3] - delims[2] - 1, 32);
+
+  *length -= delims[3] + 1 - src;
+  *data = delims[3] + 1;
+  return TRUE;
+}
+
+/* HOSTNAME SP APP-NAME SP PROCID SP MSGID SP */
+static gboolean
+_syslog_format_parse_rfc5424_columns(LogMessage *msg, const guchar **data, gint *length, guint flags)
+{
+  const guchar *hostname_start = NULL;
+  gint hostname_len = 0;
+
+  if (_syslog_format_parse_rfc5424_columns_fast(msg, data, length, flags))
+    return TRUE;
+
+  /* hostname 255 ascii */
+  _syslog_format_parse_hostname(msg, data, length, &hostname_start, &hostname_len, flags, NULL);
+  if (!_skip_space(data, length))
+    {
+      (*data)++;
+      log_msg_set_tag_by_id(msg, LM_T_SYSLOG_RFC5424_MISSING_APP_NAME);
+      return FALSE;
+    }
+  /* If we did manage to find a hostname, store it. */
+  if (hostname_start && hostname_len == 1 && *hostname_start == '-')
+    ;
+  else if (hostname_start)
+    {
+      log_msg_set_value(msg, LM_V_HOST, (gchar *) hostname_start, hostname_len);
+    }
+
+  /* application name 48 ascii*/
+  _syslog_format_parse_column(msg, LM_V_PROGRAM, data, length, 48);
+  if (!_skip_space(data, length))
+    {
+      log_msg_set_tag_by_id(msg, LM_T_SYSLOG_RFC5424_MISSING_PROCID);
+      return FALSE;
+    }
+
+  /* process id 128 ascii */
+  _syslog_format_parse_column(msg, LM_V_PID, data, length, 128);
+  if (!_skip_space(data, length))
+    {
+      log_msg_set_tag_by_id(msg, LM_T_SYSLOG_RFC5424_MISSING_MSGID);
+      return FALSE;
+    }
+
+  /* message id 32 ascii */
+  _syslog_format_parse_column(msg, LM_V_MSGID, data, length, 32);
+  if (!_skip_space(data, length))
+    {
+      log_msg_set_tag_by_id(msg, LM_T_SYSLOG_RFC5424_MISSING_SDATA);
+      return FALSE;
+    }
+  return TRUE;
+}
+
 /**
  * _syslog_format_parse_syslog_proto:
  *
@@ -1099,8 +1292,6 @@ _syslog_format_parse_syslog_proto(const MsgFormatOptions *parse_options, const g
 
   const guchar *src;
   gint left;
-  const guchar *hostname_start = NULL;
-  gint hostname_len = 0;
 
   src = (guchar *) data;
   left = length;
@@ -1132,45 +1323,8 @@ _syslog_format_parse_syslog_proto(const MsgFormatOptions *parse_options, const g
       goto error;
     }
 
-  /* hostname 255 ascii */
-  _syslog_format_parse_hostname(msg, &src, &left, &hostname_start, &hostname_len, parse_options->flags, NULL);
-  if (!_skip_space(&src, &left))
-    {
-      src++;
-      log_msg_set_tag_by_id(msg, LM_T_SYSLOG_RFC5424_MISSING_APP_NAME);
-      goto error;
-    }
-  /* If we did manage to find a hostname, store it. */
-  if (hostname_start && hostname_len == 1 && *hostname_start == '-')
-    ;
-  else if (hostname_start)
-    {
-      log_msg_set_value(msg, LM_V_HOST, (gchar *) hostname_start, hostname_len);
-    }
-
-  /* application name 48 ascii*/
-  _syslog_format_parse_column(msg, LM_V_PROGRAM, &src, &left, 48);
-  if (!_skip_space(&src, &left))
-    {
-      log_msg_set_tag_by_id(msg, LM_T_SYSLOG_RFC5424_MISSING_PROCID);
-      goto error;
-    }
-
-  /* process id 128 ascii */
-  _syslog_format_parse_column(msg, LM_V_PID, &src, &left, 128);
-  if (!_skip_space(&src, &left))
-    {
-      log_msg_set_tag_by_id(msg, LM_T_SYSLOG_RFC5424_MISSING_MSGID);
-      goto error;
-    }
-
-  /* message id 32 ascii */
-  _syslog_format_parse_column(msg, LM_V_MSGID, &src, &left, 32);
-  if (!_skip_space(&src, &left))
-    {
-      log_msg_set_tag_by_id(msg, LM_T_SYSLOG_RFC5424_MISSING_SDATA);
-      goto error;
-    }
+  if (!_syslog_format_parse_rfc5424_columns(msg, &src, &left, parse_options->flags))
+    goto error;
 
   /* structured data part */
   if (!_syslog_format_parse_sd_column(msg, &src, &left, parse_options))
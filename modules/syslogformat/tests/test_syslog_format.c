@@ -532,3 +532,87 @@ Test(syslog_format, test_framing_not_detected_on_input_starting_with_whitespace)
 
   log_msg_unref(msg);
 }
+
+static LogMessage *
+_parse_message(const gchar *data, guint flags)
+{
+  LogMessage *msg = log_msg_new_empty();
+  gsize problem_position;
+  guint saved_flags = parse_options.flags;
+
+  parse_options.flags |= flags;
+  cr_assert(syslog_format_handler(&parse_options, msg, (const guchar *) data, strlen(data), &problem_position),
+            "parsing failed: %s", data);
+  parse_options.flags = saved_flags;
+  return msg;
+}
+
+Test(syslog_format, rfc5424_header_columns_with_plain_and_ipv6_hostnames)
+{
+  const gchar *hostnames[] = { "mymachine.example.com", "fe80::1", "2001:db8::ff00:42:8329" };
+
+  for (gint i = 0; i < G_N_ELEMENTS(hostnames); i++)
+    {
+      gchar *data = g_strdup_printf("<165>1 2003-10-11T22:14:15.003Z %s evntslog 1234 ID47 - message", hostnames[i]);
+      LogMessage *msg = _parse_message(data, LP_SYSLOG_PROTOCOL);
+
+      assert_log_message_value_by_name(msg, "HOST", hostnames[i]);
+      assert_log_message_value_by_name(msg, "PROGRAM", "evntslog");
+      assert_log_message_value_by_name(msg, "PID", "1234");
+      assert_log_message_value_by_name(msg, "MSGID", "ID47");
+      assert_log_message_value_by_name(msg, "MSG", "message");
+
+      log_msg_unref(msg);
+      g_free(data);
+    }
+}
+
+Test(syslog_format, rfc5424_header_columns_nil_empty_and_overlong_values)
+{
+  gchar long_app_name[65];
+
+  memset(long_app_name, 'a', sizeof(long_app_name) - 1);
+  long_app_name[sizeof(long_app_name) - 1] = 0;
+
+  gchar *data = g_strdup_printf("<165>1 2003-10-11T22:14:15.003Z - %s -  - message", long_app_name);
+  LogMessage *msg = _parse_message(data, LP_SYSLOG_PROTOCOL);
+
+  assert_log_message_value_by_name(msg, "HOST", "");
+  assert_log_message_value_by_name(msg, "PROGRAM", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa");
+  assert_log_message_value_by_name(msg, "PID", "");
+  assert_log_message_value_by_name(msg, "MSGID", "");
+  assert_log_message_value_by_name(msg, "MSG", "message");
+
+  log_msg_unref(msg);
+  g_free(data);
+}
+
+Test(syslog_format, rfc5424_header_columns_missing_msgid_is_an_error)
+{
+  const gchar *data = "<165>1 2003-10-11T22:14:15.003Z host app pid";
+  LogMessage *msg = log_msg_new_empty();
+  gsize problem_position;
+
+  parse_options.flags |= LP_SYSLOG_PROTOCOL | LP_NO_RFC3164_FALLBACK;
+  cr_assert_not(syslog_format_handler(&parse_options, msg, (const guchar *) data, strlen(data), &problem_position));
+  cr_assert(log_msg_is_tag_by_id(msg, LM_T_SYSLOG_RFC5424_MISSING_MSGID));
+
+  log_msg_unref(msg);
+}
+
+Test(syslog_format, rfc3164_hostname_with_check_hostname)
+{
+  LogMessage *msg = _parse_message("<13>Feb  3 12:34:56 host.example.com program[1234]: message", LP_CHECK_HOSTNAME);
+  assert_log_message_value_by_name(msg, "HOST", "host.example.com");
+  assert_log_message_value_by_name(msg, "PROGRAM", "program");
+  log_msg_unref(msg);
+
+  msg = _parse_message("<13>Feb  3 12:34:56 ho$t program[1234]: message", LP_CHECK_HOSTNAME);
+  cr_assert(log_msg_is_tag_by_id(msg, LM_T_SYSLOG_INVALID_HOSTNAME));
+  log_msg_unref(msg);
+
+  msg = _parse_message("<13>Feb  3 12:34:56 program[1234]: message", 0);
+  assert_log_message_value_by_name(msg, "PROGRAM", "program");
+  assert_log_message_value_by_name(msg, "PID", "1234");
+  log_msg_unref(msg);
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2022 One Identity
+ * Copyright (c) 2022 László Várady
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/stopwatch.h"
+
+#include "apphook.h"
+#include "cfg.h"
+#include "syslog-format.h"
+#include "logmsg/logmsg.h"
+#include "msg-format.h"
+
+#include <string.h>
+
+static GlobalConfig *cfg;
+static MsgFormatOptions parse_options;
+
+static void
+setup(void)
+{
+  app_startup();
+  syslog_format_init();
+
+  cfg = cfg_new_snippet();
+  msg_format_options_defaults(&parse_options);
+  msg_format_options_init(&parse_options, cfg);
+}
+
+static void
+teardown(void)
+{
+  msg_format_options_destroy(&parse_options);
+  app_shutdown();
+  cfg_free(cfg);
+}
+
+TestSuite(syslog_format_speed, .init = setup, .fini = teardown);
+
+/*
+ * Benchmark corpus: loggen style messages, with hostnames that are either
+ * accepted by the single pass delimiter scan or need the char-by-char
+ * parser (IPv6 addresses).
+ */
+#define PARSER_BENCHMARK_COUNT 100000
+
+static void
+_benchmark_parser(const gchar *path, const gchar *data, guint flags)
+{
+  gsize data_length = strlen(data);
+  gsize problem_position;
+  guint saved_flags = parse_options.flags;
+
+  parse_options.flags |= flags;
+  start_stopwatch();
+  for (gint i = 0; i < PARSER_BENCHMARK_COUNT; i++)
+    {
+      LogMessage *msg = log_msg_new_empty();
+      syslog_format_handler(&parse_options, msg, (const guchar *) data, data_length, &problem_position);
+      log_msg_unref(msg);
+    }
+  stop_stopwatch_and_display_result(PARSER_BENCHMARK_COUNT, "      %-40s", path);
+  parse_options.flags = saved_flags;
+}
+
+Test(syslog_format_speed, test_parser_speed)
+{
+  _benchmark_parser("rfc5424, single pass header",
+                    "<38>1 2024-05-16T12:09:27.123+02:00 localhost prg00000 1234 - - seq: 0000000000, "
+                    "thread: 0000, runid: 1715854167, stamp: 2024-05-16T12:09:27 PADDPADDPADDPADD", LP_SYSLOG_PROTOCOL);
+  _benchmark_parser("rfc5424, fallback (ipv6 hostname)",
+                    "<38>1 2024-05-16T12:09:27.123+02:00 fe80::1 prg00000 1234 - - seq: 0000000000, "
+                    "thread: 0000, runid: 1715854167, stamp: 2024-05-16T12:09:27 PADDPADDPADDPADD", LP_SYSLOG_PROTOCOL);
+  _benchmark_parser("rfc3164, single pass hostname",
+                    "<38>May 16 12:09:27 localhost prg00000[1234]: seq: 0000000000, "
+                    "thread: 0000, runid: 1715854167, stamp: 2024-05-16T12:09:27 PADDPADDPADDPADD", 0);
+  _benchmark_parser("rfc3164, fallback (ipv6 hostname)",
+                    "<38>May 16 12:09:27 fe80::1 prg00000[1234]: seq: 0000000000, "
+                    "thread: 0000, runid: 1715854167, stamp: 2024-05-16T12:09:27 PADDPADDPADDPADD", 0);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "path-trace.h"
+
+static gint path_trace_sampling = 0;
+
+static GOptionEntry path_trace_options_start[] =
+{
+  { "sampling", 's', 0, G_OPTION_ARG_INT, &path_trace_sampling, "Trace 1 out of N messages, default: 1000", "<N>" },
+  { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL }
+};
+
+static gint
+slng_path_trace_start(int argc, char *argv[], const gchar *mode, GOptionContext *ctx)
+{
+  gchar buff[64];
+
+  if (path_trace_sampling > 0)
+    g_snprintf(buff, sizeof(buff), "PATH_TRACE START %d", path_trace_sampling);
+  else
+    g_snprintf(buff, sizeof(buff), "PATH_TRACE START");
+
+  return dispatch_command(buff);
+}
+
+static gint
+slng_path_trace_stop(int argc, char *argv[], const gchar *mode, GOptionContext *ctx)
+{
+  return dispatch_command("PATH_TRACE STOP");
+}
+
+static gint
+slng_path_trace_dump(int argc, char *argv[], const gchar *mode, GOptionContext *ctx)
+{
+  return dispatch_command("PATH_TRACE DUMP");
+}
+
+CommandDescriptor path_trace_commands[] =
+{
+  { "start", path_trace_options_start, "Start tracing the path of sampled messages", slng_path_trace_start },
+  { "stop", no_options, "Stop tracing, messages already traced are still completed", slng_path_trace_stop },
+  { "dump", no_options, "Print the most recent completed traces as JSON", slng_path_trace_dump },
+  { NULL }
+};
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "profile.h"
+
+static gint profile_sampling = 0;
+
+static GOptionEntry profile_options_start[] =
+{
+  { "sampling", 's', 0, G_OPTION_ARG_INT, &profile_sampling, "Profile 1 out of N messages, default: 100", "<N>" },
+  { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL }
+};
+
+static gint
+slng_profile_start(int argc, char *argv[], const gchar *mode, GOptionContext *ctx)
+{
+  gchar buff[64];
+
+  if (profile_sampling > 0)
+    g_snprintf(buff, sizeof(buff), "PROFILE START %d", profile_sampling);
+  else
+    g_snprintf(buff, sizeof(buff), "PROFILE START");
+
+  return dispatch_command(buff);
+}
+
+static gint
+slng_profile_stop(int argc, char *argv[], const gchar *mode, GOptionContext *ctx)
+{
+  return dispatch_command("PROFILE STOP");
+}
+
+static gint
+slng_profile_reset(int argc, char *argv[], const gchar *mode, GOptionContext *ctx)
+{
+  return dispatch_command("PROFILE RESET");
+}
+
+static gint
+slng_profile_report(int argc, char *argv[], const gchar *mode, GOptionContext *ctx)
+{
+  return dispatch_command("PROFILE REPORT");
+}
+
+static gint
+slng_profile_flamegraph(int argc, char *argv[], const gchar *mode, GOptionContext *ctx)
+{
+  return dispatch_command("PROFILE COLLAPSED");
+}
+
+CommandDescriptor profile_commands[] =
+{
+  { "start", profile_options_start, "Start profiling the processing pipeline", slng_profile_start },
+  { "stop", no_options, "Stop profiling, keeping the results collected so far", slng_profile_stop },
+  { "reset", no_options, "Clear the collected results", slng_profile_reset },
+  { "report", no_options, "Print the pipeline elements ranked by the time spent in them", slng_profile_report },
+  { "flamegraph", no_options, "Print the collected stacks in collapsed format (flamegraph.pl input)", slng_profile_flamegraph },
+  { NULL }
+};
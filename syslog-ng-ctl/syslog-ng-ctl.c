@@ -38,6 +38,8 @@
 #include "commands/license.h"
 #include "commands/healthcheck.h"
 #include "commands/attach.h"
+#include "commands/profile.h"
+#include "commands/path-trace.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -128,6 +130,8 @@ static CommandDescriptor modes[] =
   { "list-files", no_options, "Print files present in config", slng_listfiles, NULL },
   { "export-config-graph", no_options, "export configuration graph", slng_export_config_graph, NULL },
   { "healthcheck", healthcheck_options, "Health check", slng_healthcheck, NULL },
+  { "profile", no_options, "Pipeline profiler", NULL, profile_commands },
+  { "path-trace", no_options, "Sampled message path tracing", NULL, path_trace_commands },
   { NULL, NULL },
 };
 
@@ -0,0 +1,645 @@
+#!/usr/bin/env python3
+#############################################################################
+# Copyright (c) 2024 Axoflow
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms of the GNU General Public License version 2 as published
+# by the Free Software Foundation, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+#
+# As an additional exemption you are allowed to compile & link against the
+# OpenSSL libraries as published by the OpenSSL project. See the file
+# COPYING for details.
+#
+#############################################################################
+#
+# Throughput benchmark suite.
+#
+# Every scenario starts syslog-ng with a canonical configuration, drives it
+# with loggen (at a fixed rate and at saturation), and measures the
+# processed message rate, CPU time per message, peak RSS and the p99
+# end-to-end latency (based on the output_event_latency_seconds
+# histograms).  The results are written as JSON, so they can be compared
+# between builds and releases.
+#
+# Only the Python standard library is used.
+#
+import argparse
+import http.server
+import json
+import os
+import platform
+import re
+import shutil
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+SC_CLK_TCK = os.sysconf("SC_CLK_TCK")
+
+OPTIONS = """
+@version: current
+
+options {
+  stats(level(1) latency-sampling(%(latency_sampling)d));
+  keep-hostname(yes);
+  log-fifo-size(100000);
+};
+"""
+
+SCENARIOS = {}
+
+
+def scenario(name, loggen_args=None, sink=None, module=None):
+    def decorator(func):
+        SCENARIOS[name] = {"config": func, "loggen_args": loggen_args, "sink": sink, "module": module}
+        return func
+    return decorator
+
+
+@scenario("tcp-to-file", loggen_args=["--inet", "--stream"])
+def tcp_to_file(ctx):
+    return """
+log {
+  source { network(port(%(port)d) transport(tcp) log-iw-size(100000) max-connections(100)); };
+  destination { file("%(workdir)s/output.log"); };
+};
+""" % ctx
+
+
+@scenario("udp-to-file", loggen_args=["--inet", "--dgram"])
+def udp_to_file(ctx):
+    return """
+log {
+  source { network(port(%(port)d) transport(udp) so-rcvbuf(16777216)); };
+  destination { file("%(workdir)s/output.log"); };
+};
+""" % ctx
+
+
+@scenario("tls-to-tcp", loggen_args=["--inet", "--stream", "--use-ssl"], sink="tcp")
+def tls_to_tcp(ctx):
+    return """
+log {
+  source {
+    network(port(%(port)d) transport(tls) log-iw-size(100000) max-connections(100)
+            tls(peer-verify(optional-untrusted) cert-file("%(cert_file)s") key-file("%(key_file)s")));
+  };
+  destination { network("127.0.0.1" port(%(sink_port)d) transport(tcp)); };
+};
+""" % ctx
+
+
+@scenario("json-parse-to-format-json", loggen_args=["--inet", "--stream", "--dont-parse"])
+def json_parse_to_format_json(ctx):
+    return """
+log {
+  source { network(port(%(port)d) transport(tcp) flags(no-parse) log-iw-size(100000) max-connections(100)); };
+  parser { json-parser(prefix(".json.")); };
+  destination { file("%(workdir)s/output.log" template("$(format-json --scope dot-nv-pairs)\\n")); };
+};
+""" % ctx
+
+
+@scenario("filterx", loggen_args=["--inet", "--stream"])
+def filterx(ctx):
+    return """
+log {
+  source { network(port(%(port)d) transport(tcp) log-iw-size(100000) max-connections(100)); };
+  filterx {
+    fields = json();
+    fields += regexp_search($MSG, "seq: (?<seq>\\\\d+), thread: (?<thread>\\\\d+), runid: (?<runid>\\\\d+)");
+    fields.host = lower($HOST);
+    fields.program = upper($PROGRAM);
+    fields.length = len($MSG);
+    if (fields.thread == "0000") {
+      fields.first_thread = true;
+    };
+    $MSG = format_json(fields);
+  };
+  destination { file("%(workdir)s/output.log" template("$MSG\\n")); };
+};
+""" % ctx
+
+
+@scenario("disk-buffer-drain", loggen_args=["--inet", "--stream"], sink="tcp-delayed")
+def disk_buffer_drain(ctx):
+    return """
+log {
+  source { network(port(%(port)d) transport(tcp) log-iw-size(100000) max-connections(100)); };
+  destination {
+    network("127.0.0.1" port(%(sink_port)d) transport(tcp) time-reopen(1)
+            disk-buffer(reliable(no) capacity-bytes(1GiB) front-cache-size(10000) dir("%(workdir)s")));
+  };
+};
+""" % ctx
+
+
+@scenario("http", loggen_args=["--inet", "--stream"], sink="http")
+def http_to_stand_in(ctx):
+    return """
+log {
+  source { network(port(%(port)d) transport(tcp) log-iw-size(100000) max-connections(100)); };
+  destination {
+    http(url("http://127.0.0.1:%(sink_port)d/") method("POST") workers(4)
+         batch-lines(1000) batch-timeout(100) body("$MSG"));
+  };
+};
+""" % ctx
+
+
+KAFKA_MOCK_DESTINATION = """
+log {
+  source { network(port(%(port)d) transport(tcp) log-iw-size(100000) max-connections(100)); };
+  destination {
+    kafka(bootstrap-servers("127.0.0.1:9092") topic("bench") workers(4) batch-lines(1000) %(produce_batch)s
+          config("test.mock.num.brokers"("3") "linger.ms"("5") "queue.buffering.max.messages"("1000000")));
+  };
+};
+"""
+
+
+# librdkafka's built-in mock cluster stands in for the brokers, so these
+# measure the client side of the destination, not a real broker round-trip
+@scenario("kafka-mock", loggen_args=["--inet", "--stream"], module="kafka")
+def kafka_mock(ctx):
+    return KAFKA_MOCK_DESTINATION % dict(ctx, produce_batch="")
+
+
+@scenario("kafka-mock-produce-batch", loggen_args=["--inet", "--stream"], module="kafka")
+def kafka_mock_produce_batch(ctx):
+    return KAFKA_MOCK_DESTINATION % dict(ctx, produce_batch="produce-batch(yes)")
+
+
+@scenario("wildcard-file-10k")
+def wildcard_file(ctx):
+    return """
+log {
+  source { wildcard-file(base-dir("%(workdir)s/input") filename-pattern("*.log") max-files(20000)
+                         follow-freq(1) log-iw-size(1000000) flags(no-parse)); };
+  destination { file("%(workdir)s/output.log"); };
+};
+""" % ctx
+
+
+class TcpSink(threading.Thread):
+    """Accepts connections and discards everything received."""
+
+    def __init__(self, port):
+        super().__init__(daemon=True)
+        self.server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.server.bind(("127.0.0.1", port))
+        self.server.listen(16)
+
+    def run(self):
+        while True:
+            try:
+                conn, _ = self.server.accept()
+            except OSError:
+                return
+            threading.Thread(target=self._drain, args=(conn,), daemon=True).start()
+
+    @staticmethod
+    def _drain(conn):
+        with conn:
+            while conn.recv(1024 * 1024):
+                pass
+
+    def stop(self):
+        self.server.close()
+
+
+class HttpSinkHandler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def do_POST(self):
+        self.rfile.read(int(self.headers.get("Content-Length", 0)))
+        self.send_response(200)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+
+    def log_message(self, format, *args):
+        pass
+
+
+class HttpSink(threading.Thread):
+    """A stand-in for an HTTP collector, answering every request with 200."""
+
+    def __init__(self, port):
+        super().__init__(daemon=True)
+        self.server = http.server.ThreadingHTTPServer(("127.0.0.1", port), HttpSinkHandler)
+
+    def run(self):
+        self.server.serve_forever()
+
+    def stop(self):
+        self.server.shutdown()
+        self.server.server_close()
+
+
+def find_free_port():
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+
+class SyslogNg:
+    def __init__(self, args, workdir, config):
+        self.args = args
+        self.workdir = workdir
+        self.config_path = os.path.join(workdir, "syslog-ng.conf")
+        self.control_path = os.path.join(workdir, "syslog-ng.ctl")
+        with open(self.config_path, "w") as f:
+            f.write(config)
+        self.process = None
+
+    def start(self):
+        self.process = subprocess.Popen(
+            [
+                self.args.syslog_ng, "-F", "--no-caps",
+                "-f", self.config_path,
+                "-R", os.path.join(self.workdir, "syslog-ng.persist"),
+                "-p", os.path.join(self.workdir, "syslog-ng.pid"),
+                "-c", self.control_path,
+            ],
+            stdout=subprocess.DEVNULL,
+            stderr=open(os.path.join(self.workdir, "syslog-ng.stderr"), "w"),
+        )
+        deadline = time.monotonic() + 30
+        while time.monotonic() < deadline:
+            if self.process.poll() is not None:
+                raise RuntimeError("syslog-ng exited during startup, see %s" % os.path.join(self.workdir, "syslog-ng.stderr"))
+            if os.path.exists(self.control_path) and self.ctl("stats", "prometheus") is not None:
+                return
+            time.sleep(0.1)
+        raise RuntimeError("syslog-ng did not start up in time")
+
+    def stop(self):
+        if not self.process:
+            return
+        self.process.send_signal(signal.SIGTERM)
+        try:
+            self.process.wait(timeout=60)
+        except subprocess.TimeoutExpired:
+            self.process.kill()
+            self.process.wait()
+
+    def ctl(self, *command):
+        result = subprocess.run(
+            [self.args.syslog_ng_ctl, *command, "-c", self.control_path],
+            stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, universal_newlines=True,
+        )
+        return result.stdout if result.returncode == 0 else None
+
+    def cpu_seconds(self):
+        with open("/proc/%d/stat" % self.process.pid) as f:
+            fields = f.read().rsplit(")", 1)[1].split()
+        # utime and stime are the 14th and 15th fields, counted from the pid
+        return (int(fields[11]) + int(fields[12])) / SC_CLK_TCK
+
+    def peak_rss_kb(self):
+        with open("/proc/%d/status" % self.process.pid) as f:
+            for line in f:
+                if line.startswith("VmHWM:"):
+                    return int(line.split()[1])
+        return None
+
+    def metrics(self):
+        return parse_prometheus(self.ctl("stats", "prometheus") or "")
+
+
+PROMETHEUS_LINE = re.compile(r'^(?P<name>[a-zA-Z_:][a-zA-Z0-9_:]*)(?:\{(?P<labels>.*)\})? (?P<value>\S+)$')
+PROMETHEUS_LABEL = re.compile(r'([a-zA-Z_][a-zA-Z0-9_]*)="((?:[^"\\]|\\.)*)"')
+
+
+def parse_prometheus(text):
+    samples = []
+    for line in text.splitlines():
+        match = PROMETHEUS_LINE.match(line)
+        if not match:
+            continue
+        labels = dict(PROMETHEUS_LABEL.findall(match.group("labels") or ""))
+        samples.append((match.group("name"), labels, float(match.group("value"))))
+    return samples
+
+
+def delivered_messages(samples):
+    return sum(value for name, labels, value in samples
+               if name == "syslogng_output_events_total" and labels.get("result") == "delivered")
+
+
+def latency_quantile(samples, quantile, stage="received_to_sent"):
+    """Quantile of the latency histogram summed over all destinations, in milliseconds."""
+    buckets = {}
+    for name, labels, value in samples:
+        if name == "syslogng_output_event_latency_seconds_bucket" and labels.get("stage") == stage:
+            le = float("inf") if labels["le"] == "+Inf" else float(labels["le"])
+            buckets[le] = buckets.get(le, 0) + value
+
+    if not buckets:
+        return None
+
+    bounds = sorted(buckets)
+    total = buckets[bounds[-1]]
+    if total == 0:
+        return None
+
+    for bound in bounds:
+        if buckets[bound] >= quantile * total:
+            return bound * 1000 if bound != float("inf") else None
+    return None
+
+
+def subtract_histograms(after, before):
+    before_values = {(name, tuple(sorted(labels.items()))): value for name, labels, value in before}
+    return [(name, labels, value - before_values.get((name, tuple(sorted(labels.items()))), 0))
+            for name, labels, value in after]
+
+
+def wait_until_drained(syslog_ng, expected, timeout, idle_timeout=5):
+    """
+    Waits until @expected messages are delivered, or the delivered counter
+    stops growing (e.g. UDP drops) for @idle_timeout seconds.
+    """
+    deadline = time.monotonic() + timeout
+    delivered = delivered_messages(syslog_ng.metrics())
+    last_progress = time.monotonic()
+    while delivered < expected and time.monotonic() < deadline:
+        time.sleep(0.2)
+        current = delivered_messages(syslog_ng.metrics())
+        if current > delivered:
+            last_progress = time.monotonic()
+        elif time.monotonic() - last_progress > idle_timeout:
+            break
+        delivered = current
+    return delivered
+
+
+def generate_json_corpus(path, count=10000):
+    with open(path, "w") as f:
+        for i in range(count):
+            f.write(json.dumps({
+                "seq": i,
+                "host": "host-%d" % (i % 64),
+                "app": {"name": "bench", "pid": 1000 + i % 32},
+                "level": ["info", "warning", "error"][i % 3],
+                "message": "request served in %d ms" % (i % 500),
+                "tags": ["a", "b", "c"],
+            }) + "\n")
+
+
+def run_loggen(args, scenario_info, ctx, rate, duration):
+    command = [args.loggen, "--quiet", "--size", str(args.message_size),
+               "--active-connections", str(args.connections), "--interval", str(duration),
+               "--rate", str(rate)]
+    command += scenario_info["loggen_args"]
+    if "--dont-parse" in scenario_info["loggen_args"]:
+        command += ["--read-file", ctx["json_corpus"], "--loop-reading"]
+    command += ["127.0.0.1", str(ctx["port"])]
+
+    result = subprocess.run(command, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, universal_newlines=True)
+    if result.returncode != 0:
+        raise RuntimeError("loggen failed: %s" % result.stderr.strip())
+
+    match = re.search(r"count\s*=\s*(\d+)", result.stderr)
+    return int(match.group(1)) if match else None
+
+
+def feed_wildcard_files(workdir, file_count, duration, rate):
+    """Appends to the followed files in a round-robin fashion, returns the number of lines written."""
+    input_dir = os.path.join(workdir, "input")
+    paths = [os.path.join(input_dir, "file-%05d.log" % i) for i in range(file_count)]
+
+    written = 0
+    deadline = time.monotonic() + duration
+    line = "x" * 100 + "\n"
+    while time.monotonic() < deadline:
+        round_start = time.monotonic()
+        for path in paths:
+            with open(path, "a") as f:
+                f.write(line)
+        written += len(paths)
+        if rate:
+            time.sleep(max(0.0, len(paths) / rate - (time.monotonic() - round_start)))
+    return written
+
+
+def prepare_workdir(args, name, mode):
+    workdir = tempfile.mkdtemp(prefix="bench-%s-%s-" % (name, mode), dir=args.workdir)
+    ctx = {
+        "workdir": workdir,
+        "port": find_free_port(),
+        "sink_port": find_free_port(),
+        "cert_file": args.cert_file,
+        "key_file": args.key_file,
+        "json_corpus": os.path.join(workdir, "corpus.json"),
+        "latency_sampling": args.latency_sampling,
+    }
+
+    if name == "json-parse-to-format-json":
+        generate_json_corpus(ctx["json_corpus"])
+
+    if name == "wildcard-file-10k":
+        os.makedirs(os.path.join(workdir, "input"))
+        for i in range(args.wildcard_files):
+            open(os.path.join(workdir, "input", "file-%05d.log" % i), "w").close()
+
+    return workdir, ctx
+
+
+def start_sink(kind, port):
+    if kind == "tcp":
+        sink = TcpSink(port)
+    elif kind == "http":
+        sink = HttpSink(port)
+    else:
+        return None
+    sink.start()
+    return sink
+
+
+def run_scenario(args, name, mode):
+    scenario_info = SCENARIOS[name]
+    workdir, ctx = prepare_workdir(args, name, mode)
+    rate = args.rate if mode == "fixed-rate" else args.saturation_rate
+
+    sink = start_sink(scenario_info["sink"], ctx["sink_port"])
+    syslog_ng = SyslogNg(args, workdir, OPTIONS % ctx + scenario_info["config"](ctx))
+
+    try:
+        syslog_ng.start()
+        before = syslog_ng.metrics()
+        delivered_before = delivered_messages(before)
+        cpu_before = syslog_ng.cpu_seconds()
+        start = time.monotonic()
+
+        if name == "wildcard-file-10k":
+            sent = feed_wildcard_files(workdir, args.wildcard_files, args.duration,
+                                       rate if mode == "fixed-rate" else 0)
+        else:
+            sent = run_loggen(args, scenario_info, ctx, max(1, rate // args.connections), args.duration)
+
+        if scenario_info["sink"] == "tcp-delayed":
+            # the destination was down while loading, now measure how fast the backlog drains
+            sink = start_sink("tcp", ctx["sink_port"])
+            start = time.monotonic()
+            cpu_before = syslog_ng.cpu_seconds()
+
+        delivered = wait_until_drained(syslog_ng, delivered_before + (sent or 0), args.drain_timeout)
+        elapsed = time.monotonic() - start
+        cpu_used = syslog_ng.cpu_seconds() - cpu_before
+
+        after = syslog_ng.metrics()
+        latency = subtract_histograms(after, before)
+        processed = delivered - delivered_before
+
+        return {
+            "scenario": name,
+            "mode": mode,
+            "target_rate": rate if mode == "fixed-rate" else None,
+            "sent": sent,
+            "processed": int(processed),
+            "duration_sec": round(elapsed, 3),
+            "msg_per_sec": round(processed / elapsed, 1) if elapsed > 0 else None,
+            "cpu_usec_per_msg": round(cpu_used * 1e6 / processed, 3) if processed > 0 else None,
+            "peak_rss_kb": syslog_ng.peak_rss_kb(),
+            "p50_latency_ms": latency_quantile(latency, 0.50),
+            "p99_latency_ms": latency_quantile(latency, 0.99),
+        }
+    finally:
+        syslog_ng.stop()
+        if sink:
+            sink.stop()
+        if not args.keep_workdir:
+            shutil.rmtree(workdir, ignore_errors=True)
+
+
+def syslog_ng_version_output(args):
+    result = subprocess.run([args.syslog_ng, "--version"], stdout=subprocess.PIPE, universal_newlines=True)
+    return result.stdout or ""
+
+
+def syslog_ng_version(args):
+    lines = syslog_ng_version_output(args).splitlines()
+    return lines[0].split()[-1] if lines else None
+
+
+def available_modules(args):
+    for line in syslog_ng_version_output(args).splitlines():
+        if line.startswith("Available-Modules:"):
+            return set(module.strip() for module in line.split(":", 1)[1].split(","))
+    return set()
+
+
+def parse_args():
+    srcdir = os.path.dirname(os.path.abspath(__file__))
+    default_ssl_dir = os.path.join(srcdir, "..", "functional")
+
+    parser = argparse.ArgumentParser(description="syslog-ng throughput benchmarks")
+    parser.add_argument("--installdir", help="syslog-ng installation prefix, sets the default binary paths")
+    parser.add_argument("--syslog-ng", help="path of the syslog-ng binary")
+    parser.add_argument("--syslog-ng-ctl", help="path of the syslog-ng-ctl binary")
+    parser.add_argument("--loggen", help="path of the loggen binary")
+    parser.add_argument("--scenario", action="append", choices=sorted(SCENARIOS),
+                        help="run only the given scenario, can be used multiple times")
+    parser.add_argument("--mode", action="append", choices=["fixed-rate", "saturation"],
+                        help="run only the given mode, can be used multiple times")
+    parser.add_argument("--duration", type=int, default=30, help="seconds to generate load for, default: %(default)s")
+    parser.add_argument("--rate", type=int, default=50000, help="total msg/sec in fixed-rate mode, default: %(default)s")
+    parser.add_argument("--saturation-rate", type=int, default=10000000,
+                        help="total msg/sec requested in saturation mode, default: %(default)s")
+    parser.add_argument("--connections", type=int, default=4, help="loggen connections, default: %(default)s")
+    parser.add_argument("--message-size", type=int, default=256, help="message size, default: %(default)s")
+    parser.add_argument("--wildcard-files", type=int, default=10000,
+                        help="number of files followed in the wildcard-file-10k scenario, default: %(default)s")
+    parser.add_argument("--latency-sampling", type=int, default=100,
+                        help="measure latency on 1 out of N messages, default: %(default)s")
+    parser.add_argument("--drain-timeout", type=int, default=300,
+                        help="seconds to wait for the queued messages to be delivered, default: %(default)s")
+    parser.add_argument("--cert-file", default=os.path.join(default_ssl_dir, "ssl.crt"))
+    parser.add_argument("--key-file", default=os.path.join(default_ssl_dir, "ssl.key"))
+    parser.add_argument("--workdir", default=None, help="directory for the temporary files")
+    parser.add_argument("--keep-workdir", action="store_true", help="do not remove the temporary files")
+    parser.add_argument("--output", "-o", help="write the JSON results into this file instead of stdout")
+    args = parser.parse_args()
+
+    if args.installdir:
+        args.syslog_ng = args.syslog_ng or os.path.join(args.installdir, "sbin", "syslog-ng")
+        args.syslog_ng_ctl = args.syslog_ng_ctl or os.path.join(args.installdir, "sbin", "syslog-ng-ctl")
+        args.loggen = args.loggen or os.path.join(args.installdir, "bin", "loggen")
+
+    for binary in ("syslog_ng", "syslog_ng_ctl", "loggen"):
+        setattr(args, binary, getattr(args, binary) or shutil.which(binary.replace("_", "-")))
+        if not getattr(args, binary):
+            parser.error("%s not found, use --installdir or --%s" % (binary.replace("_", "-"), binary.replace("_", "-")))
+
+    return args
+
+
+def main():
+    args = parse_args()
+    scenarios = args.scenario or list(SCENARIOS)
+    modes = args.mode or ["fixed-rate", "saturation"]
+
+    modules = available_modules(args)
+
+    results = []
+    for name in scenarios:
+        module = SCENARIOS[name]["module"]
+        if module and module not in modules:
+            print("Skipping %s, the %s module is not available" % (name, module), file=sys.stderr)
+            continue
+
+        for mode in modes:
+            print("Running %s (%s)..." % (name, mode), file=sys.stderr)
+            try:
+                result = run_scenario(args, name, mode)
+            except Exception as e:
+                result = {"scenario": name, "mode": mode, "error": str(e)}
+            print("  %s" % json.dumps(result), file=sys.stderr)
+            results.append(result)
+
+    report = {
+        "syslog_ng_version": syslog_ng_version(args),
+        "timestamp": int(time.time()),
+        "host": {
+            "machine": platform.machine(),
+            "kernel": platform.release(),
+            "cpus": os.cpu_count(),
+        },
+        "parameters": {
+            "duration_sec": args.duration,
+            "rate": args.rate,
+            "saturation_rate": args.saturation_rate,
+            "connections": args.connections,
+            "message_size": args.message_size,
+            "latency_sampling": args.latency_sampling,
+        },
+        "results": results,
+    }
+
+    output = json.dumps(report, indent=2)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(output + "\n")
+    else:
+        print(output)
+
+    return 1 if any("error" in result for result in results) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -2000,6 +2000,26 @@ def test_regexp_subst(config, syslog_ng):
     assert file_true.read_log() == exp
 
 
+def test_regexp_match_any(config, syslog_ng):
+    (file_true, file_false) = create_config(
+        config, r"""
+        $MSG = {};
+        $MSG.first = regexp_match_any("CRON[42]: job started", ["CRON\\[", "sshd\\[", /(\w+)\1/]);
+        $MSG.second = regexp_match_any("sshd[1234]: Accepted publickey", ["CRON\\[", "sshd\\[", /(\w+)\1/]);
+        $MSG.backref = regexp_match_any("foofoo", ["CRON\\[", "sshd\\[", /(\w+)\1/]);
+        $MSG.none = regexp_match_any("kernel: oom", ["CRON\\[", "sshd\\["]);
+    """,
+    )
+    syslog_ng.start(config)
+
+    assert file_true.get_stats()["processed"] == 1
+    assert "processed" not in file_false.get_stats()
+    exp = (
+        r"""{"first":0,"second":1,"backref":2,"none":null}"""
+    )
+    assert file_true.read_log() == exp
+
+
 def test_regexp_subst_all_args_are_mandatory(config, syslog_ng):
     (file_true, file_false) = create_config(
         config, r"""
@@ -27,6 +27,7 @@
 #include "loggen_helper.h"
 #include "file_reader.h"
 #include "logline_generator.h"
+#include "message_corpus.h"
 #include "reloc.h"
 
 #include <stdio.h>
@@ -64,6 +65,8 @@ static PluginOption global_plugin_option =
   .proxy_dst_ip = NULL,
   .proxy_src_port = NULL,
   .proxy_dst_port = NULL,
+  .batch_size = 64,
+  .pin_threads = 0,
 };
 
 static char *sdata_value = NULL;
@@ -80,6 +83,10 @@ static gint64 *thread_stat_count_last = NULL;
 
 static GMutex message_counter_lock;
 
+/* log2 histogram of the time spent sending the messages, in nanoseconds */
+#define SEND_TIME_BUCKETS 48
+static gint64 send_time_histogram[SEND_TIME_BUCKETS];
+
 static gboolean
 _process_proxied_arg(const gchar *option_name,
                      const gchar *value,
@@ -113,9 +120,22 @@ static GOptionEntry loggen_options[] =
   { "quiet", 'Q', 0, G_OPTION_ARG_NONE, &quiet, "Don't print the msg/sec data", NULL },
   { "debug", 0, 0, G_OPTION_ARG_NONE, &debug, "Enable loggen debug messages", NULL },
   { "reconnect", 0, 0, G_OPTION_ARG_NONE, &global_plugin_option.reconnect, "Attempt to reconnect when destination connections are lost", NULL},
+  { "batch", 0, 0, G_OPTION_ARG_INT, &global_plugin_option.batch_size, "Number of pre-rendered messages to send in a single system call (default = 64)", "<number>" },
+  { "pin-threads", 0, 0, G_OPTION_ARG_NONE, &global_plugin_option.pin_threads, "Pin the sender threads to CPUs", NULL },
   { NULL }
 };
 
+static int
+render_message(char *buffer, int buffer_size, ThreadData *thread_context, unsigned long seq)
+{
+  if (read_from_file)
+    return read_next_message_from_file(buffer, buffer_size, syslog_proto, thread_context->index);
+
+  return generate_log_line(thread_context,
+                           buffer, buffer_size,
+                           syslog_proto, thread_context->index, global_plugin_option.rate, seq);
+}
+
 /* This is the callback function called by plugins when
  * they need a new log line */
 int
@@ -134,12 +154,7 @@ generate_message(char *buffer, int buffer_size, ThreadData *thread_context, unsi
       return str_len;
     }
 
-  if (read_from_file)
-    str_len = read_next_message_from_file(buffer, buffer_size, syslog_proto, thread_context->index);
-  else
-    str_len = generate_log_line(thread_context,
-                                buffer, buffer_size,
-                                syslog_proto, thread_context->index, global_plugin_option.rate, seq);
+  str_len = render_message(buffer, buffer_size, thread_context, seq);
 
   if (str_len < 0)
     return -1;
@@ -156,6 +171,63 @@ generate_message(char *buffer, int buffer_size, ThreadData *thread_context, unsi
   return str_len;
 }
 
+/* This is the callback function called by plugins after sending a batch
+ * of pre-rendered messages */
+static void
+account_sent_messages(ThreadData *thread_context, int count, gsize bytes, gint64 send_time_nsec)
+{
+  gint bucket = 0;
+  while (bucket < SEND_TIME_BUCKETS - 1 && (G_GINT64_CONSTANT(1) << (bucket + 1)) <= send_time_nsec)
+    bucket++;
+
+  g_mutex_lock(&message_counter_lock);
+  sent_messages_num += count;
+  raw_message_length += bytes;
+
+  /* every message of the batch waited for the whole batch to be sent */
+  send_time_histogram[bucket] += count;
+
+  if (thread_stat_count && csv)
+    thread_stat_count[thread_context->index] += count;
+
+  g_mutex_unlock(&message_counter_lock);
+}
+
+/* upper bound of the histogram bucket containing the quantile, in usec */
+static double
+send_time_quantile(double quantile)
+{
+  gint64 total = 0;
+  for (gint i = 0; i < SEND_TIME_BUCKETS; i++)
+    total += send_time_histogram[i];
+
+  gint64 cumulated = 0;
+  for (gint i = 0; i < SEND_TIME_BUCKETS; i++)
+    {
+      cumulated += send_time_histogram[i];
+      if (cumulated >= quantile * total)
+        return (double) (G_GINT64_CONSTANT(1) << (i + 1)) / 1000;
+    }
+  return 0;
+}
+
+static void
+print_send_time_quantiles(void)
+{
+  if (quiet)
+    return;
+
+  gint64 total = 0;
+  for (gint i = 0; i < SEND_TIME_BUCKETS; i++)
+    total += send_time_histogram[i];
+
+  if (total == 0)
+    return;
+
+  fprintf(stderr, "send latency (usec): p50 <= %.1f, p90 <= %.1f, p99 <= %.1f, p99.9 <= %.1f\n",
+          send_time_quantile(0.5), send_time_quantile(0.9), send_time_quantile(0.99), send_time_quantile(0.999));
+}
+
 static
 gboolean is_plugin_already_loaded(GPtrArray *plugin_array, const gchar *name)
 {
@@ -252,6 +324,9 @@ enumerate_plugins(const gchar *plugin_path, GPtrArray *plugin_array, GOptionCont
       else
         ERROR("plugin (%s) doesn't have set_generate_message function\n", plugin->name);
 
+      if (plugin->set_message_corpus)
+        plugin->set_message_corpus(get_message_corpus, account_sent_messages);
+
       g_ptr_array_add(plugin_array, (gpointer) plugin);
 
       /* create sub group for plugin specific parameters: */
@@ -549,6 +624,11 @@ main(int argc, char *argv[])
   g_option_group_add_entries(group, get_file_reader_options());
   g_option_context_add_group(ctx, group);
 
+  /* create sub group for pre-rendered message corpus */
+  group = g_option_group_new("message-corpus", "message-corpus", "Show options", NULL, NULL);
+  g_option_group_add_entries(group, get_message_corpus_options());
+  g_option_context_add_group(ctx, group);
+
   GError *error = NULL;
   if (!g_option_context_parse(ctx, &argc, &argv, &error))
     {
@@ -598,6 +678,23 @@ main(int argc, char *argv[])
   g_mutex_init(&message_counter_lock);
 
   init_logline_generator(plugin_array);
+
+  int use_corpus = init_message_corpus(global_plugin_option.active_connections, render_message);
+  if (use_corpus < 0)
+    {
+      ERROR("error while preparing the message corpus. exit.\n");
+      return 1;
+    }
+
+  if (use_corpus && global_plugin_option.proxied)
+    {
+      ERROR("PROXY protocol headers cannot be sent with pre-rendered messages. exit.\n");
+      return 1;
+    }
+
+  if (global_plugin_option.batch_size <= 0)
+    global_plugin_option.batch_size = 1;
+
   init_csv_statistics();
 
   if (start_plugins(plugin_array) > 0)
@@ -606,6 +703,9 @@ main(int argc, char *argv[])
       stop_plugins(plugin_array);
     }
 
+  print_send_time_quantiles();
+
+  close_message_corpus();
   close_file_reader(global_plugin_option.active_connections);
 
   g_mutex_clear(&message_counter_lock);
@@ -32,6 +32,11 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <openssl/err.h>
+#include <errno.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 #define HEADER_BUF_SIZE 128
 #define IP_ADDRESS_MAX_LENGTH 15
@@ -257,6 +262,28 @@ format_timezone_offset_with_colon(char *timestamp, int timestamp_size, struct tm
   strncat(timestamp, offset, timestamp_size - strlen(timestamp) -1);
 }
 
+/* spreads the sender threads over the available CPUs, one thread per CPU */
+void
+pin_thread_to_cpu(int thread_index)
+{
+#ifdef __linux__
+  long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cpu_count <= 0)
+    return;
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(thread_index % cpu_count, &cpu_set);
+
+  if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) < 0)
+    ERROR("error pinning thread %d to CPU %ld: %s\n", thread_index, thread_index % cpu_count, g_strerror(errno));
+  else
+    DEBUG("thread %d pinned to CPU %ld\n", thread_index, thread_index % cpu_count);
+#else
+  DEBUG("pinning threads to CPUs is not supported on this platform\n");
+#endif
+}
+
 SSL *
 open_ssl_connection(int sock_fd)
 {
@@ -31,8 +31,8 @@
 #include "loggen_plugin.h"
 #include "loggen_helper.h"
 
-gboolean
-thread_check_exit_criteria(ThreadData *thread_context)
+static gboolean
+_check_number_of_messages_reached(ThreadData *thread_context)
 {
   if (thread_context->option->number_of_messages != 0
       && thread_context->sent_messages >= thread_context->option->number_of_messages)
@@ -41,6 +41,29 @@ thread_check_exit_criteria(ThreadData *thread_context)
             thread_context->option->number_of_messages);
       return TRUE;
     }
+  return FALSE;
+}
+
+static gboolean
+_check_interval_elapsed(ThreadData *thread_context)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+
+  if ( !thread_context->option->permanent &&
+       time_val_diff_in_sec(&now, &thread_context->start_time) > thread_context->option->interval )
+    {
+      DEBUG("(thread %d) defined time (%d sec) ellapsed\n", thread_context->index, thread_context->option->interval);
+      return TRUE;
+    }
+  return FALSE;
+}
+
+gboolean
+thread_check_exit_criteria(ThreadData *thread_context)
+{
+  if (_check_number_of_messages_reached(thread_context))
+    return TRUE;
 
   long seq_check;
 
@@ -55,17 +78,17 @@ thread_check_exit_criteria(ThreadData *thread_context)
   if (seq_check > 1 && (thread_context->sent_messages % seq_check) != 0)
     return FALSE;
 
-  struct timeval now;
-  gettimeofday(&now, NULL);
+  return _check_interval_elapsed(thread_context);
+}
 
-  if ( !thread_context->option->permanent &&
-       time_val_diff_in_sec(&now, &thread_context->start_time) > thread_context->option->interval )
-    {
-      DEBUG("(thread %d) defined time (%d sec) ellapsed\n", thread_context->index, thread_context->option->interval);
-      return TRUE;
-    }
+/* same as thread_check_exit_criteria(), for threads sending messages in batches */
+gboolean
+thread_check_batch_exit_criteria(ThreadData *thread_context)
+{
+  if (_check_number_of_messages_reached(thread_context))
+    return TRUE;
 
-  return FALSE;
+  return _check_interval_elapsed(thread_context);
 }
 
 gboolean
@@ -104,3 +127,26 @@ thread_check_time_bucket(ThreadData *thread_context)
   return FALSE;
 }
 
+
+/*
+ * The number of messages that can be sent in the next batch, limited by
+ * the tokens available for the rate limit and by the number of messages
+ * to send.  Call thread_check_time_bucket() first to refill the tokens.
+ */
+int
+thread_get_batch_size(ThreadData *thread_context, int max_batch_size)
+{
+  long batch_size = max_batch_size;
+
+  if (thread_context->buckets < batch_size)
+    batch_size = thread_context->buckets;
+
+  if (thread_context->option->number_of_messages != 0)
+    {
+      long remaining = thread_context->option->number_of_messages - thread_context->sent_messages;
+      if (remaining < batch_size)
+        batch_size = remaining;
+    }
+
+  return batch_size > 0 ? batch_size : 0;
+}
@@ -51,6 +51,8 @@ typedef struct _plugin_option
   char *proxy_dst_ip;
   char *proxy_src_port;
   char *proxy_dst_port;
+  int batch_size;
+  int pin_threads;
 } PluginOption;
 
 typedef struct _thread_data
@@ -68,11 +70,34 @@ typedef struct _thread_data
   char stamp[32];
 } ThreadData;
 
+/*
+ * Messages rendered before the test is started (or read from a replay
+ * file), so sending them needs neither formatting nor copying.  The
+ * messages are stored back to back, message i is in
+ * buffer[offsets[i]..offsets[i + 1]).
+ */
+typedef struct _message_corpus
+{
+  const char *buffer;
+  const gsize *offsets;
+  int count;
+} MessageCorpus;
+
+static inline const char *
+message_corpus_get_message(const MessageCorpus *corpus, int index, gsize *length)
+{
+  *length = corpus->offsets[index + 1] - corpus->offsets[index];
+  return corpus->buffer + corpus->offsets[index];
+}
+
 typedef GOptionEntry *(*get_option_func)(void);
 typedef gboolean (*start_plugin_func)(PluginOption *option);
 typedef void (*stop_plugin_func)(PluginOption *option);
 typedef int (*generate_message_func)(char *buffer, int buffer_size, ThreadData *thread_context, unsigned long seq);
 typedef void (*set_generate_message_func)(generate_message_func gen_message);
+typedef const MessageCorpus *(*get_message_corpus_func)(ThreadData *thread_context);
+typedef void (*account_sent_messages_func)(ThreadData *thread_context, int count, gsize bytes, gint64 send_time_nsec);
+typedef void (*set_message_corpus_func)(get_message_corpus_func get_corpus, account_sent_messages_func account_sent);
 typedef int (*get_thread_count_func)(void);
 typedef gboolean (*is_plugin_activated_func)(void);
 
@@ -86,9 +111,12 @@ typedef struct _plugin_info
   set_generate_message_func set_generate_message;
   gboolean  require_framing; /* plugin can indicates that framing is mandatory in message lines */
   is_plugin_activated_func is_plugin_activated;
+  set_message_corpus_func set_message_corpus; /* optional, for plugins able to send pre-rendered messages */
 } PluginInfo;
 
 gboolean thread_check_exit_criteria(ThreadData *thread_context);
+gboolean thread_check_batch_exit_criteria(ThreadData *thread_context);
 gboolean thread_check_time_bucket(ThreadData *thread_context);
+int thread_get_batch_size(ThreadData *thread_context, int max_batch_size);
 
 #endif
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+
+#include "message_corpus.h"
+#include "loggen_helper.h"
+
+#include <string.h>
+
+typedef struct _RenderedCorpus
+{
+  MessageCorpus super;
+  GString *buffer;
+  GArray *offsets;
+} RenderedCorpus;
+
+static int prerender_count = 0;
+static char *replay_file_name = NULL;
+
+static RenderedCorpus *rendered_corpora;
+static int rendered_corpora_count;
+
+static GMappedFile *replay_file;
+static GArray *replay_offsets;
+static MessageCorpus replay_corpus;
+
+static GOptionEntry loggen_message_corpus_options[] =
+{
+  { "prerender", 0, 0, G_OPTION_ARG_INT, &prerender_count, "Render the given number of messages per connection before starting the test, and send them in a loop", "<number>" },
+  { "replay-file", 0, 0, G_OPTION_ARG_FILENAME, &replay_file_name, "Send the lines of the file as they are in a loop, the file is mapped into memory", "<filename>" },
+  { NULL }
+};
+
+GOptionEntry *
+get_message_corpus_options(void)
+{
+  return loggen_message_corpus_options;
+}
+
+static int
+_init_replay_corpus(void)
+{
+  GError *error = NULL;
+
+  replay_file = g_mapped_file_new(replay_file_name, FALSE, &error);
+  if (!replay_file)
+    {
+      ERROR("error opening replay file: %s\n", error->message);
+      g_error_free(error);
+      return -1;
+    }
+
+  const char *contents = g_mapped_file_get_contents(replay_file);
+  gsize length = g_mapped_file_get_length(replay_file);
+
+  replay_offsets = g_array_new(FALSE, FALSE, sizeof(gsize));
+
+  gsize start = 0;
+  g_array_append_val(replay_offsets, start);
+  while (start < length)
+    {
+      const char *eol = memchr(contents + start, '\n', length - start);
+      gsize end = eol ? eol - contents + 1 : length;
+
+      g_array_append_val(replay_offsets, end);
+      start = end;
+    }
+
+  if (replay_offsets->len < 2)
+    {
+      ERROR("replay file %s is empty\n", replay_file_name);
+      return -1;
+    }
+
+  replay_corpus.buffer = contents;
+  replay_corpus.offsets = (const gsize *) replay_offsets->data;
+  replay_corpus.count = replay_offsets->len - 1;
+
+  DEBUG("replay file %s mapped, %d messages\n", replay_file_name, replay_corpus.count);
+  return 1;
+}
+
+static int
+_render_corpus(RenderedCorpus *self, int thread_index, generate_message_func render_message)
+{
+  ThreadData thread_context = { .index = thread_index };
+  char message[MAX_MESSAGE_LENGTH + 1];
+
+  self->buffer = g_string_sized_new(prerender_count * 256);
+  self->offsets = g_array_sized_new(FALSE, FALSE, sizeof(gsize), prerender_count + 1);
+
+  gsize offset = 0;
+  g_array_append_val(self->offsets, offset);
+  for (int seq = 0; seq < prerender_count; seq++)
+    {
+      int message_length = render_message(message, MAX_MESSAGE_LENGTH, &thread_context, seq);
+
+      /* end of the input file */
+      if (message_length < 0)
+        break;
+
+      g_string_append_len(self->buffer, message, message_length);
+      offset = self->buffer->len;
+      g_array_append_val(self->offsets, offset);
+    }
+
+  if (self->offsets->len < 2)
+    {
+      ERROR("no messages could be rendered for connection %d\n", thread_index);
+      return -1;
+    }
+
+  self->super.buffer = self->buffer->str;
+  self->super.offsets = (const gsize *) self->offsets->data;
+  self->super.count = self->offsets->len - 1;
+
+  DEBUG("%d messages (%" G_GSIZE_FORMAT " bytes) rendered for connection %d\n",
+        self->super.count, self->buffer->len, thread_index);
+  return 1;
+}
+
+/*
+ * Returns 1 if the messages are to be sent from a corpus, 0 if the
+ * messages are generated one by one, -1 on error.
+ */
+int
+init_message_corpus(int nr_threads, generate_message_func render_message)
+{
+  if (replay_file_name && prerender_count > 0)
+    {
+      ERROR("--prerender and --replay-file cannot be used together\n");
+      return -1;
+    }
+
+  if (replay_file_name)
+    return _init_replay_corpus();
+
+  if (prerender_count <= 0)
+    {
+      DEBUG("message corpus not activated\n");
+      return 0;
+    }
+
+  rendered_corpora = g_new0(RenderedCorpus, nr_threads);
+  rendered_corpora_count = nr_threads;
+  for (int i = 0; i < nr_threads; i++)
+    {
+      if (_render_corpus(&rendered_corpora[i], i, render_message) < 0)
+        return -1;
+    }
+
+  return 1;
+}
+
+const MessageCorpus *
+get_message_corpus(ThreadData *thread_context)
+{
+  if (replay_file)
+    return &replay_corpus;
+
+  if (rendered_corpora && thread_context->index < rendered_corpora_count)
+    return &rendered_corpora[thread_context->index].super;
+
+  return NULL;
+}
+
+void
+close_message_corpus(void)
+{
+  for (int i = 0; i < rendered_corpora_count; i++)
+    {
+      if (rendered_corpora[i].buffer)
+        g_string_free(rendered_corpora[i].buffer, TRUE);
+      if (rendered_corpora[i].offsets)
+        g_array_free(rendered_corpora[i].offsets, TRUE);
+    }
+  g_free(rendered_corpora);
+  rendered_corpora = NULL;
+  rendered_corpora_count = 0;
+
+  if (replay_offsets)
+    g_array_free(replay_offsets, TRUE);
+  replay_offsets = NULL;
+
+  if (replay_file)
+    g_mapped_file_unref(replay_file);
+  replay_file = NULL;
+}
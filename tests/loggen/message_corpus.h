@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+
+#ifndef LOGGEN_MESSAGE_CORPUS_H_INCLUDED
+#define LOGGEN_MESSAGE_CORPUS_H_INCLUDED
+
+#include "compat/glib.h"
+#include "loggen_plugin.h"
+
+GOptionEntry *get_message_corpus_options(void);
+int init_message_corpus(int nr_threads, generate_message_func render_message);
+const MessageCorpus *get_message_corpus(ThreadData *thread_context);
+void close_message_corpus(void);
+
+#endif
@@ -36,9 +36,11 @@
 #include <netdb.h>
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <sys/un.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <errno.h>
 
 static gboolean       start(PluginOption *option);
@@ -49,12 +51,15 @@ static gboolean       send_msg(int fd, char *msg, size_t msg_len);
 static ssize_t        send_plain(int fd, void *buf, size_t length);
 static gint           get_thread_count(void);
 static void           set_generate_message(generate_message_func gen_message);
+static void           set_message_corpus(get_message_corpus_func get_corpus, account_sent_messages_func account_sent);
 static GOptionEntry  *get_options(void);
 static gboolean       is_plugin_activated(void);
 static GPtrArray      *thread_array = NULL;
 
 static gboolean thread_run;
 static generate_message_func generate_message;
+static get_message_corpus_func get_message_corpus;
+static account_sent_messages_func account_sent_messages;
 static GMutex thread_lock;
 static GCond thread_start;
 static GCond thread_connected;
@@ -85,9 +90,22 @@ PluginInfo socket_loggen_plugin_info =
   .get_thread_count = get_thread_count,
   .set_generate_message = set_generate_message,
   .is_plugin_activated = is_plugin_activated,
+  .set_message_corpus = set_message_corpus,
   .require_framing = FALSE
 };
 
+/* state of a thread sending pre-rendered messages */
+typedef struct _CorpusSender
+{
+  const MessageCorpus *corpus;
+  int position;
+  struct iovec *iov;
+  int iov_size;
+#ifdef __linux__
+  struct mmsghdr *msgs;
+#endif
+} CorpusSender;
+
 static gboolean
 is_plugin_activated(void)
 {
@@ -105,6 +123,13 @@ set_generate_message(generate_message_func gen_message)
   generate_message = gen_message;
 }
 
+static void
+set_message_corpus(get_message_corpus_func get_corpus, account_sent_messages_func account_sent)
+{
+  get_message_corpus = get_corpus;
+  account_sent_messages = account_sent;
+}
+
 static gint
 get_thread_count(void)
 {
@@ -306,6 +331,168 @@ idle_thread_func(gpointer user_data)
   return NULL;
 }
 
+static CorpusSender *
+corpus_sender_new(const MessageCorpus *corpus, int batch_size, int sock_type)
+{
+  CorpusSender *self = g_new0(CorpusSender, 1);
+
+  self->corpus = corpus;
+
+  /* a batch may wrap around the end of the corpus, possibly several times */
+  self->iov_size = sock_type == SOCK_DGRAM ? batch_size : batch_size / corpus->count + 2;
+  self->iov = g_new0(struct iovec, self->iov_size);
+#ifdef __linux__
+  if (sock_type == SOCK_DGRAM)
+    {
+      self->msgs = g_new0(struct mmsghdr, batch_size);
+      for (int i = 0; i < batch_size; i++)
+        {
+          self->msgs[i].msg_hdr.msg_iov = &self->iov[i];
+          self->msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+#endif
+  return self;
+}
+
+static void
+corpus_sender_free(CorpusSender *self)
+{
+  if (!self)
+    return;
+
+#ifdef __linux__
+  g_free(self->msgs);
+#endif
+  g_free(self->iov);
+  g_free(self);
+}
+
+/* consecutive messages are adjacent in the corpus, a stream needs one iovec per wrap-around */
+static gboolean
+send_corpus_stream(int fd, CorpusSender *self, int batch_size, gsize *bytes)
+{
+  const MessageCorpus *corpus = self->corpus;
+  int position = self->position;
+  int iovcnt = 0;
+
+  *bytes = 0;
+  while (batch_size > 0)
+    {
+      int count = MIN(batch_size, corpus->count - position);
+
+      self->iov[iovcnt].iov_base = (void *) (corpus->buffer + corpus->offsets[position]);
+      self->iov[iovcnt].iov_len = corpus->offsets[position + count] - corpus->offsets[position];
+      *bytes += self->iov[iovcnt].iov_len;
+      iovcnt++;
+
+      batch_size -= count;
+      position = (position + count) % corpus->count;
+    }
+
+  struct iovec *iov = self->iov;
+  while (iovcnt > 0)
+    {
+      ssize_t rc = writev(fd, iov, MIN(iovcnt, IOV_MAX));
+      if (rc < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          ERROR("error sending buffer on %d (%s)\n", fd, g_strerror(errno));
+          errno = ECONNABORTED;
+          return TRUE;
+        }
+
+      /* skip the fully sent buffers, adjust the partially sent one */
+      while (iovcnt > 0 && (size_t) rc >= iov->iov_len)
+        {
+          rc -= iov->iov_len;
+          iov++;
+          iovcnt--;
+        }
+      if (iovcnt > 0)
+        {
+          iov->iov_base = (char *) iov->iov_base + rc;
+          iov->iov_len -= rc;
+        }
+    }
+  return FALSE;
+}
+
+static gboolean
+send_corpus_datagrams(int fd, CorpusSender *self, int batch_size, gsize *bytes)
+{
+  const MessageCorpus *corpus = self->corpus;
+
+  *bytes = 0;
+  for (int i = 0; i < batch_size; i++)
+    {
+      gsize length;
+      const char *message = message_corpus_get_message(corpus, (self->position + i) % corpus->count, &length);
+
+      self->iov[i].iov_base = (void *) message;
+      self->iov[i].iov_len = length;
+      *bytes += length;
+    }
+
+#ifdef __linux__
+  int sent = 0;
+  while (sent < batch_size)
+    {
+      int rc = sendmmsg(fd, self->msgs + sent, batch_size - sent, 0);
+      if (rc < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          if (errno == ENOBUFS)
+            {
+              /* see send_plain() */
+              g_usleep(1000);
+              continue;
+            }
+          ERROR("error sending datagrams on %d (%s)\n", fd, g_strerror(errno));
+          errno = ECONNABORTED;
+          return TRUE;
+        }
+      sent += rc;
+    }
+  return FALSE;
+#else
+  for (int i = 0; i < batch_size; i++)
+    {
+      if (send_plain(fd, self->iov[i].iov_base, self->iov[i].iov_len) < 0)
+        {
+          ERROR("error sending buffer on %d\n", fd);
+          errno = ECONNABORTED;
+          return TRUE;
+        }
+    }
+  return FALSE;
+#endif
+}
+
+static gboolean
+send_corpus_batch(int fd, int sock_type, CorpusSender *self, int batch_size, ThreadData *thread_context)
+{
+  gsize bytes;
+  gint64 start = g_get_monotonic_time();
+
+  gboolean connection_error = (sock_type == SOCK_DGRAM)
+                              ? send_corpus_datagrams(fd, self, batch_size, &bytes)
+                              : send_corpus_stream(fd, self, batch_size, &bytes);
+  if (connection_error)
+    return TRUE;
+
+  gint64 send_time_nsec = (g_get_monotonic_time() - start) * 1000;
+
+  self->position = (self->position + batch_size) % self->corpus->count;
+  thread_context->sent_messages += batch_size;
+  thread_context->buckets -= batch_size;
+  account_sent_messages(thread_context, batch_size, bytes, send_time_nsec);
+
+  return FALSE;
+}
+
 gpointer
 active_thread_func(gpointer user_data)
 {
@@ -355,6 +542,14 @@ active_thread_func(gpointer user_data)
   DEBUG("thread (%s,%p) started. (r=%d,c=%d)\n", socket_loggen_plugin_info.name, g_thread_self(), option->rate,
         option->number_of_messages);
 
+  if (option->pin_threads)
+    pin_thread_to_cpu(thread_context->index);
+
+  CorpusSender *corpus_sender = NULL;
+  const MessageCorpus *corpus = get_message_corpus ? get_message_corpus(thread_context) : NULL;
+  if (corpus)
+    corpus_sender = corpus_sender_new(corpus, option->batch_size, sock_type);
+
   unsigned long count = 0;
   thread_context->buckets = thread_context->option->rate - (thread_context->option->rate / 10);
 
@@ -365,32 +560,41 @@ active_thread_func(gpointer user_data)
 
   while (fd>0 && thread_run && !connection_error)
     {
-      if (thread_check_exit_criteria(thread_context))
+      if (corpus_sender ? thread_check_batch_exit_criteria(thread_context) : thread_check_exit_criteria(thread_context))
         break;
 
       if (thread_check_time_bucket(thread_context))
         continue;
 
-      if (!generate_message)
+      if (corpus_sender)
         {
-          ERROR("generate_message not yet set up(%p)\n", g_thread_self());
-          break;
+          int batch_size = thread_get_batch_size(thread_context, option->batch_size);
+          if (batch_size > 0)
+            connection_error = send_corpus_batch(fd, sock_type, corpus_sender, batch_size, thread_context);
         }
+      else
+        {
+          if (!generate_message)
+            {
+              ERROR("generate_message not yet set up(%p)\n", g_thread_self());
+              break;
+            }
 
-      int str_len = generate_message(message, MAX_MESSAGE_LENGTH, thread_context, count++);
+          int str_len = generate_message(message, MAX_MESSAGE_LENGTH, thread_context, count++);
 
-      if (str_len < 0)
-        {
-          ERROR("can't generate more log lines. end of input file?\n");
-          break;
-        }
+          if (str_len < 0)
+            {
+              ERROR("can't generate more log lines. end of input file?\n");
+              break;
+            }
 
-      connection_error = send_msg(fd, message, str_len);
+          connection_error = send_msg(fd, message, str_len);
 
-      if(!connection_error)
-        {
-          thread_context->sent_messages++;
-          thread_context->buckets--;
+          if(!connection_error)
+            {
+              thread_context->sent_messages++;
+              thread_context->buckets--;
+            }
         }
 
       if(connection_error && option->reconnect && thread_run)
@@ -425,6 +629,7 @@ active_thread_func(gpointer user_data)
   DEBUG("thread (%s,%p) finished\n", socket_loggen_plugin_info.name, g_thread_self());
 
   g_free((gpointer)message);
+  corpus_sender_free(corpus_sender);
   g_mutex_lock(&thread_lock);
   active_thread_count--;
   g_mutex_unlock(&thread_lock);
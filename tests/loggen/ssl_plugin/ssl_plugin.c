@@ -361,6 +361,9 @@ active_thread_func(gpointer user_data)
   DEBUG("thread (%s,%p) started. (r=%d,c=%d)\n", ssl_loggen_plugin_info.name, g_thread_self(), option->rate,
         option->number_of_messages);
 
+  if (option->pin_threads)
+    pin_thread_to_cpu(thread_context->index);
+
   unsigned long count = 0;
   thread_context->buckets = thread_context->option->rate - (thread_context->option->rate / 10);
 
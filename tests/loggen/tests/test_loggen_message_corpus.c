@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+
+#include <criterion/criterion.h>
+
+#include "tests/loggen/message_corpus.c"
+
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+static int
+_render_numbered_message(char *buffer, int buffer_size, ThreadData *thread_context, unsigned long seq)
+{
+  return g_snprintf(buffer, buffer_size, "thread %d message %lu\n", thread_context->index, seq);
+}
+
+static int rendered_until_eof;
+
+static int
+_render_until_eof(char *buffer, int buffer_size, ThreadData *thread_context, unsigned long seq)
+{
+  if (rendered_until_eof == 3)
+    return -1;
+
+  rendered_until_eof++;
+  return g_snprintf(buffer, buffer_size, "line%lu\n", seq);
+}
+
+static void
+assert_corpus_message(const MessageCorpus *corpus, int index, const gchar *expected)
+{
+  gsize length;
+  const gchar *message = message_corpus_get_message(corpus, index, &length);
+
+  cr_assert_eq(length, strlen(expected));
+  cr_assert(memcmp(message, expected, length) == 0, "message %d mismatch: %.*s", index, (int) length, message);
+}
+
+Test(message_corpus, test_corpus_is_not_used_by_default)
+{
+  cr_assert_eq(init_message_corpus(2, _render_numbered_message), 0);
+
+  ThreadData thread_context = { .index = 0 };
+  cr_assert_null(get_message_corpus(&thread_context));
+}
+
+Test(message_corpus, test_prerendered_messages_are_stored_back_to_back_per_thread)
+{
+  prerender_count = 3;
+  cr_assert_eq(init_message_corpus(2, _render_numbered_message), 1);
+
+  ThreadData thread_context = { .index = 1 };
+  const MessageCorpus *corpus = get_message_corpus(&thread_context);
+
+  cr_assert_eq(corpus->count, 3);
+  assert_corpus_message(corpus, 0, "thread 1 message 0\n");
+  assert_corpus_message(corpus, 2, "thread 1 message 2\n");
+  cr_assert_eq(corpus->offsets[1], corpus->offsets[0] + strlen("thread 1 message 0\n"));
+
+  close_message_corpus();
+  prerender_count = 0;
+}
+
+Test(message_corpus, test_prerendering_stops_at_the_end_of_the_input)
+{
+  prerender_count = 10;
+  rendered_until_eof = 0;
+  cr_assert_eq(init_message_corpus(1, _render_until_eof), 1);
+
+  ThreadData thread_context = { .index = 0 };
+  cr_assert_eq(get_message_corpus(&thread_context)->count, 3);
+
+  close_message_corpus();
+  prerender_count = 0;
+}
+
+Test(message_corpus, test_replay_file_is_split_into_lines)
+{
+  gchar *path = NULL;
+  gint fd = g_file_open_tmp("loggen-replay-XXXXXX", &path, NULL);
+  cr_assert(fd >= 0);
+
+  const gchar *contents = "first\nsecond line\nlast without newline";
+  cr_assert_eq(write(fd, contents, strlen(contents)), strlen(contents));
+  close(fd);
+
+  replay_file_name = path;
+  cr_assert_eq(init_message_corpus(4, NULL), 1);
+
+  ThreadData thread_context = { .index = 3 };
+  const MessageCorpus *corpus = get_message_corpus(&thread_context);
+
+  cr_assert_eq(corpus->count, 3);
+  assert_corpus_message(corpus, 0, "first\n");
+  assert_corpus_message(corpus, 1, "second line\n");
+  assert_corpus_message(corpus, 2, "last without newline");
+
+  close_message_corpus();
+  replay_file_name = NULL;
+  g_unlink(path);
+  g_free(path);
+}
+
+Test(message_corpus, test_prerender_and_replay_file_are_mutually_exclusive)
+{
+  prerender_count = 1;
+  replay_file_name = "/dev/null";
+  cr_assert_eq(init_message_corpus(1, _render_numbered_message), -1);
+  prerender_count = 0;
+  replay_file_name = NULL;
+}